@@ -8,12 +8,35 @@ if (!(Test-Path "release")) {
 
 Write-Host "Compiling repo-context-packager (release build)..."
 
-g++ -std=c++17 -O2 -Wall -Wextra `
+g++ -std=c++17 -O2 -Wall -Wextra -pthread `
+  src/BudgetPlanner.cpp `
   src/Compressor.cpp `
+  src/CompressionCache.cpp `
+  src/ContentPipeline.cpp `
+  src/Deduplicator.cpp `
+  src/Deflate.cpp `
+  src/DependencyGraph.cpp `
+  src/DirectoryTree.cpp `
   src/FileReader.cpp `
   src/GitInfoCollector.cpp `
+  src/GitRepository.cpp `
+  src/IncrementalOutput.cpp `
+  src/LineDiff.cpp `
+  src/Lz4.cpp `
+  src/MappedFile.cpp `
   src/OutputFormatter.cpp `
+  src/OutputSink.cpp `
+  src/PackFile.cpp `
+  src/PreambleDetector.cpp `
+  src/RecordWriter.cpp `
   src/RepositoryScanner.cpp `
+  src/RevisionSource.cpp `
+  src/SearchIndex.cpp `
+  src/ShardedOutput.cpp `
+  src/StructuredMinifier.cpp `
+  src/SymbolTable.cpp `
+  src/ThreadPool.cpp `
+  src/Tokenizer.cpp `
   src/cli.cpp `
   src/main.cpp `
   -o release/repo-context-packager.exe
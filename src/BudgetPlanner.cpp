@@ -0,0 +1,76 @@
+#include "BudgetPlanner.h"
+#include "utils.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace rcpack;
+
+double BudgetPlanner::defaultRelevance(const std::string &relPath) {
+    std::string p = "/" + toLower(relPath);
+    for (const char *dir : {"/vendor/", "/third_party/", "/thirdparty/", "/node_modules/", "/external/",
+                            "/dist/", "/build/", "/generated/", "/gen/"}) {
+        if (p.find(dir) != std::string::npos) return 0.1;
+    }
+    auto dot = p.find_last_of('.');
+    std::string ext = dot == std::string::npos ? "" : p.substr(dot + 1);
+    if (ext == "json" || ext == "yaml" || ext == "yml" || ext == "xml" || ext == "lock" || ext == "csv" || ext == "sum") return 0.3;
+    if (p.find("/test") != std::string::npos || p.find("_test.") != std::string::npos || p.find(".test.") != std::string::npos) return 0.5;
+    if (ext == "md" || ext == "txt" || ext == "rst") return 0.6;
+    return 1.0;
+}
+
+size_t BudgetPlanner::headerTokens(const std::vector<std::string> &relPaths) {
+    size_t total = 96;
+    for (auto &p : relPaths) total += estimateTokens(p.size() + 3);
+    return total;
+}
+
+const char *BudgetPlanner::levelName(CompressionLevel level) {
+    switch (level) {
+        case CompressionLevel::Full: return "full text";
+        case CompressionLevel::NoComments: return "comments removed";
+        case CompressionLevel::NoBlankLines: return "comments and blank lines removed";
+        case CompressionLevel::SignaturesWithComments: return "signatures with comments";
+        case CompressionLevel::SignaturesOnly: return "signatures only";
+        case CompressionLevel::NameOnly: return "file name only";
+    }
+    return "";
+}
+
+std::vector<CompressionLevel> BudgetPlanner::plan(const std::vector<BudgetItem> &items, size_t budget,
+                                                  CompressionLevel minLevel, size_t &plannedTokens) {
+    const size_t first = static_cast<size_t>(minLevel);
+    std::vector<size_t> level(items.size(), first);
+    size_t total = 0;
+    for (auto &it : items) total += it.tokens[first];
+
+    // least relevant first; among equals, the biggest files give back the most
+    std::vector<size_t> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (items[a].relevance != items[b].relevance) return items[a].relevance < items[b].relevance;
+        return items[a].tokens[first] > items[b].tokens[first];
+    });
+
+    // a less relevant file goes all the way down before a more relevant one loses anything;
+    // files of equal relevance step down together
+    for (size_t begin = 0, end; begin < order.size() && total > budget; begin = end) {
+        for (end = begin + 1; end < order.size() && items[order[end]].relevance == items[order[begin]].relevance; ++end) {}
+        for (size_t target = first + 1; target < COMPRESSION_LEVEL_COUNT && total > budget; ++target) {
+            for (size_t k = begin; k < end && total > budget; ++k) {
+                size_t idx = order[k];
+                const auto &t = items[idx].tokens;
+                // levels are not guaranteed to shrink every file (e.g. no signatures found)
+                if (t[target] >= t[level[idx]]) continue;
+                total -= t[level[idx]] - t[target];
+                level[idx] = target;
+            }
+        }
+    }
+
+    plannedTokens = total;
+    std::vector<CompressionLevel> out;
+    out.reserve(level.size());
+    for (size_t l : level) out.push_back(static_cast<CompressionLevel>(l));
+    return out;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include "Config.h"
+
+namespace rcpack {
+
+    // One file as seen by the planner: estimated tokens at every level and how much we care about it.
+    struct BudgetItem {
+        std::array<size_t, COMPRESSION_LEVEL_COUNT> tokens{};
+        double relevance = 1.0;
+    };
+
+    // Chooses a CompressionLevel per file so the package fits a token budget.
+    // Files are degraded in relevance order: every less relevant file is taken down to NameOnly
+    // before a more relevant one loses anything. Files of equal relevance are raised one level
+    // at a time together, biggest first, so important files stay readable for as long as the
+    // budget allows.
+    class BudgetPlanner {
+    public:
+        // ~4 bytes per token for source text; good enough for planning
+        static size_t estimateTokens(size_t bytes) { return (bytes + 3) / 4; }
+        // tokens for a file's header and fences, paid even at NameOnly
+        static size_t framingTokens(const std::string &relPath) { return 16 + estimateTokens(relPath.size()); }
+        // title, git info and the Structure tree, which list every file once more
+        static size_t headerTokens(const std::vector<std::string> &relPaths);
+
+        // Heuristic used when no query ranks the files: sources > docs > tests > data > vendored code.
+        static double defaultRelevance(const std::string &relPath);
+
+        static const char *levelName(CompressionLevel level);
+
+        static std::vector<CompressionLevel> plan(const std::vector<BudgetItem> &items, size_t budget,
+                                                  CompressionLevel minLevel, size_t &plannedTokens);
+    };
+}
@@ -0,0 +1,255 @@
+#include "CompressionCache.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static constexpr char INDEX_MAGIC[4] = { 'R', 'C', 'C', 'I' };
+static constexpr uint32_t INDEX_VERSION = 5;
+static constexpr size_t HEADER_SIZE = 8;
+static constexpr size_t RECORD_SIZE = 56; // key, offset, length (u64 each), lines, flags (u32 each), source, symbols, tokens (u64 each)
+
+// One index record: key, offset, length, lines, flags, source, symbols, tokens.
+static void encodeRecord(char *rec, uint64_t key, const CompressionCache::Entry &e) {
+    std::memcpy(rec, &key, 8);
+    std::memcpy(rec + 8, &e.offset, 8);
+    std::memcpy(rec + 16, &e.length, 8);
+    std::memcpy(rec + 24, &e.lines, 4);
+    std::memcpy(rec + 28, &e.flags, 4);
+    std::memcpy(rec + 32, &e.source, 8);
+    std::memcpy(rec + 40, &e.symbols, 8);
+    std::memcpy(rec + 48, &e.tokens, 8);
+}
+
+CompressionCache::CompressionCache(const fs::path &dir, uint64_t maxBytes): cc_dir(dir), cc_maxBytes(maxBytes) {
+    std::error_code ec;
+    fs::create_directories(cc_dir, ec);
+    if (ec) {
+        std::cerr << "Warning: cannot create cache directory " << cc_dir << " -> " << ec.message() << "\n";
+        return;
+    }
+    loadIndex();
+}
+
+CompressionCache::~CompressionCache() {
+    compact();
+    if (cc_blobOut.is_open()) cc_blobOut.flush();
+    if (cc_indexOut.is_open()) cc_indexOut.flush();
+}
+
+void CompressionCache::loadIndex() {
+    fs::path indexPath = cc_dir / "index.bin";
+    fs::path blobPath = cc_dir / "blobs.bin";
+
+    bool valid = false;
+    {
+        MappedFile idx(indexPath);
+        if (idx.isOpen() && idx.size() >= HEADER_SIZE && std::memcmp(idx.data(), INDEX_MAGIC, 4) == 0) {
+            uint32_t version = 0;
+            std::memcpy(&version, idx.data() + 4, sizeof(version));
+            valid = version == INDEX_VERSION && cc_blobs.open(blobPath);
+        }
+        if (valid) {
+            size_t count = (idx.size() - HEADER_SIZE) / RECORD_SIZE; // a torn trailing record is ignored
+            cc_index.reserve(count);
+            const char *rec = idx.data() + HEADER_SIZE;
+            for (size_t i = 0; i < count; ++i, rec += RECORD_SIZE) {
+                uint64_t key;
+                Entry e;
+                std::memcpy(&key, rec, 8);
+                std::memcpy(&e.offset, rec + 8, 8);
+                std::memcpy(&e.length, rec + 16, 8);
+                std::memcpy(&e.lines, rec + 24, 4);
+                std::memcpy(&e.flags, rec + 28, 4);
+                std::memcpy(&e.source, rec + 32, 8);
+                std::memcpy(&e.symbols, rec + 40, 8);
+                std::memcpy(&e.tokens, rec + 48, 8);
+                if (e.symbols > e.length) continue;
+                if (e.offset + e.length > cc_blobs.size()) continue; // blob write never completed
+                auto [it, added] = cc_index.emplace(key, e);
+                if (!added) {
+                    cc_liveBytes -= it->second.length;
+                    it->second = e;
+                }
+                cc_liveBytes += e.length;
+            }
+            // drop any bytes past the last complete record so appends stay aligned
+            size_t goodSize = HEADER_SIZE + count * RECORD_SIZE;
+            if (goodSize != idx.size()) {
+                idx.close();
+                std::error_code ec;
+                fs::resize_file(indexPath, goodSize, ec);
+            }
+        }
+    }
+
+    if (!valid) {
+        // missing, foreign or outdated cache: start over
+        cc_index.clear();
+        cc_blobs.close();
+        std::ofstream(blobPath, std::ios::binary | std::ios::trunc);
+        std::ofstream idx(indexPath, std::ios::binary | std::ios::trunc);
+        idx.write(INDEX_MAGIC, 4);
+        idx.write(reinterpret_cast<const char *>(&INDEX_VERSION), sizeof(INDEX_VERSION));
+        if (!idx) {
+            std::cerr << "Warning: cannot initialise cache index " << indexPath << "\n";
+            return;
+        }
+    }
+
+    openForAppend();
+}
+
+void CompressionCache::openForAppend() {
+    cc_blobEnd = cc_blobs.size();
+    cc_blobOut.open(cc_dir / "blobs.bin", std::ios::binary | std::ios::app);
+    cc_indexOut.open(cc_dir / "index.bin", std::ios::binary | std::ios::app);
+    cc_open = cc_blobOut.is_open() && cc_indexOut.is_open();
+    if (!cc_open) std::cerr << "Warning: cache directory " << cc_dir << " is not writable; cache disabled\n";
+}
+
+void CompressionCache::compact() {
+    std::lock_guard<std::mutex> lock(cc_mutex);
+    if (!cc_open || (cc_blobEnd <= cc_maxBytes && cc_blobEnd - cc_liveBytes <= cc_liveBytes)) return;
+    cc_blobOut.close();
+    cc_indexOut.close();
+    cc_open = false;
+    // entries stored in this run are past the mapping taken on open
+    if (!cc_blobs.open(cc_dir / "blobs.bin")) return;
+
+    // entries used in this run first, then the most recently written ones
+    std::vector<std::pair<uint64_t, Entry>> keep(cc_index.begin(), cc_index.end());
+    std::sort(keep.begin(), keep.end(), [&](const auto &a, const auto &b) {
+        bool ua = cc_used.count(a.first) != 0, ub = cc_used.count(b.first) != 0;
+        if (ua != ub) return ua;
+        return a.second.offset > b.second.offset;
+    });
+    const fs::path blobTmp = cc_dir / "blobs.bin.tmp", indexTmp = cc_dir / "index.bin.tmp";
+    std::unordered_map<uint64_t, Entry> index;
+    uint64_t written = 0;
+    {
+        std::ofstream blobs(blobTmp, std::ios::binary | std::ios::trunc);
+        std::ofstream idx(indexTmp, std::ios::binary | std::ios::trunc);
+        idx.write(INDEX_MAGIC, 4);
+        idx.write(reinterpret_cast<const char *>(&INDEX_VERSION), sizeof(INDEX_VERSION));
+        for (auto &[key, e] : keep) {
+            if (e.offset + e.length > cc_blobs.size()) continue;
+            if (written + e.length > cc_maxBytes) continue; // evicted; a smaller one may still fit
+            Entry moved = e;
+            moved.offset = written;
+            blobs.write(cc_blobs.data() + e.offset, static_cast<std::streamsize>(e.length));
+            char rec[RECORD_SIZE];
+            encodeRecord(rec, key, moved);
+            idx.write(rec, RECORD_SIZE);
+            index.emplace(key, moved);
+            written += e.length;
+        }
+        if (!blobs || !idx) {
+            std::cerr << "Warning: could not compact the cache in " << cc_dir << "\n";
+            blobs.close();
+            idx.close();
+            std::error_code ec;
+            fs::remove(blobTmp, ec);
+            fs::remove(indexTmp, ec);
+            return;
+        }
+    }
+    cc_blobs.close();
+    std::error_code ec;
+    fs::rename(blobTmp, cc_dir / "blobs.bin", ec);
+    if (!ec) fs::rename(indexTmp, cc_dir / "index.bin", ec);
+    if (ec) {
+        // the index may now point into the new blobs: start over next time
+        std::cerr << "Warning: could not replace the cache files in " << cc_dir << " -> " << ec.message() << "\n";
+        fs::remove(cc_dir / "index.bin", ec);
+        cc_index.clear();
+        return;
+    }
+    cc_index = std::move(index);
+    cc_liveBytes = written;
+    if (cc_blobs.open(cc_dir / "blobs.bin") || written == 0) openForAppend();
+}
+
+uint64_t CompressionCache::makeKey(const fs::path &p, uintmax_t size, int64_t mtime,
+                                   unsigned optionFlags, size_t maxBytes) {
+    uint64_t h = hashString(p.generic_string());
+    h = hashCombine(h, static_cast<uint64_t>(size));
+    h = hashCombine(h, static_cast<uint64_t>(mtime));
+    h = hashCombine(h, optionFlags);
+    h = hashCombine(h, static_cast<uint64_t>(maxBytes));
+    return h;
+}
+
+bool CompressionCache::keyFor(const fs::path &p, unsigned optionFlags, size_t maxBytes, uint64_t &key,
+                              uintmax_t *sizeOut) {
+    std::error_code ec;
+    auto size = fs::file_size(p, ec);
+    if (ec) return false;
+    if (sizeOut) *sizeOut = size;
+    auto mtime = fs::last_write_time(p, ec);
+    if (ec) return false;
+    key = makeKey(p, size, static_cast<int64_t>(mtime.time_since_epoch().count()), optionFlags, maxBytes);
+    return true;
+}
+
+bool CompressionCache::lookup(uint64_t key, FileContent &out, bool *hasSymbols) const {
+    std::lock_guard<std::mutex> lock(cc_mutex);
+    auto it = cc_index.find(key);
+    // entries stored in this run are not in the mapping taken on open
+    if (!cc_open || it == cc_index.end() || it->second.offset + it->second.length > cc_blobs.size()) {
+        ++cc_misses;
+        return false;
+    }
+    const Entry &e = it->second;
+    cc_used.insert(key);
+    out.content.assign(cc_blobs.data() + e.offset, static_cast<size_t>(e.length - e.symbols));
+    if (hasSymbols) {
+        *hasSymbols = e.symbols != 0 &&
+            SymbolTable::decode(std::string_view(cc_blobs.data() + e.offset + out.content.size(), static_cast<size_t>(e.symbols)), out.symbols);
+    }
+    out.lines = e.lines;
+    out.truncated = (e.flags & 1u) != 0;
+    out.sourceHash = e.source;
+    out.tokens = static_cast<size_t>(e.tokens);
+    ++cc_hits;
+    return true;
+}
+
+void CompressionCache::store(uint64_t key, const FileContent &fc, bool withSymbols) {
+    std::string symbols;
+    if (withSymbols) fc.symbols.encode(symbols);
+    std::lock_guard<std::mutex> lock(cc_mutex);
+    if (!cc_open) return;
+    Entry e;
+    e.offset = cc_blobEnd;
+    e.symbols = symbols.size();
+    e.length = fc.content.size() + e.symbols;
+    e.lines = static_cast<uint32_t>(fc.lines);
+    e.flags = fc.truncated ? 1u : 0u;
+    e.source = fc.sourceHash;
+    e.tokens = fc.tokens;
+
+    // blob first, then the record that makes it visible
+    cc_blobOut.write(fc.content.data(), static_cast<std::streamsize>(fc.content.size()));
+    cc_blobOut.write(symbols.data(), static_cast<std::streamsize>(symbols.size()));
+    char rec[RECORD_SIZE];
+    encodeRecord(rec, key, e);
+    cc_indexOut.write(rec, RECORD_SIZE);
+    if (!cc_blobOut || !cc_indexOut) {
+        std::cerr << "Warning: failed to append to cache in " << cc_dir << "; cache disabled\n";
+        cc_open = false;
+        return;
+    }
+    cc_blobEnd += e.length;
+    auto [it, added] = cc_index.emplace(key, e);
+    if (!added) {
+        cc_liveBytes -= it->second.length;
+        it->second = e;
+    }
+    cc_liveBytes += e.length;
+    cc_used.insert(key);
+}
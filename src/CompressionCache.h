@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include "FileReader.h"
+#include "MappedFile.h"
+
+namespace rcpack {
+
+    // Persistent cache of Compressor::process output, optionally with the file's symbols.
+    // Layout inside the cache directory:
+    //   blobs.bin - append-only concatenation of processed contents (mmap'd on open)
+    //   index.bin - 8-byte header followed by fixed-size records pointing into blobs.bin
+    // Later records for the same key override earlier ones. lookup/store are safe to call
+    // from several threads. When the cache closes with more superseded bytes than live ones,
+    // or with more than maxBytes of blobs, both files are rewritten with only the live
+    // entries, those used in this run first, up to maxBytes.
+    class CompressionCache {
+    public:
+        struct Entry {
+            uint64_t offset = 0;
+            uint64_t length = 0;  // blob bytes: the content, then the encoded symbols if any
+            uint32_t lines = 0;
+            uint32_t flags = 0; // bit 0: truncated
+            uint64_t source = 0; // FileContent::sourceHash
+            uint64_t symbols = 0; // bytes of SymbolTable::encode at the end of the blob; 0 = not stored
+            uint64_t tokens = 0;  // FileContent::tokens as stored (passthrough counts), else 0
+        };
+
+        static constexpr uint64_t DEFAULT_MAX_BYTES = 256ull * 1024 * 1024;
+
+        explicit CompressionCache(const std::filesystem::path &dir, uint64_t maxBytes = DEFAULT_MAX_BYTES);
+        ~CompressionCache();
+
+        bool isOpen() const { return cc_open; }
+        const std::filesystem::path &dir() const { return cc_dir; }
+
+        // Key over (path, size, mtime) plus everything that changes the processed output.
+        static uint64_t makeKey(const std::filesystem::path &p, uintmax_t size, int64_t mtime,
+                                unsigned optionFlags, size_t maxBytes);
+        // Same as above but stats the file itself (and reports its size). Returns false if it cannot be stat'ed.
+        static bool keyFor(const std::filesystem::path &p, unsigned optionFlags, size_t maxBytes, uint64_t &key,
+                           uintmax_t *size = nullptr);
+
+        // With hasSymbols, also decodes the entry's symbols into out.symbols and tells whether it had any.
+        bool lookup(uint64_t key, FileContent &out, bool *hasSymbols = nullptr) const;
+        // withSymbols stores fc.symbols too, so that --symbols runs need not re-read the file.
+        void store(uint64_t key, const FileContent &fc, bool withSymbols = false);
+
+        size_t hits() const { std::lock_guard<std::mutex> lock(cc_mutex); return cc_hits; }
+        size_t misses() const { std::lock_guard<std::mutex> lock(cc_mutex); return cc_misses; }
+        // Blob bytes referenced by the index (superseded entries excluded) and in blobs.bin.
+        uint64_t liveBytes() const { std::lock_guard<std::mutex> lock(cc_mutex); return cc_liveBytes; }
+        uint64_t fileBytes() const { std::lock_guard<std::mutex> lock(cc_mutex); return cc_blobEnd; }
+        // Rewrites the files if they hold too much garbage or exceed maxBytes (also run on close).
+        void compact();
+
+    private:
+        std::filesystem::path cc_dir;
+        bool cc_open = false;
+        MappedFile cc_blobs;
+        std::unordered_map<uint64_t, Entry> cc_index;
+        std::ofstream cc_blobOut;
+        std::ofstream cc_indexOut;
+        uint64_t cc_blobEnd = 0;
+        uint64_t cc_liveBytes = 0;
+        uint64_t cc_maxBytes;
+        mutable std::unordered_set<uint64_t> cc_used; // looked up or stored in this run
+        mutable size_t cc_hits = 0;
+        mutable size_t cc_misses = 0;
+        mutable std::mutex cc_mutex;
+
+        void loadIndex();
+        void openForAppend();
+    };
+}
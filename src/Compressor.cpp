@@ -1,10 +1,30 @@
 #include "Compressor.h"
+#include "StructuredMinifier.h"
 #include <sstream>
 #include <unordered_set>
 #include <cctype>
 
 using namespace rcpack;
 
+bool Compressor::isCLikeSignature(const std::string &trimmed) {
+    if (trimmed.empty()) return false;
+    if (starts_with(trimmed, "class ") || starts_with(trimmed, "struct ")) return true;
+    if (starts_with(trimmed, "function ") || trimmed.find(" function ") != std::string::npos) return true;
+
+    if (trimmed.find('(') != std::string::npos && trimmed.find(')') != std::string::npos) {
+        if (trimmed.find('{') != std::string::npos) return true;
+        if (!trimmed.empty() && trimmed.back() == '{') return true;
+    }
+
+    if (trimmed.find("=>") != std::string::npos && trimmed.find('{') != std::string::npos) return true;
+    return false;
+}
+
+bool Compressor::isPythonSignature(const std::string &trimmed) {
+    if (starts_with(trimmed, "def ") || starts_with(trimmed, "class ")) return true;
+    return false;
+}
+
 std::vector<std::string> Compressor::extractChunks(const std::string &s, const std::string &ext) {
     std::vector<std::string> chunks;
     std::unordered_set<std::string> seen;
@@ -15,32 +35,13 @@ std::vector<std::string> Compressor::extractChunks(const std::string &s, const s
         offsets[i+1] = offsets[i] + lines[i].size() + 1;
     }
 
-    auto is_c_like_sig = [&](const std::string &trimmed) -> bool {
-        if (trimmed.empty()) return false;
-        if (starts_with(trimmed, "class ") || starts_with(trimmed, "struct ")) return true;
-        if (starts_with(trimmed, "function ") || trimmed.find(" function ") != std::string::npos) return true;
-        
-        if (trimmed.find('(') != std::string::npos && trimmed.find(')') != std::string::npos) {
-            if (trimmed.find('{') != std::string::npos) return true;
-            if (!trimmed.empty() && trimmed.back() == '{') return true;
-        }
-        
-        if (trimmed.find("=>") != std::string::npos && trimmed.find('{') != std::string::npos) return true;
-        return false;
-    };
-
-    auto is_python_sig = [&](const std::string &trimmed) -> bool {
-        if (starts_with(trimmed, "def ") || starts_with(trimmed, "class ")) return true;
-        return false;
-    };
-
     for (size_t i = 0; i < lines.size(); ++i) {
         std::string trimmed = trim(lines[i]);
         bool matched = false;
         if (ext == "py") {
-            if (is_python_sig(trimmed)) matched = true;
+            if (isPythonSignature(trimmed)) matched = true;
         } else {
-            if (is_c_like_sig(trimmed)) matched = true;
+            if (isCLikeSignature(trimmed)) matched = true;
         }
         if (!matched) continue;
 
@@ -155,7 +156,8 @@ std::string Compressor::process(const std::string &content,
                                       bool removeComments,
                                       bool removeEmptyLines) {
     std::string data = content;
-    if (removeComments) data = stripComments(data);
+    // other languages have other comment syntax, or none: leave them alone
+    if (removeComments && hasCStyleComments(path)) data = stripComments(data);
     if (removeEmptyLines) {
         std::istringstream iss(data);
         std::ostringstream oss;
@@ -169,6 +171,10 @@ std::string Compressor::process(const std::string &content,
     }
     if (!compress) return data;
 
+    // config/data files have no signatures; hand them to the structured backends instead
+    auto kind = StructuredMinifier::detect(path);
+    if (kind != StructuredMinifier::Kind::None) return StructuredMinifier::process(kind, data, path);
+
     auto chunks = extractChunks(data, extension(path));
     if (chunks.empty()) {
         if (!data.empty() && data.back() != '\n') data.push_back('\n');
@@ -192,11 +198,33 @@ std::string rcpack::Compressor::extension(const std::string &path) {
     return toLower(ext);
 }
 
+bool Compressor::hasCStyleComments(const std::string &path) {
+    static const std::unordered_set<std::string> exts = {
+        "c", "h", "cc", "cpp", "cxx", "c++", "hh", "hpp", "hxx", "h++", "ipp", "inl", "tpp", "cu", "m", "mm",
+        "cs", "java", "kt", "kts", "scala", "groovy", "gradle", "swift", "dart", "go", "rs", "zig",
+        "js", "jsx", "mjs", "cjs", "ts", "tsx", "mts", "cts", "php", "proto", "css", "scss", "less", "jsonc"
+    };
+    auto pos = path.find_last_of('.');
+    return pos != std::string::npos && exts.count(toLower(path.substr(pos + 1))) != 0;
+}
+
 std::string rcpack::Compressor::stripComments(const std::string &s) {
     std::string out;
     out.reserve(s.size());
     bool inBlock = false, inLine = false;
     for (size_t i = 0; i < s.size(); ++i) {
+        if (!inBlock && !inLine && (s[i] == '"' || s[i] == '`' || s[i] == '\'')) {
+            // string and character literals are copied as they are; a quote that does not
+            // close on its line (a Rust lifetime, an apostrophe) is just a character
+            const char quote = s[i];
+            size_t end = i + 1;
+            while (end < s.size() && s[end] != quote && (s[end] != '\n' || quote == '`')) end += s[end] == '\\' ? 2 : 1;
+            if (end < s.size() && s[end] == quote) {
+                out.append(s, i, end - i + 1);
+                i = end;
+                continue;
+            }
+        }
         if (!inBlock && !inLine && i + 1 < s.size() && s[i] == '/' && s[i + 1] == '/') {
             inLine = true; ++i; continue;
         }
@@ -209,3 +237,167 @@ std::string rcpack::Compressor::stripComments(const std::string &s) {
     }
     return out;
 }
+
+static bool isIdentChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+// identifier (possibly qualified with :: or ~) ending right before pos, skipping spaces
+static std::string identifierBefore(const std::string &s, size_t pos) {
+    size_t end = pos;
+    while (end > 0 && std::isspace(static_cast<unsigned char>(s[end - 1]))) --end;
+    size_t start = end;
+    while (start > 0 && (isIdentChar(s[start - 1]) || s[start - 1] == ':' || s[start - 1] == '~')) --start;
+    while (start < end && s[start] == ':') ++start;
+    return s.substr(start, end - start);
+}
+
+static std::string identifierAfter(const std::string &s, size_t pos) {
+    while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) ++pos;
+    size_t end = pos;
+    while (end < s.size() && isIdentChar(s[end])) ++end;
+    return s.substr(pos, end - pos);
+}
+
+void Compressor::extractSymbols(const std::string &content, const std::string &path, SymbolTable &out) {
+    static const std::unordered_set<std::string> notNames = {
+        "if", "for", "while", "switch", "catch", "return", "else", "do", "sizeof", "new", "delete",
+        "throw", "function", "await", "typeof", "foreach", "using", "lock", "synchronized"
+    };
+    const std::string ext = extension(path);
+    if (StructuredMinifier::detect(path) != StructuredMinifier::Kind::None) return;
+
+    auto lines = split_lines(content);
+
+    if (ext == "py") {
+        struct Scope { size_t indent; int32_t row; };
+        std::vector<Scope> scopes;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::string t = trim(lines[i]);
+            if (!isPythonSignature(t)) continue;
+            size_t indent = lines[i].find_first_not_of(" \t");
+            while (!scopes.empty() && scopes.back().indent >= indent) scopes.pop_back();
+            bool isClass = starts_with(t, "class ");
+            std::string name = identifierAfter(t, isClass ? 6 : 4);
+            if (name.empty()) continue;
+            int32_t parent = scopes.empty() ? -1 : scopes.back().row;
+            SymbolKind kind = isClass ? SymbolKind::Class
+                : (parent >= 0 && out.kind(parent) == SymbolKind::Class ? SymbolKind::Method : SymbolKind::Function);
+            size_t row = out.add(name, kind, 0, static_cast<uint32_t>(i + 1), parent);
+            scopes.push_back({indent, static_cast<int32_t>(row)});
+        }
+        return;
+    }
+
+    std::vector<size_t> offsets(lines.size() + 1, 0);
+    for (size_t i = 0; i < lines.size(); ++i) offsets[i + 1] = offsets[i] + lines[i].size() + 1;
+
+    // open class/function bodies as (closing brace offset, row, isFunction)
+    struct Scope { size_t end; int32_t row; bool function; };
+    std::vector<Scope> scopes;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::string t = trim(lines[i]);
+        if (!isCLikeSignature(t) || line_is_comment_only(t)) continue;
+        if (t[0] == ':' || t[0] == ',') continue; // constructor initializer list
+        size_t pos = offsets[i];
+        while (!scopes.empty() && scopes.back().end < pos) scopes.pop_back();
+        // anything inside a function body is a call or local lambda, not an API symbol
+        if (!scopes.empty() && scopes.back().function) continue;
+
+        SymbolKind kind = SymbolKind::Function;
+        std::string name;
+        if (starts_with(t, "class ") || starts_with(t, "struct ")) {
+            if (t.back() == ';' && t.find('{') == std::string::npos) continue; // forward declaration
+            kind = t[0] == 'c' ? SymbolKind::Class : SymbolKind::Struct;
+            name = identifierAfter(t, kind == SymbolKind::Class ? 6 : 7);
+        } else if (starts_with(t, "function ")) {
+            name = identifierAfter(t, 9);
+        } else if (t.find(" function ") != std::string::npos) {
+            name = identifierAfter(t, t.find(" function ") + 10);
+        } else {
+            size_t arrow = t.find("=>");
+            size_t paren = t.find('(');
+            size_t assign = t.find(" = ");
+            if (arrow != std::string::npos && assign != std::string::npos && assign < arrow && (paren == std::string::npos || assign < paren)) {
+                name = identifierBefore(t, assign);
+            } else if (paren != std::string::npos) {
+                name = identifierBefore(t, paren);
+            }
+        }
+        if (name.empty() || notNames.count(name)) continue;
+
+        int32_t parent = scopes.empty() ? -1 : scopes.back().row;
+        if (kind == SymbolKind::Function && parent >= 0) kind = SymbolKind::Method;
+        size_t row = out.add(name, kind, 0, static_cast<uint32_t>(i + 1), parent);
+
+        size_t brace = std::string::npos;
+        for (size_t b = pos; b < content.size(); ++b) {
+            if (content[b] == '{') { brace = b; break; }
+            if (content[b] == ';') break;
+        }
+        if (brace == std::string::npos) continue;
+        size_t close = find_matching_brace_safe(content, brace);
+        if (close == std::string::npos) close = content.size();
+        scopes.push_back({close, static_cast<int32_t>(row), kind == SymbolKind::Function || kind == SymbolKind::Method});
+    }
+}
+
+void Compressor::levelFlags(CompressionLevel level, bool &compress, bool &removeComments, bool &removeEmptyLines) {
+    compress = level == CompressionLevel::SignaturesWithComments || level == CompressionLevel::SignaturesOnly;
+    removeComments = level == CompressionLevel::NoComments || level == CompressionLevel::NoBlankLines
+                  || level == CompressionLevel::SignaturesOnly;
+    removeEmptyLines = level == CompressionLevel::NoBlankLines || level == CompressionLevel::SignaturesOnly;
+}
+
+std::string Compressor::process(const std::string &content, const std::string &path, CompressionLevel level) {
+    if (level == CompressionLevel::NameOnly) return "";
+    bool compress, removeComments, removeEmptyLines;
+    levelFlags(level, compress, removeComments, removeEmptyLines);
+    return process(content, path, compress, removeComments, removeEmptyLines);
+}
+
+std::array<size_t, COMPRESSION_LEVEL_COUNT> Compressor::estimateLevelSizes(const std::string &content, const std::string &path) {
+    std::array<size_t, COMPRESSION_LEVEL_COUNT> est{};
+    const size_t full = content.size();
+    const std::string ext = extension(path);
+
+    // comment bytes exactly as process() removes them; then one pass for blank and signature lines
+    size_t commentBytes = hasCStyleComments(path) ? full - stripComments(content).size() : 0;
+    size_t blankBytes = 0, sigBytes = 0, sigCount = 0;
+    size_t lineStart = 0;
+    for (size_t i = 0; i <= content.size(); ++i) {
+        if (i == content.size() || content[i] == '\n') {
+            size_t len = i - lineStart;
+            std::string t = trim(content.substr(lineStart, len));
+            if (t.empty()) blankBytes += len + 1;
+            else if (ext == "py" ? isPythonSignature(t) : isCLikeSignature(t)) {
+                sigBytes += t.size();
+                ++sigCount;
+            }
+            lineStart = i + 1;
+        }
+    }
+
+    est[static_cast<size_t>(CompressionLevel::Full)] = full;
+    size_t noComments = full - std::min(full, commentBytes);
+    est[static_cast<size_t>(CompressionLevel::NoComments)] = noComments;
+    size_t noBlank = noComments - std::min(noComments, blankBytes);
+    est[static_cast<size_t>(CompressionLevel::NoBlankLines)] = noBlank;
+
+    if (StructuredMinifier::detect(path) != StructuredMinifier::Kind::None) {
+        // minified data typically keeps about a third of the text
+        est[static_cast<size_t>(CompressionLevel::SignaturesWithComments)] = full / 3;
+        est[static_cast<size_t>(CompressionLevel::SignaturesOnly)] = full / 3;
+    } else if (sigCount == 0) {
+        // compress falls back to the (cleaned) text when it finds no signatures
+        est[static_cast<size_t>(CompressionLevel::SignaturesWithComments)] = full;
+        est[static_cast<size_t>(CompressionLevel::SignaturesOnly)] = noBlank;
+    } else {
+        // each snippet gets a " { /* ... */ }" body and a separator line
+        size_t sigsOnly = sigBytes + sigCount * 22;
+        est[static_cast<size_t>(CompressionLevel::SignaturesWithComments)] = std::min(full, sigsOnly + commentBytes / 2);
+        est[static_cast<size_t>(CompressionLevel::SignaturesOnly)] = std::min(noBlank, sigsOnly);
+    }
+    est[static_cast<size_t>(CompressionLevel::NameOnly)] = 0;
+    return est;
+}
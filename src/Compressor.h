@@ -1,9 +1,15 @@
 #pragma once
 #include "utils.h"
+#include "SymbolTable.h"
+#include "Config.h"
+#include <array>
 #include <string>
 #include <vector>
 
 namespace rcpack {
+    // Bump whenever process() output changes for the same input so cached results are invalidated.
+    const unsigned COMPRESSOR_VERSION = 3;
+
     class Compressor {
     public:
         Compressor() = default;
@@ -15,7 +21,24 @@ namespace rcpack {
                             bool removeComments,
                             bool removeEmptyLines);
 
+        // Same as above with the flags implied by a planner level (NameOnly yields "").
+        std::string process(const std::string &content, const std::string &path, CompressionLevel level);
+        static void levelFlags(CompressionLevel level, bool &compress, bool &removeComments, bool &removeEmptyLines);
+        // Languages whose comments stripComments understands (// and /* */); removeComments
+        // leaves every other file untouched.
+        static bool hasCStyleComments(const std::string &path);
+
+        // Approximate output size in bytes at every level, from one scan of the content.
+        // Cheap enough to run on every file; exact sizes would need process() per level.
+        std::array<size_t, COMPRESSION_LEVEL_COUNT> estimateLevelSizes(const std::string &content, const std::string &path);
+
+        // Adds the functions/classes found by the same signature detection as compress mode.
+        // Rows use file index 0; SymbolTable::append assigns the real index when merging.
+        void extractSymbols(const std::string &content, const std::string &path, SymbolTable &out);
+
     private:
+        static bool isCLikeSignature(const std::string &trimmed);
+        static bool isPythonSignature(const std::string &trimmed);
         std::string extension(const std::string &path);
         std::string stripComments(const std::string &s);
         std::vector<std::string> extractChunks(const std::string &s, const std::string &ext);
@@ -2,21 +2,56 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 
 namespace rcpack {
-    
+
+    // Per-file reduction steps chosen by the --max-tokens planner, largest output first.
+    enum class CompressionLevel { Full, NoComments, NoBlankLines, SignaturesWithComments, SignaturesOnly, NameOnly };
+    constexpr size_t COMPRESSION_LEVEL_COUNT = 6;
+
+    // --format: the markdown document, records for other programs (see RecordWriter), or an
+    // indexed .rcpk container (see PackFile.h).
+    enum class OutputFormat { Markdown, Json, Jsonl, MsgPack, Pack };
+
     class Config {
     public:
         std::vector<std::string> c_paths{};
         std::string c_outputFile{};
         std::vector<std::string> c_includePatterns{};
         std::vector<std::string> c_excludePatterns{};
+        std::string c_cacheDir{};
         bool showHelp = false;
         bool showVersion = false;
         bool showRecent = false;
+        std::string c_sinceRef{}; // only files changed in the working tree since the merge base with this ref
+        bool staged = false;      // only files whose index version differs from HEAD
+        bool diffHunks = false;   // with c_sinceRef/staged: append a unified diff to every file section
+        std::string c_rev{};      // package this commit from the object database instead of the working tree
         bool dirsOnly = false;
         bool removeComments = false;  //TODO
         bool removeEmptyLines = false; //TODO
         bool compress = false;
+        bool dedup = false;      // replace files identical to an earlier one with a reference
+        bool nearDedup = false;  // also replace near-identical files (implies dedup)
+        bool commonPreamble = false; // print shared leading blocks once instead of per file
+        bool symbols = false;        // print a repository-wide "Symbols" section
+        std::string c_symbolsJson{}; // also write the symbol index as JSON to this file
+        std::string c_query{};   // keep only files matching this text, best BM25 match first
+        size_t queryTop = 0;     // with c_query: keep at most this many files; 0 = no limit
+        std::vector<std::string> c_focus{}; // package only these files and their include/import neighbourhood
+        size_t focusDepth = 1;   // edges to follow from the focus files, in either direction
+        size_t maxTokens = 0;    // 0 = no budget; otherwise pick a CompressionLevel per file to fit
+        std::string c_tokenizerVocab{}; // tiktoken-format ranks file for exact counts; empty = approximate
+        bool tokenCounts = false;  // show the token count next to every file header
+        bool sortByTokens = false; // print file sections largest token count first
+        OutputFormat format = OutputFormat::Markdown;
+        bool packLz4 = true;     // .rcpk: LZ4-compress the content blocks that shrink
+        bool extract = false;    // "extract <pack> [path]": c_paths holds the pack and the file to print
+        size_t splitMaxBytes = 0;  // markdown: roll over to the next numbered -o shard past this size; 0 = one file
+        size_t splitMaxTokens = 0; // ...or past this many tokens of file content
+        bool incremental = false;  // patch the previous -o output using its .rcidx side index
+        size_t window = 64; // streaming output: files loaded ahead of the one being written
+        size_t jobs = 0; // worker threads for reading/compressing; 0 = hardware concurrency
     };
 }
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "ContentPipeline.h"
+#include "Compressor.h"
+#include "ThreadPool.h"
+#include "Hash.h"
+#include "PreambleDetector.h"
+#include "BudgetPlanner.h"
+#include "DependencyGraph.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+using namespace rcpack;
+
+// cache entries holding only loadRaw's counts (no text)
+static constexpr unsigned RAW_COUNTS = 1u << 7;
+
+static unsigned flagBits(bool compress, bool removeComments, bool removeEmptyLines) {
+    return (compress ? 1u : 0u) | (removeComments ? 2u : 0u) | (removeEmptyLines ? 4u : 0u) | (COMPRESSOR_VERSION << 8);
+}
+
+ContentPipeline::ContentPipeline(const Config &cfg, size_t maxBytes, CompressionCache *cache)
+    : cp_cfg(cfg), cp_reader(maxBytes), cp_maxBytes(maxBytes), cp_cache(cache) {
+    cp_optionFlags = flagBits(cfg.compress, cfg.removeComments, cfg.removeEmptyLines);
+}
+
+void ContentPipeline::finish(FileContent &fc) const {
+    fc.hash = hashString(fc.content);
+    // first pass of preamble detection runs here so the corpus pass only touches hashes
+    if (cp_cfg.commonPreamble) fc.prefixHashes = PreambleDetector::prefixHashes(fc.content);
+}
+
+bool ContentPipeline::wantSymbols() const {
+    return cp_cfg.symbols || !cp_cfg.c_symbolsJson.empty();
+}
+
+FileContent ContentPipeline::load(const FileEntry &fe) const {
+    try {
+        return loadUnchecked(fe);
+    } catch (const std::exception &e) {
+        return unreadable(fe, e);
+    }
+}
+
+FileContent ContentPipeline::unreadable(const FileEntry &fe, const std::exception &e) {
+    std::cerr << "Error: cannot read " << fe.path << " -> " << e.what() << "\n";
+    FileContent fc;
+    fc.unreadable = true;
+    return fc;
+}
+
+FileContent ContentPipeline::loadUnchecked(const FileEntry &fe) const {
+    uint64_t key = 0;
+    bool cacheable = cp_cache && !cp_source && CompressionCache::keyFor(fe.path, cp_optionFlags, cp_maxBytes, key);
+    Compressor compressor;
+    FileContent fc;
+    bool hasSymbols = false;
+    if (cacheable && cp_cache->lookup(key, fc, wantSymbols() ? &hasSymbols : nullptr)) {
+        if (wantSymbols() && !hasSymbols) {
+            // stored by a run without symbols: they need the original lines, so keep them from now on
+            compressor.extractSymbols(cp_reader.readFile(fe.path).content, fe.path.string(), fc.symbols);
+            cp_cache->store(key, fc, true);
+        }
+        finish(fc);
+        return fc;
+    }
+
+    fc = cp_reader.readFile(fe.path);
+    fc.sourceHash = hashString(fc.content);
+    if (wantSymbols()) compressor.extractSymbols(fc.content, fe.path.string(), fc.symbols);
+    // Run optional compression / cleanup before storing
+    fc.content = compressor.process(
+        fc.content,
+        fe.path.string(),
+        cp_cfg.compress,
+        cp_cfg.removeComments,
+        cp_cfg.removeEmptyLines
+    );
+    if (cacheable) cp_cache->store(key, fc, wantSymbols());
+    finish(fc);
+    return fc;
+}
+
+void ContentPipeline::processAtLevel(const FileEntry &fe, FileContent &fc, CompressionLevel level) const {
+    fc.level = level;
+    if (level == CompressionLevel::NameOnly) {
+        fc.content.clear();
+        finish(fc);
+        return;
+    }
+    // user flags still apply on top of whatever the planner picked
+    bool compress, removeComments, removeEmptyLines;
+    Compressor::levelFlags(level, compress, removeComments, removeEmptyLines);
+    compress |= cp_cfg.compress;
+    removeComments |= cp_cfg.removeComments;
+    removeEmptyLines |= cp_cfg.removeEmptyLines;
+
+    uint64_t key = 0;
+    bool cacheable = cp_cache && !cp_source && CompressionCache::keyFor(fe.path, flagBits(compress, removeComments, removeEmptyLines), cp_maxBytes, key);
+    FileContent cached;
+    if (cacheable && cp_cache->lookup(key, cached)) {
+        fc.content = std::move(cached.content);
+    } else {
+        Compressor compressor;
+        fc.content = compressor.process(fc.content, fe.path.string(), compress, removeComments, removeEmptyLines);
+        if (cacheable) cp_cache->store(key, fc);
+    }
+    finish(fc);
+}
+
+void ContentPipeline::forEachFile(const std::vector<FileEntry> &files, size_t maxInFlightBytes,
+                                  const std::function<void(size_t)> &work) const {
+    size_t jobs = cp_cfg.jobs == 0 ? ThreadPool::defaultThreads() : cp_cfg.jobs;
+    if (jobs <= 1 || files.size() <= 1) {
+        for (size_t i = 0; i < files.size(); ++i) work(i);
+        return;
+    }
+
+    ThreadPool pool(std::min(jobs, files.size()));
+    ByteBudget budget(maxInFlightBytes);
+    for (size_t i = 0; i < files.size(); ++i) {
+        // reads are capped at cp_maxBytes, so that is the most a single file can hold
+        size_t cost = static_cast<size_t>(std::min<uintmax_t>(files[i].size, cp_maxBytes)) + 1;
+        budget.acquire(cost);
+        pool.submit([&work, &budget, i, cost] {
+            try {
+                work(i);
+            } catch (...) {
+                budget.release(cost);
+                throw;
+            }
+            budget.release(cost);
+        });
+    }
+    pool.wait();
+}
+
+std::vector<FileContent> ContentPipeline::loadAll(const std::vector<FileEntry> &files,
+                                                  size_t maxInFlightBytes) const {
+    std::vector<FileContent> contents(files.size());
+    forEachFile(files, maxInFlightBytes, [&](size_t i) { contents[i] = load(files[i]); });
+    return contents;
+}
+
+std::vector<FileContent> ContentPipeline::loadWithinBudget(const std::vector<FileEntry> &files,
+                                                           const std::vector<double> &relevance,
+                                                           const std::vector<std::string> &relPaths,
+                                                           size_t &plannedTokens,
+                                                           size_t maxInFlightBytes) const {
+    // pass 1: read everything once and estimate every level from that single read
+    std::vector<FileContent> contents(files.size());
+    std::vector<BudgetItem> items(files.size());
+    forEachFile(files, maxInFlightBytes, [&](size_t i) {
+        Compressor compressor;
+        std::array<size_t, COMPRESSION_LEVEL_COUNT> bytes{};
+        try {
+            contents[i] = cp_reader.readFile(files[i].path);
+            contents[i].sourceHash = hashString(contents[i].content);
+            if (wantSymbols()) compressor.extractSymbols(contents[i].content, files[i].path.string(), contents[i].symbols);
+            bytes = compressor.estimateLevelSizes(contents[i].content, files[i].path.string());
+        } catch (const std::exception &e) {
+            contents[i] = unreadable(files[i], e);
+        }
+        size_t framing = BudgetPlanner::framingTokens(i < relPaths.size() ? relPaths[i] : files[i].path.generic_string());
+        for (size_t l = 0; l < COMPRESSION_LEVEL_COUNT; ++l) items[i].tokens[l] = framing + BudgetPlanner::estimateTokens(bytes[l]);
+        items[i].relevance = i < relevance.size() ? relevance[i] : 1.0;
+    });
+
+    CompressionLevel minLevel = CompressionLevel::Full;
+    if (cp_cfg.compress) minLevel = cp_cfg.removeComments ? CompressionLevel::SignaturesOnly : CompressionLevel::SignaturesWithComments;
+    else if (cp_cfg.removeComments) minLevel = cp_cfg.removeEmptyLines ? CompressionLevel::NoBlankLines : CompressionLevel::NoComments;
+    // the header and the Structure tree are paid regardless of the levels chosen
+    size_t fixed = BudgetPlanner::headerTokens(relPaths);
+    size_t budget = cp_cfg.maxTokens > fixed ? cp_cfg.maxTokens - fixed : 0;
+    auto levels = BudgetPlanner::plan(items, budget, minLevel, plannedTokens);
+    plannedTokens += fixed;
+
+    // pass 2: apply the chosen level to the text read in pass 1
+    forEachFile(files, maxInFlightBytes, [&](size_t i) {
+        if (contents[i].unreadable) return;
+        try {
+            processAtLevel(files[i], contents[i], levels[i]);
+        } catch (const std::exception &e) {
+            contents[i] = unreadable(files[i], e);
+        }
+    });
+    return contents;
+}
+
+bool ContentPipeline::loadRaw(const FileEntry &fe, FileContent &fc, const Tokenizer *tokenizer) const {
+    // with a cache, an unchanged file is never read here: only the sink copies its bytes
+    uint64_t key = 0;
+    uintmax_t size = 0;
+    bool cacheable = cp_cache && CompressionCache::keyFor(fe.path, cp_optionFlags | RAW_COUNTS, cp_maxBytes, key, &size);
+    if (cacheable) {
+        key = hashCombine(key, tokenizer ? tokenizer->vocabHash() + 1 : 0);
+        if (cp_cache->lookup(key, fc)) {
+            fc.rawBytes = static_cast<size_t>(std::min<uintmax_t>(size, cp_maxBytes));
+            return true;
+        }
+    }
+
+    MappedFile file;
+    if (!file.open(fe.path)) return false;
+    // mirror FileReader: over the limit -> the first cp_maxBytes bytes as they are;
+    // otherwise line by line, which only differs from the bytes if the last newline is missing
+    bool truncated = file.size() > cp_maxBytes;
+    size_t len = truncated ? cp_maxBytes : file.size();
+    std::string_view text(file.data() ? file.data() : "", len);
+    if (!truncated && !text.empty() && text.back() != '\n') return false;
+
+    fc = FileContent();
+    fc.truncated = truncated;
+    fc.lines = static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+    if (tokenizer) fc.tokens = tokenizer->count(text);
+    if (cacheable && file.size() == size) cp_cache->store(key, fc);
+    fc.rawBytes = len;
+    return true;
+}
+
+FileContent ContentPipeline::loadStreamed(const FileEntry &fe, const Tokenizer *tokenizer) const {
+    FileContent fc;
+    if (cp_passthrough && loadRaw(fe, fc, tokenizer)) return fc;
+    fc = load(fe);
+    if (tokenizer) fc.tokens = tokenizer->count(fc.content);
+    return fc;
+}
+
+std::vector<std::vector<std::string>> ContentPipeline::collectImports(const std::vector<FileEntry> &files) const {
+    std::vector<std::vector<std::string>> imports(files.size());
+    forEachFile(files, 64 * 1024 * 1024, [&](size_t i) {
+        DependencyGraph::extractImports(cp_reader.readFile(files[i].path).content, files[i].path.generic_string(), imports[i]);
+    });
+    return imports;
+}
+
+void ContentPipeline::countTokens(const std::vector<FileEntry> &files, std::vector<FileContent> &contents,
+                                  const Tokenizer &tokenizer) const {
+    // contents are already in memory, so the byte budget only shapes the work split
+    forEachFile(files, SIZE_MAX, [&](size_t i) {
+        if (i >= contents.size()) return;
+        auto &fc = contents[i];
+        fc.tokens = (fc.duplicateOf || fc.level == CompressionLevel::NameOnly) ? 0 : tokenizer.count(fc.content);
+    });
+}
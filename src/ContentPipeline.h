@@ -0,0 +1,89 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "FileReader.h"
+#include "RepositoryScanner.h"
+#include "CompressionCache.h"
+#include "Tokenizer.h"
+
+namespace rcpack {
+
+    // Read + Compressor::process stage for scanned files, optionally backed by the on-disk cache.
+    class ContentPipeline {
+        const Config &cp_cfg;
+        FileReader cp_reader;
+        size_t cp_maxBytes;
+        CompressionCache *cp_cache;
+        unsigned cp_optionFlags;
+        bool cp_passthrough = false;
+        const ContentSource *cp_source = nullptr;
+        // per-file bookkeeping shared by the cached and uncached paths
+        void finish(FileContent &fc) const;
+        bool wantSymbols() const;
+        FileContent loadUnchecked(const FileEntry &fe) const;
+        // what a file that failed to load (an exception from reading or processing) becomes
+        static FileContent unreadable(const FileEntry &fe, const std::exception &e);
+        // runs work(i) for every file on cfg.jobs threads, bounded by maxInFlightBytes
+        void forEachFile(const std::vector<FileEntry> &files, size_t maxInFlightBytes,
+                         const std::function<void(size_t)> &work) const;
+        // loadStreamed() with passthrough: fills lines/tokens and rawBytes without reading the file
+        // into content. The counts come from the cache when it has them; otherwise they take one
+        // pass over a mapping of the file (and are cached). False when the text would differ
+        // from the raw bytes (missing final newline), in which case the caller loads normally.
+        bool loadRaw(const FileEntry &fe, FileContent &fc, const Tokenizer *tokenizer) const;
+        // compresses already-read content in place at a planner level
+        void processAtLevel(const FileEntry &fe, FileContent &fc, CompressionLevel level) const;
+    public:
+        ContentPipeline(const Config &cfg, size_t maxBytes, CompressionCache *cache = nullptr);
+
+        // Thread-safe: every call uses its own Compressor. A file that cannot be read comes
+        // back empty with FileContent::unreadable set.
+        FileContent load(const FileEntry &fe) const;
+
+        // Loads every file on a fixed pool of cfg.jobs threads. Result i belongs to files[i],
+        // so output order does not depend on scheduling. At most maxInFlightBytes of input
+        // is being read/processed at any time.
+        std::vector<FileContent> loadAll(const std::vector<FileEntry> &files,
+                                         size_t maxInFlightBytes = 64 * 1024 * 1024) const;
+
+        // --max-tokens mode: reads every file once, estimates its size at each CompressionLevel,
+        // lets BudgetPlanner choose levels (least relevant files degrade first) and applies them.
+        // plannedTokens receives the estimated total of the chosen plan.
+        std::vector<FileContent> loadWithinBudget(const std::vector<FileEntry> &files,
+                                                  const std::vector<double> &relevance,
+                                                  const std::vector<std::string> &relPaths,
+                                                  size_t &plannedTokens,
+                                                  size_t maxInFlightBytes = 64 * 1024 * 1024) const;
+
+        // Lets loadStreamed() leave unprocessed file text on disk for the sink to copy. Has no effect
+        // when any option rewrites contents (compression, comment or blank-line removal).
+        void setPassthrough(bool on) {
+            cp_passthrough = on && !cp_source && !cp_cfg.compress && !cp_cfg.removeComments && !cp_cfg.removeEmptyLines;
+        }
+        // Reads file text from source (not owned) instead of the file system. The cache and
+        // passthrough, which both work on the files on disk, are not used then.
+        void setSource(const ContentSource *source) {
+            cp_source = source;
+            cp_reader.setSource(source);
+            if (source) cp_passthrough = false;
+        }
+
+        // One file for streamed output (see runOrdered): load() plus its token count, or
+        // with passthrough just the counts and rawBytes. Thread-safe.
+        FileContent loadStreamed(const FileEntry &fe, const Tokenizer *tokenizer) const;
+        size_t jobs() const { return cp_cfg.jobs; }
+
+        // Reads every file (in parallel) and returns the #include/import/require specifiers
+        // found in it, for DependencyGraph::build. Index i belongs to files[i].
+        std::vector<std::vector<std::string>> collectImports(const std::vector<FileEntry> &files) const;
+
+        // Fills FileContent::tokens for every file in parallel. Run after the corpus passes
+        // (dedup, preambles) so the counts match what the formatter prints.
+        void countTokens(const std::vector<FileEntry> &files, std::vector<FileContent> &contents,
+                         const Tokenizer &tokenizer) const;
+    };
+}
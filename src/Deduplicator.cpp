@@ -0,0 +1,100 @@
+#include "Deduplicator.h"
+#include "Hash.h"
+#include "utils.h"
+#include <unordered_map>
+
+using namespace rcpack;
+
+// files with fewer meaningful lines than this are too small to call "similar"
+static constexpr size_t MIN_NEAR_DUP_LINES = 8;
+
+static int popcount64(uint64_t v) {
+    int n = 0;
+    while (v) { v &= v - 1; ++n; }
+    return n;
+}
+
+size_t Deduplicator::markDuplicates(std::vector<FileContent> &contents) {
+    std::unordered_map<uint64_t, std::vector<size_t>> firstByHash;
+    size_t marked = 0;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        auto &fc = contents[i];
+        // a truncated text says nothing about the rest of the file
+        if (fc.content.empty() || fc.duplicateOf || fc.truncated) continue;
+        auto &bucket = firstByHash[fc.hash];
+        bool found = false;
+        for (size_t j : bucket) {
+            // compare bytes too: equal hashes are only a strong hint. Compressed or reduced
+            // texts can match while the files differ, so the original texts must match too.
+            if (contents[j].sourceHash == fc.sourceHash && contents[j].content == fc.content) {
+                fc.duplicateOf = j;
+                fc.nearDuplicate = false;
+                fc.similarity = 1.0;
+                ++marked;
+                found = true;
+                break;
+            }
+        }
+        if (!found) bucket.push_back(i);
+    }
+    return marked;
+}
+
+uint64_t Deduplicator::simhash(const std::string &content, size_t shingleLines) {
+    std::vector<uint64_t> lineHashes;
+    for (auto &line : split_lines(content)) {
+        std::string t = trim(line);
+        if (!t.empty()) lineHashes.push_back(hashString(t));
+    }
+    if (lineHashes.empty()) return 0;
+    if (shingleLines == 0) shingleLines = 1;
+    size_t shingles = lineHashes.size() >= shingleLines ? lineHashes.size() - shingleLines + 1 : 1;
+
+    int votes[64] = {0};
+    for (size_t s = 0; s < shingles; ++s) {
+        uint64_t h = lineHashes[s];
+        for (size_t k = 1; k < shingleLines && s + k < lineHashes.size(); ++k) h = hashCombine(h, lineHashes[s + k]);
+        for (int b = 0; b < 64; ++b) votes[b] += ((h >> b) & 1) ? 1 : -1;
+    }
+    uint64_t out = 0;
+    for (int b = 0; b < 64; ++b) if (votes[b] > 0) out |= (uint64_t(1) << b);
+    return out;
+}
+
+size_t Deduplicator::markNearDuplicates(std::vector<FileContent> &contents, unsigned maxDistance) {
+    if (maxDistance > 7) maxDistance = 7;
+    std::vector<uint64_t> sigs(contents.size(), 0);
+    std::unordered_map<uint64_t, std::vector<size_t>> bands[8];
+    size_t marked = 0;
+
+    for (size_t i = 0; i < contents.size(); ++i) {
+        auto &fc = contents[i];
+        if (fc.duplicateOf || fc.lines < MIN_NEAR_DUP_LINES) continue;
+        sigs[i] = simhash(fc.content);
+
+        // any signature within 7 bits agrees with ours on at least one 8-bit band
+        size_t best = contents.size();
+        int bestDist = 65;
+        for (int b = 0; b < 8; ++b) {
+            uint64_t band = (sigs[i] >> (8 * b)) & 0xff;
+            auto it = bands[b].find(band);
+            if (it == bands[b].end()) continue;
+            for (size_t j : it->second) {
+                int d = popcount64(sigs[i] ^ sigs[j]);
+                if (d <= static_cast<int>(maxDistance) && (d < bestDist || (d == bestDist && j < best))) {
+                    best = j;
+                    bestDist = d;
+                }
+            }
+        }
+        if (best < contents.size()) {
+            fc.duplicateOf = best;
+            fc.nearDuplicate = true;
+            fc.similarity = 1.0 - static_cast<double>(bestDist) / 64.0;
+            ++marked;
+            continue; // only originals become comparison targets
+        }
+        for (int b = 0; b < 8; ++b) bands[b][(sigs[i] >> (8 * b)) & 0xff].push_back(i);
+    }
+    return marked;
+}
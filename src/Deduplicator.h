@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FileReader.h"
+
+namespace rcpack {
+
+    // Cross-file duplicate detection over already-processed contents.
+    // Only later files are marked; the first occurrence is always kept in full.
+    class Deduplicator {
+    public:
+        // Marks files whose content is byte-identical to an earlier file and that were identical
+        // before processing (FileContent::sourceHash). Relies on FileContent::hash. Truncated
+        // files are never marked.
+        static size_t markDuplicates(std::vector<FileContent> &contents);
+
+        // Marks files whose SimHash (over shingles of consecutive lines) is within
+        // maxDistance bits of an earlier file. maxDistance is capped at 7 so the 8x8-bit
+        // banding cannot miss a candidate.
+        static size_t markNearDuplicates(std::vector<FileContent> &contents, unsigned maxDistance = 7);
+
+        static uint64_t simhash(const std::string &content, size_t shingleLines = 3);
+    };
+}
@@ -0,0 +1,566 @@
+#include "Deflate.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <queue>
+
+using namespace rcpack;
+
+namespace {
+    constexpr size_t WINDOW = 32768;
+    constexpr size_t WINDOW_MASK = WINDOW - 1;
+    constexpr unsigned HASH_BITS = 15;
+    constexpr size_t MIN_MATCH = 4;     // shorter matches are found only by accident; 3 is legal
+    constexpr size_t MAX_MATCH = 258;
+    constexpr size_t NICE_MATCH = 128;  // stop searching the chain at this length
+    constexpr unsigned MAX_CHAIN = 32;
+    constexpr size_t BLOCK_SYMBOLS = 16384;
+
+    const uint16_t LEN_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    const uint8_t LEN_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                    513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    struct Tables {
+        std::array<uint8_t, MAX_MATCH + 1> lenCode{}; // length -> index into LEN_BASE
+        std::array<uint8_t, 512> distCode{};          // see distCodeOf
+        std::array<std::array<uint32_t, 256>, 8> crc{};
+        Tables() {
+            for (uint8_t c = 0; c < 29; ++c) {
+                size_t end = c + 1 < 29 ? LEN_BASE[c + 1] : MAX_MATCH + 1;
+                for (size_t l = LEN_BASE[c]; l < end; ++l) lenCode[l] = c;
+            }
+            lenCode[MAX_MATCH] = 28;
+            for (uint8_t c = 0; c < 30; ++c) {
+                size_t end = c + 1 < 30 ? DIST_BASE[c + 1] : 32769;
+                for (size_t d = DIST_BASE[c]; d < end; ++d) {
+                    if (d <= 256) distCode[d - 1] = c;
+                    else distCode[256 + ((d - 1) >> 7)] = c;
+                }
+            }
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                crc[0][n] = c;
+            }
+            for (uint32_t n = 0; n < 256; ++n) {
+                for (size_t t = 1; t < 8; ++t) crc[t][n] = (crc[t - 1][n] >> 8) ^ crc[0][crc[t - 1][n] & 0xff];
+            }
+        }
+    };
+    const Tables &tables() {
+        static const Tables t;
+        return t;
+    }
+
+    inline unsigned distCodeOf(size_t dist) {
+        const auto &t = tables().distCode;
+        return dist <= 256 ? t[dist - 1] : t[256 + ((dist - 1) >> 7)];
+    }
+
+    inline uint32_t read32(const char *p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t hash4(const char *p) { return (read32(p) * 2654435761u) >> (32 - HASH_BITS); }
+
+    // Huffman code lengths of at most maxBits for freq (0 for unused symbols). When the tree
+    // is too deep the frequencies are halved (kept non-zero) and it is built again.
+    void buildLengths(const uint32_t *freq, size_t n, unsigned maxBits, uint8_t *lengths) {
+        std::vector<uint32_t> f(freq, freq + n);
+        std::fill(lengths, lengths + n, 0);
+        size_t used = 0, last = 0;
+        for (size_t s = 0; s < n; ++s) if (f[s]) { ++used; last = s; }
+        if (used == 0) return;
+        if (used == 1) { lengths[last] = 1; return; }
+        while (true) {
+            using Node = std::pair<uint64_t, uint32_t>; // weight, node id
+            std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+            std::vector<int32_t> parent(2 * n, -1);
+            for (size_t s = 0; s < n; ++s) if (f[s]) heap.emplace(f[s], static_cast<uint32_t>(s));
+            uint32_t next = static_cast<uint32_t>(n);
+            while (heap.size() > 1) {
+                Node a = heap.top(); heap.pop();
+                Node b = heap.top(); heap.pop();
+                parent[a.second] = static_cast<int32_t>(next);
+                parent[b.second] = static_cast<int32_t>(next);
+                heap.emplace(a.first + b.first, next++);
+            }
+            unsigned deepest = 0;
+            for (size_t s = 0; s < n; ++s) {
+                if (!f[s]) continue;
+                unsigned depth = 0;
+                for (int32_t p = parent[s]; p >= 0; p = parent[p]) ++depth;
+                lengths[s] = static_cast<uint8_t>(depth);
+                deepest = std::max(deepest, depth);
+            }
+            if (deepest <= maxBits) return;
+            for (auto &x : f) if (x) x = (x >> 1) | 1;
+        }
+    }
+
+    // Canonical codes for lengths, bit-reversed because deflate sends Huffman codes MSB first.
+    void buildCodes(const uint8_t *lengths, size_t n, uint16_t *codes) {
+        uint16_t count[16] = {}, nextCode[16] = {};
+        for (size_t s = 0; s < n; ++s) count[lengths[s]]++;
+        count[0] = 0;
+        uint16_t code = 0;
+        for (unsigned bits = 1; bits < 16; ++bits) {
+            code = static_cast<uint16_t>((code + count[bits - 1]) << 1);
+            nextCode[bits] = code;
+        }
+        for (size_t s = 0; s < n; ++s) {
+            unsigned len = lengths[s];
+            if (!len) { codes[s] = 0; continue; }
+            uint16_t c = nextCode[len]++, r = 0;
+            for (unsigned b = 0; b < len; ++b) r = static_cast<uint16_t>((r << 1) | ((c >> b) & 1));
+            codes[s] = r;
+        }
+    }
+}
+
+DeflateEncoder::DeflateEncoder() : de_head(size_t(1) << HASH_BITS, -1), de_prev(WINDOW, -1) {
+    de_symbols.reserve(BLOCK_SYMBOLS + 1);
+}
+
+uint32_t DeflateEncoder::crc32(uint32_t crc, const void *data, size_t len) {
+    const auto &t = tables().crc;
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+              t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    while (len--) crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void DeflateEncoder::putBits(std::string &out, uint32_t bits, unsigned n) {
+    de_bits |= static_cast<uint64_t>(bits) << de_bitCount;
+    de_bitCount += n;
+    while (de_bitCount >= 32) {
+        char b[4] = {static_cast<char>(de_bits), static_cast<char>(de_bits >> 8),
+                     static_cast<char>(de_bits >> 16), static_cast<char>(de_bits >> 24)};
+        out.append(b, 4);
+        de_bits >>= 32;
+        de_bitCount -= 32;
+    }
+}
+
+void DeflateEncoder::alignToByte(std::string &out) {
+    putBits(out, 0, (8 - de_bitCount % 8) % 8);
+    while (de_bitCount) {
+        out.push_back(static_cast<char>(de_bits));
+        de_bits >>= 8;
+        de_bitCount -= 8;
+    }
+}
+
+void DeflateEncoder::writeBlock(const char *buf, size_t begin, size_t end, std::string &out) {
+    const auto &tab = tables();
+    uint32_t litFreq[286] = {}, distFreq[30] = {};
+    for (const Symbol &s : de_symbols) {
+        if (s.dist == 0) {
+            litFreq[s.litLen]++;
+        } else {
+            litFreq[257 + tab.lenCode[s.litLen]]++;
+            distFreq[distCodeOf(s.dist)]++;
+        }
+    }
+    litFreq[256] = 1; // end of block
+    bool anyDist = false;
+    for (uint32_t f : distFreq) anyDist |= f != 0;
+    if (!anyDist) distFreq[0] = 1; // decoders expect at least one distance code
+
+    uint8_t litLen[286], distLen[30];
+    buildLengths(litFreq, 286, 15, litLen);
+    buildLengths(distFreq, 30, 15, distLen);
+    size_t nlit = 286, ndist = 30;
+    while (nlit > 257 && litLen[nlit - 1] == 0) --nlit;
+    while (ndist > 1 && distLen[ndist - 1] == 0) --ndist;
+
+    // run-length encode both length tables with the code-length alphabet (16: repeat the
+    // previous length 3-6 times, 17: 3-10 zeros, 18: 11-138 zeros)
+    std::vector<uint8_t> all(litLen, litLen + nlit);
+    all.insert(all.end(), distLen, distLen + ndist);
+    std::vector<std::pair<uint8_t, uint8_t>> rle; // symbol, extra bits value
+    for (size_t i = 0; i < all.size();) {
+        uint8_t l = all[i];
+        size_t run = 1;
+        while (i + run < all.size() && all[i + run] == l) ++run;
+        i += run;
+        if (l == 0) {
+            while (run >= 11) { size_t r = std::min<size_t>(run, 138); rle.emplace_back(18, static_cast<uint8_t>(r - 11)); run -= r; }
+            if (run >= 3) { rle.emplace_back(17, static_cast<uint8_t>(run - 3)); run = 0; }
+        } else {
+            rle.emplace_back(l, 0);
+            --run;
+            while (run >= 3) { size_t r = std::min<size_t>(run, 6); rle.emplace_back(16, static_cast<uint8_t>(r - 3)); run -= r; }
+        }
+        while (run--) rle.emplace_back(l, 0);
+    }
+    uint32_t clFreq[19] = {};
+    for (auto &r : rle) clFreq[r.first]++;
+    uint8_t clLen[19];
+    buildLengths(clFreq, 19, 7, clLen);
+    size_t ncl = 19;
+    while (ncl > 4 && clLen[CODE_LENGTH_ORDER[ncl - 1]] == 0) --ncl;
+
+    // compare with stored blocks before committing to the Huffman coding
+    uint64_t bits = 3 + 5 + 5 + 4 + 3 * ncl;
+    for (auto &r : rle) bits += clLen[r.first] + (r.first == 16 ? 2 : r.first == 17 ? 3 : r.first == 18 ? 7 : 0);
+    for (size_t s = 0; s < 286; ++s) {
+        if (litFreq[s]) bits += static_cast<uint64_t>(litFreq[s]) * (litLen[s] + (s > 256 ? LEN_EXTRA[s - 257] : 0));
+    }
+    for (size_t d = 0; d < 30; ++d) bits += static_cast<uint64_t>(anyDist ? distFreq[d] : 0) * (distLen[d] + DIST_EXTRA[d]);
+    const size_t raw = end - begin;
+    const uint64_t storedBits = (raw + 5 * (raw / 65535 + 1)) * 8 + 8;
+    if (storedBits < bits) {
+        for (size_t at = begin; at < end;) {
+            size_t len = std::min<size_t>(end - at, 65535);
+            putBits(out, 0, 3); // not final, stored
+            alignToByte(out);
+            char hdr[4] = {static_cast<char>(len), static_cast<char>(len >> 8),
+                           static_cast<char>(~len), static_cast<char>((~len) >> 8)};
+            out.append(hdr, 4);
+            out.append(buf + at, len);
+            at += len;
+        }
+        de_symbols.clear();
+        return;
+    }
+
+    uint16_t litCode[286], distCode[30], clCode[19];
+    buildCodes(litLen, 286, litCode);
+    buildCodes(distLen, 30, distCode);
+    buildCodes(clLen, 19, clCode);
+
+    putBits(out, 2 << 1, 3); // not final, dynamic Huffman
+    putBits(out, static_cast<uint32_t>(nlit - 257), 5);
+    putBits(out, static_cast<uint32_t>(ndist - 1), 5);
+    putBits(out, static_cast<uint32_t>(ncl - 4), 4);
+    for (size_t k = 0; k < ncl; ++k) putBits(out, clLen[CODE_LENGTH_ORDER[k]], 3);
+    for (auto &r : rle) {
+        putBits(out, clCode[r.first], clLen[r.first]);
+        if (r.first == 16) putBits(out, r.second, 2);
+        else if (r.first == 17) putBits(out, r.second, 3);
+        else if (r.first == 18) putBits(out, r.second, 7);
+    }
+    for (const Symbol &s : de_symbols) {
+        if (s.dist == 0) {
+            putBits(out, litCode[s.litLen], litLen[s.litLen]);
+            continue;
+        }
+        unsigned lc = tab.lenCode[s.litLen];
+        putBits(out, litCode[257 + lc], litLen[257 + lc]);
+        if (LEN_EXTRA[lc]) putBits(out, s.litLen - LEN_BASE[lc], LEN_EXTRA[lc]);
+        unsigned dc = distCodeOf(s.dist);
+        putBits(out, distCode[dc], distLen[dc]);
+        if (DIST_EXTRA[dc]) putBits(out, s.dist - DIST_BASE[dc], DIST_EXTRA[dc]);
+    }
+    putBits(out, litCode[256], litLen[256]);
+    de_symbols.clear();
+}
+
+void DeflateEncoder::write(std::string_view data, std::string &out) {
+    if (data.empty()) return;
+    // the window of earlier input followed by the new data; positions index this buffer
+    std::string buf;
+    buf.reserve(de_history.size() + data.size());
+    buf += de_history;
+    buf += data;
+    const char *p = buf.data();
+    const size_t end = buf.size();
+
+    std::fill(de_head.begin(), de_head.end(), -1);
+    std::fill(de_prev.begin(), de_prev.end(), -1);
+    auto insert = [&](size_t pos) {
+        uint32_t h = hash4(p + pos);
+        de_prev[pos & WINDOW_MASK] = de_head[h];
+        de_head[h] = static_cast<int32_t>(pos);
+    };
+    for (size_t pos = 0; pos + MIN_MATCH <= de_history.size(); ++pos) insert(pos);
+
+    size_t pos = de_history.size(), blockStart = pos;
+    while (pos < end) {
+        size_t best = 0, bestDist = 0;
+        if (pos + MIN_MATCH <= end) {
+            uint32_t h = hash4(p + pos);
+            int32_t cand = de_head[h];
+            de_prev[pos & WINDOW_MASK] = cand;
+            de_head[h] = static_cast<int32_t>(pos);
+            const size_t maxLen = std::min(MAX_MATCH, end - pos);
+            const uint32_t first = read32(p + pos);
+            for (unsigned chain = MAX_CHAIN; cand >= 0 && pos - static_cast<size_t>(cand) <= WINDOW && chain; --chain) {
+                const char *c = p + cand;
+                if (c[best] == p[pos + best] && read32(c) == first) {
+                    size_t len = MIN_MATCH;
+                    while (len < maxLen && c[len] == p[pos + len]) ++len;
+                    if (len > best) {
+                        best = len;
+                        bestDist = pos - static_cast<size_t>(cand);
+                        if (len >= NICE_MATCH || len == maxLen) break;
+                    }
+                }
+                int32_t next = de_prev[static_cast<size_t>(cand) & WINDOW_MASK];
+                if (next >= cand) break; // slot reused by a newer position: end of this chain
+                cand = next;
+            }
+        }
+        if (best >= MIN_MATCH) {
+            de_symbols.push_back({static_cast<uint16_t>(best), static_cast<uint16_t>(bestDist)});
+            // index the positions inside short matches; long ones are skipped for speed
+            if (best <= 32) {
+                for (size_t k = 1; k < best && pos + k + MIN_MATCH <= end; ++k) insert(pos + k);
+            }
+            pos += best;
+        } else {
+            de_symbols.push_back({static_cast<uint8_t>(p[pos]), 0});
+            ++pos;
+        }
+        if (de_symbols.size() >= BLOCK_SYMBOLS) {
+            writeBlock(p, blockStart, pos, out);
+            blockStart = pos;
+        }
+    }
+    if (!de_symbols.empty()) writeBlock(p, blockStart, pos, out);
+
+    de_history.assign(buf, end > WINDOW ? end - WINDOW : 0, std::string::npos);
+}
+
+void DeflateEncoder::finish(std::string &out) {
+    putBits(out, 1 | (1 << 1), 3); // final, fixed Huffman
+    putBits(out, 0, 7);            // end of block (code 256 is seven zero bits)
+    alignToByte(out);
+}
+
+namespace {
+    constexpr unsigned FAST_BITS = 10;
+
+    // Decoding side of one canonical Huffman code.
+    struct HuffmanTable {
+        uint16_t fast[1u << FAST_BITS]; // next FAST_BITS input bits -> symbol << 4 | length, 0 if longer
+        uint16_t count[16];             // codes per length
+        uint16_t symbols[288];          // symbols ordered by code
+
+        // False for over-subscribed lengths. Incomplete codes are accepted (a single distance
+        // code is legal); their unused bit patterns fail in decode().
+        bool build(const uint8_t *lengths, size_t n) {
+            std::memset(fast, 0, sizeof(fast));
+            std::memset(count, 0, sizeof(count));
+            for (size_t s = 0; s < n; ++s) count[lengths[s]]++;
+            count[0] = 0;
+            int left = 1;
+            for (unsigned len = 1; len < 16; ++len) {
+                left = (left << 1) - count[len];
+                if (left < 0) return false;
+            }
+            uint16_t offs[16] = {};
+            for (unsigned len = 1; len < 15; ++len) offs[len + 1] = static_cast<uint16_t>(offs[len] + count[len]);
+            for (size_t s = 0; s < n; ++s) {
+                if (lengths[s]) symbols[offs[lengths[s]]++] = static_cast<uint16_t>(s);
+            }
+            uint32_t code = 0;
+            size_t index = 0;
+            for (unsigned len = 1; len <= FAST_BITS; ++len, code <<= 1) {
+                for (unsigned k = 0; k < count[len]; ++k, ++index, ++code) {
+                    uint32_t rev = 0; // codes arrive MSB first, the bit buffer is LSB first
+                    for (unsigned b = 0; b < len; ++b) rev |= ((code >> b) & 1) << (len - 1 - b);
+                    for (uint32_t f = rev; f < (1u << FAST_BITS); f += 1u << len) {
+                        fast[f] = static_cast<uint16_t>(symbols[index] << 4 | len);
+                    }
+                }
+            }
+            return true;
+        }
+    };
+
+    // LSB-first bit buffer over the input. Reading past the end feeds zero bytes and counts
+    // them, so truncation is detected once those bits are actually used.
+    struct BitReader {
+        const unsigned char *begin, *p, *end;
+        uint64_t bits = 0;
+        unsigned count = 0;
+        size_t overrun = 0;
+
+        BitReader(std::string_view in)
+            : begin(reinterpret_cast<const unsigned char *>(in.data())), p(begin), end(begin + in.size()) {}
+        void refill() {
+            while (count <= 56) {
+                uint64_t b = 0;
+                if (p < end) b = *p++;
+                else ++overrun;
+                bits |= b << count;
+                count += 8;
+            }
+        }
+        uint32_t peek(unsigned n) {
+            if (count < n) refill();
+            return static_cast<uint32_t>(bits & ((uint64_t(1) << n) - 1));
+        }
+        void drop(unsigned n) { bits >>= n; count -= n; }
+        uint32_t take(unsigned n) {
+            uint32_t v = peek(n);
+            drop(n);
+            return v;
+        }
+        bool truncated() const { return overrun * 8 > count; }
+        size_t consumed() const { return static_cast<size_t>(p - begin) + overrun - count / 8; }
+    };
+
+    int decodeSymbol(BitReader &br, const HuffmanTable &t) {
+        uint32_t e = t.fast[br.peek(FAST_BITS)];
+        if (e) {
+            br.drop(e & 15);
+            return static_cast<int>(e >> 4);
+        }
+        // longer code: walk the canonical ranges one bit at a time
+        int code = 0, first = 0, index = 0;
+        for (unsigned len = 1; len < 16; ++len) {
+            code |= static_cast<int>(br.take(1));
+            int n = t.count[len];
+            if (code - n < first) return t.symbols[index + (code - first)];
+            index += n;
+            first = (first + n) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    struct FixedTables {
+        HuffmanTable lit, dist;
+        FixedTables() {
+            uint8_t lengths[288];
+            std::fill(lengths, lengths + 144, 8);
+            std::fill(lengths + 144, lengths + 256, 9);
+            std::fill(lengths + 256, lengths + 280, 7);
+            std::fill(lengths + 280, lengths + 288, 8);
+            lit.build(lengths, 288);
+            std::fill(lengths, lengths + 30, 5);
+            dist.build(lengths, 30);
+        }
+    };
+
+    // Reads the code lengths of a dynamic block and builds its two tables.
+    bool readDynamicTables(BitReader &br, HuffmanTable &lit, HuffmanTable &dist) {
+        unsigned nlit = br.take(5) + 257, ndist = br.take(5) + 1, nclen = br.take(4) + 4;
+        if (nlit > 286 || ndist > 30) return false;
+        uint8_t clen[19] = {};
+        for (unsigned i = 0; i < nclen; ++i) clen[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(br.take(3));
+        HuffmanTable lenTable;
+        if (!lenTable.build(clen, 19)) return false;
+        uint8_t lengths[286 + 30] = {};
+        for (unsigned i = 0; i < nlit + ndist;) {
+            int sym = decodeSymbol(br, lenTable);
+            if (sym < 0 || br.truncated()) return false;
+            if (sym < 16) {
+                lengths[i++] = static_cast<uint8_t>(sym);
+                continue;
+            }
+            uint8_t value = 0;
+            unsigned repeat;
+            if (sym == 16) {
+                if (i == 0) return false;
+                value = lengths[i - 1];
+                repeat = 3 + br.take(2);
+            } else if (sym == 17) {
+                repeat = 3 + br.take(3);
+            } else {
+                repeat = 11 + br.take(7);
+            }
+            if (i + repeat > nlit + ndist) return false;
+            while (repeat--) lengths[i++] = value;
+        }
+        if (lengths[256] == 0) return false; // no end-of-block code
+        return lit.build(lengths, nlit) && dist.build(lengths + nlit, ndist);
+    }
+}
+
+bool DeflateDecoder::inflate(std::string_view in, std::string &out, size_t *consumed) {
+    static const FixedTables fixed;
+    BitReader br(in);
+    const size_t start = out.size();
+    HuffmanTable lit, dist;
+    bool last = false;
+    while (!last) {
+        last = br.take(1) != 0;
+        unsigned type = br.take(2);
+        if (type == 0) {
+            br.drop(br.count % 8);
+            uint32_t len = br.take(16), nlen = br.take(16);
+            if (br.truncated() || len != (~nlen & 0xffff)) return false;
+            for (; len && br.count; --len) out.push_back(static_cast<char>(br.take(8)));
+            if (br.truncated() || static_cast<size_t>(br.end - br.p) < len) return false;
+            out.append(reinterpret_cast<const char *>(br.p), len);
+            br.p += len;
+            continue;
+        }
+        if (type == 3) return false;
+        if (type == 2 && !readDynamicTables(br, lit, dist)) return false;
+        const HuffmanTable &litTable = type == 1 ? fixed.lit : lit;
+        const HuffmanTable &distTable = type == 1 ? fixed.dist : dist;
+        while (true) {
+            int sym = decodeSymbol(br, litTable);
+            if (sym < 0 || br.truncated()) return false;
+            if (sym < 256) {
+                out.push_back(static_cast<char>(sym));
+                continue;
+            }
+            if (sym == 256) break;
+            sym -= 257;
+            if (sym >= 29) return false;
+            size_t len = LEN_BASE[sym] + br.take(LEN_EXTRA[sym]);
+            int dc = decodeSymbol(br, distTable);
+            if (dc < 0 || dc >= 30) return false;
+            size_t d = DIST_BASE[dc] + br.take(DIST_EXTRA[dc]);
+            if (d > out.size() - start) return false;
+            size_t from = out.size() - d;
+            if (d >= len) {
+                out.reserve(out.size() + len);
+                out.append(out.data() + from, len);
+            } else {
+                for (size_t k = 0; k < len; ++k) out.push_back(out[from + k]);
+            }
+        }
+    }
+    if (br.truncated()) return false;
+    if (consumed) *consumed = br.consumed();
+    return true;
+}
+
+bool DeflateDecoder::zlibInflate(std::string_view in, std::string &out, size_t *consumed) {
+    if (in.size() < 6) return false;
+    unsigned cmf = static_cast<unsigned char>(in[0]), flg = static_cast<unsigned char>(in[1]);
+    if ((cmf & 15) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) return false; // preset dictionaries are unused
+    const size_t start = out.size();
+    size_t used = 0;
+    if (!DeflateDecoder::inflate(in.substr(2), out, &used)) return false;
+    if (in.size() < 2 + used + 4) return false;
+    const unsigned char *a = reinterpret_cast<const unsigned char *>(in.data()) + 2 + used;
+    uint32_t expected = (uint32_t(a[0]) << 24) | (uint32_t(a[1]) << 16) | (uint32_t(a[2]) << 8) | a[3];
+    if (adler32(1, out.data() + start, out.size() - start) != expected) return false;
+    if (consumed) *consumed = 2 + used + 4;
+    return true;
+}
+
+uint32_t DeflateDecoder::adler32(uint32_t adler, const void *data, size_t len) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+    while (len) {
+        size_t n = std::min<size_t>(len, 5552); // largest run before b can overflow 32 bits
+        len -= n;
+        while (n--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rcpack {
+
+    // Streaming raw deflate (RFC 1951) encoder: greedy LZ77 over a 32 KB window with hash
+    // chains, then one dynamic-Huffman block per ~16K symbols (stored when that is smaller).
+    // Input can arrive in any number of write() calls; matches reach back into earlier ones.
+    class DeflateEncoder {
+        struct Symbol {
+            uint16_t litLen; // literal byte, or match length when dist != 0
+            uint16_t dist;
+        };
+        std::string de_history;        // last 32 KB of input, for matches across writes
+        std::vector<int32_t> de_head;  // hash -> most recent position in the current buffer
+        std::vector<int32_t> de_prev;  // position & 32767 -> previous position with that hash
+        std::vector<Symbol> de_symbols;
+        uint64_t de_bits = 0;          // pending output bits (LSB first)
+        unsigned de_bitCount = 0;
+
+        void putBits(std::string &out, uint32_t bits, unsigned n);
+        void alignToByte(std::string &out);
+        // emits de_symbols (which encode buf[begin, end)) as one block
+        void writeBlock(const char *buf, size_t begin, size_t end, std::string &out);
+    public:
+        DeflateEncoder();
+        // Compresses data as the next part of the stream; appends the finished bytes to out
+        // (a few bits may stay pending until the next call).
+        void write(std::string_view data, std::string &out);
+        // Ends the stream: an empty final block, then padding to a byte boundary.
+        void finish(std::string &out);
+
+        // CRC-32 (IEEE, as used by gzip); pass the previous result to continue.
+        static uint32_t crc32(uint32_t crc, const void *data, size_t len);
+    };
+
+    // Raw deflate (RFC 1951) decoder for whole buffers, as git stores its objects. Huffman
+    // codes up to 10 bits are decoded with one table lookup, longer ones bit by bit.
+    class DeflateDecoder {
+    public:
+        // Decodes the stream at the start of in and appends it to out; consumed, when given,
+        // receives the compressed bytes up to the end of the final block. False on corrupt or
+        // truncated input (out then holds what was decoded so far).
+        static bool inflate(std::string_view in, std::string &out, size_t *consumed = nullptr);
+        // zlib (RFC 1950) stream: 2-byte header, raw deflate, then the Adler-32 of the data.
+        static bool zlibInflate(std::string_view in, std::string &out, size_t *consumed = nullptr);
+
+        static uint32_t adler32(uint32_t adler, const void *data, size_t len);
+    };
+}
@@ -0,0 +1,286 @@
+#include "DependencyGraph.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <filesystem>
+#include <queue>
+#include <sstream>
+#include <unordered_map>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+enum class ImportStyle { C, Python, Script };
+
+static ImportStyle styleFor(const std::string &path) {
+    std::string ext = toLower(fs::path(path).extension().string());
+    if (ext == ".py" || ext == ".pyi") return ImportStyle::Python;
+    if (ext == ".js" || ext == ".jsx" || ext == ".ts" || ext == ".tsx" || ext == ".mjs" || ext == ".cjs" ||
+        ext == ".vue" || ext == ".svelte") return ImportStyle::Script;
+    return ImportStyle::C;
+}
+
+// quoted string starting at s[pos] (either quote style); empty if there is none
+static std::string quotedAt(const std::string &s, size_t pos) {
+    if (pos >= s.size() || (s[pos] != '"' && s[pos] != '\'' && s[pos] != '`')) return {};
+    size_t end = s.find(s[pos], pos + 1);
+    return end == std::string::npos ? std::string() : s.substr(pos + 1, end - pos - 1);
+}
+
+static size_t skipSpaces(const std::string &s, size_t pos) {
+    while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t')) ++pos;
+    return pos;
+}
+
+static void extractC(const std::string &line, std::vector<std::string> &out) {
+    size_t p = skipSpaces(line, 0);
+    if (p >= line.size() || line[p] != '#') return;
+    p = skipSpaces(line, p + 1);
+    if (line.compare(p, 7, "include") != 0) return;
+    p = skipSpaces(line, p + 7);
+    if (p >= line.size()) return;
+    char close = line[p] == '<' ? '>' : line[p] == '"' ? '"' : 0;
+    if (!close) return;
+    size_t end = line.find(close, p + 1);
+    if (end != std::string::npos && end > p + 1) out.push_back(line.substr(p + 1, end - p - 1));
+}
+
+static void extractPython(const std::string &line, std::vector<std::string> &out) {
+    std::string t = trim(line);
+    if (starts_with(t, "from ")) {
+        std::istringstream in(t.substr(5));
+        std::string module, kw, names;
+        in >> module >> kw;
+        if (kw != "import") return;
+        std::getline(in, names);
+        out.push_back(module);
+        // "from . import a, b" names modules, not attributes
+        if (module.find_first_not_of('.') == std::string::npos) {
+            std::vector<std::string> parts;
+            split_comma(names, parts);
+            for (auto &n : parts) {
+                std::string name = trim(n.substr(0, n.find(" as ")));
+                if (!name.empty() && name != "(" && name != "*") out.push_back(module + name);
+            }
+        }
+    } else if (starts_with(t, "import ")) {
+        std::vector<std::string> parts;
+        split_comma(t.substr(7), parts);
+        for (auto &n : parts) {
+            std::string name = trim(n.substr(0, n.find(" as ")));
+            if (!name.empty()) out.push_back(name);
+        }
+    }
+}
+
+static void extractScript(const std::string &line, std::vector<std::string> &out) {
+    std::string t = trim(line);
+    if (starts_with(t, "import ") || starts_with(t, "export ")) {
+        // import 'x'; import a from 'x'; export { b } from "x"
+        size_t q = t.find_first_of("'\"", 6);
+        size_t from = t.find(" from ");
+        if (from != std::string::npos) q = skipSpaces(t, from + 6);
+        else if (!starts_with(t, "import ")) q = std::string::npos;
+        if (q != std::string::npos) {
+            std::string spec = quotedAt(t, q);
+            if (!spec.empty()) out.push_back(spec);
+        }
+    }
+    // require('x') and dynamic import('x') may appear anywhere on the line
+    for (const char *call : {"require(", "import("}) {
+        for (size_t p = t.find(call); p != std::string::npos; p = t.find(call, p + 1)) {
+            if (p > 0 && (std::isalnum(static_cast<unsigned char>(t[p - 1])) || t[p - 1] == '_' || t[p - 1] == '.')) continue;
+            std::string spec = quotedAt(t, skipSpaces(t, p + std::char_traits<char>::length(call)));
+            if (!spec.empty()) out.push_back(spec);
+        }
+    }
+}
+
+void DependencyGraph::extractImports(const std::string &content, const std::string &path, std::vector<std::string> &out) {
+    ImportStyle style = styleFor(path);
+    size_t start = 0;
+    while (start < content.size()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos) end = content.size();
+        std::string line = content.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        switch (style) {
+            case ImportStyle::C: extractC(line, out); break;
+            case ImportStyle::Python: extractPython(line, out); break;
+            case ImportStyle::Script: extractScript(line, out); break;
+        }
+        start = end + 1;
+    }
+}
+
+namespace {
+    // Lookup tables over the scanned paths used while resolving specifiers.
+    struct PathIndex {
+        std::unordered_map<std::string, uint32_t> byPath;
+        std::unordered_map<std::string, std::vector<uint32_t>> byName;
+        const std::vector<std::string> &paths;
+
+        explicit PathIndex(const std::vector<std::string> &relPaths) : paths(relPaths) {
+            for (uint32_t i = 0; i < relPaths.size(); ++i) {
+                byPath.emplace(relPaths[i], i);
+                byName[fs::path(relPaths[i]).filename().generic_string()].push_back(i);
+            }
+        }
+
+        int64_t exact(const fs::path &p) const {
+            auto it = byPath.find(p.lexically_normal().generic_string());
+            return it == byPath.end() ? -1 : static_cast<int64_t>(it->second);
+        }
+
+        // a scanned file whose path ends with "/" + tail; the one sharing the longest
+        // directory prefix with 'from' wins, then the lowest index
+        int64_t bySuffix(const std::string &tail, const std::string &from) const {
+            std::string name = fs::path(tail).filename().generic_string();
+            auto it = byName.find(name);
+            if (it == byName.end()) return -1;
+            int64_t best = -1;
+            size_t bestShared = 0;
+            for (uint32_t c : it->second) {
+                const std::string &p = paths[c];
+                if (p != tail && !(p.size() > tail.size() && p.compare(p.size() - tail.size(), tail.size(), tail) == 0 &&
+                                   p[p.size() - tail.size() - 1] == '/')) continue;
+                size_t shared = 0;
+                while (shared < p.size() && shared < from.size() && p[shared] == from[shared]) ++shared;
+                if (best < 0 || shared > bestShared) {
+                    best = c;
+                    bestShared = shared;
+                }
+            }
+            return best;
+        }
+    };
+}
+
+static int64_t resolve(const PathIndex &index, const std::string &from, const std::string &spec) {
+    const fs::path dir = fs::path(from).parent_path();
+    switch (styleFor(from)) {
+        case ImportStyle::C: {
+            int64_t r = index.exact(dir / spec);
+            return r >= 0 ? r : index.bySuffix(fs::path(spec).lexically_normal().generic_string(), from);
+        }
+        case ImportStyle::Python: {
+            size_t dots = spec.find_first_not_of('.');
+            if (dots == std::string::npos) return -1; // "from . import x" is resolved via the ".x" entry
+            std::string rest = spec.substr(dots);
+            std::replace(rest.begin(), rest.end(), '.', '/');
+            if (dots > 0) {
+                fs::path base = dir;
+                for (size_t up = 1; up < dots; ++up) base = base.parent_path();
+                int64_t r = index.exact(base / (rest + ".py"));
+                return r >= 0 ? r : index.exact(base / rest / "__init__.py");
+            }
+            int64_t r = index.bySuffix(rest + ".py", from);
+            return r >= 0 ? r : index.bySuffix(rest + "/__init__.py", from);
+        }
+        case ImportStyle::Script: {
+            if (!starts_with(spec, ".")) return -1; // packages live outside the scanned tree
+            fs::path base = dir / spec;
+            int64_t r = index.exact(base);
+            for (const char *ext : {".ts", ".tsx", ".js", ".jsx", ".mjs", ".cjs", ".json", ".vue"}) {
+                if (r < 0) r = index.exact(fs::path(base.generic_string() + ext));
+            }
+            for (const char *idx : {"index.ts", "index.tsx", "index.js", "index.jsx"}) {
+                if (r < 0) r = index.exact(base / idx);
+            }
+            return r;
+        }
+    }
+    return -1;
+}
+
+DependencyGraph DependencyGraph::build(const std::vector<std::string> &relPaths,
+                                       const std::vector<std::vector<std::string>> &imports) {
+    PathIndex index(relPaths);
+    DependencyGraph g;
+    const size_t n = relPaths.size();
+    g.dg_offsets.assign(1, 0);
+    std::vector<uint32_t> targets;
+    for (size_t f = 0; f < n; ++f) {
+        targets.clear();
+        if (f < imports.size()) {
+            for (auto &spec : imports[f]) {
+                int64_t t = resolve(index, relPaths[f], spec);
+                if (t >= 0 && static_cast<size_t>(t) != f) targets.push_back(static_cast<uint32_t>(t));
+            }
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        g.dg_targets.insert(g.dg_targets.end(), targets.begin(), targets.end());
+        g.dg_offsets.push_back(static_cast<uint32_t>(g.dg_targets.size()));
+    }
+
+    // reverse CSR by counting sort on the target column
+    g.dg_revOffsets.assign(n + 1, 0);
+    for (uint32_t t : g.dg_targets) ++g.dg_revOffsets[t + 1];
+    for (size_t i = 0; i < n; ++i) g.dg_revOffsets[i + 1] += g.dg_revOffsets[i];
+    g.dg_sources.resize(g.dg_targets.size());
+    std::vector<uint32_t> cursor(g.dg_revOffsets.begin(), g.dg_revOffsets.end() - 1);
+    for (uint32_t f = 0; f < n; ++f) {
+        for (uint32_t e = g.dg_offsets[f]; e < g.dg_offsets[f + 1]; ++e) g.dg_sources[cursor[g.dg_targets[e]]++] = f;
+    }
+    return g;
+}
+
+std::vector<uint32_t> DependencyGraph::neighbourhood(const std::vector<uint32_t> &seeds, size_t depth) const {
+    std::vector<size_t> dist(size(), SIZE_MAX);
+    std::deque<uint32_t> queue;
+    for (uint32_t s : seeds) {
+        if (s < size() && dist[s] == SIZE_MAX) {
+            dist[s] = 0;
+            queue.push_back(s);
+        }
+    }
+    while (!queue.empty()) {
+        uint32_t f = queue.front();
+        queue.pop_front();
+        if (dist[f] >= depth) continue;
+        auto visit = [&](uint32_t g) {
+            if (dist[g] != SIZE_MAX) return;
+            dist[g] = dist[f] + 1;
+            queue.push_back(g);
+        };
+        for (uint32_t e = dg_offsets[f]; e < dg_offsets[f + 1]; ++e) visit(dg_targets[e]);
+        for (uint32_t e = dg_revOffsets[f]; e < dg_revOffsets[f + 1]; ++e) visit(dg_sources[e]);
+    }
+    std::vector<uint32_t> out;
+    for (uint32_t f = 0; f < size(); ++f) {
+        if (dist[f] != SIZE_MAX) out.push_back(f);
+    }
+    return out;
+}
+
+std::vector<uint32_t> DependencyGraph::topologicalOrder(const std::vector<uint32_t> &subset) const {
+    std::vector<char> inSubset(size(), 0);
+    for (uint32_t f : subset) if (f < size()) inSubset[f] = 1;
+
+    // a file is ready once all of its (in-subset) dependencies have been emitted
+    std::vector<uint32_t> pending(size(), 0);
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+    for (uint32_t f = 0; f < size(); ++f) {
+        if (!inSubset[f]) continue;
+        for (uint32_t e = dg_offsets[f]; e < dg_offsets[f + 1]; ++e) pending[f] += inSubset[dg_targets[e]];
+        if (!pending[f]) ready.push(f);
+    }
+    std::vector<uint32_t> order;
+    std::vector<char> emitted(size(), 0);
+    while (!ready.empty()) {
+        uint32_t f = ready.top();
+        ready.pop();
+        order.push_back(f);
+        emitted[f] = 1;
+        for (uint32_t e = dg_revOffsets[f]; e < dg_revOffsets[f + 1]; ++e) {
+            uint32_t user = dg_sources[e];
+            if (inSubset[user] && --pending[user] == 0) ready.push(user);
+        }
+    }
+    for (uint32_t f = 0; f < size(); ++f) {
+        if (inSubset[f] && !emitted[f]) order.push_back(f); // cycles
+    }
+    return order;
+}
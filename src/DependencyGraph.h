@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rcpack {
+
+    // File-level dependency graph built from #include / import / require statements.
+    // Edges point from a file to the files it uses and are stored in CSR form both ways:
+    // the dependencies of file f are dg_targets[dg_offsets[f] .. dg_offsets[f + 1]),
+    // its dependents are dg_sources[dg_revOffsets[f] .. dg_revOffsets[f + 1]).
+    class DependencyGraph {
+        std::vector<uint32_t> dg_offsets{0};
+        std::vector<uint32_t> dg_targets;
+        std::vector<uint32_t> dg_revOffsets{0};
+        std::vector<uint32_t> dg_sources;
+    public:
+        // Module specifiers as written in the source ("utils.h", "../lib/x", "pkg.mod"),
+        // in order of appearance. Only the leading statements of a file matter, so the
+        // (possibly truncated) read is enough.
+        static void extractImports(const std::string &content, const std::string &path, std::vector<std::string> &out);
+
+        // Resolves every file's specifiers against the scanned relative paths (generic
+        // separators); unresolvable ones (system headers, packages) are dropped.
+        static DependencyGraph build(const std::vector<std::string> &relPaths,
+                                     const std::vector<std::vector<std::string>> &imports);
+
+        size_t size() const { return dg_offsets.size() - 1; }
+        size_t edgeCount() const { return dg_targets.size(); }
+        std::vector<uint32_t> dependencies(uint32_t f) const {
+            return {dg_targets.begin() + dg_offsets[f], dg_targets.begin() + dg_offsets[f + 1]};
+        }
+        std::vector<uint32_t> dependents(uint32_t f) const {
+            return {dg_sources.begin() + dg_revOffsets[f], dg_sources.begin() + dg_revOffsets[f + 1]};
+        }
+
+        // Files within depth edges of any seed, following edges in both directions.
+        // Returned in increasing index order.
+        std::vector<uint32_t> neighbourhood(const std::vector<uint32_t> &seeds, size_t depth) const;
+
+        // Dependencies before the files that use them (Kahn's algorithm over the subset,
+        // lowest index first among ready files). Files on a cycle follow in index order.
+        std::vector<uint32_t> topologicalOrder(const std::vector<uint32_t> &subset) const;
+    };
+}
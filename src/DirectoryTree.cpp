@@ -0,0 +1,85 @@
+#include "DirectoryTree.h"
+#include <cstdio>
+#include <utility>
+
+using namespace rcpack;
+
+DirectoryTree::DirectoryTree() {
+    dt_nodes.emplace_back();
+    dt_nodes[0].dir = true;
+}
+
+uint32_t DirectoryTree::child(uint32_t parent, std::string_view nm, bool dir) {
+    uint32_t last = dt_nodes[parent].lastChild;
+    // sorted input: a path that continues an existing directory continues the newest child
+    if (dir && last != NONE && dt_nodes[last].dir && name(dt_nodes[last]) == nm) return last;
+    if (dir) {
+        for (uint32_t c = dt_nodes[parent].firstChild; c != NONE; c = dt_nodes[c].next)
+            if (dt_nodes[c].dir && name(dt_nodes[c]) == nm) return c;
+    }
+
+    Node n;
+    n.name = static_cast<uint32_t>(dt_names.size());
+    n.nameLen = static_cast<uint32_t>(nm.size());
+    n.dir = dir;
+    dt_names.append(nm);
+    uint32_t id = static_cast<uint32_t>(dt_nodes.size());
+    dt_nodes.push_back(n);
+    if (last == NONE) dt_nodes[parent].firstChild = id;
+    else dt_nodes[last].next = id;
+    dt_nodes[parent].lastChild = id;
+    return id;
+}
+
+void DirectoryTree::add(std::string_view relPath, uint64_t size) {
+    uint32_t node = 0;
+    dt_nodes[0].files++;
+    dt_nodes[0].bytes += size;
+    size_t pos = 0;
+    while (true) {
+        size_t slash = relPath.find('/', pos);
+        if (slash == std::string_view::npos) break;
+        if (slash > pos) {
+            node = child(node, relPath.substr(pos, slash - pos), true);
+            dt_nodes[node].files++;
+            dt_nodes[node].bytes += size;
+        }
+        pos = slash + 1;
+    }
+    uint32_t leaf = child(node, relPath.substr(pos), false);
+    dt_nodes[leaf].files = 1;
+    dt_nodes[leaf].bytes = size;
+}
+
+std::string DirectoryTree::formatBytes(uint64_t bytes) {
+    static const char *units[] = {"KB", "MB", "GB", "TB"};
+    if (bytes < 1024) return std::to_string(bytes) + " B";
+    double v = static_cast<double>(bytes) / 1024;
+    size_t u = 0;
+    while (v >= 1024 && u + 1 < sizeof(units) / sizeof(units[0])) { v /= 1024; ++u; }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f %s", v, units[u]);
+    return buf;
+}
+
+void DirectoryTree::render(OutputSink &out) const {
+    // pre-order walk with an explicit stack of (node, depth)
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    if (dt_nodes[0].firstChild != NONE) stack.emplace_back(dt_nodes[0].firstChild, 0);
+    std::string indent;
+    while (!stack.empty()) {
+        auto [id, depth] = stack.back();
+        stack.pop_back();
+        const Node &n = dt_nodes[id];
+        if (n.next != NONE) stack.emplace_back(n.next, depth);
+
+        indent.assign(depth * 2, ' ');
+        out << indent << name(n);
+        if (n.dir) {
+            out << "/ (" << n.files << (n.files == 1 ? " file, " : " files, ") << formatBytes(n.bytes) << ")\n";
+            if (n.firstChild != NONE) stack.emplace_back(n.firstChild, depth + 1);
+        } else {
+            out << '\n';
+        }
+    }
+}
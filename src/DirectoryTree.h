@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "OutputSink.h"
+
+namespace rcpack {
+
+    // Path trie behind the "Structure" section. Nodes live in one vector and their names in
+    // one character arena; children are kept as a singly linked list in insertion order.
+    // Scan output is sorted by generic path, so every directory's entries are contiguous and
+    // the child a path continues into is always its parent's newest one: building is a single
+    // linear pass and rendering needs no sort. Unsorted input still works (children are then
+    // searched and listed in first-seen order).
+    class DirectoryTree {
+        static constexpr uint32_t NONE = UINT32_MAX;
+        struct Node {
+            uint32_t name = 0;         // offset into dt_names
+            uint32_t nameLen = 0;
+            uint32_t firstChild = NONE;
+            uint32_t lastChild = NONE;
+            uint32_t next = NONE;      // next sibling
+            uint32_t files = 0;        // files at or below this node
+            uint64_t bytes = 0;        // their total size
+            bool dir = false;
+        };
+        std::vector<Node> dt_nodes;
+        std::string dt_names;
+
+        std::string_view name(const Node &n) const { return {dt_names.data() + n.name, n.nameLen}; }
+        uint32_t child(uint32_t parent, std::string_view name, bool dir);
+    public:
+        DirectoryTree();
+
+        // relPath uses '/' separators; every component but the last becomes a directory.
+        void add(std::string_view relPath, uint64_t size);
+
+        size_t fileCount() const { return dt_nodes[0].files; }
+        uint64_t totalBytes() const { return dt_nodes[0].bytes; }
+
+        // One line per node, two spaces of indent per level; directories read
+        // "name/ (N files, 12.3 KB)".
+        void render(OutputSink &out) const;
+
+        // "512 B", "12.3 KB", "4.0 MB", ...
+        static std::string formatBytes(uint64_t bytes);
+    };
+}
@@ -10,10 +10,20 @@ FileReader::FileReader(size_t maxBytes): fr_maxBytes(maxBytes){}
 
 FileContent FileReader::readFile(const std::filesystem::path &p) const{
     FileContent out;
+    if (fr_source) {
+        std::string text;
+        if (!fr_source->read(p, text)) {
+            std::cerr << "Error: cannot read " << p << " from its source\n";
+            out.unreadable = true;
+            return out;
+        }
+        return readText(std::move(text));
+    }
     std::ifstream in(p, std::ios::in | std::ios::binary);
 
     if (!in){
         std::cerr << "Error: cannot open file " << p << " for reading\n";
+        out.unreadable = true;
         return out;
     }
 
@@ -49,4 +59,17 @@ FileContent FileReader::readFile(const std::filesystem::path &p) const{
         out.lines = lines;
     }
     return out;
-}
\ No newline at end of file
+}
+
+FileContent FileReader::readText(std::string text) const {
+    FileContent out;
+    if (text.size() > fr_maxBytes) {
+        text.resize(fr_maxBytes);
+        out.truncated = true;
+    } else if (!text.empty() && text.back() != '\n') {
+        text += '\n'; // as the line-by-line read of a file leaves it
+    }
+    out.lines = std::count(text.begin(), text.end(), '\n');
+    out.content = std::move(text);
+    return out;
+}
@@ -2,20 +2,52 @@
 
 #include <string>
 #include <filesystem>
+#include <optional>
+#include <cstdint>
+#include <vector>
+#include "SymbolTable.h"
+#include "Config.h"
 
 namespace rcpack {
 
     struct FileContent {
         std::string content;
         bool truncated = false;
+        bool unreadable = false;              // the file could not be read; content is empty
         size_t lines = 0;
+        uint64_t hash = 0;                    // hashString(content), filled in by ContentPipeline
+        uint64_t sourceHash = 0;              // hashString of the text as read, before Compressor::process
+        std::optional<size_t> duplicateOf{};  // index of the first file with the same content
+        bool nearDuplicate = false;           // duplicateOf was found by similarity, not equality
+        double similarity = 1.0;
+        std::vector<uint64_t> prefixHashes{}; // leading-line hashes for PreambleDetector
+        std::optional<size_t> preambleId{};   // common preamble stripped from the front of content
+        SymbolTable symbols{};                // this file's symbols until merged into the global index
+        CompressionLevel level = CompressionLevel::Full; // chosen by BudgetPlanner under --max-tokens
+        size_t tokens = 0;                    // Tokenizer::count(content) as finally emitted
+        // Set instead of content when the text is exactly the file's first rawBytes bytes:
+        // the formatter then lets the sink copy them from disk (OutputSink::copyFile).
+        std::optional<size_t> rawBytes{};
+    };
+
+    // File text kept somewhere other than the file system (see RevisionSource).
+    class ContentSource {
+    public:
+        virtual ~ContentSource() = default;
+        // The whole text of the file listed as p; false when there is none. Thread-safe.
+        virtual bool read(const std::filesystem::path &p, std::string &out) const = 0;
     };
 
     class FileReader {
         size_t fr_maxBytes;
+        const ContentSource *fr_source = nullptr;
     public:
         // maxBytes default 16KB if file > maxBytes we'll read only first maxBytes and set truncated
         explicit FileReader(size_t maxBytes = 16 * 1024);
+        // Reads through source (not owned) instead of opening files; nullptr = the file system.
+        void setSource(const ContentSource *source) { fr_source = source; }
         FileContent readFile(const std::filesystem::path &p) const;
+        // What readFile() returns for a file holding text.
+        FileContent readText(std::string text) const;
     };
 }
\ No newline at end of file
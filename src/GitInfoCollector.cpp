@@ -1,107 +1,69 @@
 #include "GitInfoCollector.h"
+#include "GitRepository.h"
 #include <cstdio>
-#include <memory>
-#include <array>
+#include <cstdlib>
 #include <iostream>
 #include <filesystem>
-#include <system_error>
 
 using namespace rcpack;
 namespace fs = std::filesystem;
 
-#if defined(_WIN32)
-  #define POPEN _popen
-  #define PCLOSE _pclose
-  static constexpr const char* NULLDEV = "NUL";
-#else
-  #define POPEN popen
-  #define PCLOSE pclose
-  static constexpr const char* NULLDEV = "/dev/null";
-#endif
-
-// RAII helper to temporarily change cwd and restore it on destruction
-class ScopedChdir {
-public:
-    explicit ScopedChdir(const fs::path &newCwd) {
-        try {
-            oldCwd_ = fs::current_path();
-            fs::current_path(newCwd);
-            active_ = true;
-        } catch (...) {
-            active_ = false;
-        }
-    }
-    ~ScopedChdir() noexcept {
-        if (active_) {
-            try { fs::current_path(oldCwd_); } catch(...) {}
-        }
-    }
-private:
-    fs::path oldCwd_;
-    bool active_ = false;
-};
-
 GitInfoCollector::GitInfoCollector(const std::string &path): git_repoPath(path) {}
 
-static std::string trimNewline(std::string s) {
-    while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) s.pop_back();
-    return s;
-}
+std::string GitInfoCollector::formatDate(int64_t time, int tz) {
+    static const char *const WEEKDAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static const char *const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    int offsetMinutes = (std::abs(tz) / 100) * 60 + std::abs(tz) % 100;
+    int64_t local = time + (tz < 0 ? -offsetMinutes : offsetMinutes) * int64_t(60);
+    int64_t days = local / 86400, secs = local % 86400;
+    if (secs < 0) { secs += 86400; --days; }
+    // civil date from days since 1970-01-01 (Howard Hinnant's algorithm); no gmtime, which
+    // is not thread-safe everywhere
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+    int weekday = static_cast<int>(((days % 7) + 11) % 7); // 1970-01-01 was a Thursday
 
-std::string GitInfoCollector::runCmd(const std::string &cmd) const {
-    std::array<char, 256> buffer;
-    std::string result;
-    FILE* pipe = nullptr;
-    // POPEN is defined to _popen on Windows and popen on POSIX
-    pipe = POPEN(cmd.c_str(), "r");
-    if (!pipe) return {};
-    while (fgets(buffer.data(), static_cast<int>(buffer.size()), pipe) != nullptr) {
-        result += buffer.data();
-    }
-    PCLOSE(pipe);
-    return trimNewline(result);
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%s %s %d %02d:%02d:%02d %lld %c%04d", WEEKDAYS[weekday], MONTHS[month - 1],
+                  static_cast<int>(day), static_cast<int>(secs / 3600), static_cast<int>(secs / 60 % 60),
+                  static_cast<int>(secs % 60), static_cast<long long>(year), tz < 0 ? '-' : '+', std::abs(tz));
+    return buf;
 }
 
-GitInfo GitInfoCollector::collect() {
+GitInfo GitInfoCollector::collect(const std::string &revision) {
     GitInfo g;
     try {
-        fs::path start = fs::absolute(git_repoPath);
-        // If user passed a file, start from its parent
-        if (fs::exists(start) && fs::is_regular_file(start)) start = start.parent_path();
-
-        // Walk upwards to find .git folder
-        fs::path repoRoot;
-        for (fs::path p = start; ; p = p.parent_path()) {
-            if (p.empty()) break;
-            if (fs::exists(p / ".git")) { repoRoot = p; break; }
-            if (p == p.root_path()) break;
-        }
-
-        if (repoRoot.empty()) {
+        GitRepository repo;
+        if (!repo.open(git_repoPath)) {
             // Not a git repo
             g.isRepo = false;
             return g;
         }
-
         g.isRepo = true;
 
-        // Use ScopedChdir so commands are simple (avoid embedding paths into the command)
-        ScopedChdir sc(repoRoot);
+        // Branch, as git rev-parse --abbrev-ref HEAD prints it ("HEAD" when detached)
+        std::string ref = repo.headRef();
+        if (revision != "HEAD") g.branch = revision;
+        else if (ref.empty()) g.branch = "HEAD";
+        else if (ref.rfind("refs/heads/", 0) == 0) g.branch = ref.substr(11);
+        else g.branch = ref;
 
-        // Get commit SHA
-        g.commitSHA = runCmd(std::string("git rev-parse HEAD 2> ") + NULLDEV);
-        // Branch
-        g.branch = runCmd(std::string("git rev-parse --abbrev-ref HEAD 2> ") + NULLDEV);
-        // Author and date (separated by |)
-        std::string logres = runCmd(std::string("git log -1 --pretty=format:\"%an <%ae>|%ad\" 2> ") + NULLDEV);
-        if (!logres.empty()) {
-            auto pos = logres.find('|');
-            if (pos != std::string::npos) {
-                g.author = logres.substr(0, pos);
-                g.date = logres.substr(pos + 1);
-            } else {
-                g.author = logres;
-            }
+        auto head = repo.resolve(revision);
+        if (!head) return g; // no commits yet
+        g.commitSHA = head->hex();
+        if (auto commit = repo.readCommit(*head)) {
+            g.author = commit->author;
+            g.date = formatDate(commit->authorTime, commit->authorTz);
+        } else {
+            std::cerr << "Warning: could not read commit " << g.commitSHA << " from " << repo.gitDir().string() << "\n";
         }
     } catch (const std::exception &ex) {
         std::cerr << "GitInfoCollector error: " << ex.what() << "\n";
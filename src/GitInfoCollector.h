@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <optional>
 
@@ -13,11 +14,17 @@ namespace rcpack {
         std::string date;
     };
 
+    // Reads HEAD's commit straight from the .git directory (GitRepository); no git process is
+    // started and the working directory is left alone, so it is safe to call from any thread.
     class GitInfoCollector {
         std::string git_repoPath;
-        std::string runCmd(const std::string &cmd) const;
     public:
         explicit GitInfoCollector(const std::string &path);
-        GitInfo collect();
+        // HEAD's commit and branch; for another revision, its commit with the revision as
+        // given in place of the branch.
+        GitInfo collect(const std::string &revision = "HEAD");
+
+        // git's default date format in the author's zone: "Thu Feb 29 23:15:00 2024 +0530"
+        static std::string formatDate(int64_t time, int tz);
     };
-}
\ No newline at end of file
+}
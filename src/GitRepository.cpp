@@ -0,0 +1,1128 @@
+#include "GitRepository.h"
+#include "Deflate.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr int MAX_SYMREF_DEPTH = 5;
+    constexpr int MAX_TAG_DEPTH = 5; // tags of tags that peel() follows
+    constexpr size_t MIN_ABBREV = 4; // git's shortest accepted object name prefix
+    constexpr size_t MAX_DELTA_CHAIN = 10000; // git itself stops at 4095 when packing
+    constexpr size_t DELTA_BASE_CACHE_BYTES = 96 * 1024 * 1024; // git's core.deltaBaseCacheLimit
+
+    inline uint32_t be32(const unsigned char *p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    inline uint64_t be64(const unsigned char *p) { return (uint64_t(be32(p)) << 32) | be32(p + 4); }
+
+    // git's tree order: names compare bytewise, with a tree's name continuing as if followed by '/'
+    int compareTreeNames(const GitTreeEntry &a, const GitTreeEntry &b) {
+        size_t n = std::min(a.name.size(), b.name.size());
+        int c = std::memcmp(a.name.data(), b.name.data(), n);
+        if (c) return c;
+        unsigned char ca = a.name.size() > n ? a.name[n] : (a.isTree() ? '/' : 0);
+        unsigned char cb = b.name.size() > n ? b.name[n] : (b.isTree() ? '/' : 0);
+        return int(ca) - int(cb);
+    }
+
+    inline uint16_t be16(const unsigned char *p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+
+    // SHA-1 (FIPS 180-4), only to name objects the way git does.
+    class Sha1 {
+        uint32_t h_[5] = {0x67452301u, 0xefcdab89u, 0x98badcfeu, 0x10325476u, 0xc3d2e1f0u};
+        unsigned char block_[64];
+        size_t used_ = 0;
+        uint64_t total_ = 0;
+
+        static uint32_t rol(uint32_t x, unsigned n) { return (x << n) | (x >> (32 - n)); }
+        void compress(const unsigned char *p) {
+            uint32_t w[80];
+            for (int t = 0; t < 16; ++t) w[t] = be32(p + 4 * t);
+            for (int t = 16; t < 80; ++t) w[t] = rol(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+            uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4];
+            for (int t = 0; t < 80; ++t) {
+                uint32_t f, k;
+                if (t < 20) { f = (b & c) | (~b & d); k = 0x5a827999u; }
+                else if (t < 40) { f = b ^ c ^ d; k = 0x6ed9eba1u; }
+                else if (t < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdcu; }
+                else { f = b ^ c ^ d; k = 0xca62c1d6u; }
+                uint32_t tmp = rol(a, 5) + f + e + k + w[t];
+                e = d; d = c; c = rol(b, 30); b = a; a = tmp;
+            }
+            h_[0] += a; h_[1] += b; h_[2] += c; h_[3] += d; h_[4] += e;
+        }
+    public:
+        void update(const void *data, size_t len) {
+            const unsigned char *p = static_cast<const unsigned char *>(data);
+            total_ += len;
+            if (used_) {
+                size_t take = std::min(len, 64 - used_);
+                std::memcpy(block_ + used_, p, take);
+                used_ += take; p += take; len -= take;
+                if (used_ < 64) return;
+                compress(block_);
+                used_ = 0;
+            }
+            for (; len >= 64; p += 64, len -= 64) compress(p);
+            std::memcpy(block_, p, len);
+            used_ = len;
+        }
+        GitOid finish() {
+            uint64_t bits = total_ * 8;
+            unsigned char pad[72] = {0x80};
+            size_t padLen = (used_ < 56 ? 56 : 120) - used_;
+            for (int i = 0; i < 8; ++i) pad[padLen + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+            update(pad, padLen + 8);
+            GitOid id;
+            for (int i = 0; i < 5; ++i) {
+                for (int b = 0; b < 4; ++b) id.bytes[4 * i + b] = static_cast<unsigned char>(h_[i] >> (24 - 8 * b));
+            }
+            return id;
+        }
+    };
+
+    int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Whole file with trailing whitespace removed; nullopt when it cannot be read.
+    std::optional<std::string> readSmallFile(const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        if (!in) return std::nullopt;
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        std::string s = ss.str();
+        while (!s.empty() && (s.back() == '\n' || s.back() == '\r' || s.back() == ' ')) s.pop_back();
+        return s;
+    }
+
+    GitObject::Type typeFromName(std::string_view name) {
+        if (name == "commit") return GitObject::Commit;
+        if (name == "tree") return GitObject::Tree;
+        if (name == "blob") return GitObject::Blob;
+        if (name == "tag") return GitObject::Tag;
+        return GitObject::None;
+    }
+
+    // Little-endian base-128 size used in delta headers.
+    bool readDeltaSize(const unsigned char *&p, const unsigned char *end, uint64_t &size) {
+        size = 0;
+        for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+            unsigned char c = *p++;
+            size |= uint64_t(c & 0x7f) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Rebuilds a deltified object from its base: copy instructions take a range of the base,
+    // insert instructions carry up to 127 literal bytes.
+    bool applyDelta(const std::string &base, const std::string &delta, std::string &out) {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(delta.data());
+        const unsigned char *end = p + delta.size();
+        uint64_t baseSize = 0, resultSize = 0;
+        if (!readDeltaSize(p, end, baseSize) || !readDeltaSize(p, end, resultSize)) return false;
+        if (baseSize != base.size()) return false;
+        out.clear();
+        out.reserve(resultSize);
+        while (p < end) {
+            unsigned char cmd = *p++;
+            if (cmd & 0x80) {
+                uint64_t off = 0, len = 0;
+                for (unsigned b = 0; b < 4; ++b) {
+                    if (cmd & (1u << b)) {
+                        if (p == end) return false;
+                        off |= uint64_t(*p++) << (8 * b);
+                    }
+                }
+                for (unsigned b = 0; b < 3; ++b) {
+                    if (cmd & (0x10u << b)) {
+                        if (p == end) return false;
+                        len |= uint64_t(*p++) << (8 * b);
+                    }
+                }
+                if (len == 0) len = 0x10000;
+                if (off + len > base.size() || out.size() + len > resultSize) return false;
+                out.append(base, off, len);
+            } else if (cmd) {
+                if (static_cast<size_t>(end - p) < cmd || out.size() + cmd > resultSize) return false;
+                out.append(reinterpret_cast<const char *>(p), cmd);
+                p += cmd;
+            } else {
+                return false; // reserved
+            }
+        }
+        return out.size() == resultSize;
+    }
+
+    // Header of the pack entry at 'at': type (1-4 objects, 6 OFS_DELTA, 7 REF_DELTA), inflated
+    // size, where the zlib stream starts and, for deltas, where the base is.
+    struct PackEntry {
+        unsigned type = 0;
+        uint64_t inflated = 0;
+        uint64_t dataAt = 0;
+        uint64_t baseAt = 0;
+        std::optional<GitOid> refBase;
+    };
+
+    bool parsePackEntry(const unsigned char *data, uint64_t size, uint64_t at, PackEntry &e) {
+        if (at < 12 || at >= size) return false;
+        // type and inflated size: 3 + 4 bits, then 7 bits per continuation byte
+        const uint64_t objectAt = at;
+        unsigned char c = data[at++];
+        e.type = (c >> 4) & 7;
+        e.inflated = c & 15;
+        for (unsigned shift = 4; c & 0x80; shift += 7) {
+            if (at >= size || shift > 57) return false;
+            c = data[at++];
+            e.inflated |= uint64_t(c & 0x7f) << shift;
+        }
+        if (e.type == 6) { // OFS_DELTA: distance back to the base, big-endian base-128 with an offset per byte
+            if (at >= size) return false;
+            c = data[at++];
+            uint64_t back = c & 0x7f;
+            while (c & 0x80) {
+                if (at >= size || back > (UINT64_MAX >> 8)) return false;
+                c = data[at++];
+                back = ((back + 1) << 7) | (c & 0x7f);
+            }
+            if (back == 0 || back > objectAt) return false;
+            e.baseAt = objectAt - back;
+        } else if (e.type == 7) { // REF_DELTA: the base's object name
+            if (at + 20 > size) return false;
+            e.refBase = GitOid::fromRaw(data + at);
+            at += 20;
+        } else if (e.type < 1 || e.type > 4) {
+            return false;
+        }
+        e.dataAt = at;
+        return true;
+    }
+}
+
+std::string GitOid::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string s(40, '0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        s[2 * i] = digits[bytes[i] >> 4];
+        s[2 * i + 1] = digits[bytes[i] & 15];
+    }
+    return s;
+}
+
+std::optional<GitOid> GitOid::fromHex(std::string_view hex) {
+    if (hex.size() != 40) return std::nullopt;
+    GitOid id;
+    for (size_t i = 0; i < 20; ++i) {
+        int hi = hexDigit(hex[2 * i]), lo = hexDigit(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return std::nullopt;
+        id.bytes[i] = static_cast<unsigned char>(hi << 4 | lo);
+    }
+    return id;
+}
+
+GitOid GitOid::fromRaw(const void *raw) {
+    GitOid id;
+    std::memcpy(id.bytes.data(), raw, id.bytes.size());
+    return id;
+}
+
+// One objects/pack/pack-*.idx (version 2) with its .pack, which is only mapped when an object
+// is first read from it.
+struct GitRepository::Pack {
+    fs::path packPath;
+    MappedFile idx;
+    uint32_t count = 0;
+    const unsigned char *fanout = nullptr, *names = nullptr, *offsets32 = nullptr, *offsets64 = nullptr;
+    size_t largeOffsets = 0;
+
+    mutable std::once_flag mapped;
+    mutable MappedFile pack;
+    mutable bool packOk = false;
+
+    bool load(const fs::path &idxPath) {
+        if (!idx.open(idxPath) || idx.size() < 8 + 1024 + 40) return false;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(idx.data());
+        if (be32(p) != 0xff744f63u || be32(p + 4) != 2) return false; // "\377tOc", version 2
+        fanout = p + 8;
+        count = be32(fanout + 255 * 4);
+        size_t fixed = 8 + 1024 + size_t(count) * (20 + 4 + 4);
+        if (idx.size() < fixed + 40) return false;
+        names = fanout + 1024;
+        offsets32 = names + size_t(count) * 24; // past the CRC table
+        offsets64 = offsets32 + size_t(count) * 4;
+        largeOffsets = (idx.size() - fixed - 40) / 8;
+        packPath = idxPath;
+        packPath.replace_extension(".pack");
+        return true;
+    }
+
+    const MappedFile *data() const {
+        std::call_once(mapped, [this] {
+            packOk = pack.open(packPath) && pack.size() >= 12 + 20 && std::memcmp(pack.data(), "PACK", 4) == 0;
+        });
+        return packOk ? &pack : nullptr;
+    }
+
+    std::optional<uint64_t> find(const GitOid &id) const {
+        uint32_t lo = id.bytes[0] ? be32(fanout + (id.bytes[0] - 1) * 4) : 0;
+        // a damaged fanout must not send the search past the name table
+        uint32_t hi = std::min(be32(fanout + id.bytes[0] * 4), count);
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            int c = std::memcmp(names + size_t(mid) * 20, id.bytes.data(), 20);
+            if (c == 0) {
+                uint32_t off = be32(offsets32 + size_t(mid) * 4);
+                if (!(off & 0x80000000u)) return off;
+                size_t large = off & 0x7fffffffu;
+                if (large >= largeOffsets) return std::nullopt;
+                const unsigned char *q = offsets64 + large * 8;
+                return (uint64_t(be32(q)) << 32) | be32(q + 4);
+            }
+            if (c < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return std::nullopt;
+    }
+
+    // Appends the names whose first digits hex digits are those of key (the rest zero), at most
+    // limit of them.
+    void findPrefix(const GitOid &key, size_t digits, size_t limit, std::vector<GitOid> &out) const {
+        uint32_t lo = key.bytes[0] ? be32(fanout + (key.bytes[0] - 1) * 4) : 0;
+        uint32_t hi = std::min(be32(fanout + key.bytes[0] * 4), count);
+        while (lo < hi) { // the first name not below key
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (std::memcmp(names + size_t(mid) * 20, key.bytes.data(), 20) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        for (; lo < count && limit; ++lo, --limit) {
+            const unsigned char *name = names + size_t(lo) * 20;
+            if (std::memcmp(name, key.bytes.data(), digits / 2) != 0) break;
+            if (digits % 2 && (name[digits / 2] & 0xf0) != key.bytes[digits / 2]) break;
+            out.push_back(GitOid::fromRaw(name));
+        }
+    }
+};
+
+// objects/info/commit-graph, or one file of a split chain: commit names, trees, parents and
+// dates in fixed-size records, so a history walk needs no object inflation.
+struct GitRepository::CommitGraph {
+    static constexpr uint32_t NO_PARENT = 0x70000000u;
+    static constexpr size_t RECORD = 36; // tree, parent 1, parent 2, generation and date
+
+    MappedFile file;
+    uint32_t count = 0;
+    uint32_t base = 0; // commits in the graphs before this one in its chain
+    const unsigned char *fanout = nullptr, *oids = nullptr, *records = nullptr, *edges = nullptr;
+    size_t edgeCount = 0;
+
+    bool load(const fs::path &p) {
+        if (!file.open(p) || file.size() < 8 + 12 + 20) return false;
+        const unsigned char *d = reinterpret_cast<const unsigned char *>(file.data());
+        if (std::memcmp(d, "CGPH", 4) != 0 || d[4] != 1 || d[5] != 1) return false; // version 1, SHA-1
+        const size_t chunks = d[6], end = file.size() - 20;
+        if (8 + (chunks + 1) * 12 > end) return false;
+        size_t oidBytes = 0, recordBytes = 0;
+        for (size_t c = 0; c < chunks; ++c) {
+            const unsigned char *e = d + 8 + c * 12;
+            uint64_t off = be64(e + 4), next = be64(e + 16);
+            if (off > next || next > end) return false;
+            size_t len = static_cast<size_t>(next - off);
+            switch (be32(e)) {
+            case 0x4f494446: if (len == 1024) fanout = d + off; break;    // OIDF
+            case 0x4f49444c: oids = d + off; oidBytes = len; break;       // OIDL
+            case 0x43444154: records = d + off; recordBytes = len; break; // CDAT
+            case 0x45444745: edges = d + off; edgeCount = len / 4; break; // EDGE
+            default: break;
+            }
+        }
+        if (!fanout || !oids || !records) return false;
+        count = be32(fanout + 255 * 4);
+        return oidBytes >= size_t(count) * 20 && recordBytes >= size_t(count) * RECORD;
+    }
+
+    std::optional<uint32_t> find(const GitOid &id) const {
+        uint32_t lo = id.bytes[0] ? be32(fanout + (id.bytes[0] - 1) * 4) : 0;
+        uint32_t hi = std::min(be32(fanout + id.bytes[0] * 4), count);
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            int c = std::memcmp(oids + size_t(mid) * 20, id.bytes.data(), 20);
+            if (c == 0) return mid;
+            if (c < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return std::nullopt;
+    }
+};
+
+// Delta bases resolved recently, by pack entry, least recently used dropped first (git's
+// delta_base_cache): versions of a file are stored as chains against each other, so without
+// it reading n of them inflates and patches the shared bases n times.
+struct GitRepository::DeltaBaseCache {
+    using Key = std::pair<const Pack *, uint64_t>;
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            return std::hash<const void *>()(k.first) ^ static_cast<size_t>(k.second * 0x9e3779b97f4a7c15ull);
+        }
+    };
+    struct Slot {
+        std::shared_ptr<const GitObject> object;
+        std::list<Key>::iterator use;
+    };
+    std::mutex mutex;
+    std::list<Key> uses; // most recent first
+    std::unordered_map<Key, Slot, KeyHash> slots;
+    size_t bytes = 0;
+    size_t hits = 0;
+
+    std::shared_ptr<const GitObject> get(const Pack *pack, uint64_t offset) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = slots.find(Key(pack, offset));
+        if (it == slots.end()) return nullptr;
+        uses.splice(uses.begin(), uses, it->second.use);
+        ++hits;
+        return it->second.object;
+    }
+
+    void put(const Pack *pack, uint64_t offset, std::shared_ptr<const GitObject> object) {
+        const size_t size = object->data.size();
+        if (size > DELTA_BASE_CACHE_BYTES / 4) return; // would evict everything else
+        std::lock_guard<std::mutex> lock(mutex);
+        Key key(pack, offset);
+        if (slots.count(key)) return;
+        while (bytes + size > DELTA_BASE_CACHE_BYTES && !uses.empty()) {
+            auto last = slots.find(uses.back());
+            bytes -= last->second.object->data.size();
+            slots.erase(last);
+            uses.pop_back();
+        }
+        uses.push_front(key);
+        slots.emplace(key, Slot{std::move(object), uses.begin()});
+        bytes += size;
+    }
+};
+
+GitRepository::GitRepository() : gr_deltaBases(std::make_unique<DeltaBaseCache>()) {}
+GitRepository::~GitRepository() = default;
+
+bool GitRepository::open(const fs::path &path) {
+    std::error_code ec;
+    fs::path start = fs::absolute(path, ec).lexically_normal();
+    if (ec) return false;
+    if (fs::is_regular_file(start, ec)) start = start.parent_path();
+    if (!start.empty() && !start.has_filename()) start = start.parent_path(); // trailing separator
+
+    for (fs::path p = start; !p.empty(); p = p.parent_path()) {
+        fs::path dotGit = p / ".git";
+        if (fs::is_directory(dotGit, ec)) {
+            gr_gitDir = dotGit;
+        } else if (fs::is_regular_file(dotGit, ec)) {
+            // linked worktree or submodule: "gitdir: <path>"
+            auto text = readSmallFile(dotGit);
+            if (!text || text->rfind("gitdir: ", 0) != 0) return false;
+            fs::path target = text->substr(8);
+            gr_gitDir = (target.is_absolute() ? target : p / target).lexically_normal();
+        }
+        if (!gr_gitDir.empty()) {
+            gr_workTree = p;
+            break;
+        }
+        if (p == p.root_path()) break;
+    }
+    if (gr_gitDir.empty() || !fs::is_regular_file(gr_gitDir / "HEAD", ec)) return false;
+
+    gr_commonDir = gr_gitDir;
+    if (auto common = readSmallFile(gr_gitDir / "commondir")) {
+        fs::path c = *common;
+        gr_commonDir = (c.is_absolute() ? c : gr_gitDir / c).lexically_normal();
+    }
+
+    gr_objectDirs.push_back(gr_commonDir / "objects");
+    if (auto alternates = readSmallFile(gr_commonDir / "objects" / "info" / "alternates")) {
+        std::istringstream lines(*alternates);
+        for (std::string line; std::getline(lines, line);) {
+            if (line.empty() || line[0] == '#') continue;
+            fs::path alt = line;
+            gr_objectDirs.push_back((alt.is_absolute() ? alt : gr_commonDir / "objects" / alt).lexically_normal());
+        }
+    }
+    for (auto &dir : gr_objectDirs) loadPacks(dir);
+    loadCommitGraphs();
+    return true;
+}
+
+void GitRepository::loadCommitGraphs() {
+    fs::path info = gr_commonDir / "objects" / "info";
+    // a split chain replaces the single file when both exist
+    if (auto chain = readSmallFile(info / "commit-graphs" / "commit-graph-chain")) {
+        std::istringstream lines(*chain);
+        uint32_t base = 0;
+        for (std::string hash; std::getline(lines, hash);) {
+            auto graph = std::make_unique<CommitGraph>();
+            if (!graph->load(info / "commit-graphs" / ("graph-" + hash + ".graph"))) {
+                gr_graphs.clear();
+                return;
+            }
+            graph->base = base;
+            base += graph->count;
+            gr_graphs.push_back(std::move(graph));
+        }
+        return;
+    }
+    auto graph = std::make_unique<CommitGraph>();
+    if (graph->load(info / "commit-graph")) gr_graphs.push_back(std::move(graph));
+}
+
+void GitRepository::loadPacks(const fs::path &objectDir) {
+    std::error_code ec;
+    std::vector<fs::path> idxFiles;
+    for (fs::directory_iterator it(objectDir / "pack", ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".idx") idxFiles.push_back(it->path());
+    }
+    // newest packs first: they hold the most recent objects, which are looked up the most
+    std::sort(idxFiles.begin(), idxFiles.end(), [](const fs::path &a, const fs::path &b) {
+        std::error_code e1, e2;
+        return fs::last_write_time(a, e1) > fs::last_write_time(b, e2);
+    });
+    for (auto &p : idxFiles) {
+        auto pack = std::make_unique<Pack>();
+        if (pack->load(p)) gr_packs.push_back(std::move(pack));
+    }
+}
+
+std::string GitRepository::headRef() const {
+    auto head = readSmallFile(gr_gitDir / "HEAD");
+    if (!head || head->rfind("ref: ", 0) != 0) return {};
+    return head->substr(5);
+}
+
+std::optional<std::string> GitRepository::readRefFile(const std::string &name) const {
+    // pseudo-refs (HEAD, ORIG_HEAD, ...) belong to the worktree; refs/ is shared
+    bool shared = name.rfind("refs/", 0) == 0;
+    if (auto text = readSmallFile((shared ? gr_commonDir : gr_gitDir) / name)) return text;
+    if (!shared) return std::nullopt;
+    auto packed = readSmallFile(gr_commonDir / "packed-refs");
+    if (!packed) return std::nullopt;
+    std::istringstream lines(*packed);
+    for (std::string line; std::getline(lines, line);) {
+        if (line.size() > 41 && line[40] == ' ' && line.compare(41, std::string::npos, name) == 0) {
+            return line.substr(0, 40);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<GitOid> GitRepository::resolveRef(const std::string &name, int depth) const {
+    if (depth > MAX_SYMREF_DEPTH) return std::nullopt;
+    auto text = readRefFile(name);
+    if (!text) return std::nullopt;
+    if (text->rfind("ref: ", 0) == 0) return resolveRef(text->substr(5), depth + 1);
+    return GitOid::fromHex(std::string_view(*text).substr(0, 40));
+}
+
+std::optional<GitOid> GitRepository::resolve(std::string_view name) const {
+    size_t steps = name.find_first_of("~^");
+    if (steps != std::string_view::npos) {
+        // <rev>~n and <rev>^n, applied left to right; a missing n means 1
+        auto id = resolve(name.substr(0, steps));
+        for (size_t pos = steps; id && pos < name.size();) {
+            char op = name[pos++];
+            if (op != '~' && op != '^') return std::nullopt;
+            size_t n = 1;
+            if (pos < name.size() && name[pos] >= '0' && name[pos] <= '9') {
+                auto parsed = std::from_chars(name.data() + pos, name.data() + name.size(), n);
+                if (parsed.ec != std::errc()) return std::nullopt; // too large a count
+                pos = static_cast<size_t>(parsed.ptr - name.data());
+            }
+            CommitNode node;
+            if (op == '^') {
+                if (n == 0) continue; // <rev>^0: the commit itself
+                if (!readCommitNode(*id, node) || node.parents.size() < n) return std::nullopt;
+                id = node.parents[n - 1];
+            } else {
+                for (; n; --n) {
+                    if (!readCommitNode(*id, node) || node.parents.empty()) return std::nullopt;
+                    id = node.parents[0];
+                }
+            }
+        }
+        return id;
+    }
+    if (auto id = GitOid::fromHex(name)) return peel(*id);
+    if (name.empty() || name.find("..") != std::string_view::npos) return std::nullopt;
+    // the lookup order of git rev-parse
+    std::string n(name);
+    for (const std::string &candidate : {n, "refs/" + n, "refs/tags/" + n, "refs/heads/" + n,
+                                         "refs/remotes/" + n, "refs/remotes/" + n + "/HEAD"}) {
+        if (auto id = resolveRef(candidate, 0)) return peel(*id);
+    }
+    auto id = resolvePrefix(name);
+    return id ? peel(*id) : std::nullopt;
+}
+
+std::optional<GitOid> GitRepository::peel(GitOid id) const {
+    for (int depth = 0; depth <= MAX_TAG_DEPTH; ++depth) {
+        for (auto &g : gr_graphs) {
+            if (g->find(id)) return id; // a commit, known without reading it
+        }
+        GitObject obj;
+        if (!read(id, obj) || obj.type != GitObject::Tag) return id;
+        // a tag starts with "object <hex>", the object it points at
+        if (obj.data.compare(0, 7, "object ") != 0) return std::nullopt;
+        auto target = GitOid::fromHex(std::string_view(obj.data).substr(7, 40));
+        if (!target) return std::nullopt;
+        id = *target;
+    }
+    return std::nullopt;
+}
+
+std::optional<GitOid> GitRepository::resolvePrefix(std::string_view hex) const {
+    if (hex.size() < MIN_ABBREV || hex.size() >= 40) return std::nullopt;
+    GitOid key;
+    for (size_t i = 0; i < hex.size(); ++i) {
+        int d = hexDigit(hex[i]);
+        if (d < 0) return std::nullopt;
+        key.bytes[i / 2] |= static_cast<unsigned char>(i % 2 ? d : d << 4);
+    }
+    // two distinct matches are enough to know the prefix is ambiguous
+    std::vector<GitOid> found;
+    for (auto &pack : gr_packs) pack->findPrefix(key, hex.size(), 2, found);
+    const std::string digits = key.hex().substr(0, hex.size());
+    for (auto &dir : gr_objectDirs) {
+        std::error_code ec;
+        for (fs::directory_iterator it(dir / digits.substr(0, 2), ec), end; !ec && it != end; it.increment(ec)) {
+            std::string rest = it->path().filename().string();
+            if (rest.compare(0, digits.size() - 2, digits, 2, std::string::npos) != 0) continue;
+            if (auto id = GitOid::fromHex(digits.substr(0, 2) + rest)) found.push_back(*id);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    if (found.size() != 1) return std::nullopt; // unknown or ambiguous
+    return found[0];
+}
+
+bool GitRepository::read(const GitOid &id, GitObject &out) const {
+    return readPacked(id, out) || readLoose(id, out);
+}
+
+bool GitRepository::readLoose(const GitOid &id, GitObject &out) const {
+    std::string hex = id.hex();
+    for (auto &dir : gr_objectDirs) {
+        MappedFile file(dir / hex.substr(0, 2) / hex.substr(2));
+        if (!file.isOpen()) continue;
+        std::string raw;
+        if (!DeflateDecoder::zlibInflate(std::string_view(file.data(), file.size()), raw)) return false;
+        // "<type> <size>\0<data>"
+        size_t space = raw.find(' '), nul = raw.find('\0');
+        if (space == std::string::npos || nul == std::string::npos || space > nul) return false;
+        out.type = typeFromName(std::string_view(raw).substr(0, space));
+        if (out.type == GitObject::None) return false;
+        if (raw.compare(space + 1, nul - space - 1, std::to_string(raw.size() - nul - 1)) != 0) return false;
+        raw.erase(0, nul + 1);
+        out.data = std::move(raw);
+        return true;
+    }
+    return false;
+}
+
+bool GitRepository::readPacked(const GitOid &id, GitObject &out) const {
+    for (auto &pack : gr_packs) {
+        if (auto offset = pack->find(id)) return readPackObject(*pack, *offset, out);
+    }
+    return false;
+}
+
+bool GitRepository::readPackObject(const Pack &pack, uint64_t offset, GitObject &out) const {
+    const MappedFile *file = pack.data();
+    if (!file) return false;
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(file->data());
+    const uint64_t size = file->size() - 20; // trailing pack checksum
+
+    // Follow the delta chain down to its base or to a cached object, keeping the deltas
+    // outermost first together with the offsets of their entries.
+    std::vector<std::pair<uint64_t, std::string>> deltas;
+    std::shared_ptr<const GitObject> cached;
+    GitObject base;
+    std::optional<uint64_t> baseAt; // the base's own entry in this pack (not for REF_DELTA bases)
+    for (uint64_t at = offset;;) {
+        if (deltas.size() > MAX_DELTA_CHAIN) return false;
+        if ((cached = gr_deltaBases->get(&pack, at))) break;
+        PackEntry entry;
+        if (!parsePackEntry(data, size, at, entry)) return false;
+        std::string body;
+        body.reserve(entry.inflated);
+        std::string_view stream(reinterpret_cast<const char *>(data + entry.dataAt), size - entry.dataAt);
+        if (!DeflateDecoder::zlibInflate(stream, body) || body.size() != entry.inflated) return false;
+        if (entry.type <= 4) {
+            base.type = static_cast<GitObject::Type>(entry.type);
+            base.data = std::move(body);
+            baseAt = at;
+            break;
+        }
+        deltas.emplace_back(at, std::move(body));
+        if (entry.refBase) {
+            if (!read(*entry.refBase, base)) return false;
+            break;
+        }
+        at = entry.baseAt;
+    }
+    if (deltas.empty()) {
+        if (cached) out = *cached;
+        else out = std::move(base);
+        return true;
+    }
+
+    // Apply the deltas innermost first; every intermediate result is the base of the next
+    // delta and likely of other objects too, so it goes into the cache.
+    std::shared_ptr<const GitObject> current = cached;
+    if (!current) {
+        current = std::make_shared<const GitObject>(std::move(base));
+        if (baseAt) gr_deltaBases->put(&pack, *baseAt, current);
+    }
+    for (size_t k = deltas.size(); k-- > 0;) {
+        GitObject next;
+        next.type = current->type;
+        if (!applyDelta(current->data, deltas[k].second, next.data)) return false;
+        if (k == 0) {
+            out = std::move(next);
+            break;
+        }
+        auto shared = std::make_shared<const GitObject>(std::move(next));
+        gr_deltaBases->put(&pack, deltas[k].first, shared);
+        current = std::move(shared);
+    }
+    return true;
+}
+
+size_t GitRepository::deltaBaseHits() const {
+    std::lock_guard<std::mutex> lock(gr_deltaBases->mutex);
+    return gr_deltaBases->hits;
+}
+
+std::optional<uint64_t> GitRepository::objectSize(const GitOid &id) const {
+    for (auto &pack : gr_packs) {
+        auto offset = pack->find(id);
+        if (!offset) continue;
+        const MappedFile *file = pack->data();
+        if (!file) return std::nullopt;
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(file->data());
+        const uint64_t size = file->size() - 20;
+        PackEntry entry;
+        if (!parsePackEntry(data, size, *offset, entry)) return std::nullopt;
+        if (entry.type <= 4) return entry.inflated;
+        // a delta starts with the sizes of its base and of its result
+        std::string delta;
+        std::string_view stream(reinterpret_cast<const char *>(data + entry.dataAt), size - entry.dataAt);
+        if (!DeflateDecoder::zlibInflate(stream, delta)) return std::nullopt;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(delta.data()), *end = p + delta.size();
+        uint64_t baseSize = 0, resultSize = 0;
+        if (!readDeltaSize(p, end, baseSize) || !readDeltaSize(p, end, resultSize)) return std::nullopt;
+        return resultSize;
+    }
+    GitObject obj;
+    if (!readLoose(id, obj)) return std::nullopt;
+    return obj.data.size();
+}
+
+std::optional<GitCommit> GitRepository::readCommit(const GitOid &id) const {
+    GitObject obj;
+    GitCommit commit;
+    if (!read(id, obj) || obj.type != GitObject::Commit || !parseCommit(obj.data, commit)) return std::nullopt;
+    return commit;
+}
+
+bool GitRepository::parseCommit(std::string_view data, GitCommit &out) {
+    // "<name> <email> <time> <tz>" after the header keyword
+    auto parseIdent = [](std::string_view line, std::string *who, int64_t &time, int *tz) {
+        size_t gt = line.rfind('>');
+        if (gt == std::string_view::npos) return false;
+        if (who) *who = std::string(line.substr(0, gt + 1));
+        std::istringstream rest(std::string(line.substr(gt + 1)));
+        int zone = 0;
+        if (!(rest >> time)) return false;
+        rest >> zone;
+        if (tz) *tz = zone;
+        return true;
+    };
+    bool haveTree = false;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string_view::npos) eol = data.size();
+        std::string_view line = data.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (line.empty()) break; // the message follows
+        if (line.rfind("tree ", 0) == 0) {
+            auto id = GitOid::fromHex(line.substr(5));
+            if (!id) return false;
+            out.tree = *id;
+            haveTree = true;
+        } else if (line.rfind("parent ", 0) == 0) {
+            auto id = GitOid::fromHex(line.substr(7));
+            if (!id) return false;
+            out.parents.push_back(*id);
+        } else if (line.rfind("author ", 0) == 0) {
+            if (!parseIdent(line.substr(7), &out.author, out.authorTime, &out.authorTz)) return false;
+        } else if (line.rfind("committer ", 0) == 0) {
+            if (!parseIdent(line.substr(10), nullptr, out.commitTime, nullptr)) return false;
+        }
+    }
+    return haveTree;
+}
+
+bool GitRepository::parseTree(std::string_view data, std::vector<GitTreeEntry> &out) {
+    out.clear();
+    // "<octal mode> <name>\0<20-byte id>" per entry
+    size_t pos = 0;
+    while (pos < data.size()) {
+        GitTreeEntry e;
+        while (pos < data.size() && data[pos] != ' ') {
+            if (data[pos] < '0' || data[pos] > '7') return false;
+            e.mode = e.mode * 8 + static_cast<uint32_t>(data[pos++] - '0');
+        }
+        size_t nul = data.find('\0', pos);
+        if (pos == data.size() || nul == std::string_view::npos || nul + 21 > data.size()) return false;
+        e.name = data.substr(pos + 1, nul - pos - 1);
+        e.id = GitOid::fromRaw(data.data() + nul + 1);
+        out.push_back(e);
+        pos = nul + 21;
+    }
+    return true;
+}
+
+bool GitRepository::diffTrees(const GitOid *a, const GitOid *b, const std::function<void(GitChange &&)> &onChange) const {
+    return diffTreesAt(a, b, std::string(), onChange);
+}
+
+bool GitRepository::diffTreesAt(const GitOid *a, const GitOid *b, const std::string &prefix,
+                                const std::function<void(GitChange &&)> &onChange) const {
+    GitObject treeA, treeB;
+    std::vector<GitTreeEntry> ea, eb;
+    if (a && (!read(*a, treeA) || treeA.type != GitObject::Tree || !parseTree(treeA.data, ea))) return false;
+    if (b && (!read(*b, treeB) || treeB.type != GitObject::Tree || !parseTree(treeB.data, eb))) return false;
+
+    // both lists are sorted, so one merge pass pairs up entries of the same name and kind
+    size_t i = 0, j = 0;
+    while (i < ea.size() || j < eb.size()) {
+        int c = i == ea.size() ? 1 : j == eb.size() ? -1 : compareTreeNames(ea[i], eb[j]);
+        const GitTreeEntry *x = c <= 0 ? &ea[i++] : nullptr;
+        const GitTreeEntry *y = c >= 0 ? &eb[j++] : nullptr;
+        if (x && y && x->id == y->id && x->mode == y->mode) continue;
+        std::string path = prefix + std::string(x ? x->name : y->name);
+        if ((x && x->isTree()) || (y && y->isTree())) {
+            // equal names compare equal only for the same kind, so both sides are trees here
+            if (!diffTreesAt(x ? &x->id : nullptr, y ? &y->id : nullptr, path + "/", onChange)) return false;
+            continue;
+        }
+        GitChange change;
+        change.path = std::move(path);
+        if (x) { change.oldMode = x->mode; change.oldId = x->id; }
+        if (y) { change.newMode = y->mode; change.newId = y->id; }
+        onChange(std::move(change));
+    }
+    return true;
+}
+
+bool GitRepository::readCommitNode(const GitOid &id, CommitNode &out) const {
+    auto oidAt = [this](uint32_t pos, GitOid &parent) {
+        for (auto &g : gr_graphs) {
+            if (pos >= g->base && pos - g->base < g->count) {
+                parent = GitOid::fromRaw(g->oids + size_t(pos - g->base) * 20);
+                return true;
+            }
+        }
+        return false;
+    };
+    for (auto &g : gr_graphs) {
+        auto local = g->find(id);
+        if (!local) continue;
+        const unsigned char *r = g->records + size_t(*local) * CommitGraph::RECORD;
+        CommitNode node;
+        node.tree = GitOid::fromRaw(r);
+        uint32_t p1 = be32(r + 20), p2 = be32(r + 24);
+        node.commitTime = static_cast<int64_t>((uint64_t(be32(r + 28) & 3) << 32) | be32(r + 32));
+        GitOid parent;
+        bool ok = true;
+        if (p1 != CommitGraph::NO_PARENT) {
+            ok = oidAt(p1, parent);
+            node.parents.push_back(parent);
+        }
+        if (p2 != CommitGraph::NO_PARENT && (p2 & 0x80000000u)) {
+            // octopus merge: the second and further parents are a list in the EDGE chunk
+            for (size_t e = p2 & 0x7fffffffu; ok; ++e) {
+                if (e >= g->edgeCount) { ok = false; break; }
+                uint32_t v = be32(g->edges + e * 4);
+                ok = oidAt(v & 0x7fffffffu, parent);
+                node.parents.push_back(parent);
+                if (v & 0x80000000u) break;
+            }
+        } else if (p2 != CommitGraph::NO_PARENT) {
+            ok = ok && oidAt(p2, parent);
+            node.parents.push_back(parent);
+        }
+        if (ok) {
+            out = std::move(node);
+            return true;
+        }
+        break; // inconsistent graph: read the object instead
+    }
+    auto commit = readCommit(id);
+    if (!commit) return false;
+    out.tree = commit->tree;
+    out.parents = std::move(commit->parents);
+    out.commitTime = commit->commitTime;
+    return true;
+}
+
+bool GitRepository::pathsChangedSince(const GitOid &head, int64_t since, std::unordered_set<std::string> &paths,
+                                      size_t *commits) const {
+    std::unordered_map<GitOid, CommitNode, GitOidHash> nodes;
+    std::priority_queue<std::pair<int64_t, GitOid>> queue; // newest committer date first
+    auto enqueue = [&](const GitOid &id) {
+        if (nodes.count(id)) return true;
+        CommitNode node;
+        if (!readCommitNode(id, node)) return false;
+        queue.emplace(node.commitTime, id);
+        nodes.emplace(id, std::move(node));
+        return true;
+    };
+    if (!enqueue(head)) return false;
+
+    size_t walked = 0;
+    std::vector<std::string> changed;
+    auto collect = [&](GitChange &&c) { changed.push_back(std::move(c.path)); };
+    while (!queue.empty() && queue.top().first >= since) {
+        GitOid id = queue.top().second;
+        queue.pop();
+        const CommitNode &node = nodes.at(id);
+        ++walked;
+        // parents missing from the object store (a shallow clone's boundary) are left out
+        std::vector<const CommitNode *> parents;
+        for (auto &p : node.parents) {
+            if (enqueue(p)) parents.push_back(&nodes.at(p));
+        }
+        changed.clear();
+        if (parents.empty()) {
+            if (!diffTrees(nullptr, &node.tree, collect)) return false;
+        } else {
+            if (!diffTrees(&parents[0]->tree, &node.tree, collect)) return false;
+            // a merge only counts what differs from every parent: changes made on a merged
+            // branch are found when its own commits are walked
+            for (size_t k = 1; k < parents.size() && !changed.empty(); ++k) {
+                std::unordered_set<std::string> other;
+                if (!diffTrees(&parents[k]->tree, &node.tree, [&](GitChange &&c) { other.insert(std::move(c.path)); })) return false;
+                changed.erase(std::remove_if(changed.begin(), changed.end(),
+                                             [&](const std::string &p) { return !other.count(p); }), changed.end());
+            }
+        }
+        for (auto &p : changed) paths.insert(std::move(p));
+    }
+    if (commits) *commits = walked;
+    return true;
+}
+
+std::optional<GitOid> GitRepository::mergeBase(const GitOid &a, const GitOid &b) const {
+    if (a == b) return a;
+    // walk both histories newest first, marking which side reached each commit; the first
+    // commit reached from both is the merge base
+    struct Seen {
+        CommitNode node;
+        unsigned sides = 0;
+    };
+    std::unordered_map<GitOid, Seen, GitOidHash> seen;
+    std::priority_queue<std::pair<int64_t, GitOid>> queue;
+    auto reach = [&](const GitOid &id, unsigned sides) {
+        auto it = seen.find(id);
+        if (it == seen.end()) {
+            CommitNode node;
+            if (!readCommitNode(id, node)) return;
+            it = seen.emplace(id, Seen{std::move(node), 0}).first;
+        }
+        if ((it->second.sides | sides) == it->second.sides) return;
+        it->second.sides |= sides;
+        queue.emplace(it->second.node.commitTime, id);
+    };
+    reach(a, 1);
+    reach(b, 2);
+    while (!queue.empty()) {
+        GitOid id = queue.top().second;
+        queue.pop();
+        const Seen &s = seen.at(id);
+        if (s.sides == 3) return id;
+        for (auto &p : s.node.parents) reach(p, s.sides);
+    }
+    return std::nullopt;
+}
+
+GitOid GitRepository::hashObject(GitObject::Type type, std::string_view data) {
+    static const char *const names[] = {"", "commit", "tree", "blob", "tag"};
+    std::string header = std::string(names[type]) + " " + std::to_string(data.size());
+    Sha1 sha;
+    sha.update(header.data(), header.size() + 1); // with its terminating NUL
+    sha.update(data.data(), data.size());
+    return sha.finish();
+}
+
+bool GitRepository::readIndex(std::vector<GitIndexEntry> &out) const {
+    out.clear();
+    std::error_code ec;
+    if (!fs::exists(gr_gitDir / "index", ec)) return true; // nothing staged yet
+    MappedFile file(gr_gitDir / "index");
+    if (!file.isOpen() || file.size() < 12 + 20) return false;
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(file.data());
+    const size_t end = file.size() - 20; // trailing checksum
+    uint32_t version = be32(p + 4), count = be32(p + 8);
+    if (std::memcmp(p, "DIRC", 4) != 0 || version < 2 || version > 4) return false;
+
+    size_t pos = 12;
+    std::string previous;
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        // ctime, mtime, dev, ino, mode, uid, gid, size (32 bits each), object name, flags
+        if (pos + 62 > end) return false;
+        const unsigned char *e = p + pos;
+        GitIndexEntry entry;
+        entry.mtimeSec = be32(e + 8);
+        entry.mtimeNsec = be32(e + 12);
+        entry.mode = be32(e + 24);
+        entry.size = be32(e + 36);
+        entry.id = GitOid::fromRaw(e + 40);
+        uint16_t flags = be16(e + 60);
+        entry.stage = (flags >> 12) & 3;
+        size_t header = 62;
+        if (flags & 0x4000) { // extended flags (version 3+)
+            if (pos + 64 > end) return false;
+            entry.skipWorktree = (be16(e + 62) & 0x4000) != 0;
+            header = 64;
+        }
+        size_t at = pos + header;
+        if (version == 4) {
+            // the path drops n bytes from the end of the previous one, then adds a suffix
+            size_t strip = 0;
+            unsigned char c;
+            do {
+                if (at >= end) return false;
+                c = p[at++];
+                strip = (strip << 7) | (c & 0x7f);
+                if (c & 0x80) ++strip;
+            } while (c & 0x80);
+            const void *nul = std::memchr(p + at, 0, end - at);
+            if (!nul || strip > previous.size()) return false;
+            size_t len = static_cast<const unsigned char *>(nul) - (p + at);
+            entry.path = previous.substr(0, previous.size() - strip);
+            entry.path.append(reinterpret_cast<const char *>(p + at), len);
+            pos = at + len + 1;
+        } else {
+            const void *nul = std::memchr(p + at, 0, end - at);
+            if (!nul) return false;
+            size_t len = static_cast<const unsigned char *>(nul) - (p + at);
+            entry.path.assign(reinterpret_cast<const char *>(p + at), len);
+            pos += (header + len + 8) & ~size_t(7); // NUL-padded to a multiple of 8
+        }
+        previous = entry.path;
+        out.push_back(std::move(entry));
+    }
+    return true;
+}
+
+bool GitRepository::workingTreeBlob(const GitIndexEntry &entry, int64_t indexMtime, uint32_t &mode, GitOid &id) const {
+    fs::path file = gr_workTree / fs::u8path(entry.path);
+#if !defined(_WIN32)
+    struct stat st;
+    if (::lstat(file.c_str(), &st) != 0) return false;
+    if (S_ISLNK(st.st_mode)) {
+        std::string target(static_cast<size_t>(st.st_size) + 1, '\0');
+        ssize_t n = ::readlink(file.c_str(), &target[0], target.size());
+        if (n < 0) return false;
+        target.resize(static_cast<size_t>(n));
+        mode = 0120000;
+        id = hashObject(GitObject::Blob, target);
+        return true;
+    }
+    if (!S_ISREG(st.st_mode)) return false;
+    mode = (st.st_mode & S_IXUSR) ? 0100755 : 0100644;
+    // unchanged since it was staged, unless it was written in the same second as the index
+    // ("racily clean": a later edit within that second would keep the same stat data)
+    if (static_cast<uint32_t>(st.st_size) == entry.size && static_cast<uint32_t>(st.st_mtime) == entry.mtimeSec &&
+        static_cast<int64_t>(entry.mtimeSec) < indexMtime && mode == entry.mode) {
+        id = entry.id;
+        return true;
+    }
+#else
+    (void)indexMtime;
+    std::error_code ec;
+    if (!fs::is_regular_file(file, ec)) return false;
+    mode = entry.mode;
+#endif
+    MappedFile data(file);
+    if (!data.isOpen()) return false;
+    id = hashObject(GitObject::Blob, std::string_view(data.data(), data.size()));
+    return true;
+}
+
+bool GitRepository::diffIndex(const GitOid *tree, bool workingTree, const std::function<void(GitChange &&)> &onChange) const {
+    std::unordered_map<std::string, std::pair<uint32_t, GitOid>> base;
+    if (tree && !diffTrees(nullptr, tree, [&](GitChange &&c) {
+            base.emplace(std::move(c.path), std::make_pair(c.newMode, c.newId));
+        })) return false;
+    std::vector<GitIndexEntry> index;
+    if (!readIndex(index)) return false;
+    int64_t indexMtime = 0;
+#if !defined(_WIN32)
+    struct stat st;
+    if (::stat((gr_gitDir / "index").c_str(), &st) == 0) indexMtime = static_cast<int64_t>(st.st_mtime);
+#endif
+
+    std::string lastUnmerged;
+    for (const auto &e : index) {
+        GitChange c;
+        c.path = e.path;
+        c.newMode = e.mode;
+        c.newId = e.id;
+        if (e.stage) {
+            if (e.path == lastUnmerged) continue; // one report for all sides of a conflict
+            lastUnmerged = e.path;
+            c.newId = GitOid();
+        } else if (workingTree && !e.skipWorktree && (e.mode & 0170000) != 0160000) {
+            if (!workingTreeBlob(e, indexMtime, c.newMode, c.newId)) {
+                c.newMode = 0; // deleted from the working tree
+                c.newId = GitOid();
+            }
+        }
+        auto it = base.find(e.path);
+        if (it != base.end()) {
+            c.oldMode = it->second.first;
+            c.oldId = it->second.second;
+            base.erase(it);
+        }
+        if (!e.stage && c.oldMode == c.newMode && c.oldId == c.newId) continue;
+        onChange(std::move(c));
+    }
+    for (auto &[path, old] : base) { // in the tree, no longer in the index
+        GitChange c;
+        c.path = path;
+        c.oldMode = old.first;
+        c.oldId = old.second;
+        onChange(std::move(c));
+    }
+    return true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <functional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "MappedFile.h"
+
+namespace rcpack {
+
+    // SHA-1 object name.
+    struct GitOid {
+        std::array<unsigned char, 20> bytes{};
+
+        std::string hex() const;
+        // 40 hex digits (either case); nullopt for anything else
+        static std::optional<GitOid> fromHex(std::string_view hex);
+        static GitOid fromRaw(const void *raw);
+        bool operator==(const GitOid &o) const { return bytes == o.bytes; }
+        bool operator!=(const GitOid &o) const { return bytes != o.bytes; }
+        bool operator<(const GitOid &o) const { return bytes < o.bytes; }
+    };
+
+    struct GitOidHash {
+        size_t operator()(const GitOid &id) const {
+            size_t h;
+            std::memcpy(&h, id.bytes.data(), sizeof(h)); // already uniformly distributed
+            return h;
+        }
+    };
+
+    struct GitObject {
+        enum Type { None = 0, Commit = 1, Tree = 2, Blob = 3, Tag = 4 };
+        Type type = None;
+        std::string data;
+    };
+
+    struct GitCommit {
+        GitOid tree;
+        std::vector<GitOid> parents;
+        std::string author;     // "Name <email>"
+        int64_t authorTime = 0; // seconds since the epoch
+        int authorTz = 0;       // as written: +0530 -> 530, -0800 -> -800
+        int64_t commitTime = 0;
+    };
+
+    struct GitTreeEntry {
+        uint32_t mode = 0;     // 040000 tree, 0100644/0100755 file, 0120000 symlink, 0160000 submodule
+        std::string_view name; // points into the tree object's data
+        GitOid id;
+        bool isTree() const { return mode == 040000; }
+    };
+
+    // One path that differs between two trees; a zero mode means absent on that side.
+    struct GitChange {
+        std::string path; // relative to the tree root, '/'-separated
+        uint32_t oldMode = 0, newMode = 0;
+        GitOid oldId, newId;
+    };
+
+    // One .git/index entry (stage 0, or one side of an unresolved merge conflict).
+    struct GitIndexEntry {
+        std::string path;
+        GitOid id;
+        uint32_t mode = 0;
+        uint32_t mtimeSec = 0, mtimeNsec = 0;
+        uint32_t size = 0; // file size, truncated to 32 bits as git stores it
+        unsigned stage = 0;
+        bool skipWorktree = false; // sparse checkout: no working tree file is expected
+    };
+
+    // Read-only access to a repository's .git directory without running git: HEAD, loose refs
+    // and packed-refs, and objects stored loose or in pack files (index v2, offset and ref
+    // deltas, with a cache of resolved delta bases). Linked worktrees (a .git file) and
+    // objects/info/alternates are followed. Reads are thread-safe once open() has returned.
+    class GitRepository {
+    public:
+        GitRepository();
+        ~GitRepository();
+        GitRepository(const GitRepository &) = delete;
+        GitRepository &operator=(const GitRepository &) = delete;
+
+        // Finds the repository containing path by walking up to a .git entry. False when there
+        // is none or it has no HEAD.
+        bool open(const std::filesystem::path &path);
+        const std::filesystem::path &workTree() const { return gr_workTree; }
+        const std::filesystem::path &gitDir() const { return gr_gitDir; }
+
+        // HEAD's symbolic target ("refs/heads/main"); empty when HEAD is detached.
+        std::string headRef() const;
+        // HEAD, a full ref name, a branch, tag or remote name, 40 hex digits or a unique prefix
+        // of at least 4 of them, optionally followed by ~n (n-th first-parent ancestor) and ^n
+        // (n-th parent) steps. Annotated tags are peeled to the object they tag. nullopt for
+        // unknown names, ambiguous prefixes and damaged tags.
+        std::optional<GitOid> resolve(std::string_view name) const;
+        // The newest commit (by committer date) reachable from both a and b.
+        std::optional<GitOid> mergeBase(const GitOid &a, const GitOid &b) const;
+
+        bool read(const GitOid &id, GitObject &out) const;
+        // Size of an object's data without reading all of it (packed deltas: only the delta).
+        std::optional<uint64_t> objectSize(const GitOid &id) const;
+        // Objects served from the delta base cache (resolved bases of packed delta chains).
+        size_t deltaBaseHits() const;
+        // Reads id and parses it as a commit (nullopt for missing objects and other types).
+        std::optional<GitCommit> readCommit(const GitOid &id) const;
+        static bool parseCommit(std::string_view data, GitCommit &out);
+        // Entries of a tree object in stored order (git's order: directories sort as "name/").
+        static bool parseTree(std::string_view data, std::vector<GitTreeEntry> &out);
+
+        // Calls onChange for every file that differs between trees a and b (nullptr = empty
+        // tree), recursing only into subtrees whose ids differ. False when a tree is missing.
+        bool diffTrees(const GitOid *a, const GitOid *b, const std::function<void(GitChange &&)> &onChange) const;
+
+        // Changes from tree (nullptr = empty) to the index or, with workingTree, to the working
+        // tree files the index tracks (untracked files are not considered). A file whose size
+        // and modification time match its index entry is taken to be unchanged; others are
+        // hashed. Deleted files have a zero newMode; unmerged paths a zero newId.
+        bool diffIndex(const GitOid *tree, bool workingTree, const std::function<void(GitChange &&)> &onChange) const;
+        bool readIndex(std::vector<GitIndexEntry> &out) const;
+        // Object name of data stored as type: SHA-1 of "<type> <size>\0<data>"
+        static GitOid hashObject(GitObject::Type type, std::string_view data);
+
+        // Paths touched by the commits reachable from head whose committer date is at or after
+        // since: each commit is diffed against its parent (merges: only paths that differ from
+        // every parent). The walk runs newest first and stops at the first older commit.
+        // Commit parents, trees and dates come from the commit-graph file when it covers them.
+        bool pathsChangedSince(const GitOid &head, int64_t since, std::unordered_set<std::string> &paths,
+                               size_t *commits = nullptr) const;
+        bool hasCommitGraph() const { return !gr_graphs.empty(); }
+
+    private:
+        struct Pack;
+        struct CommitGraph;
+        struct DeltaBaseCache;
+        struct CommitNode {
+            GitOid tree;
+            std::vector<GitOid> parents;
+            int64_t commitTime = 0;
+        };
+        std::filesystem::path gr_workTree;
+        std::filesystem::path gr_gitDir;    // HEAD and per-worktree refs
+        std::filesystem::path gr_commonDir; // objects, refs and packed-refs
+        std::vector<std::filesystem::path> gr_objectDirs; // own objects/ first, then alternates
+        std::vector<std::unique_ptr<Pack>> gr_packs;
+        std::vector<std::unique_ptr<CommitGraph>> gr_graphs; // a split chain in order, base first
+        std::unique_ptr<DeltaBaseCache> gr_deltaBases;
+
+        std::optional<std::string> readRefFile(const std::string &name) const;
+        std::optional<GitOid> resolveRef(const std::string &name, int depth) const;
+        // The one object whose name starts with hex (4 to 39 digits), from packs and loose objects.
+        std::optional<GitOid> resolvePrefix(std::string_view hex) const;
+        // id, or for an annotated tag the first object down its chain that is not a tag.
+        std::optional<GitOid> peel(GitOid id) const;
+        bool readLoose(const GitOid &id, GitObject &out) const;
+        bool readPacked(const GitOid &id, GitObject &out) const;
+        bool readPackObject(const Pack &pack, uint64_t offset, GitObject &out) const;
+        void loadPacks(const std::filesystem::path &objectDir);
+        void loadCommitGraphs();
+        bool readCommitNode(const GitOid &id, CommitNode &out) const;
+        bool workingTreeBlob(const GitIndexEntry &entry, int64_t indexMtime, uint32_t &mode, GitOid &id) const;
+        bool diffTreesAt(const GitOid *a, const GitOid *b, const std::string &prefix,
+                         const std::function<void(GitChange &&)> &onChange) const;
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace rcpack {
+
+    // 64-bit multiply-mix used by hashBytes (same constants as wyhash).
+    inline uint64_t hashMix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+        // portable fallback: fold the two halves with a multiply-xorshift
+        uint64_t h = (a ^ (b >> 29)) * 0xbf58476d1ce4e5b9ULL;
+        return h ^ (h >> 31) ^ b;
+#endif
+    }
+
+    inline uint64_t hashRead64(const unsigned char *p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // Fast non-cryptographic hash. Consumes 32 bytes per round in four
+    // independent lanes so the compiler can keep them in flight together.
+    inline uint64_t hashBytes(const void *data, size_t len, uint64_t seed = 0) {
+        constexpr uint64_t P0 = 0xa0761d6478bd642fULL;
+        constexpr uint64_t P1 = 0xe7037ed1a0b428dbULL;
+        constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+        constexpr uint64_t P3 = 0x589965cc75374cc3ULL;
+
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        // each lane starts on a different constant than the one it is mixed with, so the
+        // first block's multiplier is never zero
+        uint64_t a = seed ^ P1, b = seed ^ P2, c = seed ^ P3, d = seed ^ P0;
+        size_t i = 0;
+        for (; i + 32 <= len; i += 32) {
+            a = hashMix(hashRead64(p + i) ^ P1, a ^ P0);
+            b = hashMix(hashRead64(p + i + 8) ^ P2, b ^ P1);
+            c = hashMix(hashRead64(p + i + 16) ^ P3, c ^ P2);
+            d = hashMix(hashRead64(p + i + 24) ^ P0, d ^ P3);
+        }
+        uint64_t h = a ^ b ^ c ^ d;
+        for (; i + 8 <= len; i += 8) h = hashMix(hashRead64(p + i) ^ P1, h ^ P0);
+        uint64_t tail = 0;
+        if (i < len) std::memcpy(&tail, p + i, len - i);
+        h = hashMix(tail ^ P2, h ^ P3);
+        return hashMix(h ^ static_cast<uint64_t>(len), P1);
+    }
+
+    inline uint64_t hashString(const std::string &s, uint64_t seed = 0) {
+        return hashBytes(s.data(), s.size(), seed);
+    }
+
+    // Combine an extra value into an existing hash (order-sensitive).
+    inline uint64_t hashCombine(uint64_t h, uint64_t v) {
+        return hashMix(h ^ 0x9e3779b97f4a7c15ULL, v ^ 0xe7037ed1a0b428dbULL);
+    }
+}
@@ -0,0 +1,374 @@
+#include "IncrementalOutput.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static constexpr char INDEX_MAGIC[4] = { 'R', 'C', 'I', 'X' };
+static constexpr uint32_t INDEX_VERSION = 1;
+static constexpr uint64_t NEW_BYTES = UINT64_MAX;
+static constexpr size_t COPY_CHUNK = 8u << 20; // buffer for shifting a range inside the output
+
+namespace {
+    template <typename T>
+    void put(std::string &out, T v) {
+        out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    // bounds-checked little reader over the mapped index
+    struct Cursor {
+        const char *p;
+        const char *end;
+        template <typename T>
+        bool get(T &v) {
+            if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return true;
+        }
+    };
+
+    int64_t mtimeOf(const fs::path &p, std::error_code &ec) {
+        auto t = fs::last_write_time(p, ec);
+        return ec ? 0 : static_cast<int64_t>(t.time_since_epoch().count());
+    }
+}
+
+void FilePatch::addNew(std::string bytes) {
+    if (bytes.empty()) return;
+    uint64_t len = bytes.size();
+    fp_pieces.push_back({fp_size, NEW_BYTES, len, std::move(bytes)});
+    fp_size += len;
+}
+
+void FilePatch::addOld(uint64_t offset, uint64_t length) {
+    if (length == 0) return;
+    // extend the previous range when this one continues it in both layouts
+    if (!fp_pieces.empty()) {
+        Piece &last = fp_pieces.back();
+        if (last.oldOffset != NEW_BYTES && last.oldOffset + last.length == offset) {
+            last.length += length;
+            fp_size += length;
+            return;
+        }
+    }
+    fp_pieces.push_back({fp_size, offset, length, {}});
+    fp_size += length;
+}
+
+bool FilePatch::inOrder() const {
+    uint64_t end = 0;
+    for (const Piece &p : fp_pieces) {
+        if (p.oldOffset == NEW_BYTES) continue;
+        if (p.oldOffset < end) return false;
+        end = p.oldOffset + p.length;
+    }
+    return true;
+}
+
+uint64_t FilePatch::patchCost() const {
+    if (!inOrder()) return UINT64_MAX;
+    uint64_t cost = 0;
+    for (const Piece &p : fp_pieces) {
+        if (p.oldOffset == NEW_BYTES) cost += p.length;
+        else if (p.oldOffset != p.newOffset) cost += 2 * p.length;
+    }
+    return cost;
+}
+
+bool FilePatch::shift(std::fstream &io, const Piece &p, std::string &buf) {
+    // one overlapping copy, walking away from the destination so no byte is read after it
+    // has been overwritten
+    const bool backwards = p.newOffset > p.oldOffset;
+    for (uint64_t done = 0; done < p.length;) {
+        uint64_t n = std::min<uint64_t>(buf.size(), p.length - done);
+        uint64_t at = backwards ? p.length - done - n : done;
+        io.seekg(static_cast<std::streamoff>(p.oldOffset + at));
+        io.read(buf.data(), static_cast<std::streamsize>(n));
+        io.seekp(static_cast<std::streamoff>(p.newOffset + at));
+        io.write(buf.data(), static_cast<std::streamsize>(n));
+        done += n;
+    }
+    return static_cast<bool>(io);
+}
+
+bool FilePatch::apply(const fs::path &file) const {
+    if (!inOrder()) return false;
+    std::error_code ec;
+    const uint64_t oldSize = fs::file_size(file, ec);
+    if (ec) return false;
+    uint64_t largest = 0;
+    for (const Piece &p : fp_pieces) {
+        if (p.oldOffset == NEW_BYTES) continue;
+        if (p.oldOffset + p.length > oldSize) return false;
+        if (p.oldOffset != p.newOffset) largest = std::max(largest, p.length);
+    }
+
+    if (fp_size > oldSize) {
+        fs::resize_file(file, fp_size, ec);
+        if (ec) return false;
+    }
+    std::fstream io(file, std::ios::in | std::ios::out | std::ios::binary);
+    if (!io) return false;
+    // The kept ranges are in the same order in both layouts, so a range moving towards the
+    // end can only land on ranges after it and one moving towards the start only on ranges
+    // before it: the first are moved last to first, the second first to last.
+    std::string buf(static_cast<size_t>(std::min<uint64_t>(COPY_CHUNK, largest)), '\0');
+    for (auto it = fp_pieces.rbegin(); it != fp_pieces.rend(); ++it) {
+        if (it->oldOffset != NEW_BYTES && it->newOffset > it->oldOffset && !shift(io, *it, buf)) return false;
+    }
+    for (const Piece &p : fp_pieces) {
+        if (p.oldOffset != NEW_BYTES && p.newOffset < p.oldOffset && !shift(io, p, buf)) return false;
+    }
+    // new bytes go into the gaps left between the kept ranges
+    for (const Piece &p : fp_pieces) {
+        if (p.oldOffset != NEW_BYTES) continue;
+        io.seekp(static_cast<std::streamoff>(p.newOffset));
+        io.write(p.bytes.data(), static_cast<std::streamsize>(p.bytes.size()));
+    }
+    io.close();
+    if (!io) return false;
+    if (fp_size < oldSize) {
+        fs::resize_file(file, fp_size, ec);
+        if (ec) return false;
+    }
+    return true;
+}
+
+bool FilePatch::rewrite(const fs::path &file) const {
+    fs::path tmp = file;
+    tmp += ".tmp";
+    {
+        MappedFile old(file);
+        auto sink = FdSink::open(tmp);
+        if (!sink) return false;
+        for (const Piece &p : fp_pieces) {
+            if (p.oldOffset == NEW_BYTES) {
+                sink->write(p.bytes);
+            } else {
+                if (!old.isOpen() || p.oldOffset + p.length > old.size()) return false;
+                sink->write(old.data() + p.oldOffset, static_cast<size_t>(p.length));
+            }
+        }
+        if (!sink->finish()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, file, ec);
+    return !ec;
+}
+
+
+IncrementalOutput::IncrementalOutput(const fs::path &out, uint64_t options): io_out(out), io_options(options) {
+    loadIndex();
+    if (!io_previous) {
+        fs::path tmp = io_out;
+        tmp += ".tmp";
+        io_sink = FdSink::open(tmp);
+    }
+}
+
+IncrementalOutput::~IncrementalOutput() = default;
+
+fs::path IncrementalOutput::indexPath(const fs::path &out) {
+    fs::path p = out;
+    p += ".rcidx";
+    return p;
+}
+
+void IncrementalOutput::loadIndex() {
+    MappedFile idx(indexPath(io_out));
+    if (!idx.isOpen() || idx.size() < 8 || std::memcmp(idx.data(), INDEX_MAGIC, 4) != 0) return;
+    Cursor c{idx.data() + 4, idx.data() + idx.size()};
+    uint32_t version = 0, count = 0;
+    uint64_t options = 0, outSize = 0;
+    int64_t outMtime = 0;
+    if (!c.get(version) || version != INDEX_VERSION || !c.get(options) || options != io_options) return;
+    if (!c.get(outSize) || !c.get(outMtime) || !c.get(io_oldHeaderHash) || !c.get(io_oldHeaderLength) ||
+        !c.get(io_oldSummaryHash) || !c.get(io_oldSummaryLength) || !c.get(count)) return;
+
+    // the output must be exactly what the index describes
+    std::error_code ec;
+    if (fs::file_size(io_out, ec) != outSize || ec || mtimeOf(io_out, ec) != outMtime || ec) return;
+    if (io_oldHeaderLength > outSize || io_oldSummaryLength > outSize - io_oldHeaderLength) return;
+
+    io_old.resize(count);
+    for (Entry &e : io_old) {
+        uint32_t pathLen = 0;
+        if (!c.get(e.offset) || !c.get(e.length) || !c.get(e.fileSize) || !c.get(e.mtime) || !c.get(e.hash) ||
+            !c.get(e.lines) || !c.get(e.tokens) || !c.get(pathLen) || static_cast<size_t>(c.end - c.p) < pathLen) {
+            io_old.clear();
+            return;
+        }
+        e.path.assign(c.p, pathLen);
+        c.p += pathLen;
+        if (e.offset + e.length > outSize) {
+            io_old.clear();
+            return;
+        }
+    }
+    for (size_t k = 0; k < io_old.size(); ++k) io_oldByPath.emplace(io_old[k].path, k);
+    io_oldSize = outSize;
+    io_previous = true;
+}
+
+bool IncrementalOutput::saveIndex() const {
+    std::string buf(INDEX_MAGIC, 4);
+    std::error_code ec;
+    put(buf, INDEX_VERSION);
+    put(buf, io_options);
+    put<uint64_t>(buf, fs::file_size(io_out, ec));
+    put(buf, mtimeOf(io_out, ec));
+    put(buf, io_headerHash);
+    put(buf, io_headerLength);
+    put(buf, io_summaryHash);
+    put(buf, io_summaryLength);
+    put(buf, static_cast<uint32_t>(io_entries.size()));
+    if (ec) return false;
+    for (const Entry &e : io_entries) {
+        put(buf, e.offset);
+        put(buf, e.length);
+        put(buf, e.fileSize);
+        put(buf, e.mtime);
+        put(buf, e.hash);
+        put(buf, e.lines);
+        put(buf, e.tokens);
+        put(buf, static_cast<uint32_t>(e.path.size()));
+        buf += e.path;
+    }
+    fs::path tmp = indexPath(io_out);
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        if (!out) return false;
+    }
+    fs::rename(tmp, indexPath(io_out), ec);
+    return !ec;
+}
+
+IncrementalOutput::Item IncrementalOutput::prepare(const FileEntry &fe,
+                                                   const std::function<OutputFormatter::Section()> &render) const {
+    Item item;
+    item.entry.path = fe.path.generic_string();
+    item.entry.fileSize = fe.size;
+    std::error_code ec;
+    item.entry.mtime = mtimeOf(fe.path, ec);
+    auto it = io_oldByPath.find(item.entry.path);
+    if (!ec && it != io_oldByPath.end()) {
+        const Entry &old = io_old[it->second];
+        if (old.fileSize == fe.size && old.mtime == item.entry.mtime) {
+            item.previous = &old;
+            item.section.lines = old.lines;
+            item.section.tokens = old.tokens;
+            return item;
+        }
+    }
+    item.section = render();
+    return item;
+}
+
+void IncrementalOutput::begin(std::string header) {
+    io_headerHash = hashString(header);
+    io_headerLength = header.size();
+    if (io_previous && io_headerHash == io_oldHeaderHash && io_headerLength == io_oldHeaderLength) {
+        io_patch.addOld(0, io_headerLength);
+    } else if (io_sink) {
+        io_sink->write(header);
+    } else {
+        io_patch.addNew(std::move(header));
+    }
+    io_offset = io_headerLength;
+}
+
+void IncrementalOutput::add(Item &&item) {
+    Entry e = std::move(item.entry);
+    e.offset = io_offset;
+    e.lines = static_cast<uint32_t>(item.section.lines);
+    e.tokens = static_cast<uint32_t>(item.section.tokens);
+    if (item.previous) {
+        e.length = item.previous->length;
+        e.hash = item.previous->hash;
+        io_patch.addOld(item.previous->offset, e.length);
+        ++io_reused;
+    } else {
+        const OutputFormatter::Section &sec = item.section;
+        std::string bytes = sec.head;
+        if (sec.rawBytes) {
+            MappedFile mf(fs::path(e.path));
+            bytes.append(mf.data() ? mf.data() : "", std::min(mf.size(), *sec.rawBytes));
+        } else {
+            bytes += sec.bodyRef ? *sec.bodyRef : sec.body;
+        }
+        bytes += sec.tail;
+        e.length = bytes.size();
+        e.hash = hashString(bytes);
+        auto it = io_oldByPath.find(e.path);
+        if (it != io_oldByPath.end() && io_old[it->second].hash == e.hash && io_old[it->second].length == e.length) {
+            // touched but rendered the same
+            io_patch.addOld(io_old[it->second].offset, e.length);
+            ++io_reused;
+        } else if (io_sink) {
+            io_sink->write(bytes);
+        } else {
+            io_patch.addNew(std::move(bytes));
+        }
+    }
+    io_offset += e.length;
+    io_entries.push_back(std::move(e));
+}
+
+void IncrementalOutput::end(std::string summary) {
+    io_summaryHash = hashString(summary);
+    io_summaryLength = summary.size();
+    if (io_previous && io_summaryHash == io_oldSummaryHash && io_summaryLength == io_oldSummaryLength) {
+        io_patch.addOld(io_oldSize - io_oldSummaryLength, io_summaryLength);
+    } else if (io_sink) {
+        io_sink->write(summary);
+    } else {
+        io_patch.addNew(std::move(summary));
+    }
+    io_offset += io_summaryLength;
+}
+
+bool IncrementalOutput::finish() {
+    std::error_code ec;
+    bool ok;
+    if (io_sink) {
+        ok = io_sink->finish();
+        io_sink.reset();
+        fs::path tmp = io_out;
+        tmp += ".tmp";
+        if (ok) fs::rename(tmp, io_out, ec);
+        ok = ok && !ec;
+        io_mode = "wrote the whole output";
+        io_ioBytes = io_offset;
+    } else if (io_patch.patchCost() == 0 && io_patch.size() == io_oldSize) {
+        ok = true;
+        io_mode = "output unchanged";
+    } else if (io_patch.patchCost() < io_patch.size()) {
+        // a torn patch must not be mistaken for a valid output next time
+        fs::remove(indexPath(io_out), ec);
+        io_ioBytes = io_patch.patchCost();
+        ok = io_patch.apply(io_out);
+        io_mode = "patched the output in place";
+    } else {
+        io_ioBytes = io_patch.size();
+        ok = io_patch.rewrite(io_out);
+        io_mode = "rewrote the whole output";
+    }
+    if (!ok) {
+        std::cerr << "Error: cannot update " << io_out.string() << "\n";
+        fs::remove(indexPath(io_out), ec);
+        return false;
+    }
+    if (!saveIndex()) {
+        std::cerr << "Warning: cannot write " << indexPath(io_out).string() << "; the next run writes everything\n";
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "OutputFormatter.h"
+#include "OutputSink.h"
+
+namespace rcpack {
+
+    // A file's new layout as a list of pieces: new bytes, or a range of its current contents.
+    // apply() turns the current file into that layout in place: ranges that stay put are not
+    // touched, each range that moves is shifted with one overlapping copy, and the new bytes
+    // are written into the gaps. rewrite() writes the whole layout to a temporary file and
+    // renames it over.
+    class FilePatch {
+    public:
+        void addNew(std::string bytes);
+        void addOld(uint64_t offset, uint64_t length);
+        uint64_t size() const { return fp_size; }
+        // Bytes apply() would read and write; UINT64_MAX when the kept ranges are reordered,
+        // which apply() does not handle.
+        uint64_t patchCost() const;
+        bool apply(const std::filesystem::path &file) const;
+        bool rewrite(const std::filesystem::path &file) const;
+    private:
+        struct Piece {
+            uint64_t newOffset;
+            uint64_t oldOffset; // UINT64_MAX for new bytes
+            uint64_t length;
+            std::string bytes;
+        };
+        std::vector<Piece> fp_pieces;
+        uint64_t fp_size = 0;
+        bool inOrder() const;
+        static bool shift(std::fstream &io, const Piece &p, std::string &buf);
+    };
+
+    // --incremental: the markdown output is regenerated by patching the previous one. A side
+    // index (<out>.rcidx) records where every file section of the last run was written, with the
+    // file's size, modification time and a hash of the section. Sections of unchanged files are
+    // kept without reading the files; touched files whose section comes out identical are kept
+    // too. Everything else becomes a FilePatch, applied in place unless a full rewrite is cheaper.
+    class IncrementalOutput {
+    public:
+        struct Entry {
+            std::string path;
+            uint64_t offset = 0;
+            uint64_t length = 0;
+            uint64_t fileSize = 0;
+            int64_t mtime = 0;
+            uint64_t hash = 0; // hashBytes of the section
+            uint32_t lines = 0;
+            uint32_t tokens = 0;
+        };
+        // One file's contribution, produced on any thread by prepare() and consumed by add() in
+        // output order. section holds only lines/tokens when previous is set.
+        struct Item {
+            OutputFormatter::Section section;
+            const Entry *previous = nullptr; // unchanged since the last run: reuse its bytes
+            Entry entry;
+        };
+
+        // options: fingerprint of every setting that shapes a section; a different one
+        // discards the previous index.
+        IncrementalOutput(const std::filesystem::path &out, uint64_t options);
+        ~IncrementalOutput();
+        IncrementalOutput(const IncrementalOutput &) = delete;
+        IncrementalOutput &operator=(const IncrementalOutput &) = delete;
+
+        // The previous output and its index match each other (otherwise everything is written).
+        bool hasPrevious() const { return io_previous; }
+        // Stats fe; reuses the previous section when size and mtime are unchanged, otherwise
+        // calls render. Thread-safe.
+        Item prepare(const FileEntry &fe, const std::function<OutputFormatter::Section()> &render) const;
+
+        void begin(std::string header);
+        void add(Item &&item);
+        void end(std::string summary);
+        // Patches or rewrites the output and saves the new index; false on I/O errors.
+        bool finish();
+
+        size_t reused() const { return io_reused; }
+        size_t sections() const { return io_entries.size(); }
+        // How finish() updated the output, and the bytes it read and wrote to do so.
+        const char *mode() const { return io_mode; }
+        uint64_t ioBytes() const { return io_ioBytes; }
+
+        static std::filesystem::path indexPath(const std::filesystem::path &out);
+    private:
+        std::filesystem::path io_out;
+        uint64_t io_options;
+        bool io_previous = false;
+        // previous run
+        std::vector<Entry> io_old;
+        std::unordered_map<std::string, size_t> io_oldByPath;
+        uint64_t io_oldHeaderHash = 0, io_oldHeaderLength = 0;
+        uint64_t io_oldSummaryHash = 0, io_oldSummaryLength = 0, io_oldSize = 0;
+        // this run
+        std::vector<Entry> io_entries;
+        uint64_t io_headerHash = 0, io_headerLength = 0;
+        uint64_t io_summaryHash = 0, io_summaryLength = 0;
+        uint64_t io_offset = 0;
+        FilePatch io_patch;
+        std::unique_ptr<FdSink> io_sink; // no previous output: written straight to a temporary file
+        size_t io_reused = 0;
+        const char *io_mode = "";
+        uint64_t io_ioBytes = 0;
+
+        void loadIndex();
+        bool saveIndex() const;
+    };
+}
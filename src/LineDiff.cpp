@@ -0,0 +1,176 @@
+#include "LineDiff.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace rcpack;
+
+namespace {
+    // Edit distance searched for a middle snake before a range is given up as replaced
+    // outright: keeps huge rewrites from costing O((N+M)D) with a large D.
+    constexpr long MAX_EDIT_DISTANCE = 4096;
+
+    std::string hunkRange(size_t start, size_t count) {
+        // diff(1): an empty range names the line before it; a single line has no count
+        if (count == 0) return std::to_string(start) + ",0";
+        if (count == 1) return std::to_string(start + 1);
+        return std::to_string(start + 1) + "," + std::to_string(count);
+    }
+}
+
+std::vector<std::string_view> LineDiff::splitLines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        size_t end = eol == std::string_view::npos ? text.size() : eol + 1;
+        lines.push_back(text.substr(pos, end - pos));
+        pos = end;
+    }
+    return lines;
+}
+
+LineDiff::LineDiff(std::string_view oldText, std::string_view newText)
+    : ld_old(splitLines(oldText)), ld_new(splitLines(newText)) {
+    std::unordered_map<std::string_view, size_t> ids;
+    ld_oldIds.reserve(ld_old.size());
+    ld_newIds.reserve(ld_new.size());
+    for (auto line : ld_old) ld_oldIds.push_back(ids.emplace(line, ids.size()).first->second);
+    for (auto line : ld_new) ld_newIds.push_back(ids.emplace(line, ids.size()).first->second);
+    ld_deleted.assign(ld_old.size(), false);
+    ld_inserted.assign(ld_new.size(), false);
+
+    long maxD = std::min<long>(static_cast<long>(ld_old.size() + ld_new.size() + 1) / 2, MAX_EDIT_DISTANCE);
+    std::vector<long> fwd(2 * maxD + 2), bwd(2 * maxD + 2);
+    compare(0, ld_old.size(), 0, ld_new.size(), fwd, bwd);
+
+    size_t i = 0, j = 0;
+    while (i < ld_old.size() || j < ld_new.size()) {
+        if (i < ld_old.size() && ld_deleted[i]) {
+            ld_edits.push_back({Op::Delete, i++, j});
+            ++ld_changes;
+        } else if (j < ld_new.size() && ld_inserted[j]) {
+            ld_edits.push_back({Op::Insert, i, j++});
+            ++ld_changes;
+        } else {
+            ld_edits.push_back({Op::Equal, i++, j++});
+        }
+    }
+}
+
+void LineDiff::compare(size_t a0, size_t a1, size_t b0, size_t b1, std::vector<long> &fwd, std::vector<long> &bwd) {
+    const size_t *A = ld_oldIds.data(), *B = ld_newIds.data();
+    while (a0 < a1 && b0 < b1 && A[a0] == B[b0]) ++a0, ++b0;
+    while (a0 < a1 && b0 < b1 && A[a1 - 1] == B[b1 - 1]) --a1, --b1;
+    auto replaceAll = [&] {
+        for (size_t k = a0; k < a1; ++k) ld_deleted[k] = true;
+        for (size_t k = b0; k < b1; ++k) ld_inserted[k] = true;
+    };
+    if (a0 == a1 || b0 == b1) {
+        replaceAll();
+        return;
+    }
+
+    // Middle snake: forward paths from (a0, b0) and reverse paths from (a1, b1), one edit
+    // at a time, until they overlap on some diagonal; fwd/bwd hold the furthest x per diagonal.
+    const long n = static_cast<long>(a1 - a0), m = static_cast<long>(b1 - b0);
+    const long maxD = std::min<long>((n + m + 1) / 2, MAX_EDIT_DISTANCE);
+    const long off = maxD, len = 2 * maxD;
+    std::fill(fwd.begin(), fwd.begin() + len + 2, -1);
+    std::fill(bwd.begin(), bwd.begin() + len + 2, -1);
+    fwd[off + 1] = 0;
+    bwd[off + 1] = 0;
+    const long delta = n - m;
+    const bool front = delta % 2 != 0; // odd delta: overlap is found on a forward step
+    long k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+    long splitX = -1, splitY = -1;
+    for (long d = 0; d < maxD && splitX < 0; ++d) {
+        for (long k1 = -d + k1start; k1 <= d - k1end && splitX < 0; k1 += 2) {
+            long k1off = off + k1;
+            long x1 = (k1 == -d || (k1 != d && fwd[k1off - 1] < fwd[k1off + 1])) ? fwd[k1off + 1] : fwd[k1off - 1] + 1;
+            long y1 = x1 - k1;
+            while (x1 < n && y1 < m && A[a0 + x1] == B[b0 + y1]) ++x1, ++y1;
+            fwd[k1off] = x1;
+            if (x1 > n) {
+                k1end += 2; // ran off the right edge
+            } else if (y1 > m) {
+                k1start += 2; // ran off the bottom edge
+            } else if (front) {
+                long k2off = off + delta - k1;
+                if (k2off >= 0 && k2off < len && bwd[k2off] != -1 && x1 >= n - bwd[k2off]) {
+                    splitX = x1;
+                    splitY = y1;
+                }
+            }
+        }
+        for (long k2 = -d + k2start; k2 <= d - k2end && splitX < 0; k2 += 2) {
+            long k2off = off + k2;
+            long x2 = (k2 == -d || (k2 != d && bwd[k2off - 1] < bwd[k2off + 1])) ? bwd[k2off + 1] : bwd[k2off - 1] + 1;
+            long y2 = x2 - k2;
+            while (x2 < n && y2 < m && A[a1 - 1 - x2] == B[b1 - 1 - y2]) ++x2, ++y2;
+            bwd[k2off] = x2;
+            if (x2 > n) {
+                k2end += 2;
+            } else if (y2 > m) {
+                k2start += 2;
+            } else if (!front) {
+                long k1off = off + delta - k2;
+                if (k1off >= 0 && k1off < len && fwd[k1off] != -1 && fwd[k1off] >= n - x2) {
+                    splitX = fwd[k1off];
+                    splitY = off + splitX - k1off;
+                }
+            }
+        }
+    }
+    if (splitX <= 0 && splitY <= 0) {
+        replaceAll(); // no overlap within MAX_EDIT_DISTANCE (or no progress): replaced outright
+        return;
+    }
+    if (splitX >= n && splitY >= m) {
+        replaceAll();
+        return;
+    }
+    compare(a0, a0 + splitX, b0, b0 + splitY, fwd, bwd);
+    compare(a0 + splitX, a1, b0 + splitY, b1, fwd, bwd);
+}
+
+std::string LineDiff::unified(const std::string &oldName, const std::string &newName, size_t context) const {
+    if (ld_changes == 0) return {};
+    std::string out;
+    out += "--- " + (oldName.empty() ? std::string("/dev/null") : "a/" + oldName) + "\n";
+    out += "+++ " + (newName.empty() ? std::string("/dev/null") : "b/" + newName) + "\n";
+
+    auto line = [&](char prefix, std::string_view text) {
+        out += prefix;
+        out += text;
+        if (text.empty() || text.back() != '\n') out += "\n\\ No newline at end of file\n";
+    };
+    const size_t count = ld_edits.size();
+    size_t k = 0;
+    while (k < count) {
+        while (k < count && ld_edits[k].op == Op::Equal) ++k;
+        if (k == count) break;
+        // the hunk runs from context lines before this change to context lines after the last
+        // change that follows with at most 2 * context equal lines in between
+        size_t begin = k >= context ? k - context : 0;
+        size_t last = k;
+        for (size_t e = k + 1; e < count; ++e) {
+            if (ld_edits[e].op == Op::Equal) continue;
+            if (e - last - 1 > 2 * context) break;
+            last = e;
+        }
+        size_t end = std::min(count, last + 1 + context);
+        size_t oldCount = 0, newCount = 0;
+        for (size_t e = begin; e < end; ++e) {
+            if (ld_edits[e].op != Op::Insert) ++oldCount;
+            if (ld_edits[e].op != Op::Delete) ++newCount;
+        }
+        out += "@@ -" + hunkRange(ld_edits[begin].oldLine, oldCount) + " +" + hunkRange(ld_edits[begin].newLine, newCount) + " @@\n";
+        for (size_t e = begin; e < end; ++e) {
+            const Edit &ed = ld_edits[e];
+            if (ed.op == Op::Insert) line('+', ld_new[ed.newLine]);
+            else line(static_cast<char>(ed.op), ld_old[ed.oldLine]);
+        }
+        k = end;
+    }
+    return out;
+}
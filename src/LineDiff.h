@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rcpack {
+
+    // Line diff with Myers' O(ND) algorithm in linear space (middle-snake bisection), after
+    // trimming the common head and tail. Lines are compared with their '\n', so a missing final
+    // newline is a change, as in diff(1).
+    class LineDiff {
+    public:
+        enum class Op : char { Equal = ' ', Delete = '-', Insert = '+' };
+        struct Edit {
+            Op op;
+            size_t oldLine; // 0-based index into the old lines (Equal, Delete)
+            size_t newLine; // 0-based index into the new lines (Equal, Insert)
+        };
+
+        LineDiff(std::string_view oldText, std::string_view newText);
+
+        // Minimal edit script: every old and new line once, in order.
+        const std::vector<Edit> &edits() const { return ld_edits; }
+        size_t changes() const { return ld_changes; }
+
+        // Unified diff ("--- a/x", "+++ b/x", "@@ -l,n +l,n @@" hunks) with context lines
+        // around each change; empty when the texts are equal. An empty name prints /dev/null.
+        std::string unified(const std::string &oldName, const std::string &newName, size_t context = 3) const;
+
+        static std::vector<std::string_view> splitLines(std::string_view text);
+
+    private:
+        std::vector<std::string_view> ld_old, ld_new;
+        std::vector<size_t> ld_oldIds, ld_newIds; // lines interned to integers
+        std::vector<bool> ld_deleted, ld_inserted;
+        std::vector<Edit> ld_edits;
+        size_t ld_changes = 0;
+
+        void compare(size_t a0, size_t a1, size_t b0, size_t b1, std::vector<long> &fwd, std::vector<long> &bwd);
+    };
+}
@@ -0,0 +1,178 @@
+#include "Lz4.h"
+#include <cstdint>
+#include <cstring>
+
+using namespace rcpack;
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5; // a block ends with at least this many literals
+    constexpr size_t MF_LIMIT = 12;     // no match may start closer than this to the end
+    constexpr size_t MAX_DISTANCE = 65535;
+    constexpr unsigned HASH_LOG = 12;
+
+    inline uint32_t read32(const unsigned char *p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void putLength(std::string &out, size_t rem) {
+        for (; rem >= 255; rem -= 255) out.push_back(static_cast<char>(255));
+        out.push_back(static_cast<char>(rem));
+    }
+
+    // token, literal run and (unless last) offset and match length
+    void emitSequence(std::string &out, const unsigned char *lit, size_t litLen, size_t offset, size_t matchLen, bool last) {
+        size_t ml = last ? 0 : matchLen - MIN_MATCH;
+        out.push_back(static_cast<char>(((litLen < 15 ? litLen : 15) << 4) | (ml < 15 ? ml : 15)));
+        if (litLen >= 15) putLength(out, litLen - 15);
+        out.append(reinterpret_cast<const char *>(lit), litLen);
+        if (last) return;
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (ml >= 15) putLength(out, ml - 15);
+    }
+
+    void putLE32(std::string &out, uint32_t v) {
+        for (int b = 0; b < 4; ++b) out.push_back(static_cast<char>((v >> (8 * b)) & 0xff));
+    }
+
+    inline uint32_t rotl(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+    // reads a 255-continued length extension; false when it runs off the input
+    bool getLength(const unsigned char *&ip, const unsigned char *end, size_t &len) {
+        unsigned char b;
+        do {
+            if (ip >= end) return false;
+            b = *ip++;
+            len += b;
+        } while (b == 255);
+        return true;
+    }
+}
+
+void Lz4::compressBlock(std::string_view src, std::string &out) {
+    const unsigned char *s = reinterpret_cast<const unsigned char *>(src.data());
+    const size_t n = src.size();
+    out.reserve(out.size() + n + n / 255 + 16);
+
+    size_t anchor = 0;
+    if (n > MF_LIMIT) {
+        uint32_t table[1u << HASH_LOG] = {}; // position + 1; 0 = empty
+        const size_t limit = n - MF_LIMIT, matchEnd = n - LAST_LITERALS;
+        size_t ip = 0;
+        unsigned misses = 0;
+        while (ip < limit) {
+            uint32_t seq = read32(s + ip);
+            uint32_t h = (seq * 2654435761u) >> (32 - HASH_LOG);
+            size_t ref = table[h];
+            table[h] = static_cast<uint32_t>(ip + 1);
+            if (ref == 0 || ip - (ref - 1) > MAX_DISTANCE || read32(s + ref - 1) != seq) {
+                ip += 1 + (misses++ >> 6); // skip faster through incompressible data
+                continue;
+            }
+            --ref;
+            while (ip > anchor && ref > 0 && s[ip - 1] == s[ref - 1]) { --ip; --ref; }
+            size_t len = MIN_MATCH;
+            while (ip + len < matchEnd && s[ref + len] == s[ip + len]) ++len;
+            emitSequence(out, s + anchor, ip - anchor, ip - ref, len, false);
+            ip += len;
+            anchor = ip;
+            misses = 0;
+        }
+    }
+    emitSequence(out, s + anchor, n - anchor, 0, 0, true);
+}
+
+bool Lz4::decompressBlock(std::string_view src, char *dst, size_t dstLen) {
+    const unsigned char *ip = reinterpret_cast<const unsigned char *>(src.data());
+    const unsigned char *const end = ip + src.size();
+    char *op = dst;
+    char *const oend = dst + dstLen;
+    while (true) {
+        if (ip >= end) return false;
+        unsigned token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !getLength(ip, end, lit)) return false;
+        if (lit > static_cast<size_t>(end - ip) || lit > static_cast<size_t>(oend - op)) return false;
+        std::memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        if (ip == end) return op == oend; // the last sequence has no match
+
+        if (end - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+        size_t len = token & 15;
+        if (len == 15 && !getLength(ip, end, len)) return false;
+        len += MIN_MATCH;
+        if (len > static_cast<size_t>(oend - op)) return false;
+        const char *match = op - offset;
+        if (offset >= len) {
+            std::memcpy(op, match, len);
+        } else {
+            for (size_t k = 0; k < len; ++k) op[k] = match[k]; // overlapping: repeats the pattern
+        }
+        op += len;
+    }
+}
+
+uint32_t Lz4::xxh32(const void *data, size_t len, uint32_t seed) {
+    constexpr uint32_t P1 = 2654435761u, P2 = 2246822519u, P3 = 3266489917u, P4 = 668265263u, P5 = 374761393u;
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *const end = p + len;
+    uint32_t h;
+    if (len >= 16) {
+        uint32_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        for (; end - p >= 16; p += 16) {
+            v1 = rotl(v1 + read32(p) * P2, 13) * P1;
+            v2 = rotl(v2 + read32(p + 4) * P2, 13) * P1;
+            v3 = rotl(v3 + read32(p + 8) * P2, 13) * P1;
+            v4 = rotl(v4 + read32(p + 12) * P2, 13) * P1;
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    } else {
+        h = seed + P5;
+    }
+    h += static_cast<uint32_t>(len);
+    for (; end - p >= 4; p += 4) h = rotl(h + read32(p) * P3, 17) * P4;
+    for (; p < end; ++p) h = rotl(h + *p * P5, 11) * P1;
+    h ^= h >> 15;
+    h *= P2;
+    h ^= h >> 13;
+    h *= P3;
+    h ^= h >> 16;
+    return h;
+}
+
+void Lz4::frameHeader(std::string &out) {
+    putLE32(out, 0x184D2204);
+    // version 01, independent blocks, block checksums; 1 MiB maximum block size
+    const unsigned char descriptor[2] = {0x70, 0x60};
+    out.push_back(static_cast<char>(descriptor[0]));
+    out.push_back(static_cast<char>(descriptor[1]));
+    out.push_back(static_cast<char>((xxh32(descriptor, 2) >> 8) & 0xff));
+}
+
+void Lz4::frameBlock(std::string_view chunk, std::string &out) {
+    size_t at = out.size();
+    putLE32(out, 0); // size, patched below
+    compressBlock(chunk, out);
+    size_t stored = out.size() - at - 4;
+    uint32_t word = static_cast<uint32_t>(stored);
+    if (stored >= chunk.size()) {
+        // incompressible: store the bytes (high bit of the size marks it)
+        out.resize(at + 4);
+        out.append(chunk);
+        stored = chunk.size();
+        word = static_cast<uint32_t>(stored) | 0x80000000u;
+    }
+    for (int b = 0; b < 4; ++b) out[at + b] = static_cast<char>((word >> (8 * b)) & 0xff);
+    putLE32(out, xxh32(out.data() + at + 4, stored));
+}
+
+void Lz4::frameEnd(std::string &out) {
+    putLE32(out, 0);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace rcpack {
+
+    // LZ4 block format: greedy single-probe matcher with a 4K-entry hash table, output
+    // readable by any LZ4 decoder. Used bare for .rcpk content blocks and wrapped in the LZ4
+    // frame format (independent blocks of up to 1 MiB, each with an XXH32 checksum) for -o *.lz4.
+    class Lz4 {
+    public:
+        static constexpr size_t FRAME_BLOCK_MAX = 1 << 20;
+
+        // Appends src compressed as one block.
+        static void compressBlock(std::string_view src, std::string &out);
+        // Decodes one block into exactly dstLen bytes; false when the input is malformed
+        // or does not decode to dstLen bytes.
+        static bool decompressBlock(std::string_view src, char *dst, size_t dstLen);
+
+        // Frame pieces: header, then one frameBlock per chunk of at most FRAME_BLOCK_MAX bytes,
+        // then frameEnd.
+        static void frameHeader(std::string &out);
+        static void frameBlock(std::string_view chunk, std::string &out);
+        static void frameEnd(std::string &out);
+        static uint32_t xxh32(const void *data, size_t len, uint32_t seed = 0);
+    };
+}
@@ -0,0 +1,76 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <iostream>
+
+#if !defined(_WIN32)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+using namespace rcpack;
+
+MappedFile::MappedFile(const std::filesystem::path &p) { open(p); }
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this == &other) return *this;
+    close();
+    mf_fallback = std::move(other.mf_fallback);
+    mf_mapped = other.mf_mapped;
+    mf_size = other.mf_size;
+    mf_data = mf_mapped ? other.mf_data : mf_fallback.data();
+    other.mf_data = nullptr;
+    other.mf_size = 0;
+    other.mf_mapped = false;
+    return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path &p) {
+    close();
+#if !defined(_WIN32)
+    int fd = ::open(p.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    mf_size = static_cast<size_t>(st.st_size);
+    if (mf_size == 0) {
+        // mmap rejects zero-length mappings; an empty file is still a valid view
+        ::close(fd);
+        mf_mapped = true;
+        return true;
+    }
+    void *addr = mmap(nullptr, mf_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) { mf_size = 0; return false; }
+    mf_data = static_cast<const char *>(addr);
+    mf_mapped = true;
+    return true;
+#else
+    std::ifstream in(p, std::ios::in | std::ios::binary);
+    if (!in) return false;
+    std::error_code ec;
+    auto sz = std::filesystem::file_size(p, ec);
+    if (ec) return false;
+    mf_fallback.resize(static_cast<size_t>(sz));
+    in.read(&mf_fallback[0], static_cast<std::streamsize>(sz));
+    mf_fallback.resize(static_cast<size_t>(in.gcount()));
+    mf_size = mf_fallback.size();
+    mf_data = mf_fallback.data();
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#if !defined(_WIN32)
+    if (mf_mapped && mf_data) munmap(const_cast<char *>(mf_data), mf_size);
+#endif
+    mf_fallback.clear();
+    mf_data = nullptr;
+    mf_size = 0;
+    mf_mapped = false;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+
+namespace rcpack {
+
+    // Read-only view of a whole file. Uses mmap on POSIX; elsewhere the file is
+    // read into an owned buffer so callers see the same interface.
+    class MappedFile {
+        const char *mf_data = nullptr;
+        size_t mf_size = 0;
+        bool mf_mapped = false;
+        std::string mf_fallback;
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path &p);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        bool open(const std::filesystem::path &p);
+        void close();
+        bool isOpen() const { return mf_data != nullptr || mf_mapped; }
+        const char *data() const { return mf_data; }
+        size_t size() const { return mf_size; }
+    };
+}
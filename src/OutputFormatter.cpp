@@ -1,71 +1,256 @@
 #include "OutputFormatter.h"
+#include "BudgetPlanner.h"
+#include "ThreadPool.h"
+#include "DirectoryTree.h"
+#include "MappedFile.h"
+#include "RecordWriter.h"
 #include <system_error>
 #include <iostream>
-#include <map>
 #include <algorithm>
 
 using namespace rcpack;
 
-OutputFormatter::OutputFormatter(std::ostream &out): out_(out){}
+OutputFormatter::OutputFormatter(std::ostream &out)
+    : out_adapter(std::make_unique<OstreamSink>(out)), out_(*out_adapter) {}
 
-void OutputFormatter::printTree(const std::vector<FileEntry>& files, const std::filesystem::path& root) {
-    //std::cerr << "OutputFormatter::printTree: received " << files.size() << " files; root = " << root << "\n";
+OutputFormatter::OutputFormatter(OutputSink &out): out_(out) {}
 
-    // Build a basic tree: map of directories to their children
-    std::map<std::string, std::vector<std::string>> tree;
-    for (const auto& f : files) {
-        std::error_code ec;
-        std::filesystem::path rel = std::filesystem::relative(f.path, root, ec);
-        std::string rels;
-        if (ec) {
-            // Could not compute relative path: log and fallback to filename only
-            std::cerr << "  relative() failed for: " << f.path << " -> " << ec.message() << "\n";
-            rels = f.path.filename().generic_string();
-            // Put it under "." to ensure it's visible in the output tree
-            tree["."].push_back(rels);
-            continue;
-        }
-        else {
-            rels = rel.generic_string();
+// root-relative generic path, or the absolute one when the file lies outside root
+static std::string displayPath(const FileEntry &fe, const std::filesystem::path &root) {
+    std::string_view fast = relativeTo(fe, root);
+    if (!fast.empty()) return std::string(fast);
+    std::error_code ec;
+    auto rel = std::filesystem::relative(fe.path, root, ec);
+    return ec ? fe.path.generic_string() : rel.generic_string();
+}
+
+void OutputFormatter::printSymbols(const std::vector<FileEntry>& files, const std::filesystem::path& root) {
+    out_ << "## Symbols\n\n```\n";
+    uint32_t currentFile = UINT32_MAX;
+    for (size_t r = 0; r < symbols_->size(); ++r) {
+        uint32_t f = symbols_->file(r);
+        if (f != currentFile) {
+            currentFile = f;
+            out_ << (f < files.size() ? displayPath(files[f], root) : std::string("?")) << "\n";
         }
+        size_t depth = 1;
+        for (int32_t p = symbols_->parent(r); p >= 0; p = symbols_->parent(p)) ++depth;
+        out_ << std::string(depth * 2, ' ') << SymbolTable::kindName(symbols_->kind(r)) << ' '
+             << symbols_->name(r) << " :" << symbols_->line(r) << "\n";
+    }
+    out_ << "```\n\n";
+}
 
-        std::filesystem::path p(rels);
-        std::string parent = p.parent_path().generic_string();
-        if (parent.empty()) parent = ".";
-        tree[parent].push_back(p.filename().generic_string());
+void OutputFormatter::writeSymbolsJson(std::ostream &os, const std::filesystem::path &root,
+                                       const std::vector<FileEntry> &files, const SymbolTable &symbols) {
+    // the same escaping as the record output, which keeps non-UTF-8 names valid JSON
+    std::string quoted;
+    auto string = [&](std::string_view s) -> const std::string & {
+        quoted.assign(1, '"');
+        RecordWriter::escapeJson(quoted, s);
+        quoted += '"';
+        return quoted;
+    };
+    os << "{\"files\":[";
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (i) os << ',';
+        os << string(displayPath(files[i], root));
+    }
+    os << "],\n\"name\":[";
+    for (size_t r = 0; r < symbols.size(); ++r) {
+        if (r) os << ',';
+        os << string(symbols.name(r));
+    }
+    os << "],\n\"kind\":[";
+    for (size_t r = 0; r < symbols.size(); ++r) os << (r ? "," : "") << '"' << SymbolTable::kindName(symbols.kind(r)) << '"';
+    os << "],\n\"file\":[";
+    for (size_t r = 0; r < symbols.size(); ++r) os << (r ? "," : "") << symbols.file(r);
+    os << "],\n\"line\":[";
+    for (size_t r = 0; r < symbols.size(); ++r) os << (r ? "," : "") << symbols.line(r);
+    os << "],\n\"parent\":[";
+    for (size_t r = 0; r < symbols.size(); ++r) os << (r ? "," : "") << symbols.parent(r);
+    os << "]}\n";
+}
 
-        // DEBUG: print what we added
-        //std::cerr << "  file: " << f.path << " -> rel: " << rels << " parent: " << parent << "\n";
+void OutputFormatter::addToTree(DirectoryTree& tree, const FileEntry& f, const std::filesystem::path& root) const {
+    std::string_view fast = relativeTo(f, root);
+    if (!fast.empty()) {
+        tree.add(fast, f.size);
+        return;
     }
+    std::error_code ec;
+    std::filesystem::path rel = std::filesystem::relative(f.path, root, ec);
+    if (ec) {
+        // Could not compute relative path: log and list the file name at the top level
+        std::cerr << "  relative() failed for: " << f.path << " -> " << ec.message() << "\n";
+        tree.add(f.path.filename().generic_string(), f.size);
+        return;
+    }
+    tree.add(rel.generic_string(), f.size);
+}
 
-    // Print tree in deterministic order
+void OutputFormatter::printTree(const std::vector<FileEntry>& files, const std::filesystem::path& root) {
+    // scan order is sorted by path, so the trie is built in one pass and printed as built
+    DirectoryTree tree;
+    if (out_partFiles) {
+        for (size_t i : *out_partFiles) {
+            if (i < files.size()) addToTree(tree, files[i], root);
+        }
+    } else {
+        for (const auto& f : files) addToTree(tree, f, root);
+    }
+
+    out_ << "```\n";
+    tree.render(out_);
     out_ << "```\n";
-    std::vector<std::string> keys;
-    for (auto& kv : tree) keys.push_back(kv.first);
-    std::sort(keys.begin(), keys.end());
-    for (auto& k : keys) {
-        // sort children for deterministic output
-        auto &children = tree[k];
-        std::sort(children.begin(), children.end());
-
-        if (k == ".") {
-            for (auto& name : children) out_ << name << "\n";
+}
+
+
+void OutputFormatter::beginRecords(const std::filesystem::path& root, const Config& cfg, const GitInfo& git) {
+    const bool doc = out_format == OutputFormat::Json;
+    const size_t preambleCount = (!cfg.dirsOnly && preambles_) ? preambles_->size() : 0;
+    std::string rec;
+    RecordWriter w(out_format, rec);
+    w.beginMap(4);
+    if (!doc) w.key("type").value("header");
+    w.key("root").value(std::filesystem::absolute(root).generic_string());
+    w.key("git");
+    if (git.isRepo) {
+        w.beginMap(4).key("commit").value(git.commitSHA).key("branch").value(git.branch)
+         .key("author").value(git.author).key("date").value(git.date).endMap();
+    } else {
+        w.null();
+    }
+    w.key("preambles").beginArray(preambleCount);
+    for (size_t p = 0; p < preambleCount; ++p) {
+        const auto &pre = (*preambles_)[p];
+        w.beginMap(3).key("lines").value(pre.lineCount).key("files").value(pre.files.size())
+         .key("text").value(pre.text).endMap();
+    }
+    w.endArray();
+    if (doc) {
+        w.key("files").beginArray(0);
+        rec += '\n';
+    } else {
+        w.endMap();
+        if (out_format == OutputFormat::Jsonl) rec += '\n';
+    }
+    out_ << rec;
+}
+
+OutputFormatter::Section OutputFormatter::renderRecord(const std::filesystem::path& root,
+    const Config& cfg,
+    const ScanResult& scan,
+    size_t i,
+    const FileContent* fc) const {
+    Section sec;
+    sec.file = i;
+    if (fc) {
+        sec.lines = fc->lines;
+        sec.tokens = fc->tokens;
+        sec.duplicate = fc->duplicateOf.has_value();
+    }
+    const auto &fe = scan.files[i];
+    const bool doc = out_format == OutputFormat::Json;
+    const bool withTokens = tokenMode_ && fc;
+    const bool dup = fc && fc->duplicateOf && *fc->duplicateOf < scan.files.size();
+    const bool near = dup && fc->nearDuplicate;
+    const bool omitted = fc && !dup && fc->level == CompressionLevel::NameOnly;
+    const bool reduced = fc && !dup && !omitted && cfg.maxTokens > 0 && fc->level != CompressionLevel::Full;
+    const bool preamble = fc && !dup && !omitted && fc->preambleId;
+    const bool unreadable = fc && !dup && fc->unreadable;
+    const bool content = !dup && !omitted;
+    const bool diff = diffs_ && i < diffs_->size() && !(*diffs_)[i].empty();
+
+    RecordWriter w(out_format, sec.head);
+    w.beginMap((doc ? 0 : 1) + 4 + withTokens + dup + near + omitted + reduced + preamble + unreadable + diff + content);
+    if (!doc) w.key("type").value("file");
+    w.key("path").value(displayPath(fe, root));
+    w.key("size").value(fe.size);
+    w.key("lines").value(sec.lines);
+    if (withTokens) w.key("tokens").value(fc->tokens);
+    w.key("truncated").value(fc && fc->truncated);
+    if (dup) w.key("duplicateOf").value(displayPath(scan.files[*fc->duplicateOf], root));
+    if (near) w.key("similarity").value(fc->similarity);
+    if (omitted) w.key("omitted").value(true);
+    if (reduced) w.key("level").value(BudgetPlanner::levelName(fc->level));
+    if (preamble) w.key("preamble").value(*fc->preambleId + 1);
+    if (unreadable) w.key("unreadable").value(true);
+    if (diff) w.key("diff").value((*diffs_)[i]);
+
+    // the content string comes last so its text can travel as the section body
+    RecordWriter t(out_format, sec.tail);
+    if (content && fc && !unreadable) {
+        w.key("content");
+        if (out_format == OutputFormat::MsgPack) {
+            // MessagePack strings are length-prefixed raw bytes: no transformation at all
+            if (fc->rawBytes) sec.rawBytes = fc->rawBytes;
+            else sec.bodyRef = &fc->content;
+            w.openString(fc->rawBytes ? *fc->rawBytes : fc->content.size());
+        } else {
+            w.openString(0);
+            if (fc->rawBytes) {
+                MappedFile mf(fe.path);
+                RecordWriter::escapeJson(sec.body, std::string_view(mf.data() ? mf.data() : "", std::min(mf.size(), *fc->rawBytes)));
+            } else {
+                RecordWriter::escapeJson(sec.body, fc->content);
+            }
         }
-        else {
-            out_ << k << "/\n";
-            for (auto& name : children) out_ << "  " << name << "\n";
+        t.closeString();
+    } else if (content) {
+        w.key("content").null();
+    }
+    t.endMap();
+    if (out_format == OutputFormat::Jsonl) sec.tail += '\n';
+    return sec;
+}
+
+void OutputFormatter::endRecords(const std::filesystem::path& root, const Config& cfg, const ScanResult& scan) {
+    const bool doc = out_format == OutputFormat::Json;
+    std::string rec;
+    if (cfg.dirsOnly) {
+        // no sections were written: list the files by name
+        for (const auto &fe : scan.files) {
+            if (doc && out_records++) rec += ",\n";
+            RecordWriter w(out_format, rec);
+            w.beginMap(doc ? 2 : 3);
+            if (!doc) w.key("type").value("file");
+            w.key("path").value(displayPath(fe, root)).key("size").value(fe.size).endMap();
+            if (out_format == OutputFormat::Jsonl) rec += '\n';
+            if (rec.size() >= 64 * 1024) { out_ << rec; rec.clear(); }
         }
     }
-    out_ << "```\n";
+    if (doc) rec += out_records ? "\n],\"summary\":" : "],\"summary\":";
+    RecordWriter w(out_format, rec);
+    w.beginMap((doc ? 0 : 1) + 3 + (tokenMode_ ? 2 : 0));
+    if (!doc) w.key("type").value("summary");
+    w.key("files").value(scan.files.size());
+    w.key("lines").value(out_totalLines);
+    if (tokenMode_) w.key("tokens").value(out_totalTokens).key("tokenizer").value(tokenMode_);
+    w.key("duplicates").value(out_duplicates);
+    w.endMap();
+    if (doc) rec += "}\n";
+    else if (out_format == OutputFormat::Jsonl) rec += '\n';
+    out_ << rec;
 }
 
 
-void OutputFormatter::generate(const std::filesystem::path& root,
+void OutputFormatter::begin(const std::filesystem::path& root,
     const Config& cfg,
     const GitInfo& git,
-    const ScanResult& scan,
-    const std::vector<FileContent>& contents) {
-    out_ << "# Repository Context\n\n";
+    const ScanResult& scan) {
+    out_totalLines = 0;
+    out_totalTokens = 0;
+    out_duplicates = 0;
+    out_records = 0;
+    if (out_format != OutputFormat::Markdown) {
+        beginRecords(root, cfg, git);
+        return;
+    }
+
+    out_ << "# Repository Context";
+    if (out_part) out_ << " (part " << out_part << ")";
+    out_ << "\n\n";
     out_ << "## File System Location\n\n";
     out_ << std::filesystem::absolute(root).generic_string() << "\n\n";
 
@@ -84,38 +269,185 @@ void OutputFormatter::generate(const std::filesystem::path& root,
     printTree(scan.files, root);
     out_ << "\n";
 
+    if (symbols_ && !symbols_->empty() && out_part <= 1) printSymbols(scan.files, root);
+
     if (!cfg.dirsOnly) {
+        if (preambles_ && !preambles_->empty()) {
+            out_ << "## Common Preambles\n\n";
+            for (size_t p = 0; p < preambles_->size(); ++p) {
+                const auto &pre = (*preambles_)[p];
+                out_ << "### Preamble " << (p + 1) << " (" << pre.lineCount << " lines, shared by "
+                     << pre.files.size() << " files)\n";
+                out_ << "```\n" << pre.text << "```\n\n";
+            }
+        }
+
         out_ << "## File Contents\n\n";
+    }
+}
 
-        for (size_t i = 0; i < scan.files.size(); ++i) {
-            auto& fe = scan.files[i];
-            out_ << "### File: ";
-            std::error_code ec;
-            auto rel = std::filesystem::relative(fe.path, root, ec);
-            if (!ec) out_ << rel.generic_string() << "\n";
-            else out_ << fe.path.generic_string() << "  (failed to compute relative: " << ec.message() << ")\n";
-
-            out_ << "```\n";
-            if (i < contents.size()) {
-                out_ << contents[i].content;
-                if (contents[i].truncated) out_ << "\n...(truncated)\n";
-            }
-            else {
-                out_ << "(no content read)\n";
-            }
-            out_ << "```\n\n";
+OutputFormatter::Section OutputFormatter::renderSection(const std::filesystem::path& root,
+    const Config& cfg,
+    const ScanResult& scan,
+    size_t i,
+    const FileContent* fc) const {
+    if (out_format != OutputFormat::Markdown) return renderRecord(root, cfg, scan, i, fc);
+    Section sec;
+    sec.file = i;
+    if (fc) {
+        sec.lines = fc->lines;
+        sec.tokens = fc->tokens;
+        sec.duplicate = fc->duplicateOf.has_value();
+    }
+
+    std::string &h = sec.head;
+    auto& fe = scan.files[i];
+    h += "### File: ";
+    std::string_view fast = relativeTo(fe, root);
+    if (!fast.empty()) {
+        h += fast;
+    } else {
+        std::error_code ec;
+        auto rel = std::filesystem::relative(fe.path, root, ec);
+        if (!ec) h += rel.generic_string();
+        else h += fe.path.generic_string() + "  (failed to compute relative: " + ec.message() + ")";
+    }
+    if (tokenMode_ && cfg.tokenCounts && fc) h += " (" + std::to_string(fc->tokens) + " tokens)";
+    h += "\n";
+
+    if (fc && fc->duplicateOf && *fc->duplicateOf < scan.files.size()) {
+        // duplicate: point at the first occurrence instead of repeating it
+        std::string origName = displayPath(scan.files[*fc->duplicateOf], root);
+        if (fc->nearDuplicate) {
+            h += "(near-duplicate of " + origName + ", ~" +
+                 std::to_string(static_cast<int>(fc->similarity * 100.0 + 0.5)) + "% similar; content omitted)\n\n";
+        } else {
+            h += "(identical to " + origName + ")\n\n";
         }
+        return sec;
+    }
 
-        // Summary
-        size_t totalLines = 0;
-        for (auto& c : contents) totalLines += c.lines;
+    if (fc && fc->level == CompressionLevel::NameOnly) {
+        h += "(omitted to fit the token budget)\n\n";
+        return sec;
+    }
+    if (fc && fc->unreadable) {
+        h += "(could not be read)\n\n";
+        return sec;
+    }
+    if (fc && cfg.maxTokens > 0 && fc->level != CompressionLevel::Full) {
+        h += std::string("(reduced to fit the token budget: ") + BudgetPlanner::levelName(fc->level) + ")\n";
+    }
+    if (fc && fc->preambleId) {
+        h += "(begins with common preamble " + std::to_string(*fc->preambleId + 1) + ")\n";
+    }
+    h += "```\n";
+    if (!fc) h += "(no content read)\n";
+    else if (fc->rawBytes) sec.rawBytes = fc->rawBytes;
+    else sec.bodyRef = &fc->content;
+    if (fc && fc->truncated) sec.tail += "\n...(truncated)\n";
+    sec.tail += "```\n\n";
+    if (diffs_ && i < diffs_->size() && !(*diffs_)[i].empty()) sec.tail += "```diff\n" + (*diffs_)[i] + "```\n\n";
+    return sec;
+}
+
+OutputFormatter::Section OutputFormatter::renderSection(const std::filesystem::path& root,
+    const Config& cfg,
+    const ScanResult& scan,
+    size_t i,
+    FileContent&& fc) const {
+    Section sec = renderSection(root, cfg, scan, i, &fc);
+    if (sec.bodyRef) {
+        sec.body = std::move(fc.content);
+        sec.bodyRef = nullptr;
+    }
+    return sec;
+}
+
+OutputFormatter::Section OutputFormatter::unreadableSection(const std::filesystem::path& root,
+    const Config& cfg,
+    const ScanResult& scan,
+    size_t i) const {
+    FileContent fc;
+    fc.unreadable = true;
+    return renderSection(root, cfg, scan, i, &fc);
+}
+
+void OutputFormatter::countSection(const Section& sec) {
+    out_totalLines += sec.lines;
+    out_totalTokens += sec.tokens;
+    if (sec.duplicate) ++out_duplicates;
+}
+
+void OutputFormatter::writeSection(const Section& sec, const ScanResult& scan) {
+    countSection(sec);
+    if (out_format == OutputFormat::Json && out_records) out_ << ",\n";
+    ++out_records;
+
+    if (sec.rawBytes) {
+        // unmodified text: framing goes through the buffer, the bytes are copied from disk
+        out_ << sec.head;
+        size_t copied = out_.copyFile(scan.files[sec.file].path, *sec.rawBytes);
+        if (copied < *sec.rawBytes && out_format == OutputFormat::MsgPack) {
+            // the string length is already written: keep the stream decodable
+            std::cerr << "Warning: " << scan.files[sec.file].path << " changed or became unreadable while packaging\n";
+            out_ << std::string(*sec.rawBytes - copied, ' ');
+        } else if (copied < *sec.rawBytes) {
+            out_ << "\n(file changed or became unreadable while packaging)\n";
+        }
+        out_ << sec.tail;
+        return;
+    }
+    // header, content and closing fence go out as one gathered write
+    std::string_view parts[] = {sec.head, sec.bodyRef ? std::string_view(*sec.bodyRef) : std::string_view(sec.body), sec.tail};
+    out_.writev(parts, 3);
+}
+
+void OutputFormatter::writeFile(const std::filesystem::path& root,
+    const Config& cfg,
+    const ScanResult& scan,
+    size_t i,
+    const FileContent* fc) {
+    if (cfg.dirsOnly || i >= scan.files.size()) return;
+    writeSection(renderSection(root, cfg, scan, i, fc), scan);
+}
+
+void OutputFormatter::end(const std::filesystem::path& root, const Config& cfg, const ScanResult& scan) {
+    if (out_format != OutputFormat::Markdown) {
+        endRecords(root, cfg, scan);
+        return;
+    }
+    if (!cfg.dirsOnly) {
         out_ << "## Summary\n";
-        out_ << "- Total files: " << scan.files.size() << "\n";
-        out_ << "- Total lines: " << totalLines << "\n";
+        if (out_part) out_ << "- Part: " << out_part << "\n";
+        out_ << "- Total files: " << (out_partFiles ? out_partFiles->size() : scan.files.size()) << "\n";
+        out_ << "- Total lines: " << out_totalLines << "\n";
+        if (tokenMode_) out_ << "- Total tokens: " << out_totalTokens << " (" << tokenMode_ << ")\n";
+        if (out_duplicates) out_ << "- Duplicate files: " << out_duplicates << "\n";
 
     } else {
         // print a short note
         out_ << "## File Contents\n\n";
         out_ << "(skipped: directory-only mode)\n\n";
     }
-}
\ No newline at end of file
+}
+
+void OutputFormatter::generate(const std::filesystem::path& root,
+    const Config& cfg,
+    const GitInfo& git,
+    const ScanResult& scan,
+    const std::vector<FileContent>& contents) {
+    begin(root, cfg, git, scan);
+    if (!cfg.dirsOnly) {
+        // sections are rendered on cfg.jobs threads and written in order
+        auto fileAt = [&](size_t k) { return (order_ && k < order_->size()) ? (*order_)[k] : k; };
+        runOrdered<Section>(scan.files.size(), cfg.jobs, cfg.window,
+            [&](size_t k) {
+                size_t i = fileAt(k);
+                return renderSection(root, cfg, scan, i, i < contents.size() ? &contents[i] : nullptr);
+            },
+            [&](size_t, Section &&sec) { writeSection(sec, scan); },
+            [&](size_t k) { return unreadableSection(root, cfg, scan, fileAt(k)); });
+    }
+    end(root, cfg, scan);
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <string>
 #include <ostream>
 #include <vector>
 #include <filesystem>
@@ -7,14 +10,99 @@
 #include "FileReader.h"
 #include "GitInfoCollector.h"
 #include "Config.h"
+#include "PreambleDetector.h"
+#include "SymbolTable.h"
+#include "OutputSink.h"
 
 namespace rcpack {
 
+    class DirectoryTree;
+
     class OutputFormatter {
-        std::ostream &out_;
+    public:
+        // One file's section, rendered off the output thread and written by writeSection().
+        struct Section {
+            size_t file = 0;
+            std::string head;                     // "### File:" line, notes and opening fence
+            std::string body;                     // file text owned by the section...
+            const std::string *bodyRef = nullptr; // ...or still owned by the caller's FileContent
+            std::optional<size_t> rawBytes{};     // ...or the file's first rawBytes, copied by the sink
+            std::string tail;                     // truncation note and closing fence
+            size_t lines = 0;
+            size_t tokens = 0;
+            bool duplicate = false;
+        };
+    private:
+        std::unique_ptr<OstreamSink> out_adapter; // set when constructed from a std::ostream
+        OutputSink &out_;
+        const std::vector<Preamble> *preambles_ = nullptr;
+        const SymbolTable *symbols_ = nullptr;
+        const std::vector<size_t> *order_ = nullptr;
+        const std::vector<std::string> *diffs_ = nullptr;
+        const char *tokenMode_ = nullptr;
+        size_t out_part = 0;                           // shard number; 0 = the whole output
+        const std::vector<size_t> *out_partFiles = nullptr; // the shard's files (sorted indices)
+        OutputFormat out_format = OutputFormat::Markdown;
+        size_t out_records = 0; // file records written (Json: separators between them)
+        // Summary totals accumulated by writeFile
+        size_t out_totalLines = 0;
+        size_t out_totalTokens = 0;
+        size_t out_duplicates = 0;
         void printTree(const std::vector<FileEntry>& files, const std::filesystem::path &root);
+        void addToTree(DirectoryTree &tree, const FileEntry &f, const std::filesystem::path &root) const;
+        void printSymbols(const std::vector<FileEntry>& files, const std::filesystem::path &root);
+        // --format json/jsonl/msgpack counterparts of begin(), renderSection() and end()
+        void beginRecords(const std::filesystem::path &root, const Config &cfg, const GitInfo &git);
+        Section renderRecord(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan,
+                             size_t i, const FileContent *fc) const;
+        void endRecords(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan);
     public:
         OutputFormatter(std::ostream &out);
+        OutputFormatter(OutputSink &out);
+        // Blocks stripped by PreambleDetector; printed once before the file contents.
+        void setPreambles(const std::vector<Preamble> *preambles) { preambles_ = preambles; }
+        // Global symbol index (file column = index into scan.files); printed as a "Symbols" section.
+        void setSymbols(const SymbolTable *symbols) { symbols_ = symbols; }
+        // Print file sections in this order (indices into scan.files) instead of scan order.
+        void setOrder(const std::vector<size_t> *order) { order_ = order; }
+        // Unified diff per file (indexed like scan.files; empty = none): a ```diff block after
+        // the content, or a "diff" field in records.
+        void setDiffs(const std::vector<std::string> *diffs) { diffs_ = diffs; }
+        // FileContent::tokens has been filled in; mode names how ("approximate", "BPE vocabulary").
+        void setTokenCounts(const char *mode) { tokenMode_ = mode; }
+        // Write records instead of markdown. Json is one document whose "files" array holds a
+        // record per file; Jsonl and MsgPack write a header record, one record per file and a
+        // summary record, each usable as soon as it arrives. Json and Jsonl need the text
+        // itself, so files should not be loaded with FileContent::rawBytes for them.
+        void setFormat(OutputFormat format) { out_format = format; }
+        // Markdown shard of a split output (see ShardedOutput): the title carries the part number,
+        // the Structure tree and the Summary cover only files (indices into scan.files, sorted),
+        // and the Symbols section is left to part 1.
+        void setPart(size_t part, const std::vector<size_t> *files) { out_part = part; out_partFiles = files; }
+        // Columnar JSON: {"files":[...],"name":[...],"kind":[...],"file":[...],"line":[...],"parent":[...]}
+        static void writeSymbolsJson(std::ostream &os, const std::filesystem::path &root,
+                                     const std::vector<FileEntry> &files, const SymbolTable &symbols);
+        // Streaming interface: begin() writes everything up to the file sections (tree, symbols,
+        // preambles), writeFile() one section (fc == nullptr when nothing was read), end() the
+        // Summary. generate() is begin + writeFile for every file + end.
+        void begin(const std::filesystem::path &root, const Config &cfg, const GitInfo &git, const ScanResult &scan);
+        void writeFile(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan,
+                       size_t i, const FileContent *fc);
+
+        // Thread-safe halves of writeFile: render on any thread, write in order on one.
+        // The FileContent* overload references fc's text; the && overload takes it over.
+        Section renderSection(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan,
+                              size_t i, const FileContent *fc) const;
+        Section renderSection(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan,
+                              size_t i, FileContent &&fc) const;
+        // The "(could not be read)" section for file i, for a render that failed.
+        Section unreadableSection(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan,
+                                  size_t i) const;
+        void writeSection(const Section &section, const ScanResult &scan);
+        // Adds a section to the Summary totals without writing it (it is already in the output).
+        void countSection(const Section &section);
+        void end(const std::filesystem::path &root, const Config &cfg, const ScanResult &scan);
+
         void generate(const std::filesystem::path &root,
               const Config &cfg,
               const GitInfo &git,
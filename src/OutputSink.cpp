@@ -0,0 +1,316 @@
+#include "OutputSink.h"
+#include "Deflate.h"
+#include "Lz4.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+using namespace rcpack;
+
+void OutputSink::writev(const std::string_view *parts, size_t count) {
+    for (size_t i = 0; i < count; ++i) write(parts[i].data(), parts[i].size());
+}
+
+size_t OutputSink::copyFile(const std::filesystem::path &p, size_t len) {
+    std::ifstream in(p, std::ios::in | std::ios::binary);
+    if (!in) return 0;
+    std::vector<char> chunk(64 * 1024);
+    size_t done = 0;
+    while (done < len && in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(std::min(chunk.size(), len - done)));
+        size_t n = static_cast<size_t>(in.gcount());
+        if (n == 0) break;
+        write(chunk.data(), n);
+        done += n;
+    }
+    return done;
+}
+
+static char *allocateBuffer(size_t capacity) {
+#if defined(_WIN32)
+    return static_cast<char *>(std::malloc(capacity));
+#else
+    void *p = nullptr;
+    if (posix_memalign(&p, 4096, capacity) != 0) return nullptr;
+    return static_cast<char *>(p);
+#endif
+}
+
+FdSink::FdSink(int fd, size_t capacity)
+    : fs_fd(fd), fs_owned(false), fs_capacity(capacity), fs_buffer(allocateBuffer(capacity), std::free) {
+    if (!fs_buffer) fs_capacity = 0; // unbuffered: every write goes straight out
+}
+
+FdSink::~FdSink() {
+    flush();
+    if (fs_owned && fs_fd >= 0) {
+#if defined(_WIN32)
+        _close(fs_fd);
+#else
+        ::close(fs_fd);
+#endif
+    }
+}
+
+std::unique_ptr<FdSink> FdSink::open(const std::filesystem::path &p, size_t capacity) {
+#if defined(_WIN32)
+    int fd = _wopen(p.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    int fd = ::open(p.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0) {
+        std::cerr << "Error: cannot open output file: " << p.string() << " (" << std::strerror(errno) << ")\n";
+        return nullptr;
+    }
+    auto sink = std::make_unique<FdSink>(fd, capacity);
+    sink->fs_owned = true;
+    return sink;
+}
+
+void FdSink::fail(const char *what) {
+    if (!fs_failed) std::cerr << "Error: " << what << " failed: " << std::strerror(errno) << "\n";
+    fs_failed = true;
+}
+
+void FdSink::writeOut(const std::string_view *parts, size_t count) {
+    if (fs_failed) {
+        fs_used = 0;
+        return;
+    }
+#if defined(_WIN32)
+    std::string_view pending(fs_buffer.get(), fs_used);
+    auto writeAll = [&](std::string_view s) {
+        while (!s.empty() && !fs_failed) {
+            int n = _write(fs_fd, s.data(), static_cast<unsigned>(std::min<size_t>(s.size(), 1u << 30)));
+            if (n < 0) fail("write");
+            else s.remove_prefix(static_cast<size_t>(n));
+        }
+    };
+    writeAll(pending);
+    for (size_t i = 0; i < count; ++i) writeAll(parts[i]);
+#else
+    std::vector<iovec> iov;
+    iov.reserve(count + 1);
+    if (fs_used) iov.push_back({fs_buffer.get(), fs_used});
+    for (size_t i = 0; i < count; ++i) {
+        if (!parts[i].empty()) iov.push_back({const_cast<char *>(parts[i].data()), parts[i].size()});
+    }
+    size_t first = 0;
+    while (first < iov.size()) {
+        int batch = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t n = ::writev(fs_fd, iov.data() + first, batch);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("write");
+            break;
+        }
+        // drop fully written slices, trim a partially written one
+        size_t done = static_cast<size_t>(n);
+        while (first < iov.size() && done >= iov[first].iov_len) done -= iov[first++].iov_len;
+        if (first < iov.size() && done) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + done;
+            iov[first].iov_len -= done;
+        }
+    }
+#endif
+    fs_used = 0;
+}
+
+void FdSink::write(const char *data, size_t len) {
+    if (len == 0) return;
+    if (fs_used + len <= fs_capacity) {
+        std::memcpy(fs_buffer.get() + fs_used, data, len);
+        fs_used += len;
+        return;
+    }
+    std::string_view part(data, len);
+    writev(&part, 1);
+}
+
+void FdSink::writev(const std::string_view *parts, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) total += parts[i].size();
+    if (fs_used + total <= fs_capacity) {
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(fs_buffer.get() + fs_used, parts[i].data(), parts[i].size());
+            fs_used += parts[i].size();
+        }
+        return;
+    }
+    // does not fit: send the buffer and the slices in one gathered call instead of copying
+    writeOut(parts, count);
+}
+
+bool FdSink::flush() {
+    if (fs_used) writeOut(nullptr, 0);
+    return !fs_failed;
+}
+
+size_t FdSink::copyFile(const std::filesystem::path &p, size_t len) {
+#if defined(__linux__)
+    // the buffered framing must reach the fd before the kernel appends after it
+    if (len == 0 || !flush()) return 0;
+    int in = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return 0;
+    size_t done = 0;
+    loff_t offset = 0;
+    while (done < len) {
+        ssize_t n = ::copy_file_range(in, &offset, fs_fd, nullptr, len - done, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break; // EXDEV/EINVAL for pipes and terminals, 0 at end of file
+        done += static_cast<size_t>(n);
+    }
+    while (done < len) {
+        off_t off = static_cast<off_t>(done);
+        ssize_t n = ::sendfile(fs_fd, in, &off, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    // neither worked (or the file shrank): copy what is left through the buffer
+    while (done < len && fs_capacity > 0 && !fs_failed) {
+        ssize_t n = ::pread(in, fs_buffer.get(), std::min(fs_capacity, len - done), static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        fs_used = static_cast<size_t>(n);
+        writeOut(nullptr, 0);
+        done += static_cast<size_t>(n);
+    }
+    ::close(in);
+    return done;
+#else
+    return OutputSink::copyFile(p, len);
+#endif
+}
+
+std::optional<CompressingSink::Codec> CompressingSink::codecFor(const std::filesystem::path &p) {
+    auto ext = p.extension();
+    if (ext == ".gz") return Codec::Gzip;
+    if (ext == ".lz4") return Codec::Lz4;
+    return std::nullopt;
+}
+
+CompressingSink::CompressingSink(std::unique_ptr<OutputSink> inner, Codec codec)
+    : cs_inner(std::move(inner)), cs_codec(codec) {
+    if (cs_codec == Codec::Gzip) cs_deflate = std::make_unique<DeflateEncoder>();
+    cs_chunk.reserve(CHUNK);
+    cs_thread = std::thread([this] { run(); });
+}
+
+CompressingSink::~CompressingSink() {
+    finish();
+}
+
+void CompressingSink::write(const char *data, size_t len) {
+    while (len) {
+        size_t take = std::min(len, CHUNK - cs_chunk.size());
+        cs_chunk.append(data, take);
+        data += take;
+        len -= take;
+        if (cs_chunk.size() == CHUNK) submit();
+    }
+}
+
+void CompressingSink::submit() {
+    if (cs_chunk.empty()) return;
+    std::unique_lock<std::mutex> lock(cs_mutex);
+    cs_drained.wait(lock, [&] { return cs_queue.size() < 2; });
+    cs_queue.push_back(std::move(cs_chunk));
+    cs_wake.notify_one();
+    lock.unlock();
+    cs_chunk = std::string();
+    cs_chunk.reserve(CHUNK);
+}
+
+bool CompressingSink::flush() {
+    if (cs_finished) return cs_ok;
+    submit();
+    std::unique_lock<std::mutex> lock(cs_mutex);
+    cs_drained.wait(lock, [&] { return cs_queue.empty() && !cs_busy; });
+    // the compressor is idle until the next submit(), so the inner sink is ours
+    return cs_inner->flush();
+}
+
+bool CompressingSink::finish() {
+    if (cs_finished) return cs_ok;
+    submit();
+    {
+        std::lock_guard<std::mutex> lock(cs_mutex);
+        cs_closing = true;
+    }
+    cs_wake.notify_one();
+    cs_thread.join();
+    cs_finished = true;
+    cs_ok = cs_inner->finish();
+    return cs_ok;
+}
+
+void CompressingSink::run() {
+    auto putLE32 = [](std::string &out, uint32_t v) {
+        for (int b = 0; b < 4; ++b) out.push_back(static_cast<char>((v >> (8 * b)) & 0xff));
+    };
+    std::string out;
+    if (cs_codec == Codec::Gzip) {
+        // magic, deflate, no flags, no mtime, no extra flags, unknown OS
+        out.assign("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    } else {
+        Lz4::frameHeader(out);
+    }
+    while (true) {
+        std::string chunk;
+        {
+            std::unique_lock<std::mutex> lock(cs_mutex);
+            cs_wake.wait(lock, [&] { return !cs_queue.empty() || cs_closing; });
+            if (cs_queue.empty()) break;
+            chunk = std::move(cs_queue.front());
+            cs_queue.pop_front();
+            cs_busy = true;
+        }
+        cs_drained.notify_all();
+
+        auto start = std::chrono::steady_clock::now();
+        if (cs_codec == Codec::Gzip) {
+            cs_crc = DeflateEncoder::crc32(cs_crc, chunk.data(), chunk.size());
+            cs_deflate->write(chunk, out);
+        } else {
+            Lz4::frameBlock(chunk, out);
+        }
+        cs_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cs_in += chunk.size();
+        cs_out += out.size();
+        cs_inner->write(out.data(), out.size());
+        out.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(cs_mutex);
+            cs_busy = false;
+        }
+        cs_drained.notify_all();
+    }
+    if (cs_codec == Codec::Gzip) {
+        cs_deflate->finish(out);
+        putLE32(out, cs_crc);
+        putLE32(out, static_cast<uint32_t>(cs_in)); // ISIZE is the length modulo 2^32
+    } else {
+        Lz4::frameEnd(out);
+    }
+    cs_out += out.size();
+    cs_inner->write(out.data(), out.size());
+}
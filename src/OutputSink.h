@@ -0,0 +1,150 @@
+#pragma once
+
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+namespace rcpack {
+
+    class DeflateEncoder;
+
+    // Byte sink used by OutputFormatter. Text goes in through operator<< or write(); large
+    // slices can be handed over together with writev() so they are not copied into a buffer.
+    class OutputSink {
+    public:
+        virtual ~OutputSink() = default;
+        virtual void write(const char *data, size_t len) = 0;
+        // Gathered write of count slices; the default writes them one by one.
+        virtual void writev(const std::string_view *parts, size_t count);
+        // Pushes buffered bytes out. Returns false if any write so far has failed.
+        virtual bool flush() = 0;
+        // Ends the output: flush(), after writing the trailer of a compressed stream.
+        virtual bool finish() { return flush(); }
+        // Appends the first len bytes of a file; returns how many were copied (fewer if the
+        // file is shorter or unreadable). The default reads it in chunks and calls write().
+        virtual size_t copyFile(const std::filesystem::path &p, size_t len);
+
+        void write(std::string_view s) { write(s.data(), s.size()); }
+
+        OutputSink &operator<<(std::string_view s) { write(s.data(), s.size()); return *this; }
+        OutputSink &operator<<(const std::string &s) { write(s.data(), s.size()); return *this; }
+        OutputSink &operator<<(const char *s) { return *this << std::string_view(s); }
+        OutputSink &operator<<(char c) { write(&c, 1); return *this; }
+        template <typename T, typename = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, char>::value &&
+                                                          !std::is_same<T, bool>::value>>
+        OutputSink &operator<<(T value) {
+            char buf[24];
+            auto r = std::to_chars(buf, buf + sizeof(buf), value);
+            write(buf, static_cast<size_t>(r.ptr - buf));
+            return *this;
+        }
+    };
+
+    // Buffers into a large page-aligned block and writes it with write(2); a big slice, or a
+    // writev() batch that does not fit, goes out together with the pending buffer in one
+    // writev(2) call. Works for stdout, files and pipes.
+    class FdSink : public OutputSink {
+        int fs_fd;
+        bool fs_owned;
+        bool fs_failed = false;
+        size_t fs_capacity;
+        size_t fs_used = 0;
+        std::unique_ptr<char, void (*)(void *)> fs_buffer;
+        // writes the pending buffer followed by the given slices, retrying short writes
+        void writeOut(const std::string_view *parts, size_t count);
+        void fail(const char *what);
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+        // Does not take ownership of fd (e.g. 1 for stdout).
+        explicit FdSink(int fd, size_t capacity = DEFAULT_CAPACITY);
+        ~FdSink() override;
+        FdSink(const FdSink &) = delete;
+        FdSink &operator=(const FdSink &) = delete;
+
+        // Creates/truncates the file; returns nullptr (after printing an error) on failure.
+        static std::unique_ptr<FdSink> open(const std::filesystem::path &p, size_t capacity = DEFAULT_CAPACITY);
+
+        int fd() const { return fs_fd; }
+        void write(const char *data, size_t len) override;
+        void writev(const std::string_view *parts, size_t count) override;
+        bool flush() override;
+        // Kernel-side copy: copy_file_range(2) into regular files, sendfile(2) into pipes and
+        // anything else it accepts, then a read/write loop for whatever remains.
+        size_t copyFile(const std::filesystem::path &p, size_t len) override;
+        using OutputSink::write;
+    };
+
+    // Compresses everything written into a gzip member (-o *.gz) or an LZ4 frame (-o *.lz4)
+    // on a background thread, so compression overlaps producing the content. Writes are
+    // gathered into 1 MiB chunks; at most two wait for the compressor before write() blocks.
+    class CompressingSink : public OutputSink {
+    public:
+        enum class Codec { Gzip, Lz4 };
+        static constexpr size_t CHUNK = 1 << 20;
+
+        // Codec for an output file name (.gz, .lz4); nullopt for anything else.
+        static std::optional<Codec> codecFor(const std::filesystem::path &p);
+
+        CompressingSink(std::unique_ptr<OutputSink> inner, Codec codec);
+        ~CompressingSink() override;
+        CompressingSink(const CompressingSink &) = delete;
+        CompressingSink &operator=(const CompressingSink &) = delete;
+
+        void write(const char *data, size_t len) override;
+        // Everything written so far is compressed and handed to the inner sink; the stream
+        // stays open.
+        bool flush() override;
+        bool finish() override;
+        using OutputSink::write;
+
+        const char *codecName() const { return cs_codec == Codec::Gzip ? "gzip" : "lz4"; }
+        // Totals for the stats line; valid after finish().
+        uint64_t bytesIn() const { return cs_in; }
+        uint64_t bytesOut() const { return cs_out; }
+        double compressSeconds() const { return cs_seconds; }
+    private:
+        std::unique_ptr<OutputSink> cs_inner;
+        Codec cs_codec;
+        std::string cs_chunk; // being filled by write()
+        std::mutex cs_mutex;
+        std::condition_variable cs_wake;    // compressor: work or closing
+        std::condition_variable cs_drained; // writers: queue space / all done
+        std::deque<std::string> cs_queue;
+        bool cs_busy = false;
+        bool cs_closing = false;
+        bool cs_finished = false;
+        bool cs_ok = true;
+        // owned by the compressor thread until it is joined
+        std::unique_ptr<DeflateEncoder> cs_deflate;
+        uint32_t cs_crc = 0;
+        uint64_t cs_in = 0;
+        uint64_t cs_out = 0;
+        double cs_seconds = 0;
+        std::thread cs_thread;
+
+        void submit();
+        void run();
+    };
+
+    // Adapter over an existing std::ostream (tests, string output).
+    class OstreamSink : public OutputSink {
+        std::ostream &os_;
+    public:
+        explicit OstreamSink(std::ostream &os) : os_(os) {}
+        void write(const char *data, size_t len) override { os_.write(data, static_cast<std::streamsize>(len)); }
+        bool flush() override { os_.flush(); return static_cast<bool>(os_); }
+        using OutputSink::write;
+    };
+}
@@ -0,0 +1,205 @@
+#include "PackFile.h"
+#include "Hash.h"
+#include "Lz4.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace rcpack;
+
+namespace {
+    const char MAGIC[4] = {'R', 'C', 'P', 'K'};
+    const char END_MAGIC[8] = {'R', 'C', 'P', 'K', 'E', 'N', 'D', '\0'};
+
+    void putLE(std::string &out, uint64_t v, int bytes) {
+        for (int b = 0; b < bytes; ++b) out.push_back(static_cast<char>((v >> (8 * b)) & 0xff));
+    }
+
+    uint64_t getLE(const unsigned char *p, size_t bytes) {
+        uint64_t v = 0;
+        for (size_t b = 0; b < bytes; ++b) v |= static_cast<uint64_t>(p[b]) << (8 * b);
+        return v;
+    }
+
+    std::string header() {
+        std::string h(MAGIC, 4);
+        putLE(h, pack::VERSION, 4);
+        putLE(h, 0, 8);
+        return h;
+    }
+}
+
+std::string pack::flagNames(uint8_t flags) {
+    std::string out;
+    if (flags & Truncated) out += "truncated,";
+    if (flags & Reduced) out += "reduced,";
+    if (flags & NoContent) out += "no-content,";
+    if (out.empty()) return "-";
+    out.pop_back();
+    return out;
+}
+
+PackBlock PackWriter::encode(std::string_view text, bool lz4) {
+    PackBlock b;
+    b.rawSize = text.size();
+    b.hash = hashBytes(text.data(), text.size());
+    if (lz4 && text.size() >= 64) {
+        Lz4::compressBlock(text, b.data);
+        if (b.data.size() < text.size()) {
+            b.codec = pack::Lz4;
+            return b;
+        }
+        b.data.clear();
+    }
+    b.data.assign(text.data(), text.size());
+    return b;
+}
+
+void PackWriter::begin() {
+    std::string h = header();
+    pw_out << h;
+    pw_offset = h.size();
+}
+
+void PackWriter::add(std::string path, PackBlock &&block) {
+    Entry e;
+    e.path = std::move(path);
+    e.offset = pw_offset;
+    e.stored = block.data.size();
+    e.raw = block.rawSize;
+    e.hash = block.hash;
+    e.lines = block.lines;
+    e.codec = block.codec;
+    e.flags = block.flags;
+    pw_out << block.data;
+    pw_offset += block.data.size();
+    pw_entries.push_back(std::move(e));
+}
+
+void PackWriter::addAlias(std::string path, size_t original, uint32_t lines) {
+    Entry e = pw_entries[original];
+    e.path = std::move(path);
+    e.lines = lines;
+    pw_entries.push_back(std::move(e));
+}
+
+void PackWriter::finish() {
+    std::vector<size_t> order(pw_entries.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return pw_entries[a].path < pw_entries[b].path; });
+
+    std::string index;
+    putLE(index, pw_entries.size(), 4);
+    uint64_t nameOffset = 0;
+    for (size_t i : order) {
+        const Entry &e = pw_entries[i];
+        putLE(index, e.offset, 8);
+        putLE(index, e.stored, 8);
+        putLE(index, e.raw, 8);
+        putLE(index, e.hash, 8);
+        putLE(index, nameOffset, 4);
+        putLE(index, e.path.size(), 4);
+        putLE(index, e.lines, 4);
+        putLE(index, e.codec, 1);
+        putLE(index, e.flags, 1);
+        putLE(index, 0, 2);
+        nameOffset += e.path.size();
+    }
+    for (size_t i : order) index += pw_entries[i].path;
+
+    std::string h = header();
+    std::string footer;
+    putLE(footer, pw_offset, 8);
+    putLE(footer, index.size(), 8);
+    putLE(footer, hashBytes(index.data(), index.size(), hashBytes(h.data(), h.size())), 8);
+    footer.append(END_MAGIC, 8);
+    pw_out << index << footer;
+    pw_offset += index.size() + footer.size();
+}
+
+bool PackReader::open(const std::filesystem::path &p) {
+    if (!pr_file.open(p)) {
+        std::cerr << "Error: cannot open pack: " << p.string() << "\n";
+        return false;
+    }
+    const unsigned char *d = reinterpret_cast<const unsigned char *>(pr_file.data());
+    const size_t n = pr_file.size();
+    if (n < pack::HEADER_SIZE + pack::FOOTER_SIZE || std::memcmp(d, MAGIC, 4) != 0 ||
+        std::memcmp(d + n - 8, END_MAGIC, 8) != 0) {
+        std::cerr << "Error: not an .rcpk file: " << p.string() << "\n";
+        return false;
+    }
+    if (getLE(d + 4, 4) != pack::VERSION) {
+        std::cerr << "Error: unsupported .rcpk version " << getLE(d + 4, 4) << ": " << p.string() << "\n";
+        return false;
+    }
+    const unsigned char *f = d + n - pack::FOOTER_SIZE;
+    pr_indexOffset = getLE(f, 8);
+    pr_indexSize = getLE(f + 8, 8);
+    pr_checksum = getLE(f + 16, 8);
+    const uint64_t indexEnd = n - pack::FOOTER_SIZE;
+    if (pr_indexOffset < pack::HEADER_SIZE || pr_indexSize < 4 || pr_indexOffset > indexEnd ||
+        pr_indexSize != indexEnd - pr_indexOffset) {
+        std::cerr << "Error: damaged .rcpk footer: " << p.string() << "\n";
+        return false;
+    }
+    const unsigned char *index = d + pr_indexOffset;
+    pr_count = static_cast<uint32_t>(getLE(index, 4));
+    if ((pr_indexSize - 4) / pack::ENTRY_SIZE < pr_count) {
+        std::cerr << "Error: damaged .rcpk index: " << p.string() << "\n";
+        return false;
+    }
+    pr_entries = index + 4;
+    pr_names = reinterpret_cast<const char *>(pr_entries + static_cast<size_t>(pr_count) * pack::ENTRY_SIZE);
+    pr_namesSize = pr_indexSize - 4 - static_cast<size_t>(pr_count) * pack::ENTRY_SIZE;
+    return true;
+}
+
+uint64_t PackReader::field(size_t i, size_t at, size_t bytes) const {
+    return getLE(pr_entries + i * pack::ENTRY_SIZE + at, bytes);
+}
+
+std::string_view PackReader::path(size_t i) const {
+    uint64_t off = field(i, 32, 4), len = field(i, 36, 4);
+    if (off > pr_namesSize || len > pr_namesSize - off) return {};
+    return {pr_names + off, static_cast<size_t>(len)};
+}
+
+std::optional<size_t> PackReader::find(std::string_view p) const {
+    size_t lo = 0, hi = pr_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = path(mid).compare(p);
+        if (c == 0) return mid;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return std::nullopt;
+}
+
+bool PackReader::read(size_t i, std::string &out) const {
+    const uint64_t offset = field(i, 0, 8), stored = field(i, 8, 8), raw = field(i, 16, 8);
+    const uint8_t codec = static_cast<uint8_t>(field(i, 44, 1));
+    if (offset < pack::HEADER_SIZE || offset > pr_indexOffset || stored > pr_indexOffset - offset ||
+        (codec == pack::Stored && raw != stored) || raw > (uint64_t(1) << 40)) {
+        std::cerr << "Error: damaged .rcpk entry: " << path(i) << "\n";
+        return false;
+    }
+    std::string_view block(pr_file.data() + offset, static_cast<size_t>(stored));
+    out.resize(static_cast<size_t>(raw));
+    bool ok = codec == pack::Stored ? (std::memcpy(out.data(), block.data(), block.size()), true)
+            : codec == pack::Lz4 ? Lz4::decompressBlock(block, out.data(), out.size())
+            : false;
+    if (!ok || hashBytes(out.data(), out.size()) != field(i, 24, 8)) {
+        std::cerr << "Error: content of " << path(i) << " is damaged (checksum mismatch)\n";
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool PackReader::verifyIndex() const {
+    std::string h = header();
+    return hashBytes(pr_file.data() + pr_indexOffset, static_cast<size_t>(pr_indexSize),
+                     hashBytes(h.data(), h.size())) == pr_checksum;
+}
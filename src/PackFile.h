@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "OutputSink.h"
+
+namespace rcpack {
+
+    // .rcpk container, all integers little-endian:
+    //   header  "RCPK" u32 version u64 reserved                                   (16 bytes)
+    //   blocks  one per distinct file content, stored or LZ4-compressed
+    //   index   u32 count, count entries sorted by path (48 bytes each, below),
+    //           then the paths themselves
+    //   footer  u64 indexOffset u64 indexSize u64 checksum "RCPKEND\0"              (32 bytes)
+    // checksum is hashBytes of the index seeded with hashBytes of the header; every entry
+    // carries hashBytes of its own text, so one file can be checked without reading the others.
+    // Blocks hold the text as packaged, which is not always the file's bytes: cut at the read
+    // limit (Truncated), compressed or budget-reduced (Reduced), left out (NoContent), and a
+    // missing final newline is added as in every other output format.
+    namespace pack {
+        constexpr uint32_t VERSION = 2; // 1: written with the earlier hashBytes
+        constexpr size_t HEADER_SIZE = 16;
+        constexpr size_t ENTRY_SIZE = 48;
+        constexpr size_t FOOTER_SIZE = 32;
+        enum Codec : uint8_t { Stored = 0, Lz4 = 1 };
+        enum Flags : uint8_t { Truncated = 1, Reduced = 2, NoContent = 4 };
+        // "truncated,reduced,no-content" for the set bits, "-" for none
+        std::string flagNames(uint8_t flags);
+    }
+
+    // Index entry: u64 offset, u64 stored size, u64 raw size, u64 hash, u32 path offset,
+    // u32 path length, u32 lines, u8 codec, u8 flags, u16 reserved.
+
+    // One file's content block, encoded off the output thread by PackWriter::encode().
+    struct PackBlock {
+        std::string data;     // bytes as stored
+        uint64_t rawSize = 0; // decoded length
+        uint64_t hash = 0;    // hashBytes of the decoded text
+        uint32_t lines = 0;
+        uint8_t codec = pack::Stored;
+        uint8_t flags = 0;
+    };
+
+    class PackWriter {
+        struct Entry {
+            std::string path;
+            uint64_t offset = 0, stored = 0, raw = 0, hash = 0;
+            uint32_t lines = 0;
+            uint8_t codec = 0, flags = 0;
+        };
+        OutputSink &pw_out;
+        uint64_t pw_offset = 0;
+        std::vector<Entry> pw_entries;
+    public:
+        explicit PackWriter(OutputSink &out) : pw_out(out) {}
+        // Thread-safe. lz4: compress the block when that makes it smaller.
+        static PackBlock encode(std::string_view text, bool lz4);
+
+        void begin();
+        void add(std::string path, PackBlock &&block);
+        // A file with the same text as the one added original-th: shares its block.
+        void addAlias(std::string path, size_t original, uint32_t lines);
+        // Sorts the index by path and writes it and the footer.
+        void finish();
+        size_t fileCount() const { return pw_entries.size(); }
+        uint64_t bytesWritten() const { return pw_offset; }
+    };
+
+    // Random access to a .rcpk: open() maps the file and checks header and footer; find()
+    // is a binary search over the index; read() decodes and verifies one block.
+    class PackReader {
+        MappedFile pr_file;
+        const unsigned char *pr_entries = nullptr;
+        const char *pr_names = nullptr;
+        size_t pr_namesSize = 0;
+        uint32_t pr_count = 0;
+        uint64_t pr_indexOffset = 0, pr_indexSize = 0, pr_checksum = 0;
+        uint64_t field(size_t i, size_t at, size_t bytes) const;
+    public:
+        bool open(const std::filesystem::path &p);
+        size_t size() const { return pr_count; }
+        std::string_view path(size_t i) const;
+        uint64_t rawSize(size_t i) const { return field(i, 16, 8); }
+        uint32_t lines(size_t i) const { return static_cast<uint32_t>(field(i, 40, 4)); }
+        uint8_t flags(size_t i) const { return static_cast<uint8_t>(field(i, 45, 1)); }
+        std::optional<size_t> find(std::string_view path) const;
+        // false (with a message on stderr) when the block is damaged
+        bool read(size_t i, std::string &out) const;
+        // Recomputes the header + index checksum (reads the whole index).
+        bool verifyIndex() const;
+    };
+}
@@ -0,0 +1,95 @@
+#include "PreambleDetector.h"
+#include "Hash.h"
+#include <unordered_map>
+
+using namespace rcpack;
+
+// byte length of the first n lines of s (each including its '\n')
+static size_t prefixBytes(const std::string &s, size_t n) {
+    size_t pos = 0;
+    for (size_t k = 0; k < n; ++k) {
+        size_t nl = s.find('\n', pos);
+        if (nl == std::string::npos) return std::string::npos;
+        pos = nl + 1;
+    }
+    return pos;
+}
+
+std::vector<uint64_t> PreambleDetector::prefixHashes(const std::string &content, size_t maxLines) {
+    std::vector<uint64_t> out;
+    uint64_t h = 0;
+    size_t start = 0;
+    while (out.size() < maxLines) {
+        size_t nl = content.find('\n', start);
+        if (nl == std::string::npos) break; // an unterminated last line never joins a preamble
+        h = hashCombine(h, hashBytes(content.data() + start, nl - start));
+        out.push_back(h);
+        start = nl + 1;
+    }
+    return out;
+}
+
+std::vector<Preamble> PreambleDetector::extract(std::vector<FileContent> &contents,
+                                                size_t minLines, size_t minFiles) {
+    if (minLines == 0) minLines = 1;
+    if (minFiles < 2) minFiles = 2;
+
+    auto eligible = [](const FileContent &fc) { return !fc.duplicateOf; };
+
+    // pass 2a: how many files share each prefix
+    std::unordered_map<uint64_t, size_t> counts;
+    for (auto &fc : contents) {
+        if (!eligible(fc)) continue;
+        if (fc.prefixHashes.empty()) fc.prefixHashes = prefixHashes(fc.content);
+        for (size_t k = minLines; k <= fc.prefixHashes.size(); ++k) ++counts[fc.prefixHashes[k - 1]];
+    }
+
+    // pass 2b: longest sufficiently common prefix per file
+    std::vector<Preamble> preambles;
+    std::unordered_map<uint64_t, size_t> idByHash;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        auto &fc = contents[i];
+        if (!eligible(fc)) continue;
+        size_t best = 0;
+        for (size_t k = fc.prefixHashes.size(); k >= minLines && k > 0; --k) {
+            if (counts[fc.prefixHashes[k - 1]] >= minFiles) { best = k; break; }
+        }
+        if (best == 0) continue;
+
+        uint64_t h = fc.prefixHashes[best - 1];
+        size_t bytes = prefixBytes(fc.content, best);
+        if (bytes == std::string::npos) continue;
+        auto it = idByHash.find(h);
+        if (it == idByHash.end()) {
+            Preamble p;
+            p.text = fc.content.substr(0, bytes);
+            p.lineCount = best;
+            it = idByHash.emplace(h, preambles.size()).first;
+            preambles.push_back(std::move(p));
+        } else if (fc.content.compare(0, bytes, preambles[it->second].text) != 0) {
+            continue; // hash collision; keep the file untouched
+        }
+        preambles[it->second].files.push_back(i);
+        fc.preambleId = it->second;
+        fc.content.erase(0, bytes);
+    }
+
+    // a block whose other files were claimed by longer preambles is no longer shared
+    std::vector<Preamble> kept;
+    for (auto &p : preambles) {
+        if (p.files.size() >= 2) {
+            for (size_t f : p.files) contents[f].preambleId = kept.size();
+            kept.push_back(std::move(p));
+        } else {
+            for (size_t f : p.files) {
+                contents[f].content.insert(0, p.text);
+                contents[f].preambleId.reset();
+            }
+        }
+    }
+    for (auto &fc : contents) {
+        fc.prefixHashes.clear();
+        fc.prefixHashes.shrink_to_fit();
+    }
+    return kept;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FileReader.h"
+
+namespace rcpack {
+
+    // A run of leading lines (license header, include block, ...) shared by several files.
+    struct Preamble {
+        std::string text;          // exact bytes, including the trailing newline
+        size_t lineCount = 0;
+        std::vector<size_t> files; // indices into contents, in scan order
+    };
+
+    // Corpus-level boilerplate removal, split in two passes so the first can run per file
+    // (e.g. on the pipeline workers) and the second only looks at hashes:
+    //   1. prefixHashes(): rolling hash of the first 1..maxLines lines of one file
+    //   2. extract(): picks, per file, the longest prefix shared with at least minFiles
+    //      files, strips it and returns each distinct block once.
+    class PreambleDetector {
+    public:
+        static std::vector<uint64_t> prefixHashes(const std::string &content, size_t maxLines = 64);
+
+        static std::vector<Preamble> extract(std::vector<FileContent> &contents,
+                                             size_t minLines = 3, size_t minFiles = 3);
+    };
+}
@@ -0,0 +1,226 @@
+#include "RecordWriter.h"
+#include <cstdio>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RCPACK_SSE2 1
+#endif
+
+using namespace rcpack;
+
+namespace {
+    // control characters, quote and backslash are escaped; bytes >= 0x80 are checked as UTF-8
+    inline bool needsEscape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\' || c >= 0x80; }
+
+    // Length of the well-formed UTF-8 sequence at p (no overlongs or surrogates), 0 if none.
+    size_t utf8Sequence(const unsigned char *p, size_t n) {
+        unsigned char c = p[0];
+        size_t len = c < 0xc2 ? 0 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf5 ? 4 : 0;
+        if (len == 0 || n < len) return 0;
+        for (size_t k = 1; k < len; ++k) if ((p[k] & 0xc0) != 0x80) return 0;
+        if ((c == 0xe0 && p[1] < 0xa0) || (c == 0xed && p[1] >= 0xa0) ||
+            (c == 0xf0 && p[1] < 0x90) || (c == 0xf4 && p[1] >= 0x90)) return 0;
+        return len;
+    }
+
+    // MessagePack integers and lengths are big-endian
+    void putBE(std::string &out, uint64_t v, int bytes) {
+        for (int b = bytes - 1; b >= 0; --b) out.push_back(static_cast<char>((v >> (8 * b)) & 0xff));
+    }
+}
+
+size_t RecordWriter::plainPrefix(const char *s, size_t len) {
+    size_t i = 0;
+#if defined(RCPACK_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        // unsigned v <= 0x1f  <=>  max(v, 0x1f) == 0x1f
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                   _mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+        int mask = _mm_movemask_epi8(_mm_or_si128(hit, v)); // v's own top bit: non-ASCII
+        if (mask) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+    }
+#else
+    // SWAR: a byte of x is zero  <=>  its bit 7 is set in (x - 0x01..) & ~x & 0x80..
+    constexpr uint64_t ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t x;
+        std::memcpy(&x, s + i, 8);
+        uint64_t q = x ^ (ones * '"'), b = x ^ (ones * '\\');
+        uint64_t hit = ((q - ones) & ~q) | ((b - ones) & ~b) | ((x - ones * 0x20) & ~x) | x;
+        if (hit & highs) break; // locate it bytewise below
+    }
+#endif
+    while (i < len && !needsEscape(static_cast<unsigned char>(s[i]))) ++i;
+    return i;
+}
+
+void RecordWriter::escapeJson(std::string &out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out.reserve(out.size() + s.size() + 16);
+    const char *p = s.data();
+    size_t n = s.size();
+    while (n) {
+        size_t run = plainPrefix(p, n);
+        out.append(p, run);
+        if (run == n) break;
+        unsigned char c = static_cast<unsigned char>(p[run]);
+        if (c >= 0x80) {
+            // valid UTF-8 is copied; any other byte becomes U+FFFD so the document stays valid
+            size_t len = utf8Sequence(reinterpret_cast<const unsigned char *>(p + run), n - run);
+            if (len) out.append(p + run, len);
+            else out += "\\ufffd";
+            p += run + (len ? len : 1);
+            n -= run + (len ? len : 1);
+            continue;
+        }
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out.push_back(hex[c >> 4]);
+                out.push_back(hex[c & 0xf]);
+        }
+        p += run + 1;
+        n -= run + 1;
+    }
+}
+
+void RecordWriter::uint(uint64_t n) {
+    if (!rw_msgpack) {
+        rw_out += std::to_string(n);
+    } else if (n < 0x80) {
+        rw_out.push_back(static_cast<char>(n));
+    } else if (n <= 0xff) {
+        rw_out.push_back(static_cast<char>(0xcc)); putBE(rw_out, n, 1);
+    } else if (n <= 0xffff) {
+        rw_out.push_back(static_cast<char>(0xcd)); putBE(rw_out, n, 2);
+    } else if (n <= 0xffffffffULL) {
+        rw_out.push_back(static_cast<char>(0xce)); putBE(rw_out, n, 4);
+    } else {
+        rw_out.push_back(static_cast<char>(0xcf)); putBE(rw_out, n, 8);
+    }
+}
+
+RecordWriter &RecordWriter::beginMap(size_t entries) {
+    if (!rw_msgpack) {
+        separate();
+        rw_out.push_back('{');
+        rw_comma = false;
+    } else if (entries < 16) {
+        rw_out.push_back(static_cast<char>(0x80 | entries));
+    } else if (entries <= 0xffff) {
+        rw_out.push_back(static_cast<char>(0xde)); putBE(rw_out, entries, 2);
+    } else {
+        rw_out.push_back(static_cast<char>(0xdf)); putBE(rw_out, entries, 4);
+    }
+    return *this;
+}
+
+RecordWriter &RecordWriter::endMap() {
+    if (!rw_msgpack) {
+        rw_out.push_back('}');
+        rw_comma = true;
+    }
+    return *this;
+}
+
+RecordWriter &RecordWriter::beginArray(size_t items) {
+    if (!rw_msgpack) {
+        separate();
+        rw_out.push_back('[');
+        rw_comma = false;
+    } else if (items < 16) {
+        rw_out.push_back(static_cast<char>(0x90 | items));
+    } else if (items <= 0xffff) {
+        rw_out.push_back(static_cast<char>(0xdc)); putBE(rw_out, items, 2);
+    } else {
+        rw_out.push_back(static_cast<char>(0xdd)); putBE(rw_out, items, 4);
+    }
+    return *this;
+}
+
+RecordWriter &RecordWriter::endArray() {
+    if (!rw_msgpack) {
+        rw_out.push_back(']');
+        rw_comma = true;
+    }
+    return *this;
+}
+
+RecordWriter &RecordWriter::key(std::string_view k) {
+    value(k);
+    if (!rw_msgpack) {
+        rw_out.push_back(':');
+        rw_comma = false;
+    }
+    return *this;
+}
+
+RecordWriter &RecordWriter::openString(size_t len) {
+    separate();
+    if (!rw_msgpack) {
+        rw_out.push_back('"');
+    } else if (len < 32) {
+        rw_out.push_back(static_cast<char>(0xa0 | len));
+    } else if (len <= 0xff) {
+        rw_out.push_back(static_cast<char>(0xd9)); putBE(rw_out, len, 1);
+    } else if (len <= 0xffff) {
+        rw_out.push_back(static_cast<char>(0xda)); putBE(rw_out, len, 2);
+    } else {
+        rw_out.push_back(static_cast<char>(0xdb)); putBE(rw_out, len, 4);
+    }
+    return *this;
+}
+
+RecordWriter &RecordWriter::closeString() {
+    if (!rw_msgpack) rw_out.push_back('"');
+    rw_comma = true;
+    return *this;
+}
+
+RecordWriter &RecordWriter::value(std::string_view s) {
+    openString(s.size());
+    if (rw_msgpack) rw_out.append(s);
+    else escapeJson(rw_out, s);
+    return closeString();
+}
+
+RecordWriter &RecordWriter::value(bool b) {
+    separate();
+    if (rw_msgpack) rw_out.push_back(static_cast<char>(b ? 0xc3 : 0xc2));
+    else rw_out += b ? "true" : "false";
+    rw_comma = true;
+    return *this;
+}
+
+RecordWriter &RecordWriter::value(double d) {
+    separate();
+    if (rw_msgpack) {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        rw_out.push_back(static_cast<char>(0xcb));
+        putBE(rw_out, bits, 8);
+    } else {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", d);
+        rw_out += buf;
+    }
+    rw_comma = true;
+    return *this;
+}
+
+RecordWriter &RecordWriter::null() {
+    separate();
+    if (rw_msgpack) rw_out.push_back(static_cast<char>(0xc0));
+    else rw_out += "null";
+    rw_comma = true;
+    return *this;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "Config.h"
+
+namespace rcpack {
+
+    // Appends maps, arrays and scalars to a string as JSON or MessagePack, so the structured
+    // --format writers build one record with the same calls whatever the encoding. Counts
+    // passed to beginMap/beginArray are only used by MessagePack (JSON closes with endMap/
+    // endArray, which MessagePack ignores). Markdown is not a record format; treat it as Json.
+    class RecordWriter {
+        std::string &rw_out;
+        bool rw_msgpack;
+        bool rw_comma = false; // JSON: the next key or value needs a separator
+
+        void separate() { if (rw_comma && !rw_msgpack) rw_out.push_back(','); }
+        void uint(uint64_t n);
+    public:
+        RecordWriter(OutputFormat format, std::string &out)
+            : rw_out(out), rw_msgpack(format == OutputFormat::MsgPack) {}
+
+        RecordWriter &beginMap(size_t entries);
+        RecordWriter &endMap();
+        RecordWriter &beginArray(size_t items);
+        RecordWriter &endArray();
+        RecordWriter &key(std::string_view k);
+
+        RecordWriter &value(std::string_view s);
+        RecordWriter &value(const std::string &s) { return value(std::string_view(s)); }
+        RecordWriter &value(const char *s) { return value(std::string_view(s)); }
+        RecordWriter &value(bool b);
+        RecordWriter &value(double d);
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+        RecordWriter &value(T n) { separate(); uint(static_cast<uint64_t>(n)); rw_comma = true; return *this; }
+        RecordWriter &null();
+
+        // A string value of len bytes whose text the caller writes itself (JSON: already
+        // escaped, between openString and closeString; MessagePack: raw, after the header).
+        RecordWriter &openString(size_t len);
+        RecordWriter &closeString();
+
+        // Appends s with JSON string escaping (no quotes). Runs of ASCII that need none are
+        // found 16 bytes at a time and copied in one append; bytes that are not valid UTF-8
+        // become \ufffd.
+        static void escapeJson(std::string &out, std::string_view s);
+        // Length of the ASCII prefix of s that escapeJson copies unchanged.
+        static size_t plainPrefix(const char *s, size_t len);
+    };
+}
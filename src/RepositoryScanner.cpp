@@ -1,9 +1,82 @@
+#include <algorithm>
 #include <iostream>
 #include "RepositoryScanner.h"
 
 namespace fs = std::filesystem;
 using namespace rcpack;
 
+// Where the part of 'entry' below 'dir' starts in entry.native(); entries produced by walking
+// dir always begin with dir's text. 0 when that does not hold.
+static uint32_t relativeOffset(const fs::path &dir, const fs::path &entry) {
+    const auto &d = dir.native();
+    const auto &e = entry.native();
+    size_t len = d.size();
+    while (len > 1 && fs::path::preferred_separator == d[len - 1]) --len;
+    if (len == 0 || e.size() <= len + 1 || e.compare(0, len, d, 0, len) != 0 || e[len] != fs::path::preferred_separator) return 0;
+    return static_cast<uint32_t>(len + 1);
+}
+
+PathSet::PathSet(const fs::path &root) : ps_root(root.lexically_normal().generic_string()) {
+    if (ps_root.empty() || ps_root.back() != '/') ps_root += '/';
+}
+
+void PathSet::add(std::string_view relativePath) {
+    std::string rel(relativePath);
+    for (size_t slash = rel.find('/'); slash != std::string::npos; slash = rel.find('/', slash + 1)) {
+        ps_dirs.insert(rel.substr(0, slash));
+    }
+    ps_files.insert(std::move(rel));
+}
+
+bool PathSet::relative(const fs::path &p, std::string &rel) const {
+    rel = p.generic_string();
+    if (rel.size() < ps_root.size() || rel.compare(0, ps_root.size(), ps_root) != 0) {
+        // root itself, possibly without its trailing '/'
+        if (rel.size() + 1 == ps_root.size() && ps_root.compare(0, rel.size(), rel) == 0) {
+            rel.clear();
+            return true;
+        }
+        return false;
+    }
+    rel.erase(0, ps_root.size());
+    while (!rel.empty() && rel.back() == '/') rel.pop_back();
+    return true;
+}
+
+bool PathSet::containsFile(const fs::path &p) const {
+    std::string rel;
+    return relative(p, rel) && ps_files.count(rel) != 0;
+}
+
+bool PathSet::mayContain(const fs::path &dir) const {
+    std::string rel;
+    if (!relative(dir, rel)) {
+        // a directory above root still leads to it
+        std::string d = dir.generic_string();
+        if (!d.empty() && d.back() != '/') d += '/';
+        return ps_root.compare(0, d.size(), d) == 0;
+    }
+    return rel.empty() || ps_dirs.count(rel) != 0;
+}
+
+std::vector<std::string> PathSet::filesUnder(const fs::path &dir) const {
+    std::vector<std::string> out;
+    std::string rel, lead; // dir relative to root; or root relative to dir when dir is above it
+    if (relative(dir, rel)) {
+        if (!rel.empty()) rel += '/';
+    } else {
+        if (!mayContain(dir)) return out;
+        rel.clear();
+        std::string d = dir.generic_string();
+        if (!d.empty() && d.back() != '/') d += '/';
+        lead = ps_root.substr(d.size());
+    }
+    for (const auto &f : ps_files) {
+        if (f.size() > rel.size() && f.compare(0, rel.size(), rel) == 0) out.push_back(lead + f.substr(rel.size()));
+    }
+    return out;
+}
+
 //Optional Functionality -i or --include:
 RepositoryScanner::RepositoryScanner(std::vector<std::string> includePatterns, std::vector<std::string> excludePatterns) {
     // normalize patterns: accept "*.js" or ".js" or "js"
@@ -72,7 +145,7 @@ ScanResult RepositoryScanner::scanPaths(const std::vector<std::string>& paths){
             }
 
             if (fs::is_regular_file(p)) {
-                if (matches(p)) {
+                if (matches(p) && (!rs_only || rs_only->containsFile(p))) {
                     std::error_code ec;
                     uintmax_t sz = fs::file_size(p, ec);
                     if (ec) {
@@ -80,10 +153,28 @@ ScanResult RepositoryScanner::scanPaths(const std::vector<std::string>& paths){
                         result.skipped.push_back(p);
                     } else {
                         FileEntry e{p, sz};
+                        e.relOffset = relativeOffset(p.parent_path(), p);
                         result.files.push_back(std::move(e));
                     }
                 }
             } else if (fs::is_directory(p)){
+                if (rs_only) {
+                    for (const auto &rel : rs_only->filesUnder(p)) {
+                        fs::path entryPath = p / fs::u8path(rel);
+                        std::error_code ec;
+                        if (!fs::is_regular_file(entryPath, ec) || !matches(entryPath)) continue; // e.g. deleted
+                        uintmax_t sz = fs::file_size(entryPath, ec);
+                        if (ec) {
+                            std::cerr << "Warning (file_size): " << entryPath << " -> " << ec.message() << "\n";
+                            result.skipped.push_back(entryPath);
+                            continue;
+                        }
+                        FileEntry e{entryPath, sz};
+                        e.relOffset = relativeOffset(p, entryPath);
+                        result.files.push_back(std::move(e));
+                    }
+                    continue;
+                }
                 fs::recursive_directory_iterator start(p, fs::directory_options::skip_permission_denied);
                 fs::recursive_directory_iterator end; //default-constructed iterator that represents the “end” of a recursive directory traversal.
                 for (auto it = start; it != end; ++it){
@@ -97,6 +188,7 @@ ScanResult RepositoryScanner::scanPaths(const std::vector<std::string>& paths){
                                 result.skipped.push_back(entryPath);
                             } else {
                                 FileEntry e{entryPath, sz};
+                                e.relOffset = relativeOffset(p, entryPath);
                                 result.files.push_back(std::move(e));
                             }
                         }
@@ -120,4 +212,53 @@ ScanResult RepositoryScanner::scanPaths(const std::vector<std::string>& paths){
               });
 
     return result;
-}
\ No newline at end of file
+}
+
+ScanResult RepositoryScanner::scanListing(const std::vector<std::string> &paths, const fs::path &root,
+                                          const std::vector<std::string> &listing) const {
+    ScanResult result;
+    std::string base = root.lexically_normal().generic_string();
+    while (!base.empty() && base.back() == '/') base.pop_back();
+    for (const auto &pstr : paths) {
+        fs::path p(pstr);
+        std::string rel = p.lexically_normal().generic_string();
+        while (!rel.empty() && rel.back() == '/') rel.pop_back();
+        if (rel.size() > base.size() && rel.compare(0, base.size() + 1, base + "/") == 0) {
+            rel.erase(0, base.size() + 1);
+        } else if (rel == base) {
+            rel.clear();
+        } else {
+            std::cerr << "Warning: path is outside the repository: " << p << "\n";
+            result.skipped.push_back(p);
+            continue;
+        }
+        // the listing is sorted, so the files below rel are one run of it
+        const std::string prefix = rel.empty() ? rel : rel + "/";
+        size_t found = 0;
+        for (auto it = std::lower_bound(listing.begin(), listing.end(), rel); it != listing.end(); ++it) {
+            FileEntry e;
+            if (*it == rel) { // a file argument
+                e.path = p;
+                e.relOffset = relativeOffset(p.parent_path(), p);
+            } else if (it->compare(0, prefix.size(), prefix) == 0) {
+                e.path = p / fs::u8path(it->substr(prefix.size()));
+                e.relOffset = relativeOffset(p, e.path);
+            } else if (*it > prefix) {
+                break;
+            } else {
+                continue; // e.g. "dir.txt" between "dir" and "dir/"
+            }
+            ++found;
+            if (matches(e.path)) result.files.push_back(std::move(e));
+        }
+        if (!found) {
+            std::cerr << "Warning: path does not exist in the revision: " << p << "\n";
+            result.skipped.push_back(p);
+        }
+    }
+    std::sort(result.files.begin(), result.files.end(),
+              [](const FileEntry &a, const FileEntry &b){
+                  return a.path.generic_string() < b.path.generic_string();
+              });
+    return result;
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <regex>
 #include <optional>
+#include <unordered_set>
 #include "utils.h"
 
 namespace rcpack {
@@ -11,19 +13,68 @@ namespace rcpack {
     struct FileEntry {
         std::filesystem::path path;
         uintmax_t size = 0;
+        // path.native().substr(relOffset) is the path relative to the directory it was found
+        // in by scanPaths (or its file name for a file argument); 0 = not recorded
+        uint32_t relOffset = 0;
     };
 
+    // fe's path relative to root (generic separators) sliced out of the path itself, without
+    // touching the filesystem or allocating. Empty when fe was not found by scanning root
+    // (callers then fall back to std::filesystem::relative).
+    inline std::string_view relativeTo(const FileEntry &fe, const std::filesystem::path &root) {
+#if defined(_WIN32)
+        (void)fe; (void)root;
+        return {}; // native paths are wide with '\\' separators; use the slow path
+#else
+        if (fe.relOffset == 0) return {};
+        std::string_view dir(root.native());
+        while (dir.size() > 1 && dir.back() == '/') dir.remove_suffix(1);
+        std::string_view full(fe.path.native());
+        if (fe.relOffset != dir.size() + 1 || full.size() <= fe.relOffset || full.compare(0, dir.size(), dir) != 0 ||
+            full[dir.size()] != '/') return {};
+        return full.substr(fe.relOffset);
+#endif
+    }
+
     struct ScanResult {
         std::vector<FileEntry> files;
         std::vector<std::filesystem::path> skipped; // unreadable or wrong
     };
 
+    // A set of files below root ('/'-separated paths relative to it) together with every
+    // directory that leads to one, so a scan can skip whole subtrees that hold none of them.
+    class PathSet {
+        std::string ps_root; // generic form, ending in '/'
+        std::unordered_set<std::string> ps_files;
+        std::unordered_set<std::string> ps_dirs;
+        // p relative to root; false when p is not below it
+        bool relative(const std::filesystem::path &p, std::string &rel) const;
+    public:
+        explicit PathSet(const std::filesystem::path &root);
+        void add(std::string_view relativePath);
+        bool containsFile(const std::filesystem::path &p) const;
+        // p may hold a member: it is root, a directory above root, or leads to an added file
+        bool mayContain(const std::filesystem::path &dir) const;
+        // Members below dir, as '/'-separated paths relative to dir (in no particular order)
+        std::vector<std::string> filesUnder(const std::filesystem::path &dir) const;
+        size_t size() const { return ps_files.size(); }
+    };
+
     class RepositoryScanner {
         std::vector<std::string> rs_patterns;
         std::vector<std::regex> rs_excludeRegexes;
+        const PathSet *rs_only = nullptr;
         bool matches(const std::filesystem::path &p) const;
     public:
         RepositoryScanner(std::vector<std::string> includePatterns = {}, std::vector<std::string> excludePatterns = {});
+        // Restricts scans to the files in only (not owned; must outlive the scans): a directory
+        // argument is not walked, its members of only are looked up one by one.
+        void setOnly(const PathSet *only) { rs_only = only; }
         ScanResult scanPaths(const std::vector<std::string>& paths);
+        // scanPaths() over a listing of files instead of the file system (--rev: a commit's
+        // tree): the listed files ('/'-separated, relative to root) at or below paths that
+        // pass the filters. Sizes are left at 0.
+        ScanResult scanListing(const std::vector<std::string> &paths, const std::filesystem::path &root,
+                               const std::vector<std::string> &listing) const;
     };
 }
\ No newline at end of file
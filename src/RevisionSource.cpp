@@ -0,0 +1,56 @@
+#include "RevisionSource.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+RevisionSource::RevisionSource(const GitRepository &repo)
+    : rv_repo(repo), rv_root(repo.workTree().lexically_normal().generic_string()) {
+    if (rv_root.empty() || rv_root.back() != '/') rv_root += '/';
+}
+
+bool RevisionSource::load(const GitOid &commit) {
+    auto c = rv_repo.readCommit(commit);
+    if (!c) return false;
+    rv_blobs.clear();
+    rv_paths.clear();
+    bool ok = rv_repo.diffTrees(nullptr, &c->tree, [&](GitChange &&change) {
+        if ((change.newMode & 0170000) != 0100000) return; // symlink or submodule
+        rv_paths.push_back(change.path);
+        rv_blobs.emplace(std::move(change.path), change.newId);
+    });
+    std::sort(rv_paths.begin(), rv_paths.end());
+    return ok;
+}
+
+void RevisionSource::add(std::string path, const GitOid &blob) {
+    auto it = std::lower_bound(rv_paths.begin(), rv_paths.end(), path);
+    if (it == rv_paths.end() || *it != path) rv_paths.insert(it, path);
+    rv_blobs[std::move(path)] = blob;
+}
+
+const GitOid *RevisionSource::blobFor(const fs::path &p) const {
+    std::string path = p.lexically_normal().generic_string();
+    if (path.size() <= rv_root.size() || path.compare(0, rv_root.size(), rv_root) != 0) return nullptr;
+    auto it = rv_blobs.find(path.substr(rv_root.size()));
+    return it == rv_blobs.end() ? nullptr : &it->second;
+}
+
+bool RevisionSource::read(const fs::path &p, std::string &out) const {
+    const GitOid *id = blobFor(p);
+    GitObject blob;
+    if (!id || !rv_repo.read(*id, blob) || blob.type != GitObject::Blob) return false;
+    out = std::move(blob.data);
+    return true;
+}
+
+void RevisionSource::fillSizes(std::vector<FileEntry> &files, size_t jobs) const {
+    runOrdered<uintmax_t>(files.size(), jobs, 256,
+        [&](size_t i) -> uintmax_t {
+            const GitOid *id = blobFor(files[i].path);
+            auto size = id ? rv_repo.objectSize(*id) : std::nullopt;
+            return size ? *size : 0;
+        },
+        [&](size_t i, uintmax_t size) { files[i].size = size; });
+}
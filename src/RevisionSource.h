@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FileReader.h"
+#include "GitRepository.h"
+#include "RepositoryScanner.h"
+
+namespace rcpack {
+
+    // The files of one commit, straight from the object database (--rev): a listing for
+    // RepositoryScanner::scanListing and their text for FileReader. The working tree is never
+    // read, so revisions can be packaged while it is in use, and many of them side by side.
+    // Files are named as they would be checked out below the repository's work tree.
+    // Single blobs can be listed too (--staged: the versions in the index).
+    class RevisionSource : public ContentSource {
+        const GitRepository &rv_repo;
+        std::string rv_root; // the work tree, generic form ending in '/'
+        std::unordered_map<std::string, GitOid> rv_blobs; // regular files by root-relative path
+        std::vector<std::string> rv_paths;                // the same paths, sorted
+        const GitOid *blobFor(const std::filesystem::path &p) const;
+    public:
+        explicit RevisionSource(const GitRepository &repo);
+        // Lists the regular files in commit's tree (symlinks and submodules are left out).
+        bool load(const GitOid &commit);
+        // Lists blob as the regular file at path (root-relative), replacing any earlier entry.
+        void add(std::string path, const GitOid &blob);
+        const std::vector<std::string> &paths() const { return rv_paths; }
+
+        bool read(const std::filesystem::path &p, std::string &out) const override;
+        // Fills FileEntry::size from the blob sizes, on jobs threads.
+        void fillSizes(std::vector<FileEntry> &files, size_t jobs) const;
+    };
+}
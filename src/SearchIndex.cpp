@@ -0,0 +1,213 @@
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace rcpack;
+
+// ASCII-only classification; the <cctype> versions consult the locale on every call
+static bool isWordChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+static bool isLower(unsigned char c) { return c >= 'a' && c <= 'z'; }
+static bool isUpper(unsigned char c) { return c >= 'A' && c <= 'Z'; }
+
+// Calls fn(term) for every lower-cased term of text. The view points into a buffer that is
+// reused between calls, so the hot path allocates nothing once the buffer has grown.
+template <typename Fn>
+static void forEachTerm(std::string_view text, Fn &&fn) {
+    std::string buf;
+    auto emit = [&](std::string_view s) {
+        if (s.size() < 2) return;
+        buf.assign(s.data(), s.size());
+        for (auto &ch : buf) if (isUpper(static_cast<unsigned char>(ch))) ch = static_cast<char>(ch - 'A' + 'a');
+        fn(static_cast<const std::string &>(buf));
+    };
+
+    size_t i = 0;
+    const size_t n = text.size();
+    while (i < n) {
+        if (!isWordChar(static_cast<unsigned char>(text[i]))) { ++i; continue; }
+        size_t start = i;
+        bool mixed = false; // '_' or an upper-case letter after the first character
+        for (++i; i < n && isWordChar(static_cast<unsigned char>(text[i])); ++i) {
+            mixed |= text[i] == '_' || isUpper(static_cast<unsigned char>(text[i]));
+        }
+        std::string_view word = text.substr(start, i - start);
+        emit(word);
+        if (!mixed) continue;
+
+        // split fooBarBaz / foo_bar / HTTPServer into parts
+        size_t partStart = 0;
+        bool split = false;
+        for (size_t k = 1; k <= word.size(); ++k) {
+            bool boundary = k == word.size() || word[k] == '_';
+            if (!boundary) {
+                unsigned char prev = static_cast<unsigned char>(word[k - 1]), cur = static_cast<unsigned char>(word[k]);
+                bool nextLower = k + 1 < word.size() && isLower(static_cast<unsigned char>(word[k + 1]));
+                boundary = (isLower(prev) && isUpper(cur)) || (isUpper(prev) && isUpper(cur) && nextLower);
+            }
+            if (!boundary) continue;
+            if (k < word.size()) split = true;
+            if (split) emit(word.substr(partStart, k - partStart));
+            partStart = (k < word.size() && word[k] == '_') ? k + 1 : k;
+        }
+    }
+}
+
+void SearchIndex::terms(std::string_view text, std::vector<std::string> &out) {
+    forEachTerm(text, [&](const std::string &t) { out.push_back(t); });
+}
+
+namespace {
+    // Per-document term counter: open addressing over one flat slot array, with the term
+    // bytes in a shared arena, so counting a document allocates nothing once warmed up.
+    class TermCounter {
+        struct Slot { uint64_t hash; uint32_t offset, length, tf; };
+        std::vector<Slot> tc_slots = std::vector<Slot>(1024);
+        std::string tc_arena;
+        std::vector<uint32_t> tc_occupied; // slot indices in use, so clear() and forEach() skip the rest
+        void grow() {
+            std::vector<Slot> old(tc_slots.size() * 2);
+            old.swap(tc_slots);
+            const size_t mask = tc_slots.size() - 1;
+            for (auto &idx : tc_occupied) {
+                const Slot &s = old[idx];
+                size_t i = s.hash & mask;
+                while (tc_slots[i].tf) i = (i + 1) & mask;
+                tc_slots[i] = s;
+                idx = static_cast<uint32_t>(i);
+            }
+        }
+    public:
+        void clear() {
+            for (uint32_t idx : tc_occupied) tc_slots[idx].tf = 0;
+            tc_occupied.clear();
+            tc_arena.clear();
+        }
+        void add(const std::string &t) {
+            const uint64_t h = hashString(t);
+            const size_t mask = tc_slots.size() - 1;
+            size_t i = h & mask;
+            for (; tc_slots[i].tf; i = (i + 1) & mask) {
+                auto &s = tc_slots[i];
+                if (s.hash == h && s.length == t.size() && tc_arena.compare(s.offset, s.length, t) == 0) {
+                    ++s.tf;
+                    return;
+                }
+            }
+            tc_slots[i] = Slot{h, static_cast<uint32_t>(tc_arena.size()), static_cast<uint32_t>(t.size()), 1};
+            tc_arena += t;
+            tc_occupied.push_back(static_cast<uint32_t>(i));
+            if (tc_occupied.size() * 2 > tc_slots.size()) grow();
+        }
+        template <typename Fn>
+        void forEach(Fn &&fn) const {
+            for (uint32_t idx : tc_occupied) {
+                const Slot &s = tc_slots[idx];
+                fn(std::string_view(tc_arena).substr(s.offset, s.length), s.tf);
+            }
+        }
+    };
+}
+
+uint32_t SearchIndex::addDocument(std::string_view path, std::string_view text) {
+    // count within the document first: the small per-document table stays in cache, and the
+    // large dictionary is consulted once per distinct term instead of once per occurrence
+    thread_local TermCounter counter;
+    counter.clear();
+    uint32_t length = 0;
+    auto addTerm = [&](const std::string &t) {
+        counter.add(t);
+        ++length;
+    };
+    forEachTerm(path, addTerm);
+    forEachTerm(text, addTerm);
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs; // (term, tf)
+    std::string key;
+    counter.forEach([&](std::string_view term, uint32_t tf) {
+        key.assign(term.data(), term.size());
+        auto it = sx_termIds.find(key);
+        if (it == sx_termIds.end()) it = sx_termIds.emplace(key, static_cast<uint32_t>(sx_termIds.size())).first;
+        pairs.emplace_back(it->second, tf);
+    });
+    std::sort(pairs.begin(), pairs.end());
+    for (auto &p : pairs) {
+        sx_pendingTerms.push_back(p.first);
+        sx_pendingTfs.push_back(p.second);
+    }
+    sx_docEnds.push_back(static_cast<uint32_t>(sx_pendingTerms.size()));
+    sx_docLengths.push_back(length);
+    return static_cast<uint32_t>(sx_docLengths.size() - 1);
+}
+
+void SearchIndex::finalize() {
+    // counting sort of the pending pairs by term; documents come out in increasing order
+    sx_termOffsets.assign(sx_termIds.size() + 1, 0);
+    for (uint32_t t : sx_pendingTerms) ++sx_termOffsets[t + 1];
+    for (size_t t = 0; t < sx_termIds.size(); ++t) sx_termOffsets[t + 1] += sx_termOffsets[t];
+
+    sx_postDocs.resize(sx_pendingTerms.size());
+    sx_postTfs.resize(sx_pendingTerms.size());
+    std::vector<uint32_t> cursor(sx_termOffsets.begin(), sx_termOffsets.end() - 1);
+    uint32_t begin = 0;
+    for (uint32_t d = 0; d < sx_docEnds.size(); ++d) {
+        for (uint32_t p = begin; p < sx_docEnds[d]; ++p) {
+            uint32_t slot = cursor[sx_pendingTerms[p]]++;
+            sx_postDocs[slot] = d;
+            sx_postTfs[slot] = sx_pendingTfs[p];
+        }
+        begin = sx_docEnds[d];
+    }
+    std::vector<uint32_t>().swap(sx_pendingTerms);
+    std::vector<uint32_t>().swap(sx_pendingTfs);
+    std::vector<uint32_t>().swap(sx_docEnds);
+
+    double total = std::accumulate(sx_docLengths.begin(), sx_docLengths.end(), 0.0);
+    float avg = sx_docLengths.empty() || total == 0 ? 1.0f : static_cast<float>(total / sx_docLengths.size());
+    sx_docNorms.resize(sx_docLengths.size());
+    for (size_t d = 0; d < sx_docLengths.size(); ++d) {
+        sx_docNorms[d] = K1 * (1.0f - B + B * static_cast<float>(sx_docLengths[d]) / avg);
+    }
+}
+
+std::vector<float> SearchIndex::score(std::string_view query) const {
+    std::vector<float> scores(docCount(), 0.0f);
+    if (sx_termOffsets.empty()) return scores; // not finalized
+
+    std::vector<std::string> qterms;
+    terms(query, qterms);
+    std::sort(qterms.begin(), qterms.end());
+    qterms.erase(std::unique(qterms.begin(), qterms.end()), qterms.end());
+
+    const float n = static_cast<float>(docCount());
+    float *acc = scores.data();
+    const float *norms = sx_docNorms.data();
+    for (auto &q : qterms) {
+        auto it = sx_termIds.find(q);
+        if (it == sx_termIds.end()) continue;
+        const uint32_t lo = sx_termOffsets[it->second], hi = sx_termOffsets[it->second + 1];
+        const float df = static_cast<float>(hi - lo);
+        const float idf = std::log(1.0f + (n - df + 0.5f) / (df + 0.5f));
+        const float scale = idf * (K1 + 1.0f);
+        const uint32_t *docs = sx_postDocs.data() + lo;
+        const uint32_t *tfs = sx_postTfs.data() + lo;
+        // scatter-add into the per-document scores; the indexed stores keep this loop scalar
+        for (uint32_t p = 0; p < hi - lo; ++p) {
+            const float tf = static_cast<float>(tfs[p]);
+            acc[docs[p]] += scale * tf / (tf + norms[docs[p]]);
+        }
+    }
+    return scores;
+}
+
+std::vector<uint32_t> SearchIndex::rank(std::string_view query) const {
+    auto scores = score(query);
+    std::vector<uint32_t> docs;
+    for (uint32_t d = 0; d < scores.size(); ++d) {
+        if (scores[d] > 0.0f) docs.push_back(d);
+    }
+    std::stable_sort(docs.begin(), docs.end(), [&](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+    return docs;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Hash.h"
+
+namespace rcpack {
+
+    // BM25 index over the words (identifiers, comment text) of the packaged files.
+    // Documents are added once, in order, as they stream past; finalize() turns the
+    // collected (term, tf) pairs into CSR posting lists: for term t, its documents are
+    // sx_postDocs[sx_termOffsets[t] .. sx_termOffsets[t + 1]) with matching sx_postTfs.
+    class SearchIndex {
+        struct TermHash {
+            size_t operator()(const std::string &s) const { return static_cast<size_t>(hashString(s)); }
+        };
+        std::unordered_map<std::string, uint32_t, TermHash> sx_termIds;
+        std::vector<uint32_t> sx_pendingTerms;  // per-document (term, tf) runs until finalize()
+        std::vector<uint32_t> sx_pendingTfs;
+        std::vector<uint32_t> sx_docEnds;       // end of each document's run in the pending arrays
+        std::vector<uint32_t> sx_docLengths;    // terms per document
+        std::vector<uint32_t> sx_termOffsets;   // CSR row starts, termCount() + 1 entries
+        std::vector<uint32_t> sx_postDocs;
+        std::vector<uint32_t> sx_postTfs;
+        std::vector<float> sx_docNorms;         // k1 * (1 - b + b * len / avgLen), precomputed
+    public:
+        static constexpr float K1 = 1.2f;
+        static constexpr float B = 0.75f;
+
+        // Document ids are assigned in call order starting at 0. The path is indexed too,
+        // so a query naming a file or directory finds it.
+        uint32_t addDocument(std::string_view path, std::string_view text);
+        void finalize();
+
+        size_t docCount() const { return sx_docLengths.size(); }
+        size_t termCount() const { return sx_termIds.size(); }
+        size_t postingCount() const { return sx_postDocs.size(); }
+
+        // BM25 score of every document for the query (0 for documents matching no term).
+        std::vector<float> score(std::string_view query) const;
+        // Documents with a positive score, best first (ties keep document order).
+        std::vector<uint32_t> rank(std::string_view query) const;
+
+        // Lower-cased index terms of text: every identifier/word, plus its camelCase and
+        // snake_case parts, skipping single characters.
+        static void terms(std::string_view text, std::vector<std::string> &out);
+    };
+}
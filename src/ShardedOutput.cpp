@@ -0,0 +1,134 @@
+#include "ShardedOutput.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <system_error>
+
+using namespace rcpack;
+
+namespace {
+    // room for the Summary's numbers, which are zero when the fixed part is measured
+    constexpr size_t SUMMARY_SLACK = 64;
+    // "/ (N files, X.Y KB)" after a directory name in the Structure tree
+    constexpr size_t TREE_DIR_SUFFIX = 32;
+}
+
+ShardedOutput::ShardedOutput(const std::filesystem::path &out, const Config &cfg, const std::filesystem::path &root,
+                             const GitInfo &git, const ScanResult &scan, Setup setup)
+    : sh_out(out), sh_cfg(cfg), sh_root(root), sh_git(git), sh_scan(scan), sh_setup(std::move(setup)),
+      sh_render(sh_discard) {
+    sh_setup(sh_render);
+    sh_maxWriters = std::max<size_t>(2, cfg.jobs ? cfg.jobs : ThreadPool::defaultThreads());
+
+    // everything a shard carries besides its sections: measured on an empty shard
+    auto measure = [&](size_t part) {
+        std::ostringstream probe;
+        OutputFormatter empty(probe);
+        sh_setup(empty);
+        std::vector<size_t> none;
+        empty.setPart(part, &none);
+        empty.begin(root, cfg, git, scan);
+        empty.end(root, cfg, scan);
+        return probe.str().size() + SUMMARY_SLACK;
+    };
+    sh_fixed = measure(2);
+    sh_fixedFirst = measure(1); // part 1 also holds the Symbols section
+    if (cfg.splitMaxBytes && sh_fixed >= cfg.splitMaxBytes) {
+        std::cerr << "Warning: the shard header alone is " << sh_fixed << " bytes; every shard will hold one file\n";
+    }
+
+    sh_current.part = ++sh_parts;
+    sh_bytes = sh_fixedFirst;
+}
+
+ShardedOutput::~ShardedOutput() {
+    for (auto &t : sh_writers) t.join();
+}
+
+std::filesystem::path ShardedOutput::shardPath(const std::filesystem::path &out, size_t part) {
+    std::filesystem::path base = out;
+    std::string compressed;
+    if (CompressingSink::codecFor(base)) {
+        compressed = base.extension().string();
+        base.replace_extension();
+    }
+    std::string ext = base.extension().string();
+    base.replace_extension();
+    char num[24];
+    std::snprintf(num, sizeof(num), ".%03zu", part);
+    return std::filesystem::path(base.string() + num + ext + compressed);
+}
+
+size_t ShardedOutput::treeBytes(size_t file) const {
+    // upper bound for the lines the file adds to the Structure tree: one per path component,
+    // indented two spaces per level, directories with their counts
+    std::string_view rel = relativeTo(sh_scan.files[file], sh_root);
+    if (rel.empty()) return sh_scan.files[file].path.native().size() + TREE_DIR_SUFFIX;
+    size_t bytes = rel.size() + 1, depth = 0;
+    for (char c : rel) {
+        if (c != '/') continue;
+        bytes += depth * 2 + TREE_DIR_SUFFIX;
+        ++depth;
+    }
+    return bytes + depth * 2;
+}
+
+void ShardedOutput::add(OutputFormatter::Section &&sec) {
+    size_t body = sec.rawBytes ? *sec.rawBytes : sec.bodyRef ? sec.bodyRef->size() : sec.body.size();
+    size_t bytes = sec.head.size() + body + sec.tail.size() + treeBytes(sec.file);
+    if (!sh_current.files.empty() &&
+        ((sh_cfg.splitMaxBytes && sh_bytes + bytes > sh_cfg.splitMaxBytes) ||
+         (sh_cfg.splitMaxTokens && sh_tokens + sec.tokens > sh_cfg.splitMaxTokens))) {
+        closeShard();
+    }
+    sh_bytes += bytes;
+    sh_tokens += sec.tokens;
+    sh_current.files.push_back(sec.file);
+    sh_current.sections.push_back(std::move(sec));
+}
+
+void ShardedOutput::closeShard() {
+    while (sh_writers.size() >= sh_maxWriters) {
+        sh_writers.front().join();
+        sh_writers.pop_front();
+    }
+    sh_writers.emplace_back([this, shard = std::move(sh_current)]() mutable {
+        if (!writeShard(shard)) sh_ok = false;
+    });
+    sh_current = Shard{};
+    sh_current.part = ++sh_parts;
+    sh_bytes = sh_fixed;
+    sh_tokens = 0;
+}
+
+bool ShardedOutput::writeShard(Shard &shard) const {
+    std::unique_ptr<OutputSink> sink = FdSink::open(shardPath(sh_out, shard.part));
+    if (!sink) return false;
+    if (auto codec = CompressingSink::codecFor(sh_out)) {
+        sink = std::make_unique<CompressingSink>(std::move(sink), *codec);
+    }
+    // the tree wants path order; the sections keep the order they were added in
+    std::sort(shard.files.begin(), shard.files.end());
+    OutputFormatter fmt(*sink);
+    sh_setup(fmt);
+    fmt.setPart(shard.part, &shard.files);
+    fmt.begin(sh_root, sh_cfg, sh_git, sh_scan);
+    for (const auto &sec : shard.sections) fmt.writeSection(sec, sh_scan);
+    fmt.end(sh_root, sh_cfg, sh_scan);
+    return sink->finish();
+}
+
+bool ShardedOutput::finish() {
+    // sh_current is empty only when nothing was added: an empty package is still one shard
+    closeShard();
+    --sh_parts; // closeShard() opened a part that stays unused
+    for (auto &t : sh_writers) t.join();
+    sh_writers.clear();
+
+    for (size_t part = sh_parts + 1;; ++part) {
+        std::error_code ec;
+        if (!std::filesystem::remove(shardPath(sh_out, part), ec)) break;
+    }
+    return sh_ok;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "OutputFormatter.h"
+
+namespace rcpack {
+
+    // --split-max-bytes / --split-max-tokens: the markdown output as numbered shards
+    // (context.001.md, context.002.md, ...) cut at file boundaries. Each shard is a complete
+    // document with the git header, a Structure excerpt of its own files, the common preambles,
+    // its file sections and a Summary. Sections are held until the next one would overflow the
+    // shard; the full shard is then written by its own thread while the following one fills.
+    class ShardedOutput {
+    public:
+        // Applies the formatter settings (preambles, symbols, token mode) every shard shares.
+        using Setup = std::function<void(OutputFormatter &)>;
+
+        ShardedOutput(const std::filesystem::path &out, const Config &cfg, const std::filesystem::path &root,
+                      const GitInfo &git, const ScanResult &scan, Setup setup);
+        ~ShardedOutput();
+        ShardedOutput(const ShardedOutput &) = delete;
+        ShardedOutput &operator=(const ShardedOutput &) = delete;
+
+        // Formatter to render sections with (renderSection); it never writes anything itself.
+        const OutputFormatter &renderer() const { return sh_render; }
+        // Appends the next section in output order, starting a new shard first when it would
+        // not fit. A section larger than the limits on its own gets a shard to itself.
+        void add(OutputFormatter::Section &&sec);
+        // Writes the last shard, waits for all writers and removes stale higher-numbered shards
+        // left by an earlier run; false when any shard could not be written.
+        bool finish();
+        size_t shardCount() const { return sh_parts; }
+
+        // out with the part number before its extension: a.md -> a.003.md, a.md.gz -> a.003.md.gz
+        static std::filesystem::path shardPath(const std::filesystem::path &out, size_t part);
+    private:
+        struct Shard {
+            size_t part = 0;
+            std::vector<OutputFormatter::Section> sections;
+            std::vector<size_t> files;
+        };
+        std::filesystem::path sh_out;
+        const Config &sh_cfg;
+        const std::filesystem::path &sh_root;
+        const GitInfo &sh_git;
+        const ScanResult &sh_scan;
+        Setup sh_setup;
+        std::ostringstream sh_discard;
+        OutputFormatter sh_render;
+        size_t sh_fixed = 0;  // bytes every shard spends outside its sections and tree lines
+        size_t sh_fixedFirst = 0;
+        Shard sh_current;
+        size_t sh_bytes = 0;  // size estimate of sh_current (an upper bound)
+        size_t sh_tokens = 0;
+        size_t sh_parts = 0;
+        size_t sh_maxWriters = 2;
+        std::deque<std::thread> sh_writers;
+        std::atomic<bool> sh_ok{true};
+
+        size_t treeBytes(size_t file) const;
+        void closeShard();
+        bool writeShard(Shard &shard) const;
+    };
+}
@@ -0,0 +1,421 @@
+#include "StructuredMinifier.h"
+#include "utils.h"
+#include <cctype>
+#include <unordered_set>
+#include <vector>
+
+using namespace rcpack;
+
+static std::string baseName(const std::string &path) {
+    auto pos = path.find_last_of("/\\");
+    return toLower(pos == std::string::npos ? path : path.substr(pos + 1));
+}
+
+StructuredMinifier::Kind StructuredMinifier::detect(const std::string &path) {
+    static const std::unordered_set<std::string> lockfiles = {
+        "package-lock.json", "npm-shrinkwrap.json", "yarn.lock", "pnpm-lock.yaml",
+        "cargo.lock", "poetry.lock", "uv.lock", "pipfile.lock", "gemfile.lock",
+        "go.sum", "composer.lock"
+    };
+    std::string name = baseName(path);
+    if (lockfiles.count(name)) return Kind::Lockfile;
+
+    auto dot = name.find_last_of('.');
+    if (dot == std::string::npos) return Kind::None;
+    std::string ext = name.substr(dot + 1);
+    if (ext == "json" || ext == "geojson" || ext == "jsonc") return Kind::Json;
+    if (ext == "yaml" || ext == "yml") return Kind::Yaml;
+    if (ext == "xml" || ext == "xsd" || ext == "svg" || ext == "csproj" || ext == "props" || ext == "plist") return Kind::Xml;
+    return Kind::None;
+}
+
+std::string StructuredMinifier::process(Kind kind, const std::string &content, const std::string &path) {
+    switch (kind) {
+        case Kind::Json: return minifyJson(content);
+        case Kind::Yaml: return yamlSkeleton(content);
+        case Kind::Xml: return minifyXml(content);
+        case Kind::Lockfile: return summarizeLockfile(content, path);
+        case Kind::None: break;
+    }
+    return content;
+}
+
+std::string StructuredMinifier::minifyJson(const std::string &s, size_t maxArrayItems) {
+    std::string out;
+    out.reserve(s.size() / 2);
+    if (maxArrayItems == 0) maxArrayItems = 1;
+
+    std::vector<char> stack;      // '[' or '{' per open container
+    std::vector<size_t> commas;   // separators seen per open container
+    bool inString = false, escape = false;
+    bool skipping = false;        // dropping the tail of an over-long array
+    size_t skipNested = 0, skippedItems = 0;
+
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (inString) {
+            if (!skipping) out.push_back(c);
+            if (escape) escape = false;
+            else if (c == '\\') escape = true;
+            else if (c == '"') inString = false;
+            continue;
+        }
+        if (c == '"') {
+            inString = true;
+            if (!skipping) out.push_back(c);
+            continue;
+        }
+        // JSONC comments; a lone '/' is not JSON either way and is kept
+        if (c == '/' && i + 1 < s.size() && s[i + 1] == '/') {
+            i = s.find('\n', i);
+            if (i == std::string::npos) break;
+            continue;
+        }
+        if (c == '/' && i + 1 < s.size() && s[i + 1] == '*') {
+            i = s.find("*/", i + 2);
+            if (i == std::string::npos) break;
+            ++i;
+            continue;
+        }
+        if (skipping) {
+            if (c == '[' || c == '{') ++skipNested;
+            else if (c == ']' || c == '}') {
+                if (skipNested > 0) { --skipNested; continue; }
+                out += ",\"... (+" + std::to_string(skippedItems) + " more)\"]";
+                skipping = false;
+                stack.pop_back();
+                commas.pop_back();
+            }
+            else if (c == ',' && skipNested == 0) ++skippedItems;
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) continue;
+
+        if (c == '[' || c == '{') {
+            stack.push_back(c);
+            commas.push_back(0);
+        } else if (c == ']' || c == '}') {
+            if (!stack.empty()) { stack.pop_back(); commas.pop_back(); }
+        } else if (c == ',' && !stack.empty() && stack.back() == '[') {
+            if (++commas.back() >= maxArrayItems) {
+                skipping = true;
+                skipNested = 0;
+                skippedItems = 1;
+                continue;
+            }
+        }
+        out.push_back(c);
+    }
+    if (!out.empty()) out.push_back('\n');
+    return out;
+}
+
+// position of the ':' that ends a YAML mapping key, or npos
+static size_t yamlKeyColon(const std::string &t) {
+    bool inSingle = false, inDouble = false;
+    for (size_t i = 0; i < t.size(); ++i) {
+        char c = t[i];
+        if (c == '\'' && !inDouble) inSingle = !inSingle;
+        else if (c == '"' && !inSingle) inDouble = !inDouble;
+        else if (!inSingle && !inDouble) {
+            if (c == '#' && (i == 0 || t[i - 1] == ' ')) return std::string::npos;
+            if ((c == '{' || c == '[') && i == 0) return std::string::npos; // flow collection
+            if (c == ':' && (i + 1 == t.size() || t[i + 1] == ' ')) return i;
+        }
+    }
+    return std::string::npos;
+}
+
+std::string StructuredMinifier::yamlSkeleton(const std::string &s) {
+    std::string out;
+    size_t pendingIndent = 0, pendingItems = 0; // run of scalar list items being counted
+    bool inBlockScalar = false;
+    size_t blockIndent = 0;
+
+    auto flushItems = [&]() {
+        if (pendingItems == 0) return;
+        out.append(pendingIndent, ' ');
+        out += "- ... (" + std::to_string(pendingItems) + (pendingItems == 1 ? " item)\n" : " items)\n");
+        pendingItems = 0;
+    };
+
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t nl = s.find('\n', start);
+        std::string line = s.substr(start, nl == std::string::npos ? std::string::npos : nl - start);
+        start = nl == std::string::npos ? s.size() : nl + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        std::string t = trim(line);
+        if (t.empty() || t[0] == '#') continue;
+        size_t indent = line.find_first_not_of(' ');
+        if (inBlockScalar) {
+            if (indent > blockIndent) continue;
+            inBlockScalar = false;
+        }
+        if (t == "---" || t == "...") {
+            flushItems();
+            out += t + "\n";
+            continue;
+        }
+
+        bool item = t == "-" || starts_with(t, "- ");
+        std::string body = item ? trim(t.substr(1)) : t;
+        size_t colon = yamlKeyColon(body);
+        if (colon == std::string::npos) {
+            if (item) {
+                if (pendingItems && pendingIndent != indent) flushItems();
+                pendingIndent = indent;
+                ++pendingItems;
+            }
+            continue; // scalar item or continuation of a multi-line value
+        }
+
+        flushItems();
+        std::string value = trim(body.substr(colon + 1));
+        out.append(indent, ' ');
+        if (item) out += "- ";
+        out += body.substr(0, colon + 1);
+        out.push_back('\n');
+        if (!value.empty() && (value[0] == '|' || value[0] == '>')) {
+            inBlockScalar = true;
+            blockIndent = indent;
+        }
+    }
+    flushItems();
+    return out;
+}
+
+std::string StructuredMinifier::minifyXml(const std::string &s) {
+    std::string out;
+    out.reserve(s.size() / 2);
+    bool pendingSpace = false;
+    size_t i = 0;
+    while (i < s.size()) {
+        if (s.compare(i, 4, "<!--") == 0) {
+            size_t end = s.find("-->", i + 4);
+            i = end == std::string::npos ? s.size() : end + 3;
+            continue;
+        }
+        if (s.compare(i, 9, "<![CDATA[") == 0) {
+            size_t end = s.find("]]>", i + 9);
+            size_t stop = end == std::string::npos ? s.size() : end + 3;
+            if (pendingSpace && !out.empty() && out.back() != '>') out.push_back(' ');
+            pendingSpace = false;
+            out.append(s, i, stop - i);
+            i = stop;
+            continue;
+        }
+        char c = s[i];
+        if (c == '<') {
+            // copy the tag, collapsing whitespace runs outside attribute values
+            pendingSpace = false;
+            char quote = 0;
+            bool space = false;
+            for (; i < s.size(); ++i) {
+                char t = s[i];
+                if (quote) {
+                    out.push_back(t);
+                    if (t == quote) quote = 0;
+                    continue;
+                }
+                if (std::isspace(static_cast<unsigned char>(t))) { space = true; continue; }
+                if (space && t != '>' && !(t == '/' && i + 1 < s.size() && s[i + 1] == '>') && t != '?') out.push_back(' ');
+                space = false;
+                out.push_back(t);
+                if (t == '"' || t == '\'') quote = t;
+                else if (t == '>') { ++i; break; }
+            }
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = true;
+        } else {
+            if (pendingSpace && !out.empty() && out.back() != '>') out.push_back(' ');
+            pendingSpace = false;
+            out.push_back(c);
+        }
+        ++i;
+    }
+    if (!out.empty()) out.push_back('\n');
+    return out;
+}
+
+namespace {
+
+    // Collects unique "name@version" lines in first-seen order.
+    struct DependencyList {
+        std::unordered_set<std::string> seen;
+        std::string lines;
+        size_t count = 0;
+
+        void add(std::string name, std::string version) {
+            name = trim(name);
+            version = trim(version);
+            auto nm = name.rfind("node_modules/");
+            if (nm != std::string::npos) name = name.substr(nm + 13);
+            while (!version.empty() && (version[0] == '=' || version[0] == 'v')) version.erase(0, 1);
+            if (name.empty() || version.empty()) return;
+            std::string entry = name + "@" + version;
+            if (!seen.insert(entry).second) return;
+            lines += entry + "\n";
+            ++count;
+        }
+    };
+
+    std::string unquote(std::string v) {
+        v = trim(v);
+        if (v.size() >= 2 && (v.front() == '"' || v.front() == '\'') && v.back() == v.front()) v = v.substr(1, v.size() - 2);
+        return v;
+    }
+
+    // package-lock / npm-shrinkwrap / composer.lock / Pipfile.lock
+    void jsonLockDeps(const std::string &s, DependencyList &deps) {
+        struct Frame { bool object; std::string key; std::string parentKey; std::string name; std::string version; };
+        std::vector<Frame> stack;
+        std::string lastString;
+        bool expectKey = false;
+
+        for (size_t i = 0; i < s.size(); ++i) {
+            char c = s[i];
+            if (c == '"') {
+                size_t j = i + 1;
+                std::string str;
+                for (; j < s.size() && s[j] != '"'; ++j) {
+                    if (s[j] == '\\' && j + 1 < s.size()) ++j;
+                    str.push_back(s[j]);
+                }
+                i = j;
+                if (!stack.empty() && stack.back().object) {
+                    Frame &f = stack.back();
+                    if (expectKey) {
+                        f.key = str;
+                        expectKey = false;
+                    } else if (f.key == "name") {
+                        f.name = str;
+                    } else if (f.key == "version") {
+                        f.version = str;
+                    }
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                std::string parent = !stack.empty() && stack.back().object ? stack.back().key : std::string();
+                stack.push_back({c == '{', "", parent, "", ""});
+                expectKey = c == '{';
+            } else if (c == '}' || c == ']') {
+                if (stack.empty()) continue;
+                Frame f = std::move(stack.back());
+                stack.pop_back();
+                // the root object describes the project itself
+                if (f.object && !stack.empty() && !f.version.empty()) {
+                    deps.add(f.name.empty() ? f.parentKey : f.name, f.version);
+                }
+                expectKey = false;
+            } else if (c == ',') {
+                expectKey = !stack.empty() && stack.back().object;
+            }
+        }
+    }
+
+    // yarn.lock: unindented "spec, spec:" header followed by an indented version line
+    void yarnDeps(const std::string &s, DependencyList &deps) {
+        std::string current;
+        for (auto &line : split_lines(s)) {
+            if (line.empty() || line[0] == '#') continue;
+            if (line[0] != ' ') {
+                std::string spec = line[0] == '"' ? line.substr(1, line.find('"', 1) - 1)
+                                                  : line.substr(0, line.find_first_of(",:"));
+                auto at = spec.find('@', 1);
+                current = at == std::string::npos ? spec : spec.substr(0, at);
+                continue;
+            }
+            std::string t = trim(line);
+            if (starts_with(t, "version ")) deps.add(current, unquote(t.substr(8)));
+            else if (starts_with(t, "version: ")) deps.add(current, unquote(t.substr(9)));
+        }
+    }
+
+    // Cargo.lock / poetry.lock / uv.lock: [[package]] tables with name and version keys
+    void tomlPackageDeps(const std::string &s, DependencyList &deps) {
+        std::string name, version;
+        bool inPackage = false;
+        auto flush = [&]() {
+            if (inPackage) deps.add(name, version);
+            name.clear();
+            version.clear();
+        };
+        for (auto &line : split_lines(s)) {
+            std::string t = trim(line);
+            if (starts_with(t, "[")) {
+                if (starts_with(t, "[[package]]")) { flush(); inPackage = true; }
+                else if (!starts_with(t, "[package.")) { flush(); inPackage = false; }
+                continue;
+            }
+            if (!inPackage) continue;
+            auto eq = t.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = trim(t.substr(0, eq));
+            if (key == "name" && name.empty()) name = unquote(t.substr(eq + 1));
+            else if (key == "version" && version.empty()) version = unquote(t.substr(eq + 1));
+        }
+        flush();
+    }
+
+    // Gemfile.lock: "    name (version)" lines under specs:
+    void gemfileDeps(const std::string &s, DependencyList &deps) {
+        for (auto &line : split_lines(s)) {
+            if (line.size() < 5 || line.compare(0, 4, "    ") != 0 || line[4] == ' ') continue;
+            std::string t = trim(line);
+            auto open = t.find(" (");
+            auto close = t.rfind(')');
+            if (open == std::string::npos || close == std::string::npos || close < open) continue;
+            deps.add(t.substr(0, open), t.substr(open + 2, close - open - 2));
+        }
+    }
+
+    // go.sum: "module version[/go.mod] hash"
+    void goSumDeps(const std::string &s, DependencyList &deps) {
+        for (auto &line : split_lines(s)) {
+            std::string t = trim(line);
+            auto sp = t.find(' ');
+            if (sp == std::string::npos) continue;
+            auto sp2 = t.find(' ', sp + 1);
+            std::string version = t.substr(sp + 1, sp2 == std::string::npos ? std::string::npos : sp2 - sp - 1);
+            auto gm = version.find("/go.mod");
+            if (gm != std::string::npos) version = version.substr(0, gm);
+            deps.add(t.substr(0, sp), version);
+        }
+    }
+
+    // pnpm-lock.yaml: "  /name@version:" or "  name@version:" keys under packages:
+    void pnpmDeps(const std::string &s, DependencyList &deps) {
+        bool inPackages = false;
+        for (auto &line : split_lines(s)) {
+            if (line.empty()) continue;
+            if (line[0] != ' ') { inPackages = starts_with(line, "packages:"); continue; }
+            if (!inPackages || line.size() < 3 || line[2] == ' ') continue;
+            std::string key = unquote(trim(line));
+            if (!key.empty() && key.back() == ':') key = unquote(key.substr(0, key.size() - 1));
+            if (!key.empty() && key[0] == '/') key.erase(0, 1);
+            auto paren = key.find('(');
+            if (paren != std::string::npos) key = key.substr(0, paren);
+            auto at = key.rfind('@');
+            if (at == std::string::npos || at == 0) continue;
+            deps.add(key.substr(0, at), key.substr(at + 1));
+        }
+    }
+}
+
+std::string StructuredMinifier::summarizeLockfile(const std::string &s, const std::string &path) {
+    std::string name = baseName(path);
+    DependencyList deps;
+    if (name == "yarn.lock") yarnDeps(s, deps);
+    else if (name == "pnpm-lock.yaml") pnpmDeps(s, deps);
+    else if (name == "cargo.lock" || name == "poetry.lock" || name == "uv.lock") tomlPackageDeps(s, deps);
+    else if (name == "gemfile.lock") gemfileDeps(s, deps);
+    else if (name == "go.sum") goSumDeps(s, deps);
+    else jsonLockDeps(s, deps);
+
+    return "# lockfile summary: " + std::to_string(deps.count) + " dependencies\n" + deps.lines;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+namespace rcpack {
+
+    // Single-pass reducers for config/data files, used by Compressor::process in compress mode.
+    // Each keeps only O(nesting depth) state besides the output it produces.
+    class StructuredMinifier {
+    public:
+        enum class Kind { None, Json, Yaml, Xml, Lockfile };
+
+        // Picks a backend from the file name; Lockfile wins over the extension
+        // (package-lock.json is summarised, not minified).
+        static Kind detect(const std::string &path);
+        static std::string process(Kind kind, const std::string &content, const std::string &path);
+
+        // Whitespace-free JSON; arrays longer than maxArrayItems keep their first items
+        // followed by a "... (+N more)" marker so the result is still valid JSON.
+        static std::string minifyJson(const std::string &s, size_t maxArrayItems = 3);
+        // Keys with their indentation; values dropped, runs of scalar list items counted.
+        static std::string yamlSkeleton(const std::string &s);
+        // Comments and inter-tag whitespace removed, text runs collapsed to single spaces.
+        static std::string minifyXml(const std::string &s);
+        // "name@version" per dependency for npm/yarn/pnpm/cargo/poetry/bundler/go/composer locks.
+        static std::string summarizeLockfile(const std::string &s, const std::string &path);
+    };
+}
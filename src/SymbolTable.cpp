@@ -0,0 +1,81 @@
+#include "SymbolTable.h"
+#include <cstring>
+
+using namespace rcpack;
+
+size_t SymbolTable::add(std::string_view name, SymbolKind kind, uint32_t file, uint32_t line, int32_t parent) {
+    st_names.append(name.data(), name.size());
+    st_nameOffsets.push_back(static_cast<uint32_t>(st_names.size()));
+    st_kinds.push_back(kind);
+    st_files.push_back(file);
+    st_lines.push_back(line);
+    st_parents.push_back(parent);
+    return st_kinds.size() - 1;
+}
+
+void SymbolTable::append(const SymbolTable &other, uint32_t file) {
+    const int32_t base = static_cast<int32_t>(size());
+    for (size_t r = 0; r < other.size(); ++r) {
+        int32_t parent = other.parent(r) < 0 ? -1 : other.parent(r) + base;
+        add(other.name(r), other.kind(r), file, other.line(r), parent);
+    }
+}
+
+void SymbolTable::clear() {
+    st_names.clear();
+    st_nameOffsets.assign(1, 0);
+    st_kinds.clear();
+    st_files.clear();
+    st_lines.clear();
+    st_parents.clear();
+}
+
+// u32 rows, then per row: u8 kind, u32 file, u32 line, i32 parent, u32 name length, name
+void SymbolTable::encode(std::string &out) const {
+    auto put = [&](const void *p, size_t n) { out.append(static_cast<const char *>(p), n); };
+    uint32_t rows = static_cast<uint32_t>(size());
+    put(&rows, 4);
+    for (size_t r = 0; r < size(); ++r) {
+        uint8_t kind = static_cast<uint8_t>(st_kinds[r]);
+        uint32_t len = st_nameOffsets[r + 1] - st_nameOffsets[r];
+        put(&kind, 1);
+        put(&st_files[r], 4);
+        put(&st_lines[r], 4);
+        put(&st_parents[r], 4);
+        put(&len, 4);
+        put(st_names.data() + st_nameOffsets[r], len);
+    }
+}
+
+bool SymbolTable::decode(std::string_view in, SymbolTable &out) {
+    out.clear();
+    size_t at = 0;
+    auto get = [&](void *p, size_t n) {
+        if (in.size() - at < n) return false;
+        std::memcpy(p, in.data() + at, n);
+        at += n;
+        return true;
+    };
+    uint32_t rows = 0;
+    if (!get(&rows, 4)) return false;
+    for (uint32_t r = 0; r < rows; ++r) {
+        uint8_t kind;
+        uint32_t file, line, len;
+        int32_t parent;
+        if (!get(&kind, 1) || !get(&file, 4) || !get(&line, 4) || !get(&parent, 4) || !get(&len, 4)) return false;
+        if (kind > static_cast<uint8_t>(SymbolKind::Struct) || in.size() - at < len || parent >= static_cast<int32_t>(r)) return false;
+        out.add(in.substr(at, len), static_cast<SymbolKind>(kind), file, line, parent);
+        at += len;
+    }
+    return at == in.size();
+}
+
+const char *SymbolTable::kindName(SymbolKind kind) {
+    switch (kind) {
+        case SymbolKind::Function: return "function";
+        case SymbolKind::Method: return "method";
+        case SymbolKind::Class: return "class";
+        case SymbolKind::Struct: return "struct";
+    }
+    return "symbol";
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rcpack {
+
+    enum class SymbolKind : uint8_t { Function, Method, Class, Struct };
+
+    // Repository-wide symbol index stored column by column: one contiguous name pool plus
+    // one vector per attribute, so a 50k-file repo costs a few bytes per symbol.
+    class SymbolTable {
+        std::string st_names;
+        std::vector<uint32_t> st_nameOffsets{0}; // size() + 1 entries into st_names
+        std::vector<SymbolKind> st_kinds;
+        std::vector<uint32_t> st_files;
+        std::vector<uint32_t> st_lines;
+        std::vector<int32_t> st_parents;         // row of the enclosing class/struct, -1 at top level
+    public:
+        size_t size() const { return st_kinds.size(); }
+        bool empty() const { return st_kinds.empty(); }
+
+        size_t add(std::string_view name, SymbolKind kind, uint32_t file, uint32_t line, int32_t parent = -1);
+        // Appends every row of other with its file column replaced by file; parent rows are rebased.
+        void append(const SymbolTable &other, uint32_t file);
+        void clear();
+        // Flat byte form for the on-disk cache; decode returns false on malformed input.
+        void encode(std::string &out) const;
+        static bool decode(std::string_view in, SymbolTable &out);
+
+        std::string_view name(size_t row) const {
+            return std::string_view(st_names).substr(st_nameOffsets[row], st_nameOffsets[row + 1] - st_nameOffsets[row]);
+        }
+        SymbolKind kind(size_t row) const { return st_kinds[row]; }
+        uint32_t file(size_t row) const { return st_files[row]; }
+        uint32_t line(size_t row) const { return st_lines[row]; }
+        int32_t parent(size_t row) const { return st_parents[row]; }
+
+        static const char *kindName(SymbolKind kind);
+    };
+}
@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+#include <iostream>
+
+using namespace rcpack;
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = defaultThreads();
+    tp_workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) tp_workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(tp_mutex);
+        tp_stopping = true;
+    }
+    tp_taskReady.notify_all();
+    for (auto &t : tp_workers) t.join();
+}
+
+size_t ThreadPool::defaultThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(tp_mutex);
+        tp_tasks.push_back(std::move(task));
+    }
+    tp_taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(tp_mutex);
+    tp_idle.wait(lock, [this] { return tp_tasks.empty() && tp_running == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tp_mutex);
+            tp_taskReady.wait(lock, [this] { return tp_stopping || !tp_tasks.empty(); });
+            if (tp_tasks.empty()) return; // stopping and drained
+            task = std::move(tp_tasks.front());
+            tp_tasks.pop_front();
+            ++tp_running;
+        }
+        try {
+            task();
+        } catch (const std::exception &ex) {
+            std::cerr << "Warning (worker): " << ex.what() << "\n";
+        } catch (...) {
+            std::cerr << "Warning (worker): unknown error\n";
+        }
+        {
+            std::lock_guard<std::mutex> lock(tp_mutex);
+            --tp_running;
+            if (tp_tasks.empty() && tp_running == 0) tp_idle.notify_all();
+        }
+    }
+}
+
+void ByteBudget::acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(bb_mutex);
+    bb_released.wait(lock, [&] { return bb_used == 0 || bb_used + bytes <= bb_limit; });
+    bb_used += bytes;
+}
+
+void ByteBudget::release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(bb_mutex);
+        bb_used -= bytes;
+    }
+    bb_released.notify_all();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rcpack {
+
+    // Fixed-size pool of worker threads consuming a FIFO task queue.
+    class ThreadPool {
+        std::vector<std::thread> tp_workers;
+        std::deque<std::function<void()>> tp_tasks;
+        std::mutex tp_mutex;
+        std::condition_variable tp_taskReady;
+        std::condition_variable tp_idle;
+        size_t tp_running = 0;
+        bool tp_stopping = false;
+
+        void workerLoop();
+    public:
+        // threads == 0 picks defaultThreads()
+        explicit ThreadPool(size_t threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void submit(std::function<void()> task);
+        // Blocks until the queue is empty and no task is running.
+        void wait();
+        size_t size() const { return tp_workers.size(); }
+
+        static size_t defaultThreads();
+    };
+
+    // Counting budget used to cap how many bytes are being worked on at once.
+    class ByteBudget {
+        size_t bb_limit;
+        size_t bb_used = 0;
+        std::mutex bb_mutex;
+        std::condition_variable bb_released;
+    public:
+        explicit ByteBudget(size_t limit): bb_limit(limit) {}
+        // A single request larger than the limit is admitted once nothing else is in flight.
+        void acquire(size_t bytes);
+        void release(size_t bytes);
+    };
+
+    // Runs produce(k) for k = 0 .. n-1 on `jobs` threads (0 = defaultThreads()) and hands each
+    // result to consume(k, T&&) on the calling thread, strictly in k order, as soon as it is
+    // ready. At most `window` results exist at once (produced but not yet consumed). A produce
+    // call that throws yields fallback(k) instead, so no k is skipped.
+    template <typename T, typename Produce, typename Consume, typename Fallback>
+    void runOrdered(size_t n, size_t jobs, size_t window, Produce &&produce, Consume &&consume, Fallback &&fallback) {
+        if (jobs == 0) jobs = ThreadPool::defaultThreads();
+        window = window == 0 ? 1 : window;
+        auto produceSafely = [&](size_t k) {
+            try {
+                return T(produce(k));
+            } catch (const std::exception &e) {
+                std::cerr << "Warning: worker failed: " << e.what() << "\n";
+                return T(fallback(k));
+            } catch (...) {
+                std::cerr << "Warning: worker failed\n";
+                return T(fallback(k));
+            }
+        };
+        if (jobs <= 1 || n <= 1 || window == 1) {
+            for (size_t k = 0; k < n; ++k) consume(k, produceSafely(k));
+            return;
+        }
+
+        // ring of `window` slots; slot k % window holds the result for k until it is consumed
+        std::vector<T> slots(window);
+        std::vector<char> ready(window, 0);
+        std::mutex mutex;
+        std::condition_variable filled;
+        ThreadPool pool(jobs < n ? jobs : n);
+        size_t submitted = 0;
+        for (size_t next = 0; next < n; ++next) {
+            for (; submitted < n && submitted < next + window; ++submitted) {
+                pool.submit([&, k = submitted] {
+                    T result = produceSafely(k);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    slots[k % window] = std::move(result);
+                    ready[k % window] = 1;
+                    filled.notify_all();
+                });
+            }
+            T result;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                filled.wait(lock, [&] { return ready[next % window] != 0; });
+                result = std::move(slots[next % window]);
+                slots[next % window] = T();
+                ready[next % window] = 0;
+            }
+            consume(next, std::move(result));
+        }
+        pool.wait();
+    }
+
+    // As above; a produce call that throws yields a default-constructed T.
+    template <typename T, typename Produce, typename Consume>
+    void runOrdered(size_t n, size_t jobs, size_t window, Produce &&produce, Consume &&consume) {
+        runOrdered<T>(n, jobs, window, std::forward<Produce>(produce), std::forward<Consume>(consume),
+                      [](size_t) { return T(); });
+    }
+}
@@ -0,0 +1,216 @@
+#include "Tokenizer.h"
+#include "Hash.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace rcpack;
+
+static bool isLetter(unsigned char c) { return std::isalpha(c) || c >= 0x80; }
+static bool isDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+static bool isSpace(unsigned char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+static bool isNewline(unsigned char c) { return c == '\n' || c == '\r'; }
+
+static int base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static bool base64Decode(const std::string &in, std::string &out) {
+    out.clear();
+    uint32_t buf = 0;
+    int bits = 0;
+    for (char c : in) {
+        if (c == '=') break;
+        int v = base64Value(c);
+        if (v < 0) return false;
+        buf = (buf << 6) | static_cast<uint32_t>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buf >> bits) & 0xff));
+        }
+    }
+    return true;
+}
+
+// never reused, unlike addresses: a new Tokenizer at a freed one's address gets a fresh memo
+static uint64_t nextTokenizerId() {
+    static std::atomic<uint64_t> next{1};
+    return next++;
+}
+
+Tokenizer::Tokenizer(): tk_id(nextTokenizerId()) {}
+
+bool Tokenizer::loadVocab(const std::filesystem::path &p) {
+    std::ifstream in(p, std::ios::in | std::ios::binary);
+    if (!in) {
+        std::cerr << "Warning: cannot open tokenizer vocabulary " << p << "; using approximate token counts\n";
+        return false;
+    }
+    std::vector<std::pair<std::string, uint32_t>> ranks;
+    std::string line, token;
+    size_t lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        auto sp = line.find(' ');
+        if (sp == std::string::npos || !base64Decode(line.substr(0, sp), token)) {
+            std::cerr << "Warning: malformed vocabulary line " << lineNo << " in " << p << "; using approximate token counts\n";
+            return false;
+        }
+        try {
+            ranks.emplace_back(token, static_cast<uint32_t>(std::stoul(line.substr(sp + 1))));
+        } catch (const std::exception &) {
+            std::cerr << "Warning: malformed rank on line " << lineNo << " in " << p << "; using approximate token counts\n";
+            return false;
+        }
+    }
+    // one block for all tokens, filled before any view into it is taken
+    size_t bytes = 0;
+    for (auto &r : ranks) bytes += r.first.size();
+    tk_bytes.clear();
+    tk_bytes.reserve(bytes);
+    for (auto &r : ranks) tk_bytes.insert(tk_bytes.end(), r.first.begin(), r.first.end());
+    tk_ranks.clear();
+    tk_ranks.reserve(ranks.size());
+    size_t at = 0;
+    tk_vocabHash = hashCombine(1, ranks.size());
+    for (auto &r : ranks) {
+        tk_vocabHash = hashCombine(tk_vocabHash, hashString(r.first, r.second));
+        tk_ranks[std::string_view(tk_bytes.data() + at, r.first.size())] = r.second; // later lines win
+        at += r.first.size();
+    }
+    tk_id = nextTokenizerId();
+    return !tk_ranks.empty();
+}
+
+size_t Tokenizer::nextPiece(std::string_view s, size_t pos) {
+    const size_t n = s.size();
+    auto at = [&](size_t i) { return static_cast<unsigned char>(s[i]); };
+    size_t i = pos;
+
+    // 's 't 're 've 'm 'll 'd
+    if (at(i) == '\'' && i + 1 < n) {
+        char a = static_cast<char>(std::tolower(at(i + 1)));
+        char b = i + 2 < n ? static_cast<char>(std::tolower(at(i + 2))) : 0;
+        if ((a == 'r' && b == 'e') || (a == 'v' && b == 'e') || (a == 'l' && b == 'l')) return 3;
+        if (a == 's' || a == 't' || a == 'm' || a == 'd') return 2;
+    }
+    // [^\r\n\p{L}\p{N}]?\p{L}+
+    {
+        size_t j = i;
+        if (!isLetter(at(j)) && !isDigit(at(j)) && !isNewline(at(j)) && j + 1 < n && isLetter(at(j + 1))) ++j;
+        if (isLetter(at(j))) {
+            while (j < n && isLetter(at(j))) ++j;
+            return j - i;
+        }
+    }
+    // \p{N}{1,3}
+    if (isDigit(at(i))) {
+        size_t j = i;
+        while (j < n && j - i < 3 && isDigit(at(j))) ++j;
+        return j - i;
+    }
+    //  ?[^\s\p{L}\p{N}]+[\r\n]*
+    {
+        size_t j = i;
+        if (at(j) == ' ' && j + 1 < n) ++j;
+        auto isPunct = [&](unsigned char c) { return !isSpace(c) && !isLetter(c) && !isDigit(c); };
+        if (isPunct(at(j))) {
+            while (j < n && isPunct(at(j))) ++j;
+            while (j < n && isNewline(at(j))) ++j;
+            return j - i;
+        }
+    }
+    // whitespace: \s*[\r\n]+ | \s+(?!\S) | \s+
+    size_t j = i;
+    size_t lastNewline = std::string::npos;
+    while (j < n && isSpace(at(j))) {
+        if (isNewline(at(j))) lastNewline = j;
+        ++j;
+    }
+    if (lastNewline != std::string::npos) return lastNewline + 1 - i;
+    if (j < n && j - i > 1) return j - i - 1; // leave one space to prefix the next word
+    return j > i ? j - i : 1;
+}
+
+size_t Tokenizer::approxCount(std::string_view piece) {
+    size_t len = piece.size();
+    unsigned char c = static_cast<unsigned char>(piece.back());
+    if (isSpace(c)) return 1;
+    if (isDigit(c)) return (len + 2) / 3;
+    if (isLetter(c)) {
+        size_t nonAscii = 0;
+        for (unsigned char ch : piece) if (ch >= 0x80) ++nonAscii;
+        // multi-byte text is roughly one token per character
+        if (nonAscii) return std::max<size_t>(1, nonAscii / 2 + (len - nonAscii + 5) / 6);
+        return std::max<size_t>(1, (len + 5) / 6);
+    }
+    return std::max<size_t>(1, (len + 1) / 2);
+}
+
+size_t Tokenizer::bpeCount(std::string_view piece) const {
+    if (tk_ranks.count(piece)) return 1;
+    // byte-pair merge: repeatedly join the adjacent pair with the lowest rank
+    std::vector<size_t> starts(piece.size() + 1);
+    for (size_t i = 0; i <= piece.size(); ++i) starts[i] = i;
+    for (;;) {
+        uint32_t bestRank = UINT32_MAX;
+        size_t bestAt = 0;
+        for (size_t k = 0; k + 2 < starts.size(); ++k) {
+            auto it = tk_ranks.find(piece.substr(starts[k], starts[k + 2] - starts[k]));
+            if (it != tk_ranks.end() && it->second < bestRank) {
+                bestRank = it->second;
+                bestAt = k;
+            }
+        }
+        if (bestRank == UINT32_MAX) break;
+        starts.erase(starts.begin() + static_cast<std::ptrdiff_t>(bestAt) + 1);
+    }
+    return starts.size() - 1;
+}
+
+size_t Tokenizer::count(std::string_view text) const {
+    // most pre-tokens repeat (keywords, identifiers, indentation), so memoise per thread
+    thread_local std::unordered_map<std::string, uint32_t> memo;
+    thread_local uint64_t memoOwner = 0;
+    if (memoOwner != tk_id || memo.size() > (1u << 20)) {
+        memo.clear();
+        memoOwner = tk_id;
+    }
+
+    size_t total = 0;
+    size_t pos = 0;
+    std::string key;
+    while (pos < text.size()) {
+        size_t len = Tokenizer::nextPiece(text, pos);
+        std::string_view piece = text.substr(pos, len);
+        pos += len;
+        if (!hasVocab()) {
+            total += approxCount(piece);
+            continue;
+        }
+        key.assign(piece.data(), piece.size());
+        auto it = memo.find(key);
+        if (it != memo.end()) {
+            total += it->second;
+            continue;
+        }
+        // very long runs (minified blobs) are split so the quadratic merge stays cheap
+        size_t tokens = 0;
+        for (size_t off = 0; off < piece.size(); off += 256) tokens += bpeCount(piece.substr(off, 256));
+        memo.emplace(key, static_cast<uint32_t>(tokens));
+        total += tokens;
+    }
+    return total;
+}
@@ -9,7 +9,12 @@ CLI::CLI(int argc, char* argv[]) : m_argc(argc), m_argv(argv) {}
 Config CLI::parse() {
     Config cfg;
 
-    for (int i = 1; i < m_argc; i++) {
+    int first = 1;
+    if (m_argc > 1 && std::string(m_argv[1]) == "extract") {
+        cfg.extract = true;
+        first = 2;
+    }
+    for (int i = first; i < m_argc; i++) {
         std::string arg = m_argv[i];
 
         if (arg == "-h" || arg == "--help") {
@@ -21,6 +26,28 @@ Config CLI::parse() {
         else if (arg == "-r" || arg == "--recent") {
             cfg.showRecent = true;
         }
+        else if (arg == "--since") {
+            if (i + 1 < m_argc) {
+                cfg.c_sinceRef = m_argv[++i];
+            }
+            else {
+                std::cerr << "Error: missing ref after " << arg << "\n";
+            }
+        }
+        else if (arg == "--staged") {
+            cfg.staged = true;
+        }
+        else if (arg == "--diff") {
+            cfg.diffHunks = true;
+        }
+        else if (arg == "--rev") {
+            if (i + 1 < m_argc) {
+                cfg.c_rev = m_argv[++i];
+            }
+            else {
+                std::cerr << "Error: missing commit after " << arg << "\n";
+            }
+        }
         else if (arg == "-d" || arg == "--dirs-only") {
             cfg.dirsOnly = true;
         }
@@ -41,6 +68,172 @@ Config CLI::parse() {
                 std::cerr << "Error: missing file name after " << arg << "\n";
             }
         }
+        else if (arg == "--dedup") {
+            cfg.dedup = true;
+        }
+        else if (arg == "--near-dedup") {
+            cfg.dedup = true;
+            cfg.nearDedup = true;
+        }
+        else if (arg == "--common-preamble") {
+            cfg.commonPreamble = true;
+        }
+        else if (arg == "--symbols") {
+            cfg.symbols = true;
+        }
+        else if (arg == "--symbols-json") {
+            if (i + 1 < m_argc) {
+                cfg.c_symbolsJson = m_argv[++i];
+            }
+            else {
+                std::cerr << "Error: missing file name after " << arg << "\n";
+            }
+        }
+        else if (arg == "--query") {
+            if (i + 1 < m_argc) {
+                cfg.c_query = m_argv[++i];
+            }
+            else {
+                std::cerr << "Error: missing query text after " << arg << "\n";
+            }
+        }
+        else if (arg == "--query-top") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                try {
+                    cfg.queryTop = static_cast<size_t>(std::stoull(raw));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid file count '" << raw << "' after " << arg << "\n";
+                }
+            }
+            else {
+                std::cerr << "Error: missing file count after " << arg << "\n";
+            }
+        }
+        else if (arg == "--focus") {
+            if (i + 1 < m_argc) {
+                rcpack::split_comma(m_argv[++i], cfg.c_focus);
+            }
+            else {
+                std::cerr << "Error: missing path after " << arg << "\n";
+            }
+        }
+        else if (arg == "--depth") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                try {
+                    cfg.focusDepth = static_cast<size_t>(std::stoull(raw));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid depth '" << raw << "' after " << arg << "\n";
+                }
+            }
+            else {
+                std::cerr << "Error: missing depth after " << arg << "\n";
+            }
+        }
+        else if (arg == "--max-tokens") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                try {
+                    cfg.maxTokens = static_cast<size_t>(std::stoull(raw));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid token count '" << raw << "' after " << arg << "\n";
+                }
+            }
+            else {
+                std::cerr << "Error: missing token count after " << arg << "\n";
+            }
+        }
+        else if (arg == "--incremental") {
+            cfg.incremental = true;
+        }
+        else if (arg == "--split-max-bytes" || arg == "--split-max-tokens") {
+            size_t &limit = arg == "--split-max-bytes" ? cfg.splitMaxBytes : cfg.splitMaxTokens;
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                try {
+                    limit = static_cast<size_t>(std::stoull(raw));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid limit '" << raw << "' after " << arg << "\n";
+                }
+            }
+            else {
+                std::cerr << "Error: missing limit after " << arg << "\n";
+            }
+        }
+        else if (arg == "--tokenizer-vocab") {
+            if (i + 1 < m_argc) {
+                cfg.c_tokenizerVocab = m_argv[++i];
+            }
+            else {
+                std::cerr << "Error: missing file name after " << arg << "\n";
+            }
+        }
+        else if (arg == "--token-counts") {
+            cfg.tokenCounts = true;
+        }
+        else if (arg == "--sort-by-tokens") {
+            cfg.sortByTokens = true;
+        }
+        else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                try {
+                    cfg.jobs = static_cast<size_t>(std::stoul(raw));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid thread count '" << raw << "' after " << arg << "\n";
+                }
+            }
+            else {
+                std::cerr << "Error: missing thread count after " << arg << "\n";
+            }
+        }
+        else if (arg == "--format") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                if (raw == "markdown" || raw == "md") cfg.format = OutputFormat::Markdown;
+                else if (raw == "json") cfg.format = OutputFormat::Json;
+                else if (raw == "jsonl") cfg.format = OutputFormat::Jsonl;
+                else if (raw == "msgpack") cfg.format = OutputFormat::MsgPack;
+                else if (raw == "rcpk") cfg.format = OutputFormat::Pack;
+                else std::cerr << "Error: unknown format '" << raw << "' after " << arg << " (markdown, json, jsonl, msgpack, rcpk)\n";
+            }
+            else {
+                std::cerr << "Error: missing format after " << arg << "\n";
+            }
+        }
+        else if (arg == "--pack-codec") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                if (raw == "lz4") cfg.packLz4 = true;
+                else if (raw == "none") cfg.packLz4 = false;
+                else std::cerr << "Error: unknown codec '" << raw << "' after " << arg << " (lz4, none)\n";
+            }
+            else {
+                std::cerr << "Error: missing codec after " << arg << "\n";
+            }
+        }
+        else if (arg == "--window") {
+            if (i + 1 < m_argc) {
+                std::string raw = m_argv[++i];
+                try {
+                    cfg.window = static_cast<size_t>(std::stoul(raw));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid window size '" << raw << "' after " << arg << "\n";
+                }
+            }
+            else {
+                std::cerr << "Error: missing window size after " << arg << "\n";
+            }
+        }
+        else if (arg == "--cache-dir") {
+            if (i + 1 < m_argc) {
+                cfg.c_cacheDir = m_argv[++i];
+            }
+            else {
+                std::cerr << "Error: missing directory after " << arg << "\n";
+            }
+        }
         else if (arg == "-i" || arg == "--include") {
             if (i + 1 < m_argc) {
                 std::string patterns = m_argv[++i];
@@ -65,21 +258,57 @@ Config CLI::parse() {
             cfg.c_paths.push_back(arg);
         }
     }
-    if (cfg.c_paths.empty()) {
+    if (cfg.c_paths.empty() && !cfg.extract) {
         cfg.c_paths.push_back(".");
     }
     return cfg;
 }
 
 void CLI::print_help() {
-    std::cout << "Usage: " << TOOL_NAME << " [paths...] [options]\n\n"
-        << "Package a repository (or files) into an LLM-friendly text file.\n\n"
+    std::cout << "Usage: " << TOOL_NAME << " [paths...] [options]\n"
+        << "       " << TOOL_NAME << " extract <pack.rcpk> [path] [-o file]\n\n"
+        << "Package a repository (or files) into an LLM-friendly text file.\n"
+        << "extract prints one file of an .rcpk package (or lists its files when no path is given).\n"
+        << "Packages keep the packaged text, so truncated or compressed files are not byte-exact.\n\n"
         << "Options:\n"
         << "  -h, --help            Display this help message\n"
         << "  -v, --version         Display current version information\n"
         << "  -o, --output <file>   Write packaged output to file (default: stdout)\n"
+        << "  --format <fmt>        markdown (default), json, jsonl (one record per line), msgpack or\n"
+        << "                        rcpk (indexed pack; implied by -o *.rcpk)\n"
+        << "  --pack-codec <c>      rcpk block compression: lz4 (default) or none\n"
+        << "  --split-max-bytes <n> Split the -o file at file boundaries into shards (out.001.md, ...)\n"
+        << "                        of at most n bytes; --split-max-tokens <n> caps their content tokens\n"
+        << "  --incremental         Rewrite only the sections of changed files in the -o file (keeps an\n"
+        << "                        index next to it, <file>.rcidx)\n"
         << "  -i, --include <globs> Comma-separated glob(s) to include, e.g. \"*.cpp,*.h\"\n"
-        << "  -r, --recent          Only include files modified in the last 7 days\n\n"
+        << "  -r, --recent          Only include files changed by commits of the last 7 days\n"
+        << "                        or not committed yet (file modification times outside\n"
+        << "                        a git repository)\n"
+        << "  --since <ref>         Only tracked files changed since the merge base of ref and HEAD\n"
+        << "                        (committed or not), e.g. --since main\n"
+        << "  --staged              Only files whose staged version differs from HEAD\n"
+        << "                        (packaging that staged version)\n"
+        << "  --diff                With --since/--staged: add each file's changes as a diff block\n"
+        << "  --rev <commit>        Package a commit (branch, tag, HEAD~2, 0749dca, ...) from\n"
+        << "                        the git object database without checking it out\n"
+        << "  -c, --compress        Keep only signatures and their comments\n"
+        << "  --dedup               Replace files identical to an earlier file with a reference\n"
+        << "  --near-dedup          Also replace near-identical files (similar line sequences)\n"
+        << "  --common-preamble     Print leading blocks shared by many files (license headers) once\n"
+        << "  --symbols             Add a Symbols section (functions/classes with file and line)\n"
+        << "  --symbols-json <file> Write the symbol index as JSON\n"
+        << "  --max-tokens <n>      Reduce files (least relevant first) until the package fits n tokens\n"
+        << "  --focus <paths>       Only these files and the files they include/import or are used by\n"
+        << "  --depth <n>           With --focus: how many include/import steps to follow (default: 1)\n"
+        << "  --query <text>        Keep only files relevant to the text, best match first (BM25)\n"
+        << "  --query-top <n>       With --query: keep at most n files\n"
+        << "  --token-counts        Show the token count of every file next to its header\n"
+        << "  --sort-by-tokens      Print files largest token count first\n"
+        << "  --tokenizer-vocab <f> tiktoken ranks file (e.g. cl100k_base.tiktoken) for exact counts\n"
+        << "  -j, --jobs <n>        Worker threads for reading files (default: all cores)\n"
+        << "  --window <n>          Files read ahead of the one being written (default: 64)\n"
+        << "  --cache-dir <dir>     Reuse processed file contents from a previous run\n\n"
         << "Examples:\n"
         << "  ./" << TOOL_NAME << " .\n"
         << "  ./" << TOOL_NAME << " /path/to/repo\n"
@@ -7,10 +7,34 @@
 #include "Cli.h"
 #include "RepositoryScanner.h"
 #include "FileReader.h"
+#include "ContentPipeline.h"
+#include "BudgetPlanner.h"
+#include "Deduplicator.h"
+#include "PreambleDetector.h"
 #include "GitInfoCollector.h"
+#include "GitRepository.h"
 #include "OutputFormatter.h"
 #include "utils.h"
-#include "Compressor.h"
+#include "CompressionCache.h"
+#include "Tokenizer.h"
+#include "OutputSink.h"
+#include "ThreadPool.h"
+#include "SearchIndex.h"
+#include "DependencyGraph.h"
+#include "PackFile.h"
+#include "DirectoryTree.h"
+#include "ShardedOutput.h"
+#include "IncrementalOutput.h"
+#include "Hash.h"
+#include "LineDiff.h"
+#include "RevisionSource.h"
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
 
 using namespace rcpack;
 namespace fs = std::filesystem;
@@ -44,6 +68,345 @@ static fs::path findRepoRoot(fs::path start) {
     return {};
 }
 
+// root-relative generic paths of the scanned files (absolute when outside root)
+static std::vector<std::string> relativePaths(const std::vector<FileEntry> &files, const fs::path &root) {
+    std::vector<std::string> relPaths;
+    relPaths.reserve(files.size());
+    for (auto &fe : files) {
+        std::string_view fast = relativeTo(fe, root);
+        if (!fast.empty()) {
+            relPaths.emplace_back(fast);
+            continue;
+        }
+        std::error_code ec;
+        auto rel = fs::relative(fe.path, root, ec);
+        relPaths.push_back(ec ? fe.path.generic_string() : rel.generic_string());
+    }
+    return relPaths;
+}
+
+// Drops every file not listed in kept (contents may be empty when nothing was loaded yet).
+// Survivors stay in scan order; returns the new index of each entry of kept, in kept's order.
+static std::vector<size_t> keepOnly(std::vector<FileEntry> &files, std::vector<FileContent> &contents,
+                                    const std::vector<size_t> &kept) {
+    std::vector<size_t> byScan = kept;
+    std::sort(byScan.begin(), byScan.end());
+    std::vector<size_t> newIndex(files.size(), 0);
+    std::vector<FileEntry> keptFiles;
+    std::vector<FileContent> keptContents;
+    for (size_t i : byScan) {
+        newIndex[i] = keptFiles.size();
+        keptFiles.push_back(std::move(files[i]));
+        if (i < contents.size()) keptContents.push_back(std::move(contents[i]));
+    }
+    files = std::move(keptFiles);
+    contents = std::move(keptContents);
+    std::vector<size_t> mapped;
+    for (size_t i : kept) mapped.push_back(newIndex[i]);
+    return mapped;
+}
+
+// --recent: the files touched by commits of the last MAX_RECENT_DAYS days, from the history
+// reachable from HEAD, plus those changed in the working tree or index since HEAD. File modification times say nothing after a fresh clone or CI checkout,
+// so they are only used (nullptr) outside a repository or when its history cannot be read.
+static std::unique_ptr<PathSet> recentlyCommitted(const fs::path &probe) {
+    GitRepository repo;
+    if (!repo.open(probe)) {
+        std::cerr << "Info: not a git repository; --recent uses file modification times\n";
+        return nullptr;
+    }
+    auto head = repo.resolve("HEAD");
+    std::unordered_set<std::string> paths;
+    size_t commits = 0;
+    const int64_t since = static_cast<int64_t>(std::time(nullptr)) - int64_t(MAX_RECENT_DAYS) * 24 * 3600;
+    if (!head || !repo.pathsChangedSince(*head, since, paths, &commits)) {
+        std::cerr << "Warning: could not read the commit history in " << repo.gitDir().string()
+                  << "; --recent uses file modification times\n";
+        return nullptr;
+    }
+    // edits not committed yet are the most recent of all
+    auto commit = repo.readCommit(*head);
+    size_t uncommitted = 0;
+    if (!commit || !repo.diffIndex(&commit->tree, true, [&](GitChange &&c) {
+            if (c.newMode && (c.newMode & 0170000) != 0160000 && paths.insert(std::move(c.path)).second) ++uncommitted;
+        })) {
+        std::cerr << "Warning: could not compare the working tree with HEAD in " << repo.gitDir().string()
+                  << "; --recent leaves out uncommitted changes\n";
+    }
+    auto set = std::make_unique<PathSet>(repo.workTree());
+    for (auto &p : paths) set->add(p);
+    std::cerr << "Info: --recent: " << paths.size() << " path(s) changed by " << commits << " commit(s) in the last "
+              << MAX_RECENT_DAYS << " days" << (uncommitted ? " or uncommitted (" + std::to_string(uncommitted) + ")" : std::string())
+              << (repo.hasCommitGraph() ? " (commit-graph)" : "") << "\n";
+    return set;
+}
+
+// --since <ref> / --staged: the tracked files that differ from a base commit, found by comparing
+// its tree with the working tree (--since; base = merge base of ref and HEAD) or with the index
+// (--staged; base = HEAD). --staged packages the index's versions, not the working tree's.
+struct ChangeSet {
+    std::unique_ptr<GitRepository> repo;
+    std::unique_ptr<PathSet> paths;                     // changed files that still exist
+    std::unordered_map<std::string, GitChange> changes; // by work-tree relative path
+    std::string base;                                   // the base commit, empty before the first one
+    std::unique_ptr<RevisionSource> staged;             // --staged: the staged blobs of paths
+};
+
+static std::unique_ptr<ChangeSet> changedFromBase(const Config &cfg, const fs::path &probe) {
+    const char *option = cfg.staged ? "--staged" : "--since";
+    auto set = std::make_unique<ChangeSet>();
+    set->repo = std::make_unique<GitRepository>();
+    GitRepository &repo = *set->repo;
+    if (!repo.open(probe)) {
+        std::cerr << "Error: " << option << " needs a git repository\n";
+        return nullptr;
+    }
+    auto base = repo.resolve("HEAD"); // none yet: everything staged is new
+    if (!cfg.staged) {
+        auto ref = repo.resolve(cfg.c_sinceRef);
+        if (!ref) {
+            std::cerr << "Error: unknown or ambiguous revision '" << cfg.c_sinceRef << "' for --since\n";
+            return nullptr;
+        }
+        base = base ? repo.mergeBase(*ref, *base) : std::nullopt;
+        if (!base) {
+            std::cerr << "Error: '" << cfg.c_sinceRef << "' and HEAD have no common ancestor\n";
+            return nullptr;
+        }
+    }
+    std::optional<GitCommit> commit;
+    if (base && !(commit = repo.readCommit(*base))) {
+        std::cerr << "Error: cannot read commit " << base->hex() << " in " << repo.gitDir().string() << "\n";
+        return nullptr;
+    }
+    if (base) set->base = base->hex();
+
+    set->paths = std::make_unique<PathSet>(repo.workTree());
+    if (cfg.staged) set->staged = std::make_unique<RevisionSource>(repo);
+    size_t deleted = 0, unmerged = 0;
+    bool ok = repo.diffIndex(commit ? &commit->tree : nullptr, !cfg.staged, [&](GitChange &&c) {
+        if (c.newMode == 0) {
+            ++deleted;
+        } else if (cfg.staged && c.newId == GitOid()) {
+            ++unmerged; // no single staged version to package
+        } else if ((c.newMode & 0170000) != 0160000) { // not submodules
+            set->paths->add(c.path);
+            if (set->staged) set->staged->add(c.path, c.newId);
+        }
+        std::string path = c.path;
+        set->changes.emplace(std::move(path), std::move(c));
+    });
+    if (!ok) {
+        std::cerr << "Error: cannot read the index or tree objects in " << repo.gitDir().string() << "\n";
+        return nullptr;
+    }
+    std::cerr << "Info: " << option << ": " << set->changes.size() << " changed path(s) against "
+              << (set->base.empty() ? std::string("an empty tree") : set->base.substr(0, 12))
+              << (deleted ? " (" + std::to_string(deleted) + " deleted)" : std::string()) << "\n";
+    if (unmerged) std::cerr << "Warning: --staged: " << unmerged << " unmerged path(s) left out\n";
+    return set;
+}
+
+// --diff: each scanned file's change as a unified diff, from the base blob to the working tree
+// file (--since) or to the staged blob (--staged). Indexed like files.
+static std::vector<std::string> changeDiffs(const Config &cfg, const ChangeSet &set, const std::vector<FileEntry> &files) {
+    std::vector<std::string> diffs(files.size());
+    runOrdered<std::string>(files.size(), cfg.jobs, 64,
+        [&](size_t i) {
+            std::string rel = files[i].path.lexically_relative(set.repo->workTree()).generic_string();
+            auto it = set.changes.find(rel);
+            if (it == set.changes.end()) return std::string();
+            const GitChange &c = it->second;
+            GitObject before, after;
+            if (c.oldMode && !set.repo->read(c.oldId, before)) return std::string("(base version unreadable)\n");
+            if (cfg.staged) {
+                if (c.newId == GitOid()) return std::string("(unmerged)\n");
+                if (!set.repo->read(c.newId, after)) return std::string("(staged version unreadable)\n");
+            } else {
+                MappedFile mf(files[i].path);
+                if (!mf.isOpen()) return std::string();
+                after.data.assign(mf.data(), mf.size());
+            }
+            // git's test for binary content: a NUL within the first 8000 bytes
+            auto binary = [](const std::string &s) { return std::memchr(s.data(), 0, std::min<size_t>(s.size(), 8000)) != nullptr; };
+            if (binary(before.data) || binary(after.data)) return "Binary files differ: " + rel + "\n";
+            return LineDiff(before.data, after.data).unified(c.oldMode ? rel : std::string(), rel);
+        },
+        [&](size_t i, std::string &&diff) { diffs[i] = std::move(diff); });
+    return diffs;
+}
+
+// --rev: the files of a commit, read from repo's object database.
+static std::unique_ptr<RevisionSource> openRevision(const std::string &rev, const fs::path &probe, GitRepository &repo) {
+    if (!repo.open(probe)) {
+        std::cerr << "Error: --rev needs a git repository\n";
+        return nullptr;
+    }
+    auto id = repo.resolve(rev);
+    if (!id) {
+        std::cerr << "Error: unknown or ambiguous revision '" << rev << "' for --rev\n";
+        return nullptr;
+    }
+    auto source = std::make_unique<RevisionSource>(repo);
+    if (!source->load(*id)) {
+        std::cerr << "Error: cannot read the tree of " << id->hex() << " in " << repo.gitDir().string() << "\n";
+        return nullptr;
+    }
+    std::cerr << "Info: --rev " << rev << ": commit " << id->hex().substr(0, 12) << ", "
+              << source->paths().size() << " file(s) in its tree\n";
+    return source;
+}
+
+// --focus: keep the files within --depth include/import edges of the focus files,
+// dependencies first. Returns false when no focus path matches a scanned file.
+static bool selectByFocus(const Config &cfg, const ContentPipeline &pipeline, const fs::path &outputRoot,
+                          std::vector<FileEntry> &files, std::vector<size_t> &order) {
+    auto relPaths = relativePaths(files, outputRoot);
+    auto graph = DependencyGraph::build(relPaths, pipeline.collectImports(files));
+
+    std::vector<uint32_t> seeds;
+    for (auto &raw : cfg.c_focus) {
+        fs::path p = normalizePath(raw);
+        auto it = std::find_if(files.begin(), files.end(), [&](const FileEntry &fe) { return fe.path.lexically_normal() == p; });
+        if (it == files.end()) {
+            std::cerr << "Warning: focus path is not among the scanned files: " << raw << "\n";
+            continue;
+        }
+        seeds.push_back(static_cast<uint32_t>(it - files.begin()));
+    }
+    if (seeds.empty()) return false;
+
+    auto topo = graph.topologicalOrder(graph.neighbourhood(seeds, cfg.focusDepth));
+    std::cerr << "Info: focus kept " << topo.size() << " of " << files.size() << " file(s) ("
+              << graph.edgeCount() << " dependency edge(s) resolved)\n";
+    std::vector<FileContent> none;
+    order = keepOnly(files, none, std::vector<size_t>(topo.begin(), topo.end()));
+    return true;
+}
+
+// --query: rank files with BM25 and keep the best ones that fit --query-top / --max-tokens.
+// Returns the kept indices, best first.
+static std::vector<size_t> selectByQuery(const Config &cfg, const std::vector<std::string> &relPaths,
+                                         const std::vector<FileContent> &contents) {
+    auto start = std::chrono::steady_clock::now();
+    SearchIndex index;
+    for (size_t i = 0; i < contents.size(); ++i) index.addDocument(relPaths[i], contents[i].content);
+    index.finalize();
+    auto ranked = index.rank(cfg.c_query);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Info: indexed " << index.docCount() << " file(s), " << index.termCount() << " term(s), "
+              << index.postingCount() << " posting(s) in " << ms << " ms; " << ranked.size() << " match the query\n";
+
+    std::vector<size_t> kept;
+    size_t used = BudgetPlanner::headerTokens({});
+    for (uint32_t d : ranked) {
+        if (cfg.queryTop && kept.size() >= cfg.queryTop) break;
+        size_t cost = BudgetPlanner::framingTokens(relPaths[d]) * 2 // header + tree line
+                      + BudgetPlanner::estimateTokens(contents[d].content.size());
+        if (cfg.maxTokens && used + cost > cfg.maxTokens) {
+            if (kept.empty()) kept.push_back(d); // always keep the best match
+            break;
+        }
+        used += cost;
+        kept.push_back(d);
+    }
+    return kept;
+}
+
+// --format rcpk: one block per distinct text (exact duplicates share their original's block),
+// encoded on the worker threads; files not loaded yet (streaming) are read here.
+static void writePack(const Config &cfg, const ContentPipeline &pipeline, const fs::path &root, const ScanResult &scan,
+                      const std::vector<FileContent> &contents, const std::vector<Preamble> &preambles, OutputSink &sink) {
+    auto relPaths = relativePaths(scan.files, root);
+    auto aliased = [&](size_t i) {
+        return i < contents.size() && contents[i].duplicateOf && !contents[i].nearDuplicate;
+    };
+    PackWriter writer(sink);
+    writer.begin();
+    runOrdered<PackBlock>(scan.files.size(), pipeline.jobs(), cfg.window,
+        [&](size_t i) {
+            PackBlock block;
+            if (aliased(i)) return block;
+            if (cfg.dirsOnly) {
+                block = PackWriter::encode({}, false);
+                block.flags = pack::NoContent;
+                return block;
+            }
+            FileContent loaded;
+            if (i >= contents.size()) loaded = pipeline.loadStreamed(scan.files[i], nullptr);
+            const FileContent &fc = i < contents.size() ? contents[i] : loaded;
+            if (fc.preambleId && *fc.preambleId < preambles.size()) {
+                // the pack holds whole files: put the shared preamble back
+                block = PackWriter::encode(preambles[*fc.preambleId].text + fc.content, cfg.packLz4);
+            } else {
+                block = PackWriter::encode(fc.content, cfg.packLz4);
+            }
+            block.lines = static_cast<uint32_t>(fc.lines);
+            if (fc.truncated) block.flags |= pack::Truncated;
+            // processed by the user's options or by the budget planner
+            if (fc.level != CompressionLevel::Full || cfg.compress || cfg.removeComments || cfg.removeEmptyLines) {
+                block.flags |= pack::Reduced;
+            }
+            if (fc.level == CompressionLevel::NameOnly || fc.unreadable) block.flags |= pack::NoContent;
+            return block;
+        },
+        [&](size_t i, PackBlock &&block) {
+            if (aliased(i)) writer.addAlias(relPaths[i], *contents[i].duplicateOf, static_cast<uint32_t>(contents[i].lines));
+            else writer.add(relPaths[i], std::move(block));
+        },
+        [&](size_t) {
+            // unreadable: listed without content, like an omitted file
+            PackBlock block = PackWriter::encode({}, false);
+            block.flags = pack::NoContent;
+            return block;
+        });
+    writer.finish();
+    std::cerr << "Info: packed " << writer.fileCount() << " file(s) into " << writer.bytesWritten() << " bytes\n";
+}
+
+// "extract <pack> [path]": print one file of a package, or list them all.
+static int extractFromPack(const Config &cfg) {
+    if (cfg.c_paths.empty()) {
+        std::cerr << "Error: extract needs a .rcpk file. Use -h for help.\n";
+        return 1;
+    }
+    PackReader reader;
+    if (!reader.open(normalizePath(cfg.c_paths[0]))) return 1;
+
+    std::unique_ptr<FdSink> sink = cfg.c_outputFile.empty() ? std::make_unique<FdSink>(1)
+                                                            : FdSink::open(normalizePath(cfg.c_outputFile));
+    if (!sink) return 1;
+    if (cfg.c_paths.size() < 2) {
+        if (!reader.verifyIndex()) std::cerr << "Warning: the package index does not match its checksum\n";
+        for (size_t i = 0; i < reader.size(); ++i) {
+            *sink << reader.path(i) << '\t' << reader.rawSize(i) << '\t' << reader.lines(i) << '\t'
+                  << pack::flagNames(reader.flags(i)) << '\n';
+        }
+        return sink->flush() ? 0 : 1;
+    }
+
+    std::string want = cfg.c_paths[1];
+    std::replace(want.begin(), want.end(), '\\', '/');
+    while (starts_with(want, "./")) want.erase(0, 2);
+    auto found = reader.find(want);
+    if (!found) {
+        std::cerr << "Error: " << want << " is not in " << cfg.c_paths[0] << "\n";
+        return 1;
+    }
+    // the pack keeps the packaged text: say so whenever that is not the whole file
+    const uint8_t flags = reader.flags(*found);
+    if (flags & pack::NoContent) std::cerr << "Warning: " << want << " was packaged without its content\n";
+    else if (flags & pack::Reduced) std::cerr << "Warning: " << want << " was packaged compressed; this is not the file's text\n";
+    if (flags & pack::Truncated) {
+        std::cerr << "Warning: " << want << " was truncated when packaged; only its first " << reader.rawSize(*found)
+                  << " bytes are in the package\n";
+    }
+    std::string text;
+    if (!reader.read(*found, text)) return 1;
+    *sink << text;
+    return sink->flush() ? 0 : 1;
+}
+
 int main(int argc, char** argv) {
     // parse CLI
     CLI cli(argc, argv);
@@ -58,6 +421,35 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    if (cfg.extract) return extractFromPack(cfg);
+    if (cfg.format == OutputFormat::Markdown && fs::path(cfg.c_outputFile).extension() == ".rcpk") {
+        cfg.format = OutputFormat::Pack;
+    }
+    if (fs::path(cfg.c_outputFile).extension() == ".zst") {
+        std::cerr << "Error: zstd output is not supported; use .gz or .lz4\n";
+        return 1;
+    }
+    bool split = cfg.splitMaxBytes > 0 || cfg.splitMaxTokens > 0;
+    if (split && cfg.format != OutputFormat::Markdown) {
+        std::cerr << "Error: --split-max-bytes/--split-max-tokens only apply to markdown output\n";
+        return 1;
+    }
+    if (split && cfg.c_outputFile.empty()) {
+        std::cerr << "Error: --split-max-bytes/--split-max-tokens need -o to name the shards\n";
+        return 1;
+    }
+    if (split && cfg.dirsOnly) {
+        std::cerr << "Warning: --dirs-only output has no file sections to split; writing one file\n";
+        split = false;
+    }
+    bool incremental = cfg.incremental;
+    if (incremental && (cfg.c_outputFile.empty() || cfg.format != OutputFormat::Markdown || split || cfg.dirsOnly ||
+                        CompressingSink::codecFor(cfg.c_outputFile))) {
+        std::cerr << "Warning: --incremental needs an uncompressed, unsplit markdown -o file with file contents; "
+                     "writing the whole output\n";
+        incremental = false;
+    }
+
     if (cfg.c_paths.empty()) {
         std::cerr << "Error: no paths provided. Use -h for help.\n";
         return 1;
@@ -68,7 +460,7 @@ int main(int argc, char** argv) {
     for (const auto &raw : cfg.c_paths) {
         fs::path p = normalizePath(raw);
         if (p.empty()) continue;
-        if (!fs::exists(p)) {
+        if (cfg.c_rev.empty() && !fs::exists(p)) { // --rev: it only has to exist in the revision
             std::cerr << "Warning: path does not exist: \"" << raw << "\" -> \"" << p.string() << "\"\n";
             continue;
         }
@@ -82,7 +474,8 @@ int main(int argc, char** argv) {
 
     // Use the first normalized input as the "outputRoot" (the folder whose structure we display)
     fs::path first = normalized.front();
-    fs::path outputRoot = fs::is_directory(first) ? first : first.parent_path();
+    const bool directory = fs::is_directory(first) || (!cfg.c_rev.empty() && !fs::exists(first));
+    fs::path outputRoot = directory ? first : first.parent_path();
 
     // Find repo root by walking upwards from the outputRoot
     fs::path repoRoot = findRepoRoot(outputRoot);
@@ -99,9 +492,51 @@ int main(int argc, char** argv) {
 
     // Scanner (filter patterns are passed as previously)
     RepositoryScanner scanner(cfg.c_includePatterns, cfg.c_excludePatterns);
-    auto scanResult = scanner.scanPaths(scanInputs);
+    std::unique_ptr<PathSet> recentPaths;
+    std::unique_ptr<ChangeSet> changeSet;
+    if (!cfg.c_sinceRef.empty() || cfg.staged) {
+        if (!cfg.c_sinceRef.empty() && cfg.staged) {
+            std::cerr << "Error: use either --since or --staged\n";
+            return 1;
+        }
+        if (cfg.showRecent) {
+            std::cerr << "Warning: --recent is ignored with --since/--staged\n";
+            cfg.showRecent = false;
+        }
+        changeSet = changedFromBase(cfg, outputRoot);
+        if (!changeSet) return 1;
+        scanner.setOnly(changeSet->paths.get());
+    } else if (cfg.diffHunks) {
+        std::cerr << "Warning: --diff needs --since or --staged; ignored\n";
+    }
+    GitRepository revRepo;
+    std::unique_ptr<RevisionSource> revision;
+    if (!cfg.c_rev.empty()) {
+        if (changeSet) {
+            std::cerr << "Error: --rev does not combine with --since or --staged\n";
+            return 1;
+        }
+        if (cfg.showRecent || incremental || !cfg.c_cacheDir.empty()) {
+            std::cerr << "Warning: --recent, --incremental and --cache-dir work on the working tree; "
+                         "ignored with --rev\n";
+            cfg.showRecent = false;
+            incremental = false;
+            cfg.c_cacheDir.clear();
+        }
+        revision = openRevision(cfg.c_rev, outputRoot, revRepo);
+        if (!revision) return 1;
+    }
+    if (cfg.showRecent) {
+        recentPaths = recentlyCommitted(outputRoot);
+        if (recentPaths) scanner.setOnly(recentPaths.get());
+    }
+    auto scanResult = revision ? scanner.scanListing(scanInputs, revRepo.workTree(), revision->paths())
+                               : scanner.scanPaths(scanInputs);
+    // --rev and --staged read sizes and text from the object database
+    const RevisionSource *source = revision ? revision.get() : changeSet ? changeSet->staged.get() : nullptr;
+    if (source) source->fillSizes(scanResult.files, cfg.jobs);
 
-     if(cfg.showRecent){        
+     if(cfg.showRecent && !recentPaths){        
         //using algorithm to avoid the manual loops
          auto end = std::remove_if(scanResult.files.begin(), scanResult.files.end(),
         [](const FileEntry& file) { 
@@ -113,47 +548,238 @@ int main(int argc, char** argv) {
     }
 
     // Read files
-    FileReader reader(16 * 1024);
-    rcpack::Compressor compressor;
+    const size_t maxBytes = 16 * 1024;
+
+    // Optional on-disk cache of processed contents: a hit skips both the read and the compression
+    std::unique_ptr<CompressionCache> cache;
+    if (!cfg.c_cacheDir.empty()) {
+        cache = std::make_unique<CompressionCache>(normalizePath(cfg.c_cacheDir));
+        if (!cache->isOpen()) cache.reset();
+    }
+    if (cache) {
+        // never package the cache itself when it lives inside the scanned tree
+        const std::string cacheDir = cache->dir().generic_string() + "/";
+        auto end = std::remove_if(scanResult.files.begin(), scanResult.files.end(),
+            [&](const FileEntry& file) { return starts_with(file.path.generic_string(), cacheDir); });
+        scanResult.files.erase(end, scanResult.files.end());
+    }
 
+    ContentPipeline pipeline(cfg, maxBytes, cache.get());
+    pipeline.setSource(source);
     std::vector<FileContent> contents;
-    contents.reserve(scanResult.files.size());
+    std::vector<size_t> order; // section order for the formatter; empty = scan order
+    if (!cfg.c_focus.empty() && !selectByFocus(cfg, pipeline, outputRoot, scanResult.files, order)) {
+        std::cerr << "Error: none of the --focus paths were scanned.\n";
+        return 1;
+    }
+    Tokenizer tokenizer;
+    if (!cfg.c_tokenizerVocab.empty()) tokenizer.loadVocab(normalizePath(cfg.c_tokenizerVocab));
 
-    for (auto &fe : scanResult.files) {
-        auto fc = reader.readFile(fe.path);
-        // Run optional compression / cleanup before storing
-        fc.content = compressor.process(
-            fc.content,
-            fe.path.string(),
-            cfg.compress,
-            cfg.removeComments,
-            cfg.removeEmptyLines
-        );
-        contents.push_back(std::move(fc));
+    // Corpus-level features need every file before the first section can be written;
+    // everything else streams, holding at most --window files in memory.
+    const bool streaming = !cfg.dedup && !cfg.commonPreamble && !cfg.symbols && cfg.c_symbolsJson.empty() &&
+                           cfg.maxTokens == 0 && cfg.c_query.empty() && !cfg.sortByTokens;
+    std::vector<Preamble> preambles;
+    SymbolTable symbols;
+    if (!streaming) {
+        if (!cfg.c_query.empty()) {
+            contents = pipeline.loadAll(scanResult.files);
+            auto kept = selectByQuery(cfg, relativePaths(scanResult.files, outputRoot), contents);
+            // keep scan order for the tree; print the sections best match first
+            order = keepOnly(scanResult.files, contents, kept);
+        } else if (cfg.maxTokens > 0) {
+            auto relPaths = relativePaths(scanResult.files, outputRoot);
+            std::vector<double> relevance;
+            for (auto &rel : relPaths) relevance.push_back(BudgetPlanner::defaultRelevance(rel));
+            size_t planned = 0;
+            contents = pipeline.loadWithinBudget(scanResult.files, relevance, relPaths, planned);
+            std::cerr << "Info: planned ~" << planned << " tokens for a budget of " << cfg.maxTokens << "\n";
+            if (planned > cfg.maxTokens) {
+                std::cerr << "Warning: even file names only exceed the token budget; output will be larger\n";
+            }
+        } else {
+            contents = pipeline.loadAll(scanResult.files);
+        }
+        if (cfg.dedup) {
+            size_t exact = Deduplicator::markDuplicates(contents);
+            size_t near = cfg.nearDedup ? Deduplicator::markNearDuplicates(contents) : 0;
+            std::cerr << "Info: " << exact << " duplicate and " << near << " near-duplicate file(s) replaced by references\n";
+        }
+        if (cfg.commonPreamble) {
+            preambles = PreambleDetector::extract(contents);
+            std::cerr << "Info: " << preambles.size() << " common preamble(s) factored out\n";
+        }
+        // merge per-file symbol tables in scan order so the index is deterministic
+        for (size_t i = 0; i < contents.size(); ++i) {
+            symbols.append(contents[i].symbols, static_cast<uint32_t>(i));
+            contents[i].symbols.clear();
+        }
+        if (!cfg.c_symbolsJson.empty()) {
+            fs::path jsonPath = normalizePath(cfg.c_symbolsJson);
+            std::ofstream jofs(jsonPath.string());
+            if (!jofs) {
+                std::cerr << "Error: cannot open symbols file: " << jsonPath.string() << "\n";
+                return 1;
+            }
+            OutputFormatter::writeSymbolsJson(jofs, outputRoot, scanResult.files, symbols);
+        }
+        if (!cfg.dirsOnly) pipeline.countTokens(scanResult.files, contents, tokenizer);
+        if (cfg.sortByTokens) {
+            order.resize(scanResult.files.size());
+            for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return (a < contents.size() ? contents[a].tokens : 0) > (b < contents.size() ? contents[b].tokens : 0);
+            });
+        }
     }
 
     // Git info: use repoRoot if found; otherwise pass outputRoot (collector should handle non-repo case)
     fs::path gitProbePath = repoRoot.empty() ? outputRoot : repoRoot;
     GitInfoCollector gitCollector(gitProbePath.string());
-    auto git = gitCollector.collect();
+    auto git = gitCollector.collect(cfg.c_rev.empty() ? "HEAD" : cfg.c_rev);
 
-    // Output: determine output stream (stdout or file) and use outputRoot for relative printing
-    if (!cfg.c_outputFile.empty()) {
-        // normalize output file path too
+    std::vector<std::string> diffs;
+    if (changeSet && cfg.diffHunks && !cfg.dirsOnly) diffs = changeDiffs(cfg, *changeSet, scanResult.files);
+
+    auto setupFormatter = [&](OutputFormatter &fmt) {
+        fmt.setPreambles(&preambles);
+        if (!diffs.empty()) fmt.setDiffs(&diffs);
+        if (cfg.symbols) fmt.setSymbols(&symbols);
+        if (!order.empty()) fmt.setOrder(&order);
+        fmt.setTokenCounts(tokenizer.mode());
+        fmt.setFormat(cfg.format);
+    };
+    auto fileAt = [&](size_t k) { return order.empty() ? k : order[k]; };
+    const size_t sectionCount = order.empty() ? scanResult.files.size() : order.size();
+
+    bool written = false;
+    if (split) {
+        // shards are cut while sections arrive and written by their own threads
         fs::path outPath = normalizePath(cfg.c_outputFile);
-        // If user provided relative name, normalizePath returns absolute; we can open outPath directly
-        std::ofstream ofs(outPath.string());
-        if (!ofs) {
-            std::cerr << "Error: cannot open output file: " << outPath.string() << "\n";
-            return 1;
+        ShardedOutput shards(outPath, cfg, outputRoot, git, scanResult, setupFormatter);
+        const OutputFormatter &fmt = shards.renderer();
+        if (streaming) pipeline.setPassthrough(true);
+        runOrdered<OutputFormatter::Section>(sectionCount, pipeline.jobs(), cfg.window,
+            [&](size_t k) {
+                size_t i = fileAt(k);
+                if (streaming) return fmt.renderSection(outputRoot, cfg, scanResult, i,
+                                                        pipeline.loadStreamed(scanResult.files[i], &tokenizer));
+                return fmt.renderSection(outputRoot, cfg, scanResult, i, i < contents.size() ? &contents[i] : nullptr);
+            },
+            [&](size_t, OutputFormatter::Section &&sec) { shards.add(std::move(sec)); },
+            [&](size_t k) { return fmt.unreadableSection(outputRoot, cfg, scanResult, fileAt(k)); });
+        written = shards.finish();
+        std::cerr << "Info: wrote " << shards.shardCount() << " shard(s), "
+                  << ShardedOutput::shardPath(outPath, 1).filename().string() << " to "
+                  << ShardedOutput::shardPath(outPath, shards.shardCount()).filename().string() << "\n";
+    } else if (incremental && streaming) {
+        // sections of unchanged files stay where they are in the previous output
+        uint64_t options = hashString(outputRoot.generic_string());
+        options = hashCombine(options, (cfg.compress ? 1u : 0u) | (cfg.removeComments ? 2u : 0u) |
+                                       (cfg.removeEmptyLines ? 4u : 0u) | (cfg.tokenCounts ? 8u : 0u));
+        options = hashCombine(options, hashString(std::string(tokenizer.mode()) + "\n" + cfg.c_tokenizerVocab));
+        // a section's diff also depends on the base it was taken against
+        if (!diffs.empty()) options = hashCombine(options, hashString(changeSet->base));
+        // staged, sections hold the index's versions, which file modification times do not track
+        if (changeSet && changeSet->staged) {
+            for (auto &rel : changeSet->staged->paths()) {
+                options = hashCombine(options, hashString(rel + " " + changeSet->changes.at(rel).newId.hex()));
+            }
         }
-        OutputFormatter fmt(ofs);
-        fmt.generate(outputRoot, cfg, git, scanResult, contents);
-        ofs.close();
+        IncrementalOutput inc(normalizePath(cfg.c_outputFile), options);
+        std::ostringstream text;
+        OutputFormatter fmt(text);
+        setupFormatter(fmt);
+        fmt.begin(outputRoot, cfg, git, scanResult);
+        inc.begin(text.str());
+        text.str("");
+        runOrdered<IncrementalOutput::Item>(sectionCount, pipeline.jobs(), cfg.window,
+            [&](size_t k) {
+                size_t i = fileAt(k);
+                return inc.prepare(scanResult.files[i], [&] {
+                    return fmt.renderSection(outputRoot, cfg, scanResult, i,
+                                             pipeline.loadStreamed(scanResult.files[i], &tokenizer));
+                });
+            },
+            [&](size_t, IncrementalOutput::Item &&item) {
+                fmt.countSection(item.section);
+                inc.add(std::move(item));
+            },
+            [&](size_t k) {
+                // no mtime: the next run renders it again
+                IncrementalOutput::Item item;
+                item.entry.path = scanResult.files[fileAt(k)].path.generic_string();
+                item.section = fmt.unreadableSection(outputRoot, cfg, scanResult, fileAt(k));
+                return item;
+            });
+        fmt.end(outputRoot, cfg, scanResult);
+        inc.end(text.str());
+        written = inc.finish();
+        std::cerr << "Info: incremental: " << inc.reused() << " of " << inc.sections() << " section(s) reused, "
+                  << inc.mode() << " (" << DirectoryTree::formatBytes(inc.ioBytes()) << " of I/O)\n";
     } else {
-        OutputFormatter fmt(std::cout);
-        fmt.generate(outputRoot, cfg, git, scanResult, contents);
+        if (incremental) {
+            std::cerr << "Warning: --incremental does not combine with options that need every file first; "
+                         "writing the whole output\n";
+        }
+        // Output: determine output stream (stdout or file) and use outputRoot for relative printing
+        std::unique_ptr<OutputSink> sink;
+        CompressingSink *compressing = nullptr;
+        if (!cfg.c_outputFile.empty()) {
+            // normalize output file path too
+            fs::path outPath = normalizePath(cfg.c_outputFile);
+            // If user provided relative name, normalizePath returns absolute; we can open outPath directly
+            sink = FdSink::open(outPath);
+            if (!sink) return 1;
+            if (auto codec = CompressingSink::codecFor(outPath)) {
+                auto wrapped = std::make_unique<CompressingSink>(std::move(sink), *codec);
+                compressing = wrapped.get();
+                sink = std::move(wrapped);
+            }
+        } else {
+            sink = std::make_unique<FdSink>(1); // stdout
+        }
+        if (cfg.format == OutputFormat::Pack) {
+            writePack(cfg, pipeline, outputRoot, scanResult, contents, preambles, *sink);
+        } else {
+            OutputFormatter fmt(*sink);
+            setupFormatter(fmt);
+            if (streaming) {
+                fmt.begin(outputRoot, cfg, git, scanResult);
+                if (!cfg.dirsOnly) {
+                    // unmodified file text is copied into the output by the kernel (JSON has to escape it)
+                    pipeline.setPassthrough(cfg.format == OutputFormat::Markdown || cfg.format == OutputFormat::MsgPack);
+                    // workers load a file and render its whole section; sections are written in order
+                    runOrdered<OutputFormatter::Section>(sectionCount, pipeline.jobs(), cfg.window,
+                        [&](size_t k) {
+                            size_t i = fileAt(k);
+                            return fmt.renderSection(outputRoot, cfg, scanResult, i,
+                                                     pipeline.loadStreamed(scanResult.files[i], &tokenizer));
+                        },
+                        [&](size_t, OutputFormatter::Section &&sec) { fmt.writeSection(sec, scanResult); },
+                        [&](size_t k) { return fmt.unreadableSection(outputRoot, cfg, scanResult, fileAt(k)); });
+                }
+                fmt.end(outputRoot, cfg, scanResult);
+            } else {
+                fmt.generate(outputRoot, cfg, git, scanResult, contents);
+            }
+        }
+        written = sink->finish();
+        if (compressing && compressing->bytesIn() > 0) {
+            double ratio = static_cast<double>(compressing->bytesIn()) / static_cast<double>(compressing->bytesOut());
+            double secs = compressing->compressSeconds();
+            std::cerr << "Info: " << compressing->codecName() << ": " << DirectoryTree::formatBytes(compressing->bytesIn())
+                      << " -> " << DirectoryTree::formatBytes(compressing->bytesOut()) << " (" << std::fixed
+                      << std::setprecision(1) << ratio << "x), compressed at "
+                      << (secs > 0 ? compressing->bytesIn() / secs / (1024.0 * 1024.0) : 0.0) << " MB/s\n";
+        }
+        sink.reset();
+    }
+
+    if (cache) {
+        std::cerr << "Info: cache " << cache->hits() << " hit(s), " << cache->misses() << " miss(es)\n";
     }
+    if (!written) return 1;
 
     return 0;
 }
@@ -9,8 +9,10 @@
 
 namespace rcpack {
 
+    // --recent window; outside git repositories it is checked against file modification times
+    constexpr int MAX_RECENT_DAYS = 7;
+
     inline bool isFileRecent(const std::filesystem::path &p){
-        constexpr int MAX_RECENT_DAYS = 7;    
         try{
         //get the last  change time 
         auto lastChangeTime = std::filesystem::last_write_time(p);
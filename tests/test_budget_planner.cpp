@@ -0,0 +1,87 @@
+// tests/test_budget_planner.cpp
+#include "catch.hpp"
+#include "../src/BudgetPlanner.h"
+#include "../src/Compressor.h"
+
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+
+static BudgetItem make_item(std::array<size_t, COMPRESSION_LEVEL_COUNT> tokens, double relevance) {
+    BudgetItem it;
+    it.tokens = tokens;
+    it.relevance = relevance;
+    return it;
+}
+
+TEST_CASE("BudgetPlanner::plan degrades the least relevant file first", "[BudgetPlanner][plan]") {
+    std::vector<BudgetItem> items = {
+        make_item({1000, 800, 700, 300, 200, 10}, 1.0),
+        make_item({1000, 800, 700, 300, 200, 10}, 0.1)
+    };
+
+    size_t planned = 0;
+    auto levels = BudgetPlanner::plan(items, 2000, CompressionLevel::Full, planned);
+    REQUIRE(levels[0] == CompressionLevel::Full);
+    REQUIRE(levels[1] == CompressionLevel::Full);
+    REQUIRE(planned == 2000);
+
+    levels = BudgetPlanner::plan(items, 1800, CompressionLevel::Full, planned);
+    REQUIRE(levels[0] == CompressionLevel::Full);
+    REQUIRE(levels[1] == CompressionLevel::NoComments);
+    REQUIRE(planned == 1800);
+
+    // every level step is taken by the less relevant file before the other one follows
+    levels = BudgetPlanner::plan(items, 300, CompressionLevel::Full, planned);
+    REQUIRE(levels[0] == CompressionLevel::SignaturesOnly);
+    REQUIRE(levels[1] == CompressionLevel::NameOnly);
+    REQUIRE(planned == 210);
+}
+
+TEST_CASE("BudgetPlanner::plan degrades across levels in relevance order", "[BudgetPlanner][plan]") {
+    std::vector<BudgetItem> items = {
+        make_item({1000, 800, 700, 300, 200, 10}, 1.0),
+        make_item({1000, 800, 700, 300, 200, 10}, 0.1),
+        make_item({1000, 800, 700, 300, 200, 10}, 0.1)
+    };
+    size_t planned = 0;
+    // both less relevant files reach signatures before the relevant one loses its comments
+    auto levels = BudgetPlanner::plan(items, 1700, CompressionLevel::Full, planned);
+    REQUIRE(levels[0] == CompressionLevel::Full);
+    REQUIRE(levels[1] == CompressionLevel::SignaturesWithComments);
+    REQUIRE(levels[2] == CompressionLevel::SignaturesWithComments);
+    REQUIRE(planned == 1600);
+
+    levels = BudgetPlanner::plan(items, 900, CompressionLevel::Full, planned);
+    REQUIRE(levels[0] == CompressionLevel::NoComments);
+    REQUIRE(levels[1] == CompressionLevel::NameOnly);
+    REQUIRE(levels[2] == CompressionLevel::NameOnly);
+    REQUIRE(planned == 820);
+}
+
+TEST_CASE("BudgetPlanner::plan starts from the minimum level", "[BudgetPlanner][minLevel]") {
+    std::vector<BudgetItem> items = { make_item({1000, 800, 700, 300, 200, 10}, 1.0) };
+    size_t planned = 0;
+    auto levels = BudgetPlanner::plan(items, 100000, CompressionLevel::SignaturesWithComments, planned);
+    REQUIRE(levels[0] == CompressionLevel::SignaturesWithComments);
+    REQUIRE(planned == 300);
+}
+
+TEST_CASE("Compressor::estimateLevelSizes shrinks with each level for source files", "[BudgetPlanner][estimate]") {
+    Compressor c;
+    std::string src =
+        "// helper\n"
+        "\n"
+        "int add(int a, int b) {\n"
+        "    /* add them */\n"
+        "    return a + b;\n"
+        "}\n";
+    auto est = c.estimateLevelSizes(src, "math.cpp");
+    REQUIRE(est[0] == src.size());
+    REQUIRE(est[1] < est[0]);
+    REQUIRE(est[2] < est[1]);
+    REQUIRE(est[4] <= est[2]);
+    REQUIRE(est[5] == 0);
+    REQUIRE(c.process(src, "math.cpp", CompressionLevel::NameOnly).empty());
+}
@@ -0,0 +1,164 @@
+// tests/test_compression.cpp
+#include "catch.hpp"
+#include "../src/Deflate.h"
+#include "../src/Lz4.h"
+#include "../src/OutputSink.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace rcpack;
+
+static uint32_t le32(const std::string &s, size_t at) {
+    uint32_t v = 0;
+    for (int b = 3; b >= 0; --b) v = (v << 8) | static_cast<unsigned char>(s[at + b]);
+    return v;
+}
+
+static std::string sampleText(size_t bytes) {
+    std::string text;
+    for (int i = 0; text.size() < bytes; ++i) {
+        text += "    total += weights[" + std::to_string(i % 61) + "] * sample(" + std::to_string(i % 7) + ");\n";
+    }
+    text.resize(bytes);
+    return text;
+}
+
+static std::string compressThroughSink(const std::string &text, CompressingSink::Codec codec) {
+    std::ostringstream os;
+    auto sink = std::make_unique<CompressingSink>(std::make_unique<OstreamSink>(os), codec);
+    // uneven writes that straddle chunk boundaries
+    for (size_t at = 0; at < text.size(); at += 300007) sink->write(text.substr(at, 300007));
+    REQUIRE(sink->finish());
+    REQUIRE(sink->bytesIn() == text.size());
+    REQUIRE(sink->bytesOut() == os.str().size());
+    return os.str();
+}
+
+TEST_CASE("Checksums match their reference values", "[Compression]") {
+    REQUIRE(DeflateEncoder::crc32(0, "123456789", 9) == 0xCBF43926u);
+    REQUIRE(DeflateEncoder::crc32(DeflateEncoder::crc32(0, "1234", 4), "56789", 5) == 0xCBF43926u);
+    REQUIRE(DeflateEncoder::crc32(0, "", 0) == 0);
+    REQUIRE(DeflateDecoder::adler32(1, "Wikipedia", 9) == 0x11E60398u);
+    REQUIRE(Lz4::xxh32("", 0) == 0x02CC5D05u);
+    REQUIRE(Lz4::xxh32("abc", 3) == 0x32D153FFu);
+}
+
+TEST_CASE("Empty deflate stream is a single empty final block", "[Compression]") {
+    DeflateEncoder enc;
+    std::string out;
+    enc.write("", out);
+    enc.finish(out);
+    REQUIRE(out == std::string("\x03\x00", 2));
+}
+
+TEST_CASE("Deflate shrinks repetitive text and bounds incompressible input", "[Compression]") {
+    std::string text = sampleText(200000);
+    DeflateEncoder enc;
+    std::string out;
+    enc.write(std::string_view(text).substr(0, 70000), out);
+    enc.write(std::string_view(text).substr(70000), out);
+    enc.finish(out);
+    REQUIRE(out.size() < text.size() / 5);
+
+    std::mt19937 rng(11);
+    std::string noise(100000, '\0');
+    for (auto &c : noise) c = static_cast<char>(rng());
+    DeflateEncoder raw;
+    std::string stored;
+    raw.write(noise, stored);
+    raw.finish(stored);
+    // stored blocks cost 5 bytes per 64 KB at most, plus the closing block
+    REQUIRE(stored.size() < noise.size() + 64);
+}
+
+TEST_CASE("Inflate decodes the encoder's blocks and zlib's fixed-Huffman streams", "[Compression]") {
+    std::mt19937 rng(7);
+    std::string noise(70000, '\0');
+    for (auto &c : noise) c = static_cast<char>(rng());
+    for (const std::string &text : {sampleText(300000), noise, std::string("a"), sampleText(20) + noise + sampleText(5000)}) {
+        DeflateEncoder enc;
+        std::string packed;
+        enc.write(std::string_view(text).substr(0, text.size() / 3), packed);
+        enc.write(std::string_view(text).substr(text.size() / 3), packed);
+        enc.finish(packed);
+        std::string out = "prefix";
+        size_t used = 0;
+        REQUIRE(DeflateDecoder::inflate(packed + "trailing", out, &used));
+        REQUIRE(out == "prefix" + text);
+        REQUIRE(used == packed.size());
+        // every truncation is detected
+        std::string cut;
+        REQUIRE_FALSE(DeflateDecoder::inflate(std::string_view(packed).substr(0, packed.size() - 1), cut));
+    }
+
+    // zlib.compress(b"hello, hello, hello!\n", 9): one fixed-Huffman block with a match
+    const std::string z("\x78\xda\xcb\x48\xcd\xc9\xc9\xd7\x51\xc8\x40\xa2\x14\xb9\x00\x52\x1e\x07\x00", 19);
+    std::string hello;
+    size_t used = 0;
+    REQUIRE(DeflateDecoder::zlibInflate(z, hello, &used));
+    REQUIRE(hello == "hello, hello, hello!\n");
+    REQUIRE(used == z.size());
+    std::string corrupt = z;
+    corrupt.back() ^= 1; // Adler-32 mismatch
+    hello.clear();
+    REQUIRE_FALSE(DeflateDecoder::zlibInflate(corrupt, hello));
+}
+
+TEST_CASE("CompressingSink writes a gzip member with a valid trailer", "[Compression]") {
+    std::string text = sampleText(3 * CompressingSink::CHUNK + 12345);
+    std::string gz = compressThroughSink(text, CompressingSink::Codec::Gzip);
+    REQUIRE(gz.size() > 18);
+    REQUIRE(static_cast<unsigned char>(gz[0]) == 0x1f);
+    REQUIRE(static_cast<unsigned char>(gz[1]) == 0x8b);
+    REQUIRE(gz[2] == 8);
+    REQUIRE(le32(gz, gz.size() - 8) == DeflateEncoder::crc32(0, text.data(), text.size()));
+    REQUIRE(le32(gz, gz.size() - 4) == text.size());
+    REQUIRE(gz.size() < text.size() / 5);
+
+    std::string empty = compressThroughSink("", CompressingSink::Codec::Gzip);
+    REQUIRE(empty.size() == 10 + 2 + 8);
+}
+
+TEST_CASE("CompressingSink writes an LZ4 frame that decodes block by block", "[Compression]") {
+    std::string text = sampleText(2 * CompressingSink::CHUNK + 999);
+    std::mt19937 rng(5);
+    for (int i = 0; i < 50000; ++i) text.push_back(static_cast<char>(rng())); // stored final block
+    std::string frame = compressThroughSink(text, CompressingSink::Codec::Lz4);
+
+    REQUIRE(le32(frame, 0) == 0x184D2204u);
+    REQUIRE(static_cast<unsigned char>(frame[6]) == ((Lz4::xxh32(frame.data() + 4, 2) >> 8) & 0xff));
+    size_t at = 7;
+    std::string decoded;
+    while (true) {
+        REQUIRE(at + 4 <= frame.size());
+        uint32_t word = le32(frame, at);
+        at += 4;
+        if (word == 0) break;
+        size_t size = word & 0x7fffffffu;
+        std::string_view block(frame.data() + at, size);
+        REQUIRE(le32(frame, at + size) == Lz4::xxh32(block.data(), block.size()));
+        if (word & 0x80000000u) {
+            decoded.append(block);
+        } else {
+            // every block but the last is a full chunk
+            size_t want = std::min(CompressingSink::CHUNK, text.size() - decoded.size());
+            std::string part(want, '\0');
+            REQUIRE(Lz4::decompressBlock(block, part.data(), part.size()));
+            decoded += part;
+        }
+        at += size + 4;
+    }
+    REQUIRE(at == frame.size());
+    REQUIRE(decoded == text);
+}
+
+TEST_CASE("CompressingSink picks the codec from the file name", "[Compression]") {
+    REQUIRE(CompressingSink::codecFor("out.md.gz") == CompressingSink::Codec::Gzip);
+    REQUIRE(CompressingSink::codecFor("dir/out.jsonl.lz4") == CompressingSink::Codec::Lz4);
+    REQUIRE_FALSE(CompressingSink::codecFor("out.md"));
+    REQUIRE_FALSE(CompressingSink::codecFor("out.gz.md"));
+}
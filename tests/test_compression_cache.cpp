@@ -0,0 +1,168 @@
+// tests/test_compression_cache.cpp
+#include "catch.hpp"
+#include "../src/CompressionCache.h"
+#include "../src/Hash.h"
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+TEST_CASE("hashBytes depends on every byte", "[CompressionCache][hash]") {
+    std::string base(100, 'x');
+    for (size_t at : {0, 7, 31, 32, 63, 64, 99}) {
+        std::string other = base;
+        other[at] = 'y';
+        REQUIRE(hashString(other) != hashString(base));
+        REQUIRE(hashString(other, 12345) != hashString(base, 12345));
+    }
+}
+
+TEST_CASE("CompressionCache persists entries across instances", "[CompressionCache]") {
+    fs::path tmp = make_temp_dir();
+    uint64_t key = CompressionCache::makeKey(tmp / "a.cpp", 42, 1000, 1u, 16 * 1024);
+
+    {
+        CompressionCache cache(tmp / "cache");
+        REQUIRE(cache.isOpen());
+        FileContent miss;
+        REQUIRE_FALSE(cache.lookup(key, miss));
+
+        FileContent fc;
+        fc.content = "void foo() { /* ... */ }\n";
+        fc.lines = 7;
+        fc.truncated = true;
+        cache.store(key, fc);
+    }
+
+    CompressionCache reopened(tmp / "cache");
+    FileContent hit;
+    REQUIRE(reopened.lookup(key, hit));
+    REQUIRE(hit.content == "void foo() { /* ... */ }\n");
+    REQUIRE(hit.lines == 7);
+    REQUIRE(hit.truncated == true);
+    REQUIRE(reopened.hits() == 1);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("CompressionCache key changes with options and file metadata", "[CompressionCache][key]") {
+    fs::path p = "src/a.cpp";
+    uint64_t base = CompressionCache::makeKey(p, 10, 5, 1u, 1024);
+    REQUIRE(base != CompressionCache::makeKey(p, 11, 5, 1u, 1024));
+    REQUIRE(base != CompressionCache::makeKey(p, 10, 6, 1u, 1024));
+    REQUIRE(base != CompressionCache::makeKey(p, 10, 5, 3u, 1024));
+    REQUIRE(base != CompressionCache::makeKey("src/b.cpp", 10, 5, 1u, 1024));
+}
+
+TEST_CASE("CompressionCache ignores a torn trailing index record", "[CompressionCache][recovery]") {
+    fs::path tmp = make_temp_dir();
+    {
+        CompressionCache cache(tmp / "cache");
+        FileContent fc;
+        fc.content = "abc";
+        cache.store(1, fc);
+    }
+    {
+        std::ofstream idx(tmp / "cache" / "index.bin", std::ios::binary | std::ios::app);
+        idx << "partial";
+    }
+
+    CompressionCache reopened(tmp / "cache");
+    FileContent hit;
+    REQUIRE(reopened.lookup(1, hit));
+    REQUIRE(hit.content == "abc");
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("CompressionCache compacts superseded blobs", "[CompressionCache][compact]") {
+    fs::path tmp = make_temp_dir();
+    uint64_t key = CompressionCache::makeKey(tmp / "a.cpp", 1, 1, 0u, 1024);
+    for (int run = 0; run < 10; ++run) {
+        CompressionCache cache(tmp / "cache");
+        FileContent fc;
+        fc.content = std::string(1000, static_cast<char>('a' + run));
+        cache.store(key, fc);
+    }
+    // every reopen finds at most one stale copy next to the live one
+    REQUIRE(fs::file_size(tmp / "cache" / "blobs.bin") <= 2000);
+
+    CompressionCache cache(tmp / "cache");
+    FileContent hit;
+    REQUIRE(cache.lookup(key, hit));
+    REQUIRE(hit.content == std::string(1000, 'j'));
+    REQUIRE(cache.liveBytes() == 1000);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("CompressionCache evicts entries unused in this run past its size cap", "[CompressionCache][compact]") {
+    fs::path tmp = make_temp_dir();
+    auto keyOf = [&](int i) { return CompressionCache::makeKey(tmp / std::to_string(i), 1, 1, 0u, 1024); };
+    {
+        CompressionCache cache(tmp / "cache", 1u << 20);
+        for (int i = 0; i < 5; ++i) {
+            FileContent fc;
+            fc.content = std::string(400, 'x');
+            cache.store(keyOf(i), fc);
+        }
+    }
+    {
+        CompressionCache cache(tmp / "cache", 1000);
+        FileContent fc;
+        REQUIRE(cache.lookup(keyOf(0), fc));
+        REQUIRE(cache.lookup(keyOf(1), fc));
+    }
+    REQUIRE(fs::file_size(tmp / "cache" / "blobs.bin") == 800);
+
+    CompressionCache cache(tmp / "cache", 1000);
+    FileContent fc;
+    REQUIRE(cache.lookup(keyOf(0), fc));
+    REQUIRE(cache.lookup(keyOf(1), fc));
+    for (int i = 2; i < 5; ++i) REQUIRE_FALSE(cache.lookup(keyOf(i), fc));
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("CompressionCache keeps symbols next to the content", "[CompressionCache][symbols]") {
+    fs::path tmp = make_temp_dir();
+    uint64_t key = CompressionCache::makeKey(tmp / "a.cpp", 1, 1, 0u, 1024);
+    {
+        CompressionCache cache(tmp / "cache");
+        FileContent fc;
+        fc.content = "class A {\n";
+        size_t a = fc.symbols.add("A", SymbolKind::Class, 0, 1);
+        fc.symbols.add("run", SymbolKind::Method, 0, 2, static_cast<int32_t>(a));
+        cache.store(key, fc, true);
+    }
+
+    uint64_t other = CompressionCache::makeKey(tmp / "b.cpp", 1, 1, 0u, 1024);
+    FileContent hit;
+    bool hasSymbols = false;
+    {
+        CompressionCache cache(tmp / "cache");
+        REQUIRE(cache.lookup(key, hit, &hasSymbols));
+        REQUIRE(hasSymbols);
+        REQUIRE(hit.content == "class A {\n");
+        REQUIRE(hit.symbols.size() == 2);
+        REQUIRE(hit.symbols.name(1) == "run");
+        REQUIRE(hit.symbols.kind(1) == SymbolKind::Method);
+        REQUIRE(hit.symbols.line(1) == 2);
+        REQUIRE(hit.symbols.parent(1) == 0);
+
+        FileContent plain;
+        plain.content = "x\n";
+        cache.store(other, plain);
+    }
+    // without symbols stored, lookups report that
+    CompressionCache reopened(tmp / "cache");
+    REQUIRE(reopened.lookup(other, hit, &hasSymbols));
+    REQUIRE_FALSE(hasSymbols);
+    REQUIRE(hit.content == "x\n");
+
+    remove_dir_recursive(tmp);
+}
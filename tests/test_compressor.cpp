@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include "../src/Compressor.h"
+#include "../src/StructuredMinifier.h"
 #include <string>
 
 using namespace rcpack;
@@ -11,10 +12,21 @@ TEST_CASE("Compressor::process removes // comments when removeComments=true", "[
     std::string out = c.process(content, "file.cpp", false, true, false);
 
     REQUIRE(out.find("// real comment") == std::string::npos);
+    REQUIRE(out.find("\"// not a comment\"") != std::string::npos);
 
     REQUIRE(out.find("int x = 1;") != std::string::npos);
 }
 
+TEST_CASE("Compressor::process only strips comments of languages it knows", "[Compressor][stripComments]") {
+    Compressor c;
+    REQUIRE(c.process("{\"url\": \"http://x\"}\n", "a.json", false, true, false) == "{\"url\": \"http://x\"}\n");
+    REQUIRE(c.process("See http://x // here\n", "README.md", false, true, false) == "See http://x // here\n");
+    REQUIRE(c.process("u = 'http://x'  # /* c */\n", "a.py", false, true, false) == "u = 'http://x'  # /* c */\n");
+    REQUIRE(c.process("fn f<'a>(x: &'a str) {} // c\nlet c = '/'; /* d */\n", "a.rs", false, true, false) ==
+            "fn f<'a>(x: &'a str) {} \nlet c = '/'; \n");
+    REQUIRE(c.process("const s = `a ${b} // c`; // d\n", "a.ts", false, true, false) == "const s = `a ${b} // c`; \n");
+}
+
 TEST_CASE("Compressor::process with compress=true extracts signature snippet", "[Compressor][compress]") {
     Compressor c;
     std::string content =
@@ -30,3 +42,103 @@ TEST_CASE("Compressor::process with compress=true extracts signature snippet", "
     REQUIRE(out.find("void foo(int x)") != std::string::npos);
     REQUIRE(out.find("inner comment") != std::string::npos);
 }
+
+TEST_CASE("Compressor::process with compress=true minifies JSON and collapses long arrays", "[Compressor][compress][json]") {
+    Compressor c;
+    std::string content = "{\n  \"name\": \"demo\",\n  \"items\": [1, 2, 3, 4, 5, 6],\n  \"nested\": {\"a\": [ \"x\" ]}\n}\n";
+
+    std::string out = c.process(content, "data/fixture.json", true, false, false);
+
+    REQUIRE(out == "{\"name\":\"demo\",\"items\":[1,2,3,\"... (+3 more)\"],\"nested\":{\"a\":[\"x\"]}}\n");
+}
+
+TEST_CASE("StructuredMinifier drops JSONC comments outside strings", "[Compressor][compress][json]") {
+    REQUIRE(StructuredMinifier::minifyJson("{//c\"a\":\"http://x\",/*b*/\"c\":1}") == "{\n");
+    REQUIRE(StructuredMinifier::minifyJson("{// c\n\"a\": \"http://x\", /* b } */ \"c\": 1}") == "{\"a\":\"http://x\",\"c\":1}\n");
+    REQUIRE(StructuredMinifier::minifyJson("[1, /* ] */ 2, 3, 4] // end", 2) == "[1,2,\"... (+2 more)\"]\n");
+}
+
+TEST_CASE("StructuredMinifier reduces YAML to its key skeleton", "[Compressor][compress][yaml]") {
+    std::string yaml =
+        "# comment\n"
+        "name: build\n"
+        "on:\n"
+        "  push:\n"
+        "    branches:\n"
+        "      - main\n"
+        "      - dev\n"
+        "script: |\n"
+        "  make all\n"
+        "  make test\n";
+
+    std::string out = StructuredMinifier::yamlSkeleton(yaml);
+
+    REQUIRE(out == "name:\non:\n  push:\n    branches:\n      - ... (2 items)\nscript:\n");
+}
+
+TEST_CASE("StructuredMinifier strips XML comments and whitespace between tags", "[Compressor][compress][xml]") {
+    std::string xml = "<?xml version=\"1.0\"?>\n<!-- generated -->\n<root>\n  <item  id=\"1\">  hello   world </item>\n</root>\n";
+
+    REQUIRE(StructuredMinifier::minifyXml(xml) == "<?xml version=\"1.0\"?><root><item id=\"1\">hello world</item></root>\n");
+}
+
+TEST_CASE("Compressor::process replaces lockfiles with a dependency list", "[Compressor][compress][lockfile]") {
+    Compressor c;
+    std::string npm =
+        "{\"name\":\"app\",\"version\":\"1.0.0\",\"lockfileVersion\":3,\"packages\":{"
+        "\"\":{\"name\":\"app\",\"version\":\"1.0.0\"},"
+        "\"node_modules/lodash\":{\"version\":\"4.17.21\",\"resolved\":\"https://x\"},"
+        "\"node_modules/@babel/core\":{\"version\":\"7.24.0\",\"dependencies\":{\"debug\":\"^4.1.0\"}}}}";
+    std::string out = c.process(npm, "web/package-lock.json", true, false, false);
+    REQUIRE(out.find("lodash@4.17.21\n") != std::string::npos);
+    REQUIRE(out.find("@babel/core@7.24.0\n") != std::string::npos);
+    REQUIRE(out.find("resolved") == std::string::npos);
+
+    std::string cargo = "[[package]]\nname = \"serde\"\nversion = \"1.0.197\"\n\n[[package]]\nname = \"log\"\nversion = \"0.4.21\"\n";
+    REQUIRE(c.process(cargo, "Cargo.lock", true, false, false) ==
+            "# lockfile summary: 2 dependencies\nserde@1.0.197\nlog@0.4.21\n");
+
+    std::string yarn = "\"lodash@^4.17.0\", lodash@^4.17.21:\n  version \"4.17.21\"\n  resolved \"https://x\"\n";
+    REQUIRE(c.process(yarn, "yarn.lock", true, false, false).find("lodash@4.17.21") != std::string::npos);
+}
+
+TEST_CASE("Compressor::extractSymbols records names, kinds, lines and parent scopes", "[Compressor][symbols]") {
+    Compressor c;
+    std::string cpp =
+        "class Widget {\n"
+        "public:\n"
+        "    void draw() const {\n"
+        "        if (visible) { paint(); }\n"
+        "    }\n"
+        "};\n"
+        "int main() {\n"
+        "    return 0;\n"
+        "}\n";
+
+    SymbolTable table;
+    c.extractSymbols(cpp, "widget.cpp", table);
+
+    REQUIRE(table.size() == 3);
+    REQUIRE(table.name(0) == "Widget");
+    REQUIRE(table.kind(0) == SymbolKind::Class);
+    REQUIRE(table.name(1) == "draw");
+    REQUIRE(table.kind(1) == SymbolKind::Method);
+    REQUIRE(table.parent(1) == 0);
+    REQUIRE(table.line(1) == 3);
+    REQUIRE(table.name(2) == "main");
+    REQUIRE(table.parent(2) == -1);
+
+    SymbolTable py;
+    c.extractSymbols("class A:\n    def run(self):\n        pass\ndef helper():\n    pass\n", "a.py", py);
+    REQUIRE(py.size() == 3);
+    REQUIRE(py.kind(1) == SymbolKind::Method);
+    REQUIRE(py.parent(1) == 0);
+    REQUIRE(py.kind(2) == SymbolKind::Function);
+
+    SymbolTable merged;
+    merged.append(table, 4);
+    merged.append(py, 7);
+    REQUIRE(merged.size() == 6);
+    REQUIRE(merged.file(4) == 7);
+    REQUIRE(merged.parent(4) == 3);
+}
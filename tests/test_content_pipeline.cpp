@@ -0,0 +1,113 @@
+// tests/test_content_pipeline.cpp
+#include "catch.hpp"
+#include "../src/ContentPipeline.h"
+#include "../src/ThreadPool.h"
+#include "test_helpers.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+TEST_CASE("ThreadPool runs every submitted task before wait returns", "[ThreadPool]") {
+    std::atomic<int> counter{0};
+    ThreadPool pool(4);
+    for (int i = 0; i < 200; ++i) pool.submit([&counter] { ++counter; });
+    pool.wait();
+    REQUIRE(counter == 200);
+}
+
+TEST_CASE("runOrdered replaces a failed result with the fallback", "[ThreadPool]") {
+    for (size_t jobs : {1, 4}) {
+        std::vector<int> seen;
+        runOrdered<int>(20, jobs, 4,
+            [](size_t k) -> int {
+                if (k == 7) throw std::runtime_error("boom");
+                if (k == 12) throw 12; // not a std::exception
+                return static_cast<int>(k);
+            },
+            [&](size_t, int &&v) { seen.push_back(v); },
+            [](size_t k) { return -static_cast<int>(k); });
+        REQUIRE(seen.size() == 20);
+        REQUIRE(seen[6] == 6);
+        REQUIRE(seen[7] == -7);
+        REQUIRE(seen[8] == 8);
+        REQUIRE(seen[12] == -12);
+    }
+}
+
+TEST_CASE("ContentPipeline::loadAll keeps results in scan order across threads", "[ContentPipeline][jobs]") {
+    fs::path tmp = make_temp_dir();
+    std::vector<FileEntry> files;
+    for (int i = 0; i < 40; ++i) {
+        fs::path f = tmp / ("f" + std::to_string(i) + ".cpp");
+        std::ofstream(f) << "// file " << i << "\nint f" << i << "() { return " << i << "; }\n";
+        files.push_back({f, fs::file_size(f)});
+    }
+
+    Config serialCfg;
+    serialCfg.compress = true;
+    serialCfg.jobs = 1;
+    Config parallelCfg = serialCfg;
+    parallelCfg.jobs = 4;
+
+    // a tiny in-flight budget forces the producer to wait on workers
+    auto serial = ContentPipeline(serialCfg, 16 * 1024).loadAll(files);
+    auto parallel = ContentPipeline(parallelCfg, 16 * 1024).loadAll(files, 64);
+
+    REQUIRE(parallel.size() == files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        REQUIRE(parallel[i].content == serial[i].content);
+        REQUIRE(parallel[i].content.find("f" + std::to_string(i) + "()") != std::string::npos);
+    }
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("ContentPipeline marks files it cannot read", "[ContentPipeline]") {
+    fs::path tmp = make_temp_dir();
+    std::vector<FileEntry> files = {{tmp / "missing.cpp", 10}};
+    Config cfg;
+    cfg.compress = true;
+    auto contents = ContentPipeline(cfg, 16 * 1024).loadAll(files);
+    REQUIRE(contents[0].unreadable);
+    REQUIRE(contents[0].content.empty());
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("ContentPipeline passthrough takes its counts from the cache", "[ContentPipeline][passthrough]") {
+    fs::path tmp = make_temp_dir();
+    fs::path f = tmp / "a.txt";
+    std::ofstream(f) << "one two\nthree\n";
+    FileEntry fe{f, fs::file_size(f)};
+    Config cfg;
+    Tokenizer tokenizer;
+    CompressionCache cache(tmp / "cache");
+    ContentPipeline pipeline(cfg, 16 * 1024, &cache);
+    pipeline.setPassthrough(true);
+
+    FileContent first = pipeline.loadStreamed(fe, &tokenizer);
+    REQUIRE(first.rawBytes == size_t(14));
+    REQUIRE(first.lines == 2);
+    REQUIRE(first.tokens > 0);
+    REQUIRE(cache.hits() == 0);
+
+    FileContent second = pipeline.loadStreamed(fe, &tokenizer);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(second.rawBytes == first.rawBytes);
+    REQUIRE(second.lines == first.lines);
+    REQUIRE(second.tokens == first.tokens);
+    REQUIRE(second.content.empty());
+
+    // counts without a tokenizer are kept apart
+    FileContent untokenized = pipeline.loadStreamed(fe, nullptr);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(untokenized.tokens == 0);
+
+    remove_dir_recursive(tmp);
+}
@@ -0,0 +1,92 @@
+// tests/test_deduplicator.cpp
+#include "catch.hpp"
+#include "../src/Deduplicator.h"
+#include "../src/Hash.h"
+#include "../src/ContentPipeline.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+
+static FileContent make_content(const std::string &text) {
+    FileContent fc;
+    fc.content = text;
+    fc.lines = std::count(text.begin(), text.end(), '\n');
+    fc.hash = hashString(text);
+    return fc;
+}
+
+static std::string numbered_lines(int n, const std::string &tag) {
+    std::string s;
+    for (int i = 0; i < n; ++i) s += "int " + tag + std::to_string(i) + " = compute(" + std::to_string(i) + ");\n";
+    return s;
+}
+
+TEST_CASE("Deduplicator::markDuplicates references the first identical file", "[Deduplicator][exact]") {
+    std::vector<FileContent> contents = {
+        make_content("a\nb\n"),
+        make_content("other\n"),
+        make_content("a\nb\n"),
+        make_content(""),
+        make_content("")
+    };
+
+    REQUIRE(Deduplicator::markDuplicates(contents) == 1);
+    REQUIRE_FALSE(contents[0].duplicateOf);
+    REQUIRE(contents[2].duplicateOf == size_t(0));
+    REQUIRE_FALSE(contents[2].nearDuplicate);
+    // empty files are left alone
+    REQUIRE_FALSE(contents[4].duplicateOf);
+}
+
+TEST_CASE("Deduplicator::markDuplicates ignores matches that processing created", "[Deduplicator][exact]") {
+    namespace fs = std::filesystem;
+    fs::path tmp = make_temp_dir();
+    // same first 16 KB, different tails
+    std::string head(24 * 1024, '#');
+    for (size_t i = 79; i < head.size(); i += 80) head[i] = '\n';
+    std::ofstream(tmp / "a.py") << head << "tail_a = 1\n";
+    std::ofstream(tmp / "b.py") << head << "tail_b = 2\n";
+    // same signatures, different bodies
+    std::ofstream(tmp / "c.cpp") << "int f(int x) {\n    return x + 1;\n}\n";
+    std::ofstream(tmp / "d.cpp") << "int f(int x) {\n    return x * 2;\n}\n";
+    std::ofstream(tmp / "e.cpp") << "int f(int x) {\n    return x * 2;\n}\n";
+    std::vector<FileEntry> files;
+    for (const char *name : {"a.py", "b.py", "c.cpp", "d.cpp", "e.cpp"}) files.push_back({tmp / name, fs::file_size(tmp / name)});
+
+    Config cfg;
+    cfg.compress = true;
+    auto contents = ContentPipeline(cfg, 16 * 1024).loadAll(files);
+    REQUIRE(contents[0].truncated);
+    REQUIRE(contents[0].content == contents[1].content);
+    REQUIRE(contents[2].content == contents[3].content);
+
+    REQUIRE(Deduplicator::markDuplicates(contents) == 1);
+    REQUIRE_FALSE(contents[1].duplicateOf);
+    REQUIRE_FALSE(contents[3].duplicateOf);
+    REQUIRE(contents[4].duplicateOf == size_t(3));
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("Deduplicator::markNearDuplicates finds files differing by one line", "[Deduplicator][near]") {
+    std::string base = numbered_lines(60, "v");
+    std::string edited = base;
+    edited.replace(edited.find("v30"), 3, "w30");
+
+    std::vector<FileContent> contents = {
+        make_content(base),
+        make_content(numbered_lines(60, "unrelated")),
+        make_content(edited)
+    };
+
+    Deduplicator::markNearDuplicates(contents);
+    REQUIRE_FALSE(contents[1].duplicateOf);
+    REQUIRE(contents[2].duplicateOf == size_t(0));
+    REQUIRE(contents[2].nearDuplicate);
+    REQUIRE(contents[2].similarity > 0.9);
+}
@@ -0,0 +1,60 @@
+// tests/test_dependency_graph.cpp
+#include "catch.hpp"
+#include "../src/DependencyGraph.h"
+
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+
+TEST_CASE("DependencyGraph::extractImports reads include/import/require statements", "[DependencyGraph]") {
+    std::vector<std::string> out;
+    DependencyGraph::extractImports("#include \"util.h\"\n  #  include <vector>\nint x; // #include \"no.h\"\n", "a.cpp", out);
+    REQUIRE(out == std::vector<std::string>{"util.h", "vector"});
+
+    out.clear();
+    DependencyGraph::extractImports("import os, pkg.mod as m\nfrom .sib import f\nfrom .. import up\n", "pkg/a.py", out);
+    REQUIRE(out == std::vector<std::string>{"os", "pkg.mod", ".sib", "..", "..up"});
+
+    out.clear();
+    DependencyGraph::extractImports("import x from './x';\nimport './side.css';\nexport { y } from \"../y\";\n"
+                                    "const z = require('./z'); const w = lazy(() => import('./w'));\n", "web/app.ts", out);
+    REQUIRE(out == std::vector<std::string>{"./x", "./side.css", "../y", "./z", "./w"});
+}
+
+TEST_CASE("DependencyGraph resolves edges, neighbourhoods and topological order", "[DependencyGraph]") {
+    std::vector<std::string> paths = {
+        "src/main.cpp",   // 0 -> 1, 2
+        "src/app.h",      // 1 -> 3
+        "src/util.h",     // 2
+        "include/log.h",  // 3
+        "tools/other.cpp" // 4 -> 2
+    };
+    std::vector<std::vector<std::string>> imports = {
+        {"app.h", "util.h", "iostream"},
+        {"log.h"},
+        {},
+        {},
+        {"../src/util.h"}
+    };
+    auto g = DependencyGraph::build(paths, imports);
+    REQUIRE(g.size() == 5);
+    REQUIRE(g.edgeCount() == 4);
+    REQUIRE(g.dependencies(0) == std::vector<uint32_t>{1, 2});
+    REQUIRE(g.dependencies(1) == std::vector<uint32_t>{3});
+    REQUIRE(g.dependents(2) == std::vector<uint32_t>{0, 4});
+
+    REQUIRE(g.neighbourhood({0}, 0) == std::vector<uint32_t>{0});
+    REQUIRE(g.neighbourhood({0}, 1) == std::vector<uint32_t>{0, 1, 2});
+    REQUIRE(g.neighbourhood({0}, 2) == std::vector<uint32_t>{0, 1, 2, 3, 4});
+
+    // dependencies come before their users
+    REQUIRE(g.topologicalOrder({0, 1, 2, 3, 4}) == std::vector<uint32_t>{2, 3, 1, 0, 4});
+    REQUIRE(g.topologicalOrder({0, 2}) == std::vector<uint32_t>{2, 0});
+}
+
+TEST_CASE("DependencyGraph keeps files on a cycle", "[DependencyGraph]") {
+    auto g = DependencyGraph::build({"a.py", "b.py", "c.py"}, {{"b"}, {"a"}, {"a"}});
+    REQUIRE(g.edgeCount() == 3);
+    REQUIRE(g.topologicalOrder({0, 1, 2}) == std::vector<uint32_t>{0, 1, 2});
+}
@@ -0,0 +1,90 @@
+// tests/test_directory_tree.cpp
+#include "catch.hpp"
+#include "../src/DirectoryTree.h"
+#include "../src/OutputFormatter.h"
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static std::string render(const DirectoryTree &tree) {
+    std::ostringstream oss;
+    OstreamSink sink(oss);
+    tree.render(sink);
+    sink.flush();
+    return oss.str();
+}
+
+TEST_CASE("DirectoryTree nests directories with file counts and byte totals", "[DirectoryTree]") {
+    DirectoryTree tree;
+    // sorted by generic path, as the scanner returns them
+    tree.add("package.json", 100);
+    tree.add("src/main.js", 2000);
+    tree.add("src/utils/helper.js", 48);
+    tree.add("src/utils/io/read.js", 10);
+
+    REQUIRE(tree.fileCount() == 4);
+    REQUIRE(tree.totalBytes() == 2158);
+    REQUIRE(render(tree) ==
+            "package.json\n"
+            "src/ (3 files, 2.0 KB)\n"
+            "  main.js\n"
+            "  utils/ (2 files, 58 B)\n"
+            "    helper.js\n"
+            "    io/ (1 file, 10 B)\n"
+            "      read.js\n");
+}
+
+TEST_CASE("DirectoryTree merges directories when input is not sorted", "[DirectoryTree]") {
+    DirectoryTree tree;
+    tree.add("b/x.txt", 1);
+    tree.add("a/y.txt", 2);
+    tree.add("b/z.txt", 3);
+    REQUIRE(render(tree) ==
+            "b/ (2 files, 4 B)\n"
+            "  x.txt\n"
+            "  z.txt\n"
+            "a/ (1 file, 2 B)\n"
+            "  y.txt\n");
+}
+
+TEST_CASE("DirectoryTree formats byte totals", "[DirectoryTree]") {
+    REQUIRE(DirectoryTree::formatBytes(0) == "0 B");
+    REQUIRE(DirectoryTree::formatBytes(1023) == "1023 B");
+    REQUIRE(DirectoryTree::formatBytes(1536) == "1.5 KB");
+    REQUIRE(DirectoryTree::formatBytes(5u * 1024 * 1024) == "5.0 MB");
+}
+
+TEST_CASE("OutputFormatter prints the scanned tree nested", "[OutputFormatter][DirectoryTree]") {
+    fs::path tmp = make_temp_dir();
+    fs::create_directories(tmp / "a" / "b");
+    std::ofstream(tmp / "a" / "b" / "deep.txt") << "1234";
+    std::ofstream(tmp / "a" / "top.txt") << "12";
+    std::ofstream(tmp / "root.txt") << "1";
+
+    ScanResult scan = RepositoryScanner().scanPaths({tmp.string()});
+    REQUIRE(scan.files.size() == 3);
+
+    Config cfg;
+    cfg.dirsOnly = true;
+    GitInfo git;
+    std::ostringstream oss;
+    OutputFormatter fmt(oss);
+    fmt.generate(tmp, cfg, git, scan, {});
+
+    REQUIRE(oss.str().find("## Structure\n```\n"
+                           "a/ (2 files, 6 B)\n"
+                           "  b/ (1 file, 4 B)\n"
+                           "    deep.txt\n"
+                           "  top.txt\n"
+                           "root.txt\n"
+                           "```\n") != std::string::npos);
+
+    remove_dir_recursive(tmp);
+}
@@ -10,28 +10,11 @@
 #include "../src/FileReader.h"
 #include "../src/RepositoryScanner.h"
 #include "../src/utils.h"
+#include "test_helpers.h"
 
 using namespace rcpack;
 namespace fs = std::filesystem;
 
-static fs::path make_temp_dir(const std::string &prefix = "rcpack_test_") {
-    fs::path base = fs::temp_directory_path();
-    for (int i = 0; i < 100; ++i) {
-        auto candidate = base / (prefix + std::to_string(std::rand()));
-        if (!fs::exists(candidate)) {
-            fs::create_directory(candidate);
-            return candidate;
-        }
-    }
-    throw std::runtime_error("Unable to create temp directory");
-}
-
-static void remove_dir_recursive(const fs::path &p) {
-    try {
-        if (fs::exists(p)) fs::remove_all(p);
-    } catch(...) { /* best-effort cleanup */ }
-}
-
 TEST_CASE("FileReader: full read small file and lines count", "[FileReader][readFile]") {
     fs::path tmp = make_temp_dir();
     fs::path f = tmp / "small.txt";
@@ -69,6 +52,20 @@ TEST_CASE("FileReader: truncated read when file larger than maxBytes", "[FileRea
     remove_dir_recursive(tmp);
 }
 
+TEST_CASE("FileReader: readText matches reading the same bytes from a file", "[FileReader][readText]") {
+    fs::path tmp = make_temp_dir();
+    FileReader r(8);
+    for (std::string text : {"", "a", "a\n", "a\n\nb", "0123456789abc"}) {
+        std::ofstream(tmp / "f.txt", std::ios::binary) << text;
+        auto fromFile = r.readFile(tmp / "f.txt");
+        auto fromText = r.readText(text);
+        REQUIRE(fromText.content == fromFile.content);
+        REQUIRE(fromText.lines == fromFile.lines);
+        REQUIRE(fromText.truncated == fromFile.truncated);
+    }
+    remove_dir_recursive(tmp);
+}
+
 TEST_CASE("FileReader: non-existent file returns empty FileContent", "[FileReader][error]") {
     fs::path tmp = make_temp_dir();
     fs::path f = tmp / "does_not_exist.txt";
@@ -156,3 +153,67 @@ TEST_CASE("RepositoryScanner: scanPaths handles non-existing input path by addin
     }
     REQUIRE(found == true);
 }
+
+TEST_CASE("RepositoryScanner: entries record their root-relative path", "[RepositoryScanner][relative]") {
+    fs::path tmp = make_temp_dir();
+    fs::path dir = tmp / "proj3";
+    fs::create_directories(dir / "sub");
+    std::ofstream(dir / "a.txt").put('x');
+    std::ofstream(dir / "sub" / "b.txt").put('y');
+
+    RepositoryScanner scanner({}, {});
+    // a trailing separator on the input must not change the result
+    auto result = scanner.scanPaths({ (dir / "").string() });
+    REQUIRE(result.files.size() == 2);
+    REQUIRE(relativeTo(result.files[0], dir) == "a.txt");
+    REQUIRE(relativeTo(result.files[1], dir) == "sub/b.txt");
+    REQUIRE(relativeTo(result.files[1], dir / "") == "sub/b.txt");
+    // a different root, or an entry that was not scanned, falls back to std::filesystem::relative
+    REQUIRE(relativeTo(result.files[1], dir / "sub").empty());
+    REQUIRE(relativeTo(FileEntry{dir / "a.txt"}, dir).empty());
+
+    auto single = scanner.scanPaths({ (dir / "sub" / "b.txt").string() });
+    REQUIRE(single.files.size() == 1);
+    REQUIRE(relativeTo(single.files[0], dir / "sub") == "b.txt");
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("RepositoryScanner: setOnly looks up the set's files instead of walking", "[RepositoryScanner][only]") {
+    fs::path tmp = make_temp_dir();
+    fs::path repo = tmp / "repo";
+    fs::create_directories(repo / "src" / "deep");
+    fs::create_directories(repo / "docs");
+    for (const char *f : {"top.txt", "other.txt", "src/a.cpp", "src/b.cpp", "src/deep/c.cpp", "docs/d.md"}) {
+        std::ofstream(repo / f).put('x');
+    }
+
+    PathSet only(repo);
+    only.add("top.txt");
+    only.add("src/deep/c.cpp");
+    only.add("gone/removed.txt"); // deleted since: nothing to find
+    REQUIRE(only.mayContain(repo));
+    REQUIRE(only.mayContain(tmp));
+    REQUIRE(only.mayContain(repo / "src" / "deep"));
+    REQUIRE_FALSE(only.mayContain(repo / "docs"));
+    REQUIRE_FALSE(only.containsFile(repo / "src" / "a.cpp"));
+
+    RepositoryScanner scanner({}, {});
+    scanner.setOnly(&only);
+    auto result = scanner.scanPaths({ repo.string() });
+    REQUIRE(result.files.size() == 2);
+    REQUIRE(relativeTo(result.files[0], repo) == "src/deep/c.cpp");
+    REQUIRE(relativeTo(result.files[1], repo) == "top.txt");
+
+    // a scan rooted below the set's root, and single files
+    REQUIRE(scanner.scanPaths({ (repo / "src").string() }).files.size() == 1);
+    REQUIRE(scanner.scanPaths({ (repo / "docs").string() }).files.empty());
+    REQUIRE(scanner.scanPaths({ (repo / "other.txt").string() }).files.empty());
+    REQUIRE(scanner.scanPaths({ (repo / "top.txt").string() }).files.size() == 1);
+    auto above = scanner.scanPaths({ tmp.string() });
+    REQUIRE(above.files.size() == 2);
+    REQUIRE(relativeTo(above.files[1], tmp) == "repo/top.txt");
+    REQUIRE(only.filesUnder(repo / "src").size() == 1);
+
+    remove_dir_recursive(tmp);
+}
@@ -0,0 +1,496 @@
+// tests/test_git_repository.cpp
+#include "catch.hpp"
+#include "../src/GitRepository.h"
+#include "../src/GitInfoCollector.h"
+#include "../src/RevisionSource.h"
+#include "../src/ContentPipeline.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+#if defined(_WIN32)
+static const char *const NULLDEV = "NUL";
+#else
+static const char *const NULLDEV = "/dev/null";
+#endif
+
+// Runs git in repo; returns its stdout with the trailing newline removed, nullopt on failure.
+// Identity and dates are pinned so the tests do not depend on the user's configuration.
+static std::optional<std::string> git(const fs::path &repo, const std::string &args) {
+    fs::path out = repo.parent_path() / "git-output.txt";
+    std::string cmd = "git -C \"" + repo.string() + "\" -c user.name=\"Ada Tester\" -c user.email=ada@example.com "
+                      "-c commit.gpgsign=false -c init.defaultBranch=main " + args +
+                      " > \"" + out.string() + "\" 2> " + NULLDEV;
+    if (std::system(cmd.c_str()) != 0) return std::nullopt;
+    std::string text = slurp(out);
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+    return text;
+}
+
+static void setEnv(const char *name, const std::string &value) {
+#if defined(_WIN32)
+    _putenv_s(name, value.c_str());
+#else
+    setenv(name, value.c_str(), 1);
+#endif
+}
+
+// Commits everything in repo with author and committer date daysAgo days before now.
+static bool commitAt(const fs::path &repo, const std::string &message, int daysAgo) {
+    std::string date = std::to_string(static_cast<long long>(std::time(nullptr)) - daysAgo * 86400LL) + " +0000";
+    setEnv("GIT_COMMITTER_DATE", date);
+    bool ok = git(repo, "add -A") && git(repo, "commit -q -m " + message + " --date=\"" + date + "\"");
+    setEnv("GIT_COMMITTER_DATE", "");
+    return ok;
+}
+
+static bool haveGit() {
+    return std::system((std::string("git --version > ") + NULLDEV + " 2>&1").c_str()) == 0;
+}
+
+TEST_CASE("formatDate matches git's default date format", "[GitRepository]") {
+    REQUIRE(GitInfoCollector::formatDate(1709228700, 530) == "Thu Feb 29 23:15:00 2024 +0530");
+    REQUIRE(GitInfoCollector::formatDate(0, -800) == "Wed Dec 31 16:00:00 1969 -0800");
+    REQUIRE(GitInfoCollector::formatDate(951782400, 0) == "Tue Feb 29 00:00:00 2000 +0000");
+}
+
+TEST_CASE("GitOid parses and prints hex names", "[GitRepository]") {
+    auto id = GitOid::fromHex("0123456789ABCDEF0123456789abcdef01234567");
+    REQUIRE(id);
+    REQUIRE(id->hex() == "0123456789abcdef0123456789abcdef01234567");
+    REQUIRE_FALSE(GitOid::fromHex("0123"));
+    REQUIRE_FALSE(GitOid::fromHex("g123456789abcdef0123456789abcdef01234567"));
+}
+
+TEST_CASE("GitRepository reads what git wrote, loose and packed", "[GitRepository]") {
+    if (!haveGit()) {
+        WARN("git is not installed; skipping");
+        return;
+    }
+    fs::path tmp = make_temp_dir();
+    fs::path repo = tmp / "repo";
+    fs::create_directory(repo);
+    REQUIRE(git(repo, "init -q"));
+
+    // a few versions of one file, so repacking stores most of them as deltas
+    std::string text;
+    for (int i = 0; i < 300; ++i) text += "line " + std::to_string(i) + " of the sample file\n";
+    for (int v = 0; v < 6; ++v) {
+        text.insert(text.size() / 2, "inserted in version " + std::to_string(v) + "\n");
+        std::ofstream(repo / "a.txt", std::ios::binary) << text;
+        std::ofstream(repo / ("b" + std::to_string(v) + ".txt"), std::ios::binary) << v;
+        REQUIRE(git(repo, "add -A"));
+        REQUIRE(git(repo, "commit -q -m v" + std::to_string(v) + " --date=2024-02-29T23:15:0" + std::to_string(v) + "+0530"));
+    }
+    REQUIRE(git(repo, "branch feature HEAD~2"));
+    REQUIRE(git(repo, "tag v1 HEAD~1"));
+
+    auto check = [&] {
+        GitRepository r;
+        REQUIRE(r.open(repo / "b0.txt"));
+        REQUIRE(r.workTree() == repo);
+        REQUIRE(r.headRef() == "refs/heads/main");
+        for (const char *rev : {"HEAD", "main", "feature", "v1", "refs/heads/feature"}) {
+            auto id = r.resolve(rev);
+            REQUIRE(id);
+            REQUIRE(id->hex() == *git(repo, std::string("rev-parse ") + rev));
+        }
+        REQUIRE_FALSE(r.resolve("no-such-branch"));
+
+        GitInfo info = GitInfoCollector(repo.string()).collect();
+        REQUIRE(info.isRepo);
+        REQUIRE(info.commitSHA == *git(repo, "rev-parse HEAD"));
+        REQUIRE(info.branch == "main");
+        REQUIRE(info.author + "|" + info.date == *git(repo, "log -1 --pretty=format:\"%an <%ae>|%ad\""));
+        REQUIRE(info.date == "Thu Feb 29 23:15:05 2024 +0530");
+
+        auto commit = r.readCommit(*r.resolve("HEAD"));
+        REQUIRE(commit);
+        REQUIRE(commit->parents.size() == 1);
+        REQUIRE(commit->parents[0].hex() == *git(repo, "rev-parse HEAD~1"));
+        REQUIRE(commit->tree.hex() == *git(repo, "rev-parse HEAD^{tree}"));
+
+        // every object, with the type and size git reports
+        std::istringstream all(*git(repo, "cat-file --batch-all-objects --batch-check"));
+        size_t objects = 0;
+        for (std::string hex, type, size; all >> hex >> type >> size; ++objects) {
+            GitObject obj;
+            REQUIRE(r.read(*GitOid::fromHex(hex), obj));
+            static const char *const names[] = {"", "commit", "tree", "blob", "tag"};
+            REQUIRE(names[obj.type] == type);
+            REQUIRE(std::to_string(obj.data.size()) == size);
+        }
+        REQUIRE(objects >= 6 * 3);
+        GitObject blob;
+        REQUIRE(r.read(*GitOid::fromHex(*git(repo, "rev-parse HEAD:a.txt")), blob));
+        REQUIRE(blob.data == text);
+    };
+    SECTION("loose objects and refs") {
+        check();
+    }
+    SECTION("packed objects with deltas and packed-refs") {
+        REQUIRE(git(repo, "repack -a -d -f -q --depth=10"));
+        REQUIRE(git(repo, "pack-refs --all"));
+        REQUIRE(git(repo, "prune-packed"));
+        REQUIRE_FALSE(fs::exists(repo / ".git" / "refs" / "heads" / "feature"));
+        for (auto &e : fs::directory_iterator(repo / ".git" / "objects" / "pack")) {
+            if (e.path().extension() != ".idx") continue;
+            REQUIRE(git(repo, "verify-pack -v \"" + e.path().string() + "\"")->find("chain length = ") != std::string::npos);
+        }
+        check();
+
+        // the versions of a.txt form a delta chain: reading all of them reuses resolved bases
+        GitRepository r;
+        REQUIRE(r.open(repo));
+        for (int v = 5; v >= 0; --v) {
+            auto id = GitOid::fromHex(*git(repo, "rev-parse HEAD~" + std::to_string(v) + ":a.txt"));
+            GitObject blob;
+            REQUIRE(r.read(*id, blob));
+            REQUIRE(r.objectSize(*id) == blob.data.size());
+            REQUIRE(std::to_string(blob.data.size()) == *git(repo, "cat-file -s " + id->hex()));
+        }
+        REQUIRE(r.deltaBaseHits() > 0);
+    }
+    SECTION("a pack index whose fanout overshoots its object count") {
+        REQUIRE(git(repo, "repack -a -d -q"));
+        REQUIRE(git(repo, "prune-packed"));
+        auto head = GitOid::fromHex(*git(repo, "rev-parse HEAD"));
+        if (head->bytes[0] == 255) head = GitOid::fromHex(*git(repo, "rev-parse HEAD~1")); // 255 holds the count
+        for (auto &e : fs::directory_iterator(repo / ".git" / "objects" / "pack")) {
+            if (e.path().extension() != ".idx") continue;
+            fs::permissions(e.path(), fs::perms::owner_write, fs::perm_options::add);
+            std::fstream idx(e.path(), std::ios::in | std::ios::out | std::ios::binary);
+            idx.seekp(8 + 4 * head->bytes[0]);
+            idx.write("\x7f\xff\xff\xff", 4);
+        }
+        GitRepository r;
+        REQUIRE(r.open(repo));
+        // the search is bounded by the object count, so HEAD is still found in its bucket
+        GitObject obj;
+        REQUIRE(r.read(*head, obj));
+        REQUIRE(obj.type == GitObject::Commit);
+    }
+    SECTION("detached HEAD and linked worktrees") {
+        REQUIRE(git(repo, "checkout -q --detach HEAD~1"));
+        GitInfo detached = GitInfoCollector(repo.string()).collect();
+        REQUIRE(detached.branch == "HEAD");
+        REQUIRE(detached.commitSHA == *git(repo, "rev-parse HEAD"));
+
+        REQUIRE(git(repo, "worktree add -q \"" + (tmp / "wt").string() + "\" feature"));
+        GitRepository wt;
+        REQUIRE(wt.open(tmp / "wt"));
+        REQUIRE(wt.headRef() == "refs/heads/feature");
+        REQUIRE(wt.resolve("HEAD")->hex() == *git(repo, "rev-parse feature"));
+        REQUIRE(GitInfoCollector((tmp / "wt").string()).collect().branch == "feature");
+    }
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("pathsChangedSince collects the paths of recent commits", "[GitRepository]") {
+    if (!haveGit()) {
+        WARN("git is not installed; skipping");
+        return;
+    }
+    fs::path tmp = make_temp_dir();
+    fs::path repo = tmp / "repo";
+    fs::create_directories(repo / "dir" / "sub");
+    REQUIRE(git(repo, "init -q"));
+    auto put = [&](const std::string &path, const std::string &text) {
+        std::ofstream(repo / path, std::ios::binary) << text;
+    };
+    put("a.txt", "a");
+    put("old.txt", "old");
+    put("dir/b.txt", "b");
+    put("dir/sub/c.txt", "c");
+    REQUIRE(commitAt(repo, "c0", 30));
+    put("old.txt", "old 2");
+    REQUIRE(commitAt(repo, "c1", 20));
+    REQUIRE(git(repo, "branch side"));
+    put("dir/b.txt", "b 2");
+    put("new.txt", "new");
+    REQUIRE(commitAt(repo, "c2", 2));
+    REQUIRE(git(repo, "checkout -q side"));
+    put("dir/sub/c.txt", "c 2");
+    REQUIRE(commitAt(repo, "side", 1));
+    REQUIRE(git(repo, "checkout -q main"));
+    setEnv("GIT_COMMITTER_DATE", std::to_string(static_cast<long long>(std::time(nullptr))) + " +0000");
+    REQUIRE(git(repo, "merge -q --no-edit side"));
+    setEnv("GIT_COMMITTER_DATE", "");
+
+    const int64_t since = static_cast<int64_t>(std::time(nullptr)) - 7 * 86400;
+    auto check = [&](bool graph) {
+        GitRepository r;
+        REQUIRE(r.open(repo));
+        REQUIRE(r.hasCommitGraph() == graph);
+        std::unordered_set<std::string> paths;
+        size_t commits = 0;
+        REQUIRE(r.pathsChangedSince(*r.resolve("HEAD"), since, paths, &commits));
+        // the merge adds nothing of its own; the side branch's commit is walked by itself
+        REQUIRE(paths == std::unordered_set<std::string>{"dir/b.txt", "new.txt", "dir/sub/c.txt"});
+        REQUIRE(commits == 3);
+
+        paths.clear();
+        REQUIRE(r.pathsChangedSince(*r.resolve("HEAD"), since - 25 * 86400, paths, &commits));
+        REQUIRE(paths.size() == 5); // the root commit adds every file
+        REQUIRE(commits == 5);
+    };
+    check(false);
+    REQUIRE(git(repo, "commit-graph write --reachable"));
+    check(true);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("hashObject names objects like git", "[GitRepository]") {
+    // git hash-object /dev/null and git's empty tree
+    REQUIRE(GitRepository::hashObject(GitObject::Blob, "").hex() == "e69de29bb2d1d6434b8b29ae775ad8c2e48c5391");
+    REQUIRE(GitRepository::hashObject(GitObject::Tree, "").hex() == "4b825dc642cb6eb9a060e54bf8d69288fbee4904");
+    REQUIRE(GitRepository::hashObject(GitObject::Blob, std::string(1000, 'x')).hex() ==
+            "14c7dfdd4258dec5c0e9d2e919bd249bd674be1f");
+}
+
+TEST_CASE("mergeBase, ~/^ steps and diffIndex agree with git", "[GitRepository]") {
+    if (!haveGit()) {
+        WARN("git is not installed; skipping");
+        return;
+    }
+    fs::path tmp = make_temp_dir();
+    fs::path repo = tmp / "repo";
+    fs::create_directories(repo / "dir");
+    REQUIRE(git(repo, "init -q"));
+    auto put = [&](const std::string &path, const std::string &text) {
+        std::ofstream(repo / path, std::ios::binary) << text;
+    };
+    put("a.txt", "a");
+    put("gone.txt", "gone");
+    put("dir/b.txt", "b");
+    REQUIRE(commitAt(repo, "c0", 5));
+    REQUIRE(git(repo, "checkout -q -b feature"));
+    put("dir/b.txt", "b 2");
+    put("f.txt", "f");
+    REQUIRE(commitAt(repo, "f1", 4));
+    REQUIRE(git(repo, "checkout -q main"));
+    put("a.txt", "a 2");
+    REQUIRE(commitAt(repo, "m1", 3));
+    REQUIRE(git(repo, "merge -q --no-edit feature"));
+    REQUIRE(git(repo, "checkout -q feature"));
+    put("f.txt", "f 2");
+    REQUIRE(commitAt(repo, "f2", 1));
+
+    GitRepository r;
+    REQUIRE(r.open(repo));
+    for (const char *rev : {"main~1", "main^2", "main^1~1", "main^2^", "HEAD~2", "main^0"}) {
+        auto id = r.resolve(rev);
+        REQUIRE(id);
+        REQUIRE(id->hex() == *git(repo, std::string("rev-parse ") + rev));
+    }
+    REQUIRE_FALSE(r.resolve("main^3"));
+    REQUIRE_FALSE(r.resolve("HEAD~10"));
+    REQUIRE_FALSE(r.resolve("HEAD~99999999999999999999999")); // overflows the count
+    REQUIRE_FALSE(r.resolve("main^99999999999999999999999"));
+    auto base = r.mergeBase(*r.resolve("main"), *r.resolve("HEAD"));
+    REQUIRE(base);
+    REQUIRE(base->hex() == *git(repo, "merge-base main HEAD"));
+    // --since with an annotated tag: the tag is peeled before the history walk
+    REQUIRE(git(repo, "tag -a m-release -m release main"));
+    auto tagged = r.mergeBase(*r.resolve("m-release"), *r.resolve("HEAD"));
+    REQUIRE(tagged);
+    REQUIRE(tagged->hex() == *git(repo, "merge-base m-release HEAD"));
+
+    // staged and unstaged edits; stat data alone must not hide a same-size rewrite
+    put("a.txt", "A");
+    REQUIRE(git(repo, "rm -q gone.txt"));
+    put("new.txt", "new");
+    REQUIRE(git(repo, "add new.txt"));
+    put("untracked.txt", "u");
+    fs::remove(repo / "dir" / "b.txt");
+
+    auto changes = [&](const GitOid *tree, bool workingTree) {
+        std::vector<std::string> out;
+        REQUIRE(r.diffIndex(tree, workingTree, [&](GitChange &&c) {
+            out.push_back(c.path + (c.oldMode == 0 ? " A" : c.newMode == 0 ? " D" : " M"));
+            if (c.newMode && workingTree) {
+                REQUIRE(c.newId.hex() == *git(repo, "hash-object \"" + c.path + "\""));
+            }
+        }));
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+    auto headTree = r.readCommit(*r.resolve("HEAD"))->tree;
+    auto baseTree = r.readCommit(*base)->tree;
+    // git diff --cached --name-status
+    REQUIRE(changes(&headTree, false) == std::vector<std::string>{"gone.txt D", "new.txt A"});
+    // git diff --name-status <base>
+    REQUIRE(changes(&baseTree, true) ==
+            std::vector<std::string>{"a.txt M", "dir/b.txt D", "f.txt M", "gone.txt D", "new.txt A"});
+    REQUIRE(changes(nullptr, false).size() == 4);
+
+    std::vector<GitIndexEntry> index;
+    REQUIRE(r.readIndex(index));
+    REQUIRE(index.size() == 4);
+    REQUIRE(git(repo, "update-index --index-version 4"));
+    std::vector<GitIndexEntry> v4;
+    REQUIRE(r.readIndex(v4));
+    REQUIRE(v4.size() == index.size());
+    for (size_t i = 0; i < v4.size(); ++i) {
+        REQUIRE(v4[i].path == index[i].path);
+        REQUIRE(v4[i].id == index[i].id);
+    }
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("resolve accepts unique abbreviated object names", "[GitRepository]") {
+    if (!haveGit()) {
+        WARN("git is not installed; skipping");
+        return;
+    }
+    fs::path tmp = make_temp_dir();
+    fs::path repo = tmp / "repo";
+    fs::create_directories(repo);
+    REQUIRE(git(repo, "init -q"));
+    // enough blobs that two of them share their first 4 hex digits
+    for (int i = 0; i < 1000; ++i) std::ofstream(repo / ("f" + std::to_string(i) + ".txt")) << i << "\n";
+    REQUIRE(commitAt(repo, "c1", 2));
+    std::ofstream(repo / "f0.txt") << "changed\n";
+    REQUIRE(commitAt(repo, "c2", 1));
+    std::vector<std::string> blobs;
+    std::istringstream listing(*git(repo, "ls-tree HEAD~1"));
+    for (std::string line; std::getline(listing, line);) blobs.push_back(line.substr(12, 40));
+    std::sort(blobs.begin(), blobs.end());
+    size_t twin = 1;
+    while (twin < blobs.size() && blobs[twin].compare(0, 4, blobs[twin - 1], 0, 4) != 0) ++twin;
+    REQUIRE(twin < blobs.size());
+    size_t common = 4;
+    while (blobs[twin][common] == blobs[twin - 1][common]) ++common;
+    const std::string head = *git(repo, "rev-parse HEAD"), parent = *git(repo, "rev-parse HEAD~1");
+
+    auto check = [&] {
+        GitRepository r;
+        REQUIRE(r.open(repo));
+        REQUIRE(r.resolve(head.substr(0, 7)) == GitOid::fromHex(head));
+        REQUIRE(r.resolve(head.substr(0, 7) + "~1") == GitOid::fromHex(parent));
+        std::string upper = parent.substr(0, 9);
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        REQUIRE(r.resolve(upper) == GitOid::fromHex(parent));
+        REQUIRE_FALSE(r.resolve(head.substr(0, 3))); // too short
+        REQUIRE_FALSE(r.resolve(blobs[twin].substr(0, common))); // ambiguous
+        REQUIRE(r.resolve(blobs[twin].substr(0, common + 1)) == GitOid::fromHex(blobs[twin]));
+        REQUIRE(r.resolve(blobs[twin - 1].substr(0, common + 1)) == GitOid::fromHex(blobs[twin - 1]));
+    };
+    SECTION("loose objects") { check(); }
+    SECTION("packed objects") {
+        REQUIRE(git(repo, "repack -a -d -q"));
+        REQUIRE(git(repo, "prune-packed")); // only the pack is left
+        check();
+    }
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("RevisionSource packages a commit without its working tree", "[GitRepository][rev]") {
+    if (!haveGit()) {
+        WARN("git is not installed; skipping");
+        return;
+    }
+    fs::path tmp = make_temp_dir();
+    fs::path repo = tmp / "repo";
+    fs::create_directories(repo / "dir" / "sub");
+    REQUIRE(git(repo, "init -q"));
+    auto put = [&](const std::string &path, const std::string &text) {
+        std::ofstream(repo / path, std::ios::binary) << text;
+    };
+    put("a.cpp", "int a;\n");
+    put("dir.txt", "next to dir/");
+    put("dir/b.cpp", "int b;\n");
+    put("dir/sub/c.h", "int c;\n");
+    REQUIRE(commitAt(repo, "old", 2));
+    put("a.cpp", "int a = 2;\n");
+    fs::remove(repo / "dir" / "b.cpp");
+    REQUIRE(commitAt(repo, "new", 1));
+    REQUIRE(git(repo, "repack -a -d -q"));
+    put("dir/sub/c.h", "uncommitted\n");
+
+    GitRepository r;
+    REQUIRE(r.open(repo));
+    RevisionSource source(r);
+    REQUIRE(source.load(*r.resolve("HEAD~1")));
+    REQUIRE(source.paths() == std::vector<std::string>{"a.cpp", "dir.txt", "dir/b.cpp", "dir/sub/c.h"});
+
+    RepositoryScanner scanner({"*.cpp", "*.h"}, {});
+    auto all = scanner.scanListing({repo.string()}, repo, source.paths());
+    REQUIRE(all.files.size() == 3);
+    REQUIRE(relativeTo(all.files[1], repo) == "dir/b.cpp");
+    auto dir = scanner.scanListing({(repo / "dir").string()}, repo, source.paths());
+    REQUIRE(dir.files.size() == 2);
+    REQUIRE(relativeTo(dir.files[0], repo / "dir") == "b.cpp");
+    REQUIRE(scanner.scanListing({(repo / "a.cpp").string()}, repo, source.paths()).files.size() == 1);
+    REQUIRE(scanner.scanListing({(repo / "nope").string()}, repo, source.paths()).skipped.size() == 1);
+
+    source.fillSizes(all.files, 2);
+    REQUIRE(all.files[0].size == 7);
+    Config cfg;
+    ContentPipeline pipeline(cfg, 16 * 1024);
+    pipeline.setSource(&source);
+    REQUIRE(pipeline.load(all.files[0]).content == "int a;\n");
+    REQUIRE(pipeline.load(all.files[2]).content == "int c;\n"); // not the working tree's text
+    REQUIRE(pipeline.load(all.files[1]).content == "int b;\n"); // deleted since
+    std::string text;
+    REQUIRE(source.read(repo / "dir.txt", text));
+    REQUIRE(text == "next to dir/");
+    REQUIRE_FALSE(source.read(repo / "missing.txt", text));
+
+    // --staged: the index's version, whatever the working tree holds
+    put("a.cpp", "int a = 3;\n");
+    REQUIRE(git(repo, "add a.cpp"));
+    put("a.cpp", "unstaged\n");
+    source.add("a.cpp", GitOid::fromHex(*git(repo, "rev-parse :a.cpp")).value());
+    source.add("new.cpp", GitOid::fromHex(*git(repo, "rev-parse :a.cpp")).value());
+    REQUIRE(source.paths() == std::vector<std::string>{"a.cpp", "dir.txt", "dir/b.cpp", "dir/sub/c.h", "new.cpp"});
+    REQUIRE(pipeline.load(all.files[0]).content == "int a = 3;\n");
+
+    GitInfo info = GitInfoCollector(repo.string()).collect("HEAD~1");
+    REQUIRE(info.commitSHA == *git(repo, "rev-parse HEAD~1"));
+    REQUIRE(info.branch == "HEAD~1");
+
+    // annotated tags (and a tag of one) name the commit they tag
+    REQUIRE(git(repo, "tag -a v1 -m release HEAD~1"));
+    REQUIRE(git(repo, "tag -a v1-signed -m again v1"));
+    GitRepository tagged;
+    REQUIRE(tagged.open(repo));
+    for (const char *tag : {"v1", "v1-signed", "refs/tags/v1"}) {
+        auto id = tagged.resolve(tag);
+        REQUIRE(id);
+        REQUIRE(id->hex() == *git(repo, "rev-parse HEAD~1"));
+    }
+    REQUIRE(tagged.resolve("v1~0") == tagged.resolve("HEAD~1"));
+    REQUIRE(tagged.resolve(git(repo, "rev-parse v1")->substr(0, 10)) == tagged.resolve("HEAD~1"));
+    RevisionSource release(tagged);
+    REQUIRE(release.load(*tagged.resolve("v1")));
+    REQUIRE(release.paths() == std::vector<std::string>{"a.cpp", "dir.txt", "dir/b.cpp", "dir/sub/c.h"});
+    REQUIRE(GitInfoCollector(repo.string()).collect("v1").commitSHA == *git(repo, "rev-parse HEAD~1"));
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("GitInfoCollector reports directories outside a repository", "[GitRepository]") {
+    fs::path tmp = make_temp_dir();
+    GitRepository r;
+    // temp directories are normally outside any repository; only check consistency
+    bool inside = r.open(tmp);
+    REQUIRE(GitInfoCollector(tmp.string()).collect().isRepo == inside);
+    remove_dir_recursive(tmp);
+}
@@ -0,0 +1,35 @@
+// tests/test_helpers.h
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Helpers for temp directories and files shared by the test files
+inline std::filesystem::path make_temp_dir(const std::string &prefix = "rcpack_test_") {
+    std::filesystem::path base = std::filesystem::temp_directory_path();
+    for (int i = 0; i < 100; ++i) {
+        auto candidate = base / (prefix + std::to_string(std::rand()));
+        if (!std::filesystem::exists(candidate)) {
+            std::filesystem::create_directory(candidate);
+            return candidate;
+        }
+    }
+    throw std::runtime_error("Unable to create temp directory");
+}
+
+inline void remove_dir_recursive(const std::filesystem::path &p) {
+    try {
+        if (std::filesystem::exists(p)) std::filesystem::remove_all(p);
+    } catch(...) { /* best-effort cleanup */ }
+}
+
+inline std::string slurp(const std::filesystem::path &p) {
+    std::ifstream in(p, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
@@ -0,0 +1,170 @@
+// tests/test_incremental_output.cpp
+#include "catch.hpp"
+#include "../src/IncrementalOutput.h"
+#include "test_helpers.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static void spit(const fs::path &p, const std::string &text) {
+    std::ofstream(p, std::ios::binary | std::ios::trunc) << text;
+}
+
+TEST_CASE("FilePatch applies kept, shifted and new ranges in place", "[IncrementalOutput][FilePatch]") {
+    fs::path tmp = make_temp_dir();
+    fs::path file = tmp / "out.md";
+    std::mt19937 rng(3);
+    for (int round = 0; round < 200; ++round) {
+        // old file: chunks of random sizes; new layout keeps some of them in order and
+        // replaces or inserts others
+        std::string old;
+        std::vector<std::pair<size_t, size_t>> chunks;
+        for (int k = 0; k < 12; ++k) {
+            size_t len = 1 + rng() % 3000;
+            chunks.emplace_back(old.size(), len);
+            for (size_t b = 0; b < len; ++b) old.push_back(static_cast<char>('a' + rng() % 26));
+        }
+        spit(file, old);
+
+        FilePatch patch;
+        std::string expected;
+        for (auto [off, len] : chunks) {
+            switch (rng() % 4) {
+            case 0: { // replaced
+                std::string fresh(1 + rng() % 3000, static_cast<char>('A' + rng() % 26));
+                expected += fresh;
+                patch.addNew(fresh);
+                break;
+            }
+            case 1: // removed
+                break;
+            default: // kept
+                expected += old.substr(off, len);
+                patch.addOld(off, len);
+                break;
+            }
+            if (rng() % 5 == 0) { // inserted
+                std::string fresh(1 + rng() % 500, '#');
+                expected += fresh;
+                patch.addNew(fresh);
+            }
+        }
+        REQUIRE(patch.size() == expected.size());
+        REQUIRE(patch.patchCost() <= 2 * expected.size());
+        REQUIRE(patch.apply(file));
+        REQUIRE(slurp(file) == expected);
+    }
+
+    // nothing moves: nothing to do
+    spit(file, "0123456789");
+    FilePatch same;
+    same.addOld(0, 4);
+    same.addOld(4, 6);
+    REQUIRE(same.patchCost() == 0);
+
+    // reordered ranges are left to rewrite()
+    FilePatch swapped;
+    swapped.addOld(5, 5);
+    swapped.addOld(0, 5);
+    REQUIRE(swapped.patchCost() == UINT64_MAX);
+    REQUIRE(swapped.rewrite(file));
+    REQUIRE(slurp(file) == "5678901234");
+
+    remove_dir_recursive(tmp);
+}
+
+// one run with a section per file: its name and its text
+static IncrementalOutput::Item itemFor(const IncrementalOutput &inc, const fs::path &p, size_t &rendered) {
+    FileEntry fe{p};
+    fe.size = fs::file_size(p);
+    return inc.prepare(fe, [&] {
+        ++rendered;
+        OutputFormatter::Section sec;
+        sec.head = "## " + p.filename().string() + "\n";
+        sec.body = slurp(p);
+        sec.lines = 1;
+        return sec;
+    });
+}
+
+static std::string run(const fs::path &out, const std::vector<fs::path> &files, uint64_t options,
+                       size_t &rendered, size_t &reused, std::string &mode) {
+    IncrementalOutput inc(out, options);
+    inc.begin("# header\n");
+    rendered = 0;
+    for (auto &p : files) inc.add(itemFor(inc, p, rendered));
+    inc.end("# summary\n");
+    REQUIRE(inc.finish());
+    reused = inc.reused();
+    mode = inc.mode();
+    return slurp(out);
+}
+
+TEST_CASE("IncrementalOutput rewrites only changed sections", "[IncrementalOutput]") {
+    fs::path tmp = make_temp_dir();
+    std::vector<fs::path> files;
+    for (int i = 0; i < 20; ++i) {
+        files.push_back(tmp / ("f" + std::to_string(i) + ".txt"));
+        spit(files.back(), std::string(1000 + i, static_cast<char>('a' + i)));
+    }
+    auto whole = [&] {
+        std::string s = "# header\n";
+        for (auto &p : files) s += "## " + p.filename().string() + "\n" + slurp(p);
+        return s + "# summary\n";
+    };
+    fs::path out = tmp / "out.md";
+    size_t rendered = 0, reused = 0;
+    std::string mode;
+
+    REQUIRE(run(out, files, 1, rendered, reused, mode) == whole());
+    REQUIRE(rendered == 20);
+    REQUIRE(fs::exists(IncrementalOutput::indexPath(out)));
+
+    // nothing changed: no file is read and the output is left alone
+    REQUIRE(run(out, files, 1, rendered, reused, mode) == whole());
+    REQUIRE(rendered == 0);
+    REQUIRE(reused == 20);
+    REQUIRE(mode == "output unchanged");
+
+    // one file near the end grows: patched in place
+    spit(files[17], std::string(1500, 'X'));
+    REQUIRE(run(out, files, 1, rendered, reused, mode) == whole());
+    REQUIRE(rendered == 1);
+    REQUIRE(mode == "patched the output in place");
+
+    // a file is removed and one appended
+    files.erase(files.begin() + 15);
+    files.push_back(tmp / "z.txt");
+    spit(files.back(), "appended\n");
+    REQUIRE(run(out, files, 1, rendered, reused, mode) == whole());
+    REQUIRE(rendered == 1);
+
+    // rewritten with the same text (new mtime): re-read, but the section is kept
+    spit(files[3], slurp(files[3]));
+    fs::last_write_time(files[3], fs::last_write_time(files[3]) + std::chrono::seconds(5));
+    REQUIRE(run(out, files, 1, rendered, reused, mode) == whole());
+    REQUIRE(rendered == 1);
+    REQUIRE(reused == files.size());
+
+    // a change at the front moves everything: cheaper to rewrite
+    spit(files[0], std::string(3000, 'Y'));
+    REQUIRE(run(out, files, 1, rendered, reused, mode) == whole());
+    REQUIRE(mode == "rewrote the whole output");
+
+    // different options or an edited output invalidate the index
+    REQUIRE(run(out, files, 2, rendered, reused, mode) == whole());
+    REQUIRE(rendered == files.size());
+    spit(out, slurp(out) + "edited by hand\n");
+    REQUIRE(run(out, files, 2, rendered, reused, mode) == whole());
+    REQUIRE(rendered == files.size());
+
+    remove_dir_recursive(tmp);
+}
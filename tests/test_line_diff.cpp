@@ -0,0 +1,96 @@
+// tests/test_line_diff.cpp
+#include "catch.hpp"
+#include "../src/LineDiff.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+
+// Length of the longest common subsequence of lines, by dynamic programming.
+static size_t lcsLength(const std::vector<std::string_view> &a, const std::vector<std::string_view> &b) {
+    std::vector<size_t> row(b.size() + 1, 0), prev(b.size() + 1, 0);
+    for (size_t i = 1; i <= a.size(); ++i) {
+        for (size_t j = 1; j <= b.size(); ++j) {
+            row[j] = a[i - 1] == b[j - 1] ? prev[j - 1] + 1 : std::max(prev[j], row[j - 1]);
+        }
+        std::swap(row, prev);
+    }
+    return prev[b.size()];
+}
+
+// The new text rebuilt from the old one and the edit script.
+static std::string apply(const LineDiff &diff, std::string_view oldText, std::string_view newText) {
+    auto oldLines = LineDiff::splitLines(oldText), newLines = LineDiff::splitLines(newText);
+    std::string out;
+    for (auto &e : diff.edits()) {
+        if (e.op == LineDiff::Op::Equal) out += oldLines[e.oldLine];
+        else if (e.op == LineDiff::Op::Insert) out += newLines[e.newLine];
+    }
+    return out;
+}
+
+TEST_CASE("LineDiff: equal texts have no changes", "[LineDiff]") {
+    LineDiff diff("a\nb\n", "a\nb\n");
+    REQUIRE(diff.changes() == 0);
+    REQUIRE(diff.edits().size() == 2);
+    REQUIRE(diff.unified("x", "x").empty());
+}
+
+TEST_CASE("LineDiff: unified output matches diff -u", "[LineDiff]") {
+    std::string before, after;
+    for (int i = 1; i <= 20; ++i) {
+        before += "line " + std::to_string(i) + "\n";
+        if (i == 3) after += "changed 3\n";
+        else if (i != 15) after += "line " + std::to_string(i) + "\n";
+    }
+    after += "tail";
+    LineDiff diff(before, after);
+    REQUIRE(diff.changes() == 4);
+    REQUIRE(diff.unified("f.txt", "f.txt") ==
+            "--- a/f.txt\n"
+            "+++ b/f.txt\n"
+            "@@ -1,6 +1,6 @@\n"
+            " line 1\n"
+            " line 2\n"
+            "-line 3\n"
+            "+changed 3\n"
+            " line 4\n"
+            " line 5\n"
+            " line 6\n"
+            "@@ -12,9 +12,9 @@\n"
+            " line 12\n"
+            " line 13\n"
+            " line 14\n"
+            "-line 15\n"
+            " line 16\n"
+            " line 17\n"
+            " line 18\n"
+            " line 19\n"
+            " line 20\n"
+            "+tail\n"
+            "\\ No newline at end of file\n");
+}
+
+TEST_CASE("LineDiff: added and removed files", "[LineDiff]") {
+    REQUIRE(LineDiff("", "a\nb\n").unified("", "n.txt") == "--- /dev/null\n+++ b/n.txt\n@@ -0,0 +1,2 @@\n+a\n+b\n");
+    REQUIRE(LineDiff("a\n", "").unified("o.txt", "") == "--- a/o.txt\n+++ /dev/null\n@@ -1 +0,0 @@\n-a\n");
+}
+
+TEST_CASE("LineDiff: edit scripts are minimal and rebuild the new text", "[LineDiff]") {
+    std::mt19937 rng(49);
+    for (int round = 0; round < 200; ++round) {
+        // few distinct lines, so that many alignments are possible
+        auto randomText = [&](size_t lines) {
+            std::string text;
+            for (size_t i = 0; i < lines; ++i) text += std::string(1, static_cast<char>('a' + rng() % 4)) + "\n";
+            return text;
+        };
+        std::string a = randomText(rng() % 40), b = randomText(rng() % 40);
+        LineDiff diff(a, b);
+        REQUIRE(apply(diff, a, b) == b);
+        auto la = LineDiff::splitLines(a), lb = LineDiff::splitLines(b);
+        REQUIRE(diff.changes() == la.size() + lb.size() - 2 * lcsLength(la, lb));
+    }
+}
@@ -2,6 +2,7 @@
 #include "catch.hpp"
 #include "../src/OutputFormatter.h"
 #include "../src/FileReader.h"
+#include "test_helpers.h"
 
 #include <filesystem>
 #include <fstream>
@@ -12,23 +13,6 @@
 using namespace rcpack;
 namespace fs = std::filesystem;
 
-// Helpers for temp directories
-static fs::path make_temp_dir(const std::string &prefix = "rcpack_test_") {
-    fs::path base = fs::temp_directory_path();
-    for (int i = 0; i < 100; ++i) {
-        auto candidate = base / (prefix + std::to_string(std::rand()));
-        if (!fs::exists(candidate)) {
-            fs::create_directory(candidate);
-            return candidate;
-        }
-    }
-    throw std::runtime_error("Unable to create temp directory");
-}
-
-static void remove_dir_recursive(const fs::path &p) {
-    try { if (fs::exists(p)) fs::remove_all(p); } catch(...) {}
-}
-
 TEST_CASE("OutputFormatter generates tree for nested directories", "[OutputFormatter][generate]") {
     fs::path tmp = make_temp_dir();
     fs::create_directory(tmp / "dirA");
@@ -170,3 +154,157 @@ TEST_CASE("OutputFormatter handles files outside root directory", "[OutputFormat
     remove_dir_recursive(tmp);
     std::filesystem::remove(outside);
 }
+
+TEST_CASE("OutputFormatter renders duplicates as references", "[OutputFormatter][generate][dedup]") {
+    fs::path tmp = make_temp_dir();
+    std::ofstream(tmp / "a.txt") << "same\n";
+    std::ofstream(tmp / "b.txt") << "same\n";
+
+    ScanResult scan;
+    scan.files = {{tmp / "a.txt"}, {tmp / "b.txt"}};
+    std::vector<FileContent> contents = {FileReader().readFile(tmp / "a.txt"), FileReader().readFile(tmp / "b.txt")};
+    contents[1].duplicateOf = 0;
+
+    Config cfg;
+    GitInfo git;
+
+    std::ostringstream oss;
+    OutputFormatter fmt(oss);
+    fmt.generate(tmp, cfg, git, scan, contents);
+
+    std::string out = oss.str();
+    REQUIRE(out.find("### File: b.txt\n(identical to a.txt)") != std::string::npos);
+    REQUIRE(out.find("Duplicate files: 1") != std::string::npos);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("OutputFormatter marks files that could not be read", "[OutputFormatter][generate][unreadable]") {
+    fs::path tmp = make_temp_dir();
+    std::ofstream(tmp / "a.txt") << "text\n";
+
+    ScanResult scan;
+    scan.files = {{tmp / "a.txt"}, {tmp / "gone.txt"}};
+    std::vector<FileContent> contents = {FileReader().readFile(tmp / "a.txt"), FileReader().readFile(tmp / "gone.txt")};
+    REQUIRE(contents[1].unreadable);
+
+    Config cfg;
+    GitInfo git;
+    std::ostringstream md;
+    OutputFormatter(md).generate(tmp, cfg, git, scan, contents);
+    REQUIRE(md.str().find("### File: gone.txt\n(could not be read)") != std::string::npos);
+
+    std::ostringstream jsonl;
+    OutputFormatter records(jsonl);
+    records.setFormat(OutputFormat::Jsonl);
+    records.generate(tmp, cfg, git, scan, contents);
+    REQUIRE(jsonl.str().find("\"path\":\"gone.txt\",\"size\":0,\"lines\":0,\"truncated\":false,\"unreadable\":true,\"content\":null}") != std::string::npos);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("OutputFormatter appends diff blocks after file contents", "[OutputFormatter][generate][diff]") {
+    fs::path tmp = make_temp_dir();
+    std::ofstream(tmp / "a.txt") << "new\n";
+    std::ofstream(tmp / "b.txt") << "same\n";
+
+    ScanResult scan;
+    scan.files = {{tmp / "a.txt"}, {tmp / "b.txt"}};
+    std::vector<FileContent> contents = {FileReader().readFile(tmp / "a.txt"), FileReader().readFile(tmp / "b.txt")};
+    std::vector<std::string> diffs = {"--- a/a.txt\n+++ b/a.txt\n@@ -1 +1 @@\n-old\n+new\n", ""};
+
+    Config cfg;
+    GitInfo git;
+    std::ostringstream oss;
+    OutputFormatter fmt(oss);
+    fmt.setDiffs(&diffs);
+    fmt.generate(tmp, cfg, git, scan, contents);
+    std::string out = oss.str();
+    REQUIRE(out.find("```\nnew\n```\n\n```diff\n--- a/a.txt\n+++ b/a.txt\n@@ -1 +1 @@\n-old\n+new\n```\n\n### File: b.txt") !=
+            std::string::npos);
+    REQUIRE(out.find("```diff", out.find("### File: b.txt")) == std::string::npos);
+
+    std::ostringstream json;
+    OutputFormatter records(json);
+    records.setDiffs(&diffs);
+    records.setFormat(OutputFormat::Jsonl);
+    records.generate(tmp, cfg, git, scan, contents);
+    REQUIRE(json.str().find("\"diff\":\"--- a/a.txt\\n+++ b/a.txt\\n") != std::string::npos);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("OutputFormatter prints a Symbols section and JSON index", "[OutputFormatter][symbols]") {
+    fs::path tmp = make_temp_dir();
+    std::ofstream(tmp / "w.cpp") << "class W {};\n";
+
+    ScanResult scan;
+    scan.files = {{tmp / "w.cpp"}};
+    std::vector<FileContent> contents = {FileReader().readFile(tmp / "w.cpp")};
+
+    SymbolTable symbols;
+    size_t cls = symbols.add("W", SymbolKind::Class, 0, 1);
+    symbols.add("paint", SymbolKind::Method, 0, 2, static_cast<int32_t>(cls));
+
+    Config cfg;
+    GitInfo git;
+    std::ostringstream oss;
+    OutputFormatter fmt(oss);
+    fmt.setSymbols(&symbols);
+    fmt.generate(tmp, cfg, git, scan, contents);
+    REQUIRE(oss.str().find("## Symbols\n\n```\nw.cpp\n  class W :1\n    method paint :2\n```") != std::string::npos);
+
+    std::ostringstream json;
+    OutputFormatter::writeSymbolsJson(json, tmp, scan.files, symbols);
+    REQUIRE(json.str() == "{\"files\":[\"w.cpp\"],\n\"name\":[\"W\",\"paint\"],\n\"kind\":[\"class\",\"method\"],\n"
+                          "\"file\":[0,0],\n\"line\":[1,2],\n\"parent\":[-1,0]}\n");
+
+    // names that are not UTF-8 still give valid JSON
+    SymbolTable latin1;
+    latin1.add("caf\xe9", SymbolKind::Function, 0, 1);
+    std::ostringstream escaped;
+    OutputFormatter::writeSymbolsJson(escaped, tmp, scan.files, latin1);
+    REQUIRE(escaped.str().find("\"name\":[\"caf\\ufffd\"]") != std::string::npos);
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("OutputFormatter renders sections in parallel with deterministic output", "[OutputFormatter][generate][jobs]") {
+    fs::path tmp = make_temp_dir();
+    ScanResult scan;
+    std::vector<FileContent> contents;
+    for (int i = 0; i < 40; ++i) {
+        fs::path p = tmp / ("f" + std::to_string(i) + ".txt");
+        std::ofstream(p) << "content " << i << "\n";
+        scan.files.push_back({p});
+        contents.push_back(FileReader().readFile(p));
+    }
+    GitInfo git;
+    git.isRepo = false;
+
+    Config serial;
+    serial.jobs = 1;
+    std::ostringstream a;
+    OutputFormatter(a).generate(tmp, serial, git, scan, contents);
+
+    Config parallel;
+    parallel.jobs = 4;
+    std::ostringstream b;
+    OutputFormatter(b).generate(tmp, parallel, git, scan, contents);
+
+    REQUIRE(a.str() == b.str());
+    REQUIRE(a.str().find("### File: f39.txt\n```\ncontent 39\n```\n") != std::string::npos);
+    REQUIRE(a.str().find("f0.txt") < a.str().find("### File: f1.txt"));
+
+    // writeFile is renderSection + writeSection
+    std::ostringstream c;
+    OutputFormatter fmt(c);
+    fmt.writeFile(tmp, serial, scan, 3, &contents[3]);
+    std::ostringstream d;
+    OutputFormatter fmt2(d);
+    fmt2.writeSection(fmt2.renderSection(tmp, serial, scan, 3, FileContent(contents[3])), scan);
+    REQUIRE(c.str() == d.str());
+    REQUIRE(c.str() == "### File: f3.txt\n```\ncontent 3\n```\n\n");
+
+    remove_dir_recursive(tmp);
+}
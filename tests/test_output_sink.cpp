@@ -0,0 +1,79 @@
+// tests/test_output_sink.cpp
+#include "catch.hpp"
+#include "../src/OutputSink.h"
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+TEST_CASE("OstreamSink formats text and integers", "[OutputSink]") {
+    std::ostringstream oss;
+    OstreamSink sink(oss);
+    sink << "files: " << size_t(42) << ' ' << -7 << std::string(" end");
+    std::string_view parts[] = {"a", "", "bc"};
+    sink.writev(parts, 3);
+    REQUIRE(sink.flush());
+    REQUIRE(oss.str() == "files: 42 -7 endabc");
+}
+
+TEST_CASE("FdSink writes buffered and gathered output in order", "[OutputSink]") {
+    fs::path tmp = make_temp_dir();
+    std::string expected;
+    {
+        // a tiny buffer forces both the copy path and the gathered-write path
+        auto sink = FdSink::open(tmp / "out.txt", 16);
+        REQUIRE(sink);
+        *sink << "header " << 123u << "\n";
+        expected += "header 123\n";
+        std::string big(1000, 'x');
+        std::string_view parts[] = {"```\n", big, "```\n"};
+        sink->writev(parts, 3);
+        expected += "```\n" + big + "```\n";
+        for (int i = 0; i < 50; ++i) {
+            *sink << i << ',';
+            expected += std::to_string(i) + ",";
+        }
+        REQUIRE(sink->flush());
+    }
+    REQUIRE(slurp(tmp / "out.txt") == expected);
+
+    // the destructor flushes what is still buffered
+    {
+        auto sink = FdSink::open(tmp / "tail.txt");
+        *sink << "pending";
+    }
+    REQUIRE(slurp(tmp / "tail.txt") == "pending");
+
+    REQUIRE_FALSE(FdSink::open(tmp / "missing_dir" / "x.txt"));
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("copyFile appends file bytes between buffered writes", "[OutputSink]") {
+    fs::path tmp = make_temp_dir();
+    {
+        std::ofstream src(tmp / "src.txt", std::ios::binary);
+        src << "line one\r\nline two\n";
+    }
+    {
+        auto sink = FdSink::open(tmp / "out.txt");
+        *sink << "```\n";
+        REQUIRE(sink->copyFile(tmp / "src.txt", 8) == 8);
+        *sink << "|";
+        REQUIRE(sink->copyFile(tmp / "src.txt", 100) == 19); // stops at end of file
+        REQUIRE(sink->copyFile(tmp / "missing.txt", 5) == 0);
+        *sink << "```\n";
+    }
+    REQUIRE(slurp(tmp / "out.txt") == "```\nline one|line one\r\nline two\n```\n");
+
+    // the generic fallback gives the same bytes
+    std::ostringstream oss;
+    OstreamSink adapter(oss);
+    REQUIRE(adapter.copyFile(tmp / "src.txt", 10) == 10);
+    REQUIRE(oss.str() == "line one\r\n");
+    remove_dir_recursive(tmp);
+}
@@ -0,0 +1,154 @@
+// tests/test_pack_file.cpp
+#include "catch.hpp"
+#include "../src/PackFile.h"
+#include "../src/Lz4.h"
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static std::string roundTrip(const std::string &in, size_t *compressedSize = nullptr) {
+    std::string block;
+    Lz4::compressBlock(in, block);
+    if (compressedSize) *compressedSize = block.size();
+    std::string out(in.size(), '\0');
+    REQUIRE(Lz4::decompressBlock(block, out.data(), out.size()));
+    return out;
+}
+
+TEST_CASE("Lz4 blocks round-trip", "[Lz4]") {
+    REQUIRE(roundTrip("").empty());
+    REQUIRE(roundTrip("short") == "short");
+
+    std::string code;
+    for (int i = 0; i < 2000; ++i) code += "    int value" + std::to_string(i % 37) + " = compute(x, y);\n";
+    size_t packed = 0;
+    REQUIRE(roundTrip(code, &packed) == code);
+    REQUIRE(packed < code.size() / 4);
+
+    std::string runs(100000, 'a'); // overlapping matches (offset 1)
+    REQUIRE(roundTrip(runs, &packed) == runs);
+    REQUIRE(packed < 1000);
+
+    std::mt19937 rng(7);
+    std::string noise(70000, '\0');
+    for (auto &c : noise) c = static_cast<char>(rng());
+    REQUIRE(roundTrip(noise) == noise);
+}
+
+TEST_CASE("Lz4 rejects malformed blocks", "[Lz4]") {
+    std::string block;
+    Lz4::compressBlock(std::string(1000, 'x') + "tail of the block", block);
+    std::string out(1017, '\0');
+    REQUIRE_FALSE(Lz4::decompressBlock(block.substr(0, block.size() - 3), out.data(), out.size()));
+    std::string small(10, '\0');
+    REQUIRE_FALSE(Lz4::decompressBlock(block, small.data(), small.size()));
+    REQUIRE_FALSE(Lz4::decompressBlock(std::string("\x0f\x00\x00", 3), out.data(), out.size()));
+}
+
+TEST_CASE("PackWriter and PackReader give random access by path", "[PackFile]") {
+    fs::path tmp = make_temp_dir();
+    fs::path packPath = tmp / "out.rcpk";
+    std::string big;
+    for (int i = 0; i < 500; ++i) big += "line " + std::to_string(i % 10) + " of a compressible file\n";
+    {
+        auto sink = FdSink::open(packPath);
+        REQUIRE(sink);
+        PackWriter w(*sink);
+        w.begin();
+        // added in scan order, not path order
+        auto b = PackWriter::encode(big, true);
+        b.lines = 500;
+        REQUIRE(b.codec == pack::Lz4);
+        w.add("src/z.cpp", std::move(b));
+        w.add("README.md", PackWriter::encode("# readme\n", true));
+        w.addAlias("src/copy_of_z.cpp", 0, 500);
+        w.add("src/a.h", PackWriter::encode("", false));
+        w.finish();
+        REQUIRE(sink->flush());
+    }
+
+    PackReader r;
+    REQUIRE(r.open(packPath));
+    REQUIRE(r.verifyIndex());
+    REQUIRE(r.size() == 4);
+    REQUIRE(r.path(0) == "README.md");
+    REQUIRE(r.path(3) == "src/z.cpp");
+
+    std::string text;
+    auto z = r.find("src/z.cpp");
+    REQUIRE(z);
+    REQUIRE(r.read(*z, text));
+    REQUIRE(text == big);
+    REQUIRE(r.lines(*z) == 500);
+    REQUIRE(r.read(*r.find("src/copy_of_z.cpp"), text));
+    REQUIRE(text == big);
+    REQUIRE(r.read(*r.find("README.md"), text));
+    REQUIRE(text == "# readme\n");
+    REQUIRE(r.read(*r.find("src/a.h"), text));
+    REQUIRE(text.empty());
+    REQUIRE_FALSE(r.find("src/missing.cpp"));
+    REQUIRE_FALSE(r.find("src"));
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("PackReader reports how an entry was packaged", "[PackFile]") {
+    fs::path tmp = make_temp_dir();
+    fs::path packPath = tmp / "out.rcpk";
+    {
+        auto sink = FdSink::open(packPath);
+        REQUIRE(sink);
+        PackWriter w(*sink);
+        w.begin();
+        auto cut = PackWriter::encode("first 16 KB\n", false);
+        cut.flags = pack::Truncated | pack::Reduced;
+        w.add("big.cpp", std::move(cut));
+        w.add("small.cpp", PackWriter::encode("int x;\n", false));
+        w.finish();
+        REQUIRE(sink->flush());
+    }
+    PackReader r;
+    REQUIRE(r.open(packPath));
+    REQUIRE(r.flags(*r.find("big.cpp")) == (pack::Truncated | pack::Reduced));
+    REQUIRE(r.flags(*r.find("small.cpp")) == 0);
+    REQUIRE(pack::flagNames(r.flags(*r.find("big.cpp"))) == "truncated,reduced");
+    REQUIRE(pack::flagNames(0) == "-");
+    REQUIRE(pack::flagNames(pack::NoContent) == "no-content");
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("PackReader detects damaged content and foreign files", "[PackFile]") {
+    fs::path tmp = make_temp_dir();
+    fs::path packPath = tmp / "out.rcpk";
+    {
+        auto sink = FdSink::open(packPath);
+        PackWriter w(*sink);
+        w.begin();
+        w.add("a.txt", PackWriter::encode("hello world\n", false));
+        w.finish();
+        sink->flush();
+    }
+    {
+        // flip a content byte (blocks start right after the 16-byte header)
+        std::fstream f(packPath, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(16);
+        f.put('j');
+    }
+    PackReader r;
+    REQUIRE(r.open(packPath));
+    std::string text;
+    REQUIRE_FALSE(r.read(0, text));
+
+    std::ofstream(tmp / "not.rcpk") << "just some text that is long enough to hold a header and footer";
+    PackReader other;
+    REQUIRE_FALSE(other.open(tmp / "not.rcpk"));
+
+    remove_dir_recursive(tmp);
+}
@@ -0,0 +1,49 @@
+// tests/test_preamble_detector.cpp
+#include "catch.hpp"
+#include "../src/PreambleDetector.h"
+
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+
+static FileContent make_content(const std::string &text) {
+    FileContent fc;
+    fc.content = text;
+    return fc;
+}
+
+TEST_CASE("PreambleDetector::extract strips a license header shared by several files", "[PreambleDetector]") {
+    const std::string license = "// Copyright Example\n// SPDX-License-Identifier: MIT\n//\n#include <string>\n";
+    std::vector<FileContent> contents = {
+        make_content(license + "int a();\n"),
+        make_content("int standalone();\n"),
+        make_content(license + "int b();\n"),
+        make_content(license + "int c();\n")
+    };
+
+    auto preambles = PreambleDetector::extract(contents);
+
+    REQUIRE(preambles.size() == 1);
+    REQUIRE(preambles[0].text == license);
+    REQUIRE(preambles[0].lineCount == 4);
+    REQUIRE(preambles[0].files == std::vector<size_t>{0, 2, 3});
+    REQUIRE(contents[0].content == "int a();\n");
+    REQUIRE(contents[0].preambleId == size_t(0));
+    REQUIRE_FALSE(contents[1].preambleId);
+    REQUIRE(contents[1].content == "int standalone();\n");
+}
+
+TEST_CASE("PreambleDetector::extract leaves prefixes shared by too few files alone", "[PreambleDetector][threshold]") {
+    const std::string header = "/* a */\n/* b */\n/* c */\n";
+    std::vector<FileContent> contents = {
+        make_content(header + "x\n"),
+        make_content(header + "y\n")
+    };
+
+    auto preambles = PreambleDetector::extract(contents);
+
+    REQUIRE(preambles.empty());
+    REQUIRE(contents[0].content == header + "x\n");
+    REQUIRE(contents[1].content == header + "y\n");
+}
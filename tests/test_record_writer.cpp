@@ -0,0 +1,95 @@
+// tests/test_record_writer.cpp
+#include "catch.hpp"
+#include "../src/RecordWriter.h"
+#include "../src/OutputFormatter.h"
+#include "../src/FileReader.h"
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static std::string escaped(std::string_view s) {
+    std::string out;
+    RecordWriter::escapeJson(out, s);
+    return out;
+}
+
+TEST_CASE("RecordWriter escapes JSON strings", "[RecordWriter][json]") {
+    REQUIRE(escaped("plain text") == "plain text");
+    REQUIRE(escaped("a\"b\\c\nd\te\r\x01") == "a\\\"b\\\\c\\nd\\te\\r\\u0001");
+    REQUIRE(escaped("caf\xc3\xa9 \xe2\x82\xac") == "caf\xc3\xa9 \xe2\x82\xac");
+    // stray continuation byte, truncated sequence, surrogate
+    REQUIRE(escaped("x\x80y\xe2\x82") == "x\\ufffdy\\ufffd\\ufffd");
+    REQUIRE(escaped("\xed\xa0\x80") == "\\ufffd\\ufffd\\ufffd");
+
+    // special characters at every position of the 16-byte blocks
+    for (size_t pos = 0; pos < 40; ++pos) {
+        std::string s(40, 'a');
+        s[pos] = '"';
+        REQUIRE(RecordWriter::plainPrefix(s.data(), s.size()) == pos);
+        std::string expected = std::string(pos, 'a') + "\\\"" + std::string(39 - pos, 'a');
+        REQUIRE(escaped(s) == expected);
+    }
+}
+
+TEST_CASE("RecordWriter writes JSON and MessagePack from the same calls", "[RecordWriter][msgpack]") {
+    auto build = [](OutputFormat f) {
+        std::string out;
+        RecordWriter w(f, out);
+        w.beginMap(4).key("a").value(1).key("b").beginArray(2).value(true).null().endArray()
+         .key("c").value("x").key("d").value(static_cast<uint64_t>(300)).endMap();
+        return out;
+    };
+    REQUIRE(build(OutputFormat::Json) == "{\"a\":1,\"b\":[true,null],\"c\":\"x\",\"d\":300}");
+    REQUIRE(build(OutputFormat::MsgPack) ==
+            std::string("\x84\xa1" "a\x01\xa1" "b\x92\xc3\xc0\xa1" "c\xa1" "x\xa1" "d\xcd\x01\x2c", 18));
+
+    std::string big;
+    RecordWriter(OutputFormat::MsgPack, big).value(std::string(40, 'z'));
+    REQUIRE(big.substr(0, 2) == "\xd9\x28");
+    REQUIRE(big.size() == 42);
+}
+
+TEST_CASE("OutputFormatter writes one JSON line per file", "[OutputFormatter][RecordWriter][jsonl]") {
+    fs::path tmp = make_temp_dir();
+    std::ofstream(tmp / "a.txt") << "say \"hi\"\n";
+    std::ofstream(tmp / "b.txt") << "two\nlines\n";
+
+    ScanResult scan;
+    scan.files = {{tmp / "a.txt", 9}, {tmp / "b.txt", 10}};
+    std::vector<FileContent> contents = {FileReader().readFile(tmp / "a.txt"), FileReader().readFile(tmp / "b.txt")};
+    Config cfg;
+    GitInfo git;
+
+    std::ostringstream oss;
+    OutputFormatter fmt(oss);
+    fmt.setFormat(OutputFormat::Jsonl);
+    fmt.generate(tmp, cfg, git, scan, contents);
+
+    std::vector<std::string> lines;
+    std::istringstream in(oss.str());
+    for (std::string l; std::getline(in, l);) lines.push_back(l);
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[0].rfind("{\"type\":\"header\",\"root\":", 0) == 0);
+    REQUIRE(lines[1] == "{\"type\":\"file\",\"path\":\"a.txt\",\"size\":9,\"lines\":1,\"truncated\":false,"
+                        "\"content\":\"say \\\"hi\\\"\\n\"}");
+    REQUIRE(lines[2] == "{\"type\":\"file\",\"path\":\"b.txt\",\"size\":10,\"lines\":2,\"truncated\":false,"
+                        "\"content\":\"two\\nlines\\n\"}");
+    REQUIRE(lines[3] == "{\"type\":\"summary\",\"files\":2,\"lines\":3,\"duplicates\":0}");
+
+    std::ostringstream doc;
+    OutputFormatter json(doc);
+    json.setFormat(OutputFormat::Json);
+    json.generate(tmp, cfg, git, scan, contents);
+    REQUIRE(doc.str().find("\"files\":[\n{\"path\":\"a.txt\"") != std::string::npos);
+    REQUIRE(doc.str().find("\"content\":\"say \\\"hi\\\"\\n\"},\n{\"path\":\"b.txt\"") != std::string::npos);
+    REQUIRE(doc.str().find("\n],\"summary\":{\"files\":2,\"lines\":3,\"duplicates\":0}}\n") != std::string::npos);
+
+    remove_dir_recursive(tmp);
+}
@@ -0,0 +1,43 @@
+// tests/test_search_index.cpp
+#include "catch.hpp"
+#include "../src/SearchIndex.h"
+
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+
+TEST_CASE("SearchIndex::terms splits identifiers into parts", "[SearchIndex]") {
+    std::vector<std::string> t;
+    SearchIndex::terms("parseHTTPHeader max_token_count x", t);
+    REQUIRE(t == std::vector<std::string>{"parsehttpheader", "parse", "http", "header",
+                                          "max_token_count", "max", "token", "count"});
+}
+
+TEST_CASE("SearchIndex ranks files by BM25 relevance", "[SearchIndex]") {
+    SearchIndex index;
+    index.addDocument("src/cache.cpp", "// LRU cache eviction\nvoid evictOldest(Cache &cache) { cache.evict(); }\n");
+    index.addDocument("src/parser.cpp", "// parse tokens\nint parseToken(const char *p) { return *p; }\n");
+    index.addDocument("docs/notes.md", "The cache is small. Parsing is fast. Nothing else to say here at all.\n");
+    index.finalize();
+
+    REQUIRE(index.docCount() == 3);
+    REQUIRE(index.postingCount() > 0);
+
+    auto ranked = index.rank("cache eviction");
+    REQUIRE(ranked.size() == 2);
+    REQUIRE(ranked[0] == 0);
+    REQUIRE(ranked[1] == 2);
+
+    // camelCase parts match plain words, and paths are searchable
+    ranked = index.rank("parse token");
+    REQUIRE(!ranked.empty());
+    REQUIRE(ranked[0] == 1);
+    ranked = index.rank("notes");
+    REQUIRE(ranked == std::vector<uint32_t>{2});
+
+    REQUIRE(index.rank("nonexistent").empty());
+    auto scores = index.score("cache");
+    REQUIRE(scores[1] == 0.0f);
+    REQUIRE(scores[0] > scores[2]);
+}
@@ -0,0 +1,119 @@
+// tests/test_sharded_output.cpp
+#include "catch.hpp"
+#include "../src/ShardedOutput.h"
+#include "../src/FileReader.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+// files src/f0.txt .. src/f<n-1>.txt of the same size (under 100 files), with their contents as read
+struct Corpus {
+    fs::path root;
+    ScanResult scan;
+    std::vector<FileContent> contents;
+};
+
+static Corpus makeCorpus(const fs::path &root, size_t n) {
+    Corpus c;
+    c.root = root / "repo";
+    fs::create_directories(c.root / "src");
+    for (size_t i = 0; i < n; ++i) {
+        fs::path p = c.root / "src" / ("f" + std::to_string(i) + ".txt");
+        std::ofstream out(p);
+        for (int l = 0; l < 40; ++l) out << "line " << l << " of file " << (i < 10 ? "0" : "") << i << "\n";
+    }
+    for (auto &e : fs::directory_iterator(c.root / "src")) c.scan.files.push_back({e.path()});
+    std::sort(c.scan.files.begin(), c.scan.files.end(),
+              [](const FileEntry &a, const FileEntry &b) { return a.path < b.path; });
+    for (auto &fe : c.scan.files) {
+        fe.size = fs::file_size(fe.path);
+        c.contents.push_back(FileReader().readFile(fe.path));
+        c.contents.back().tokens = c.contents.back().content.size() / 4;
+    }
+    return c;
+}
+
+static size_t writeShards(const Corpus &c, const Config &cfg, const fs::path &out) {
+    GitInfo git;
+    git.isRepo = false;
+    ShardedOutput shards(out, cfg, c.root, git, c.scan, [](OutputFormatter &) {});
+    for (size_t i = 0; i < c.scan.files.size(); ++i) {
+        shards.add(shards.renderer().renderSection(c.root, cfg, c.scan, i, &c.contents[i]));
+    }
+    REQUIRE(shards.finish());
+    return shards.shardCount();
+}
+
+TEST_CASE("ShardedOutput names shards before the extension", "[ShardedOutput]") {
+    REQUIRE(ShardedOutput::shardPath("out/context.md", 3) == fs::path("out/context.003.md"));
+    REQUIRE(ShardedOutput::shardPath("context.md.gz", 12) == fs::path("context.012.md.gz"));
+    REQUIRE(ShardedOutput::shardPath("context", 1) == fs::path("context.001"));
+    REQUIRE(ShardedOutput::shardPath("context.md", 1234) == fs::path("context.1234.md"));
+}
+
+TEST_CASE("ShardedOutput keeps every shard under the byte limit", "[ShardedOutput]") {
+    fs::path tmp = make_temp_dir();
+    Corpus c = makeCorpus(tmp, 30);
+    Config cfg;
+    cfg.splitMaxBytes = 5000;
+    size_t count = writeShards(c, cfg, tmp / "out.md");
+    REQUIRE(count > 1);
+
+    std::string sections;
+    size_t files = 0;
+    for (size_t part = 1; part <= count; ++part) {
+        std::string text = slurp(ShardedOutput::shardPath(tmp / "out.md", part));
+        REQUIRE(text.size() <= cfg.splitMaxBytes);
+        REQUIRE(text.rfind("# Repository Context (part " + std::to_string(part) + ")", 0) == 0);
+        REQUIRE(text.find("Not a git repository") != std::string::npos);
+        size_t from = text.find("## File Contents\n\n") + 18, to = text.rfind("## Summary");
+        sections += text.substr(from, to - from);
+        // the tree lists exactly the shard's own files
+        size_t here = 0;
+        for (size_t pos = 0; (pos = text.find("### File: ", pos)) != std::string::npos; ++pos) ++here;
+        REQUIRE(text.find("src/ (" + std::to_string(here) + (here == 1 ? " file, " : " files, ")) != std::string::npos);
+        files += here;
+    }
+    REQUIRE(files == 30);
+    REQUIRE_FALSE(fs::exists(tmp / "out.md"));
+
+    // the shards together hold exactly the sections of the unsplit output
+    std::ostringstream whole;
+    GitInfo git;
+    git.isRepo = false;
+    OutputFormatter(whole).generate(c.root, cfg, git, c.scan, c.contents);
+    std::string all = whole.str();
+    size_t from = all.find("## File Contents\n\n") + 18;
+    REQUIRE(sections == all.substr(from, all.rfind("## Summary") - from));
+
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("ShardedOutput splits by tokens and removes stale shards", "[ShardedOutput]") {
+    fs::path tmp = make_temp_dir();
+    Corpus c = makeCorpus(tmp, 12);
+    Config cfg;
+    cfg.splitMaxTokens = c.contents[0].tokens * 3;
+    REQUIRE(writeShards(c, cfg, tmp / "out.md") == 4);
+    REQUIRE(fs::exists(tmp / "out.004.md"));
+
+    cfg.splitMaxTokens = c.contents[0].tokens * 6;
+    REQUIRE(writeShards(c, cfg, tmp / "out.md") == 2);
+    REQUIRE(fs::exists(tmp / "out.002.md"));
+    REQUIRE_FALSE(fs::exists(tmp / "out.003.md"));
+    REQUIRE_FALSE(fs::exists(tmp / "out.004.md"));
+
+    // a file over the limit on its own still gets a shard
+    cfg.splitMaxTokens = 1;
+    REQUIRE(writeShards(c, cfg, tmp / "out.md") == 12);
+
+    remove_dir_recursive(tmp);
+}
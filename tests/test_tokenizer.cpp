@@ -0,0 +1,83 @@
+// tests/test_tokenizer.cpp
+#include "catch.hpp"
+#include "../src/Tokenizer.h"
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace rcpack;
+namespace fs = std::filesystem;
+
+static std::vector<std::string> pieces(const std::string &s) {
+    std::vector<std::string> out;
+    for (size_t pos = 0; pos < s.size();) {
+        size_t len = Tokenizer::nextPiece(s, pos);
+        out.push_back(s.substr(pos, len));
+        pos += len;
+    }
+    return out;
+}
+
+TEST_CASE("Tokenizer::nextPiece splits like the cl100k pattern", "[Tokenizer]") {
+    REQUIRE(pieces("int main() {") == std::vector<std::string>{"int", " main", "()", " {"});
+    REQUIRE(pieces("x = 12345;") == std::vector<std::string>{"x", " =", " ", "123", "45", ";"});
+    REQUIRE(pieces("don't") == std::vector<std::string>{"don", "'t"});
+    // indentation keeps one space for the following word; newlines end a whitespace run
+    REQUIRE(pieces("a\n    return") == std::vector<std::string>{"a", "\n", "   ", " return"});
+}
+
+TEST_CASE("Tokenizer runs byte-pair merges with a tiktoken vocabulary", "[Tokenizer]") {
+    fs::path tmp = make_temp_dir();
+    {
+        // a b c ' ' ab abc ' ab'
+        std::ofstream v(tmp / "vocab.tiktoken");
+        v << "YQ== 0\nYg== 1\nYw== 2\nIA== 3\nYWI= 4\nYWJj 5\nIGFi 6\n";
+    }
+    Tokenizer tok;
+    REQUIRE_FALSE(tok.hasVocab());
+    REQUIRE(tok.loadVocab(tmp / "vocab.tiktoken"));
+    REQUIRE(tok.hasVocab());
+
+    REQUIRE(tok.count("abc") == 1);
+    // " abcab" -> " " + "abc" + "ab"
+    REQUIRE(tok.count(" abcab") == 3);
+    REQUIRE(tok.count("abc abcab") == 4);
+    // memoised pieces give the same answer
+    REQUIRE(tok.count("abc abcab") == 4);
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("Tokenizer memos do not outlive their vocabulary", "[Tokenizer]") {
+    fs::path tmp = make_temp_dir();
+    std::ofstream(tmp / "merges.tiktoken") << "YQ== 0\nYg== 1\nYWI= 2\n";
+    std::ofstream(tmp / "bytes.tiktoken") << "YQ== 0\nYg== 1\n";
+    // a new Tokenizer in the same storage must not see the old one's memo
+    std::optional<Tokenizer> tok;
+    tok.emplace();
+    REQUIRE(tok->loadVocab(tmp / "merges.tiktoken"));
+    REQUIRE(tok->count("ab") == 1);
+    tok.emplace();
+    REQUIRE(tok->loadVocab(tmp / "bytes.tiktoken"));
+    REQUIRE(tok->count("ab") == 2);
+    // nor may a reload
+    REQUIRE(tok->loadVocab(tmp / "merges.tiktoken"));
+    REQUIRE(tok->count("ab") == 1);
+    remove_dir_recursive(tmp);
+}
+
+TEST_CASE("Tokenizer estimates without a vocabulary", "[Tokenizer]") {
+    Tokenizer tok;
+    REQUIRE(tok.count("") == 0);
+    REQUIRE(tok.count("int main() { return 0; }") > 5);
+    std::string big;
+    for (int i = 0; i < 100; ++i) big += "    value = compute(value, 42);\n";
+    size_t n = tok.count(big);
+    // roughly 4 bytes per token on code
+    REQUIRE(n > big.size() / 8);
+    REQUIRE(n < big.size() / 2);
+    REQUIRE(std::string(tok.mode()) == "approximate");
+}